@@ -35,6 +35,7 @@
 #include "spdk/jsonrpc.h"
 #include "spdk/rpc.h"
 #include "spdk/event.h"
+#include "spdk/thread.h"
 #include "spdk/util.h"
 #include "spdk/env.h"
 
@@ -98,7 +99,7 @@
 #define CORE_WIN_FIRST_COL 16
 #define CORE_WIN_WIDTH 48
 #define CORE_WIN_HEIGHT 11
-#define POLLER_WIN_HEIGHT 8
+#define POLLER_WIN_HEIGHT 10
 #define POLLER_WIN_WIDTH 64
 #define POLLER_WIN_FIRST_COL 14
 #define FIRST_DATA_ROW 7
@@ -131,6 +132,7 @@ enum column_pollers_type {
 	COL_POLLERS_RUN_COUNTER,
 	COL_POLLERS_PERIOD,
 	COL_POLLERS_BUSY_COUNT,
+	COL_POLLERS_CPU_USAGE,
 	COL_POLLERS_NONE = 255,
 };
 
@@ -165,6 +167,8 @@ struct run_counter_history {
 	uint64_t thread_id;
 	uint64_t last_run_counter;
 	uint64_t last_busy_counter;
+	uint64_t last_tsc;
+	uint64_t last_tsc_histogram[SPDK_POLLER_TSC_HISTOGRAM_BUCKETS];
 	TAILQ_ENTRY(run_counter_history) link;
 };
 
@@ -204,6 +208,7 @@ static struct col_desc g_col_desc[NUMBER_OF_TABS][TABS_COL_COUNT] = {
 		{.name = "Run count", .max_data_string = MAX_POLLER_RUN_COUNT},
 		{.name = "Period [us]", .max_data_string = MAX_PERIOD_STR_LEN},
 		{.name = "Status (busy count)", .max_data_string = MAX_POLLER_IND_STR_LEN},
+		{.name = "CPU %", .max_data_string = MAX_CPU_STR_LEN},
 		{.name = (char *)NULL}
 	},
 	{	{.name = "Core", .max_data_string = MAX_CORE_STR_LEN},
@@ -239,6 +244,8 @@ struct rpc_poller_info {
 	uint64_t run_count;
 	uint64_t busy_count;
 	uint64_t period_ticks;
+	uint64_t tsc;
+	uint64_t tsc_histogram[SPDK_POLLER_TSC_HISTOGRAM_BUCKETS];
 	enum spdk_poller_type type;
 	char thread_name[MAX_THREAD_NAME];
 	uint64_t thread_id;
@@ -369,6 +376,15 @@ free_rpc_core_info(struct rpc_core_info *core_info, size_t size)
 	}
 }
 
+static int
+rpc_decode_tsc_histogram(const struct spdk_json_val *val, void *out)
+{
+	size_t count;
+
+	return spdk_json_decode_array(val, spdk_json_decode_uint64, out,
+				      SPDK_POLLER_TSC_HISTOGRAM_BUCKETS, &count, sizeof(uint64_t));
+}
+
 static const struct spdk_json_object_decoder rpc_pollers_decoders[] = {
 	{"name", offsetof(struct rpc_poller_info, name), spdk_json_decode_string},
 	{"state", offsetof(struct rpc_poller_info, state), spdk_json_decode_string},
@@ -376,6 +392,8 @@ static const struct spdk_json_object_decoder rpc_pollers_decoders[] = {
 	{"run_count", offsetof(struct rpc_poller_info, run_count), spdk_json_decode_uint64},
 	{"busy_count", offsetof(struct rpc_poller_info, busy_count), spdk_json_decode_uint64},
 	{"period_ticks", offsetof(struct rpc_poller_info, period_ticks), spdk_json_decode_uint64, true},
+	{"tsc", offsetof(struct rpc_poller_info, tsc), spdk_json_decode_uint64, true},
+	{"tsc_histogram", offsetof(struct rpc_poller_info, tsc_histogram), rpc_decode_tsc_histogram, true},
 };
 
 static int
@@ -701,31 +719,42 @@ sort_threads(const void *p1, const void *p2)
 	return res;
 }
 
-static void
-store_last_counters(uint64_t poller_id, uint64_t thread_id, uint64_t last_run_counter,
-		    uint64_t last_busy_counter)
+static struct run_counter_history *
+get_history(uint64_t poller_id, uint64_t thread_id)
 {
 	struct run_counter_history *history;
 
 	TAILQ_FOREACH(history, &g_run_counter_history, link) {
 		if ((history->poller_id == poller_id) && (history->thread_id == thread_id)) {
-			history->last_run_counter = last_run_counter;
-			history->last_busy_counter = last_busy_counter;
-			return;
+			return history;
 		}
 	}
 
-	history = calloc(1, sizeof(*history));
+	return NULL;
+}
+
+static void
+store_last_counters(const struct rpc_poller_info *poller)
+{
+	struct run_counter_history *history;
+
+	history = get_history(poller->id, poller->thread_id);
 	if (history == NULL) {
-		fprintf(stderr, "Unable to allocate a history object in store_last_counters.\n");
-		return;
+		history = calloc(1, sizeof(*history));
+		if (history == NULL) {
+			fprintf(stderr, "Unable to allocate a history object in store_last_counters.\n");
+			return;
+		}
+		history->poller_id = poller->id;
+		history->thread_id = poller->thread_id;
+
+		TAILQ_INSERT_TAIL(&g_run_counter_history, history, link);
 	}
-	history->poller_id = poller_id;
-	history->thread_id = thread_id;
-	history->last_run_counter = last_run_counter;
-	history->last_busy_counter = last_busy_counter;
 
-	TAILQ_INSERT_TAIL(&g_run_counter_history, history, link);
+	history->last_run_counter = poller->run_count;
+	history->last_busy_counter = poller->busy_count;
+	history->last_tsc = poller->tsc;
+	memcpy(history->last_tsc_histogram, poller->tsc_histogram, sizeof(history->last_tsc_histogram));
 }
 
 static int
@@ -804,30 +833,59 @@ end:
 
 static uint64_t
 get_last_run_counter(uint64_t poller_id, uint64_t thread_id)
+{
+	struct run_counter_history *history = get_history(poller_id, thread_id);
+
+	return history != NULL ? history->last_run_counter : 0;
+}
+
+static uint64_t
+get_last_busy_counter(uint64_t poller_id, uint64_t thread_id)
+{
+	struct run_counter_history *history = get_history(poller_id, thread_id);
+
+	return history != NULL ? history->last_busy_counter : 0;
+}
+
+/* Ticks spent in the poller and ticks elapsed on its core since the last refresh */
+static int
+get_poller_ticks(const struct rpc_poller_info *poller, uint64_t *poller_ticks,
+		 uint64_t *core_ticks)
 {
 	struct run_counter_history *history;
+	struct rpc_core_info *core_info;
+	uint64_t i;
 
-	TAILQ_FOREACH(history, &g_run_counter_history, link) {
-		if ((history->poller_id == poller_id) && (history->thread_id == thread_id)) {
-			return history->last_run_counter;
+	for (i = 0; i < g_last_threads_count; i++) {
+		if (g_threads_info[i].id == poller->thread_id) {
+			break;
 		}
 	}
 
+	if (i == g_last_threads_count || g_threads_info[i].core_num < 0 ||
+	    g_threads_info[i].core_num >= RPC_MAX_CORES) {
+		return -ENOENT;
+	}
+
+	core_info = &g_cores_info[g_threads_info[i].core_num];
+	history = get_history(poller->id, poller->thread_id);
+
+	*poller_ticks = poller->tsc - (history != NULL ? history->last_tsc : 0);
+	*core_ticks = (core_info->busy - core_info->last_busy) + (core_info->idle - core_info->last_idle);
+
 	return 0;
 }
 
 static uint64_t
-get_last_busy_counter(uint64_t poller_id, uint64_t thread_id)
+get_poller_cpu_usage(const struct rpc_poller_info *poller)
 {
-	struct run_counter_history *history;
+	uint64_t poller_ticks, core_ticks;
 
-	TAILQ_FOREACH(history, &g_run_counter_history, link) {
-		if ((history->poller_id == poller_id) && (history->thread_id == thread_id)) {
-			return history->last_busy_counter;
-		}
+	if (get_poller_ticks(poller, &poller_ticks, &core_ticks) != 0 || core_ticks == 0) {
+		return 0;
 	}
 
-	return 0;
+	return poller_ticks * 10000 / core_ticks;
 }
 
 static int
@@ -872,6 +930,10 @@ subsort_pollers(enum column_pollers_type sort_column, const void *p1, const void
 			}
 		}
 		break;
+	case COL_POLLERS_CPU_USAGE:
+		count1 = get_poller_cpu_usage(poller1);
+		count2 = get_poller_cpu_usage(poller2);
+		break;
 	case COL_POLLERS_NONE:
 	default:
 		return 0;
@@ -926,8 +988,7 @@ get_pollers_data(void)
 
 	/* Save last run counter of each poller before updating g_pollers_stats. */
 	for (i = 0; i < g_last_pollers_count; i++) {
-		store_last_counters(g_pollers_info[i].id, g_pollers_info[i].thread_id,
-				    g_pollers_info[i].run_count, g_pollers_info[i].busy_count);
+		store_last_counters(&g_pollers_info[i]);
 	}
 
 	/* Free old pollers values before allocating memory for new ones */
@@ -1462,10 +1523,10 @@ static void
 draw_poller_tab_row(uint64_t current_row, uint8_t item_index)
 {
 	struct col_desc *col_desc = g_col_desc[POLLERS_TAB];
-	uint64_t last_run_counter, last_busy_counter;
+	uint64_t last_run_counter, last_busy_counter, poller_ticks, core_ticks;
 	uint16_t col = TABS_DATA_START_COL;
 	char run_count[MAX_POLLER_RUN_COUNT], period_ticks[MAX_PERIOD_STR_LEN],
-	     status[MAX_POLLER_IND_STR_LEN];
+	     status[MAX_POLLER_IND_STR_LEN], cpu_usage[MAX_CPU_STR_LEN];
 
 	last_busy_counter = get_last_busy_counter(g_pollers_info[current_row].id,
 			    g_pollers_info[current_row].thread_id);
@@ -1554,6 +1615,18 @@ draw_poller_tab_row(uint64_t current_row, uint8_t item_index)
 				wattroff(g_tabs[POLLERS_TAB], COLOR_PAIR(9));
 			}
 		}
+		col += col_desc[COL_POLLERS_BUSY_COUNT].max_data_string + 2;
+	}
+
+	if (!col_desc[COL_POLLERS_CPU_USAGE].disabled) {
+		if (get_poller_ticks(&g_pollers_info[current_row], &poller_ticks, &core_ticks) == 0) {
+			get_cpu_usage_str(poller_ticks, core_ticks, cpu_usage);
+		} else {
+			snprintf(cpu_usage, sizeof(cpu_usage), "n/a");
+		}
+
+		print_max_len(g_tabs[POLLERS_TAB], TABS_DATA_START_ROW + item_index, col,
+			      col_desc[COL_POLLERS_CPU_USAGE].max_data_string, ALIGN_RIGHT, cpu_usage);
 	}
 }
 
@@ -2672,6 +2745,55 @@ show_core(uint8_t current_page, uint8_t active_tab)
 	delwin(core_win);
 }
 
+/* Print average and 99th percentile cost of a poller invocation, based on the
+ * histogram of invocation cost reported by the application. */
+static void
+draw_poller_win_cost(WINDOW *poller_win, int row, struct rpc_poller_info *poller_info)
+{
+	struct run_counter_history *history = NULL;
+	uint64_t histogram[SPDK_POLLER_TSC_HISTOGRAM_BUCKETS];
+	uint64_t run_count = 0, tsc, sum = 0, target;
+	int i;
+
+	if (g_interval_data) {
+		history = get_history(poller_info->id, poller_info->thread_id);
+	}
+
+	for (i = 0; i < SPDK_POLLER_TSC_HISTOGRAM_BUCKETS; i++) {
+		histogram[i] = poller_info->tsc_histogram[i];
+		if (history != NULL) {
+			histogram[i] -= history->last_tsc_histogram[i];
+		}
+		run_count += histogram[i];
+	}
+	tsc = poller_info->tsc - (history != NULL ? history->last_tsc : 0);
+
+	print_left(poller_win, row, 2, POLLER_WIN_WIDTH, "Avg [ticks]:          p99 [ticks]:", COLOR_PAIR(5));
+	if (run_count == 0) {
+		mvwprintw(poller_win, row, POLLER_WIN_FIRST_COL, "%s", "n/a");
+		mvwprintw(poller_win, row, POLLER_WIN_FIRST_COL + 23, "%s", "n/a");
+		return;
+	}
+
+	mvwprintw(poller_win, row, POLLER_WIN_FIRST_COL, "%" PRIu64, tsc / run_count);
+
+	target = (run_count * 99 + 99) / 100;
+	for (i = 0; i < SPDK_POLLER_TSC_HISTOGRAM_BUCKETS - 1; i++) {
+		sum += histogram[i];
+		if (sum >= target) {
+			break;
+		}
+	}
+
+	if (i == SPDK_POLLER_TSC_HISTOGRAM_BUCKETS - 1) {
+		mvwprintw(poller_win, row, POLLER_WIN_FIRST_COL + 23, ">= %" PRIu64,
+			  (uint64_t)1 << (i + SPDK_POLLER_TSC_HISTOGRAM_SHIFT));
+	} else {
+		mvwprintw(poller_win, row, POLLER_WIN_FIRST_COL + 23, "< %" PRIu64,
+			  (uint64_t)1 << (i + SPDK_POLLER_TSC_HISTOGRAM_SHIFT + 1));
+	}
+}
+
 static void
 draw_poller_win_content(WINDOW *poller_win, struct rpc_poller_info *poller_info)
 {
@@ -2723,6 +2845,9 @@ draw_poller_win_content(WINDOW *poller_win, struct rpc_poller_info *poller_info)
 		print_in_middle(poller_win, 6, 1, POLLER_WIN_WIDTH - 7, "Status:", COLOR_PAIR(5));
 		print_in_middle(poller_win, 6, 1, POLLER_WIN_WIDTH + 6, "Idle", COLOR_PAIR(7));
 	}
+	mvwhline(poller_win, 7, 1, ACS_HLINE, POLLER_WIN_WIDTH - 2);
+
+	draw_poller_win_cost(poller_win, 8, poller_info);
 
 	wnoutrefresh(poller_win);
 }
@@ -47,6 +47,10 @@ extern "C" {
 /* Flags for accel operations */
 #define ACCEL_FLAG_PERSISTENT (1 << 0)
 
+/* Sizes of each of the two AES-XTS keys */
+#define SPDK_ACCEL_AES_XTS_128_KEY_SIZE	16
+#define SPDK_ACCEL_AES_XTS_256_KEY_SIZE	32
+
 enum accel_opcode {
 	ACCEL_OPC_COPY			= 0,
 	ACCEL_OPC_FILL			= 1,
@@ -54,7 +58,14 @@ enum accel_opcode {
 	ACCEL_OPC_COMPARE		= 3,
 	ACCEL_OPC_CRC32C		= 4,
 	ACCEL_OPC_COPY_CRC32C		= 5,
-	ACCEL_OPC_LAST			= 6,
+	ACCEL_OPC_XOR			= 6,
+	ACCEL_OPC_EC_ENCODE		= 7,
+	ACCEL_OPC_EC_DECODE		= 8,
+	ACCEL_OPC_COMPRESS		= 9,
+	ACCEL_OPC_DECOMPRESS		= 10,
+	ACCEL_OPC_ENCRYPT		= 11,
+	ACCEL_OPC_DECRYPT		= 12,
+	ACCEL_OPC_LAST			= 13,
 };
 
 /**
@@ -246,6 +257,446 @@ int spdk_accel_submit_copy_crc32cv(struct spdk_io_channel *ch, void *dst, struct
 				   uint32_t iovcnt, uint32_t *crc_dst, uint32_t seed,
 				   int flags, spdk_accel_completion_cb cb_fn, void *cb_arg);
 
+/**
+ * Submit an XOR request.
+ *
+ * This operation will XOR the source buffers together into the destination buffer.
+ *
+ * \param ch I/O channel associated with this call.
+ * \param dst Destination to write the result to.
+ * \param sources Array of source buffers.
+ * \param nsrcs Number of source buffers, at least 2.
+ * \param nbytes Length in bytes of each buffer.
+ * \param cb_fn Called when this XOR operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_submit_xor(struct spdk_io_channel *ch, void *dst, void **sources, uint32_t nsrcs,
+			  uint64_t nbytes, spdk_accel_completion_cb cb_fn, void *cb_arg);
+
+/**
+ * Submit an erasure code encode request.
+ *
+ * This operation will generate the parity buffers of a stripe. See spdk/ec.h for the code
+ * that is used.
+ *
+ * \param ch I/O channel associated with this call.
+ * \param data Array of data buffers.
+ * \param ndata Number of data buffers.
+ * \param parity Array of parity buffers to generate.
+ * \param nparity Number of parity buffers.
+ * \param nbytes Length in bytes of each buffer.
+ * \param cb_fn Called when this encode operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_submit_ec_encode(struct spdk_io_channel *ch, void **data, uint32_t ndata,
+				void **parity, uint32_t nparity, uint64_t nbytes,
+				spdk_accel_completion_cb cb_fn, void *cb_arg);
+
+/**
+ * Submit an erasure code decode request.
+ *
+ * This operation will reconstruct lost buffers of a stripe from the remaining ones.
+ * Buffers are numbered with the data buffers first, followed by the parity buffers.
+ *
+ * \param ch I/O channel associated with this call.
+ * \param data Array of data buffers.
+ * \param ndata Number of data buffers.
+ * \param parity Array of parity buffers.
+ * \param nparity Number of parity buffers.
+ * \param erased Indexes of the buffers to reconstruct. Must stay valid until the
+ * operation completes.
+ * \param nerased Number of buffers to reconstruct, at most nparity.
+ * \param nbytes Length in bytes of each buffer.
+ * \param cb_fn Called when this decode operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_submit_ec_decode(struct spdk_io_channel *ch, void **data, uint32_t ndata,
+				void **parity, uint32_t nparity, const uint32_t *erased,
+				uint32_t nerased, uint64_t nbytes,
+				spdk_accel_completion_cb cb_fn, void *cb_arg);
+
+/**
+ * Submit a compression request.
+ *
+ * The source data is compressed into a raw deflate stream (RFC 1951) without any
+ * zlib or gzip framing.
+ *
+ * \param ch I/O channel associated with this call.
+ * \param dst_iovs The io vector array which stores the compressed data.
+ * \param dst_iovcnt The size of the destination io vectors.
+ * \param src_iovs The io vector array which stores the data to compress.
+ * \param src_iovcnt The size of the source io vectors.
+ * \param output_size The size of the compressed data is written here on success.
+ * \param cb_fn Called when this compress operation completes. The status is -ENOSPC
+ * if the compressed data does not fit into the destination buffers.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, -ENOTSUP if no engine is able to compress, negative errno
+ * on other failures.
+ */
+int spdk_accel_submit_compress(struct spdk_io_channel *ch, struct iovec *dst_iovs,
+			       uint32_t dst_iovcnt, struct iovec *src_iovs, uint32_t src_iovcnt,
+			       uint32_t *output_size, spdk_accel_completion_cb cb_fn, void *cb_arg);
+
+/**
+ * Submit a decompression request.
+ *
+ * The source data must be a raw deflate stream, as produced by
+ * spdk_accel_submit_compress().
+ *
+ * \param ch I/O channel associated with this call.
+ * \param dst_iovs The io vector array which stores the decompressed data.
+ * \param dst_iovcnt The size of the destination io vectors.
+ * \param src_iovs The io vector array which stores the data to decompress.
+ * \param src_iovcnt The size of the source io vectors.
+ * \param output_size The size of the decompressed data is written here on success.
+ * May be NULL.
+ * \param cb_fn Called when this decompress operation completes. The status is -ENOSPC
+ * if the decompressed data does not fit into the destination buffers and -EIO if the
+ * source data is not a complete deflate stream.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, -ENOTSUP if no engine is able to decompress, negative errno
+ * on other failures.
+ */
+int spdk_accel_submit_decompress(struct spdk_io_channel *ch, struct iovec *dst_iovs,
+				 uint32_t dst_iovcnt, struct iovec *src_iovs, uint32_t src_iovcnt,
+				 uint32_t *output_size, spdk_accel_completion_cb cb_fn, void *cb_arg);
+
+/**
+ * An AES-XTS key for the encrypt and decrypt operations.
+ */
+struct spdk_accel_crypto_key;
+
+/**
+ * Create an AES-XTS key.
+ *
+ * The key material is copied, so the caller's buffers may be cleared once this returns.
+ *
+ * \param key Data key, used to encrypt the data.
+ * \param key2 Tweak key, used to encrypt the initialization vector. Must differ from key.
+ * \param key_size Size in bytes of each of the two keys, either
+ * SPDK_ACCEL_AES_XTS_128_KEY_SIZE or SPDK_ACCEL_AES_XTS_256_KEY_SIZE.
+ * \param _key The created key is returned here.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_crypto_key_create(const void *key, const void *key2, size_t key_size,
+				 struct spdk_accel_crypto_key **_key);
+
+/**
+ * Destroy an AES-XTS key and clear its key material.
+ *
+ * There must be no outstanding operations using the key.
+ *
+ * \param key Key to destroy.
+ */
+void spdk_accel_crypto_key_destroy(struct spdk_accel_crypto_key *key);
+
+/**
+ * Submit an AES-XTS encryption request.
+ *
+ * The data is encrypted in data units of block_size bytes. The first data unit uses iv as
+ * its tweak, and the tweak is incremented by one for each following data unit, so iv is
+ * typically the LBA of the first block.
+ *
+ * \param ch I/O channel associated with this call.
+ * \param key Key to encrypt with.
+ * \param dst_iovs The io vector array which stores the encrypted data.
+ * \param dst_iovcnt The size of the destination io vectors.
+ * \param src_iovs The io vector array which stores the data to encrypt.
+ * \param src_iovcnt The size of the source io vectors.
+ * \param iv Tweak of the first data unit.
+ * \param block_size Size of a data unit in bytes. Must be a multiple of 16 and the total
+ * length of the source must be a multiple of it. The length of each source and destination
+ * io vector must be a multiple of 16.
+ * \param cb_fn Called when this encrypt operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, -ENOTSUP if no engine is able to encrypt, negative errno
+ * on other failures.
+ */
+int spdk_accel_submit_encrypt(struct spdk_io_channel *ch, struct spdk_accel_crypto_key *key,
+			      struct iovec *dst_iovs, uint32_t dst_iovcnt,
+			      struct iovec *src_iovs, uint32_t src_iovcnt,
+			      uint64_t iv, uint32_t block_size,
+			      spdk_accel_completion_cb cb_fn, void *cb_arg);
+
+/**
+ * Submit an AES-XTS decryption request.
+ *
+ * See spdk_accel_submit_encrypt() for the meaning of iv and block_size, which must match
+ * the ones used to encrypt the data.
+ *
+ * \param ch I/O channel associated with this call.
+ * \param key Key to decrypt with.
+ * \param dst_iovs The io vector array which stores the decrypted data.
+ * \param dst_iovcnt The size of the destination io vectors.
+ * \param src_iovs The io vector array which stores the data to decrypt.
+ * \param src_iovcnt The size of the source io vectors.
+ * \param iv Tweak of the first data unit.
+ * \param block_size Size of a data unit in bytes.
+ * \param cb_fn Called when this decrypt operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, -ENOTSUP if no engine is able to decrypt, negative errno
+ * on other failures.
+ */
+int spdk_accel_submit_decrypt(struct spdk_io_channel *ch, struct spdk_accel_crypto_key *key,
+			      struct iovec *dst_iovs, uint32_t dst_iovcnt,
+			      struct iovec *src_iovs, uint32_t src_iovcnt,
+			      uint64_t iv, uint32_t block_size,
+			      spdk_accel_completion_cb cb_fn, void *cb_arg);
+
+/**
+ * A sequence of operations that are executed in order and completed together.
+ *
+ * A sequence is built with the spdk_accel_append_* functions and executed with
+ * spdk_accel_sequence_finish(). Each operation starts once the previous one is done,
+ * so a step may consume the output of an earlier step. Adjacent steps may be fused
+ * into a single operation when the engine executes them more efficiently that way.
+ */
+struct spdk_accel_sequence;
+
+/**
+ * Accel sequence step callback.
+ *
+ * \param cb_arg Callback argument.
+ */
+typedef void (*spdk_accel_step_cb)(void *cb_arg);
+
+/**
+ * Append a copy operation to a sequence.
+ *
+ * \param seq Sequence to append to. If *seq is NULL, a new sequence is allocated and
+ * returned through it.
+ * \param ch I/O channel associated with this call. All steps of a sequence must use the
+ * same channel.
+ * \param dst Destination to copy to.
+ * \param src Source to copy from.
+ * \param nbytes Length in bytes to copy.
+ * \param flags Accel framework flags for operations.
+ * \param cb_fn Called when this step is done, or when the sequence is aborted or fails
+ * before reaching it. May be NULL.
+ * \param cb_arg Argument passed to cb_fn.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_append_copy(struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
+			   void *dst, void *src, uint64_t nbytes, int flags,
+			   spdk_accel_step_cb cb_fn, void *cb_arg);
+
+/**
+ * Append a fill operation to a sequence.
+ *
+ * \param seq Sequence to append to. If *seq is NULL, a new sequence is allocated and
+ * returned through it.
+ * \param ch I/O channel associated with this call.
+ * \param dst Destination to fill.
+ * \param fill Constant byte to fill to the destination.
+ * \param nbytes Length in bytes to fill.
+ * \param flags Accel framework flags for operations.
+ * \param cb_fn Called when this step is done. May be NULL.
+ * \param cb_arg Argument passed to cb_fn.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_append_fill(struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
+			   void *dst, uint8_t fill, uint64_t nbytes, int flags,
+			   spdk_accel_step_cb cb_fn, void *cb_arg);
+
+/**
+ * Append a compare operation to a sequence.
+ *
+ * A miscompare stops the sequence, which then completes with -EILSEQ.
+ *
+ * \param seq Sequence to append to. If *seq is NULL, a new sequence is allocated and
+ * returned through it.
+ * \param ch I/O channel associated with this call.
+ * \param src1 First location to perform compare on.
+ * \param src2 Second location to perform compare on.
+ * \param nbytes Length in bytes to compare.
+ * \param cb_fn Called when this step is done. May be NULL.
+ * \param cb_arg Argument passed to cb_fn.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_append_compare(struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
+			      void *src1, void *src2, uint64_t nbytes,
+			      spdk_accel_step_cb cb_fn, void *cb_arg);
+
+/**
+ * Append a CRC-32C calculation to a sequence.
+ *
+ * \param seq Sequence to append to. If *seq is NULL, a new sequence is allocated and
+ * returned through it.
+ * \param ch I/O channel associated with this call.
+ * \param crc_dst Destination to write the CRC-32C to.
+ * \param src The source address for the data.
+ * \param seed Four byte seed value.
+ * \param nbytes Length in bytes.
+ * \param cb_fn Called when this step is done. May be NULL.
+ * \param cb_arg Argument passed to cb_fn.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_append_crc32c(struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
+			     uint32_t *crc_dst, void *src, uint32_t seed, uint64_t nbytes,
+			     spdk_accel_step_cb cb_fn, void *cb_arg);
+
+/**
+ * Append a chained CRC-32C calculation to a sequence.
+ *
+ * \param seq Sequence to append to. If *seq is NULL, a new sequence is allocated and
+ * returned through it.
+ * \param ch I/O channel associated with this call.
+ * \param crc_dst Destination to write the CRC-32C to.
+ * \param iovs The io vector array which stores the src data and len.
+ * \param iovcnt The size of the iov.
+ * \param seed Four byte seed value.
+ * \param cb_fn Called when this step is done. May be NULL.
+ * \param cb_arg Argument passed to cb_fn.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_append_crc32cv(struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
+			      uint32_t *crc_dst, struct iovec *iovs, uint32_t iovcnt, uint32_t seed,
+			      spdk_accel_step_cb cb_fn, void *cb_arg);
+
+/**
+ * Append a compression to a sequence.
+ *
+ * See spdk_accel_submit_compress() for the format of the compressed data.
+ *
+ * \param seq Sequence to append to. If *seq is NULL, a new sequence is allocated and
+ * returned through it.
+ * \param ch I/O channel associated with this call.
+ * \param dst_iovs The io vector array which stores the compressed data.
+ * \param dst_iovcnt The size of the destination io vectors.
+ * \param src_iovs The io vector array which stores the data to compress.
+ * \param src_iovcnt The size of the source io vectors.
+ * \param output_size The size of the compressed data is written here once the step is done.
+ * \param cb_fn Called when this step is done. May be NULL.
+ * \param cb_arg Argument passed to cb_fn.
+ *
+ * \return 0 on success, -ENOTSUP if no engine is able to compress, negative errno
+ * on other failures.
+ */
+int spdk_accel_append_compress(struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
+			       struct iovec *dst_iovs, uint32_t dst_iovcnt,
+			       struct iovec *src_iovs, uint32_t src_iovcnt,
+			       uint32_t *output_size, spdk_accel_step_cb cb_fn, void *cb_arg);
+
+/**
+ * Append a decompression to a sequence.
+ *
+ * \param seq Sequence to append to. If *seq is NULL, a new sequence is allocated and
+ * returned through it.
+ * \param ch I/O channel associated with this call.
+ * \param dst_iovs The io vector array which stores the decompressed data.
+ * \param dst_iovcnt The size of the destination io vectors.
+ * \param src_iovs The io vector array which stores the data to decompress.
+ * \param src_iovcnt The size of the source io vectors.
+ * \param output_size The size of the decompressed data is written here once the step is
+ * done. May be NULL.
+ * \param cb_fn Called when this step is done. May be NULL.
+ * \param cb_arg Argument passed to cb_fn.
+ *
+ * \return 0 on success, -ENOTSUP if no engine is able to decompress, negative errno
+ * on other failures.
+ */
+int spdk_accel_append_decompress(struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
+				 struct iovec *dst_iovs, uint32_t dst_iovcnt,
+				 struct iovec *src_iovs, uint32_t src_iovcnt,
+				 uint32_t *output_size, spdk_accel_step_cb cb_fn, void *cb_arg);
+
+/**
+ * Append an AES-XTS encryption to a sequence.
+ *
+ * See spdk_accel_submit_encrypt() for the meaning of iv and block_size.
+ *
+ * \param seq Sequence to append to. If *seq is NULL, a new sequence is allocated and
+ * returned through it.
+ * \param ch I/O channel associated with this call.
+ * \param key Key to encrypt with.
+ * \param dst_iovs The io vector array which stores the encrypted data.
+ * \param dst_iovcnt The size of the destination io vectors.
+ * \param src_iovs The io vector array which stores the data to encrypt.
+ * \param src_iovcnt The size of the source io vectors.
+ * \param iv Tweak of the first data unit.
+ * \param block_size Size of a data unit in bytes.
+ * \param cb_fn Called when this step is done. May be NULL.
+ * \param cb_arg Argument passed to cb_fn.
+ *
+ * \return 0 on success, -ENOTSUP if no engine is able to encrypt, negative errno
+ * on other failures.
+ */
+int spdk_accel_append_encrypt(struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
+			      struct spdk_accel_crypto_key *key,
+			      struct iovec *dst_iovs, uint32_t dst_iovcnt,
+			      struct iovec *src_iovs, uint32_t src_iovcnt,
+			      uint64_t iv, uint32_t block_size,
+			      spdk_accel_step_cb cb_fn, void *cb_arg);
+
+/**
+ * Append an AES-XTS decryption to a sequence.
+ *
+ * See spdk_accel_submit_encrypt() for the meaning of iv and block_size.
+ *
+ * \param seq Sequence to append to. If *seq is NULL, a new sequence is allocated and
+ * returned through it.
+ * \param ch I/O channel associated with this call.
+ * \param key Key to decrypt with.
+ * \param dst_iovs The io vector array which stores the decrypted data.
+ * \param dst_iovcnt The size of the destination io vectors.
+ * \param src_iovs The io vector array which stores the data to decrypt.
+ * \param src_iovcnt The size of the source io vectors.
+ * \param iv Tweak of the first data unit.
+ * \param block_size Size of a data unit in bytes.
+ * \param cb_fn Called when this step is done. May be NULL.
+ * \param cb_arg Argument passed to cb_fn.
+ *
+ * \return 0 on success, -ENOTSUP if no engine is able to decrypt, negative errno
+ * on other failures.
+ */
+int spdk_accel_append_decrypt(struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
+			      struct spdk_accel_crypto_key *key,
+			      struct iovec *dst_iovs, uint32_t dst_iovcnt,
+			      struct iovec *src_iovs, uint32_t src_iovcnt,
+			      uint64_t iv, uint32_t block_size,
+			      spdk_accel_step_cb cb_fn, void *cb_arg);
+
+/**
+ * Execute a sequence.
+ *
+ * The steps are executed in the order they were appended. The sequence stops at the
+ * first step that fails. Once it completes, the sequence is freed and must not be used
+ * anymore.
+ *
+ * \param seq Sequence to execute.
+ * \param cb_fn Called when the sequence completes. It is never called before this
+ * function returns.
+ * \param cb_arg Argument passed to cb_fn.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_sequence_finish(struct spdk_accel_sequence *seq,
+			       spdk_accel_completion_cb cb_fn, void *cb_arg);
+
+/**
+ * Abort a sequence that was not executed yet and free it.
+ *
+ * The step callbacks of all its steps are called.
+ *
+ * \param seq Sequence to abort. May be NULL.
+ */
+void spdk_accel_sequence_abort(struct spdk_accel_sequence *seq);
 
 struct spdk_json_write_ctx;
 
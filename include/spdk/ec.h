@@ -0,0 +1,91 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * Erasure code utility functions
+ *
+ * Reed-Solomon code over GF(2^8) with a Cauchy generator matrix. The data buffers are
+ * stored as they are and are followed by the parity buffers, so that any ndata of the
+ * ndata + nparity buffers are enough to recover the others.
+ */
+
+#ifndef SPDK_EC_H
+#define SPDK_EC_H
+
+#include "spdk/stdinc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of data buffers in a stripe */
+#define SPDK_EC_MAX_DATA_BUFS	32
+
+/** Maximum number of parity buffers in a stripe */
+#define SPDK_EC_MAX_PARITY_BUFS	8
+
+/**
+ * Generate the parity buffers of a stripe.
+ *
+ * \param data Array of data buffers.
+ * \param ndata Number of data buffers.
+ * \param parity Array of parity buffers to generate.
+ * \param nparity Number of parity buffers.
+ * \param len Length of each buffer in bytes.
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_ec_encode(void **data, uint32_t ndata, void **parity, uint32_t nparity, size_t len);
+
+/**
+ * Reconstruct lost buffers of a stripe from the remaining ones.
+ *
+ * Buffers are numbered with the data buffers first, followed by the parity buffers.
+ *
+ * \param data Array of data buffers.
+ * \param ndata Number of data buffers.
+ * \param parity Array of parity buffers.
+ * \param nparity Number of parity buffers.
+ * \param erased Indexes of the buffers to reconstruct, in any order.
+ * \param nerased Number of buffers to reconstruct, at most nparity.
+ * \param len Length of each buffer in bytes.
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_ec_decode(void **data, uint32_t ndata, void **parity, uint32_t nparity,
+		   const uint32_t *erased, uint32_t nerased, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPDK_EC_H */
@@ -316,6 +316,71 @@ void spdk_framework_enable_context_switch_monitor(bool enabled);
  */
 bool spdk_framework_context_switch_monitor_enabled(void);
 
+/**
+ * Function to be called once work stealing was enabled or disabled on all reactors.
+ *
+ * \param cb_arg Argument passed to spdk_framework_enable_work_stealing().
+ */
+typedef void (*spdk_framework_work_stealing_cb)(void *cb_arg);
+
+/**
+ * Enable or disable work stealing between reactors.
+ *
+ * When enabled, a reactor which found no work to do may poll a lightweight
+ * thread of a busy reactor once, provided that the thread's cpumask allows it.
+ * The thread stays assigned to its original reactor. Work stealing is not
+ * performed in interrupt mode.
+ *
+ * Each reactor switches in turn, so this may only be called from the application
+ * thread, and cb_fn is called there once all of them did.
+ *
+ * \param enabled True to enable, false to disable.
+ * \param cb_fn Function called when the switch is complete.
+ * \param cb_arg Argument to pass to cb_fn.
+ *
+ * \return 0 on success, -EPERM if not called from the application thread, or -EBUSY
+ * if a previous switch is still in progress.
+ */
+int spdk_framework_enable_work_stealing(bool enabled, spdk_framework_work_stealing_cb cb_fn,
+					void *cb_arg);
+
+/**
+ * Return whether work stealing between reactors is enabled.
+ *
+ * \return true if enabled or false otherwise.
+ */
+bool spdk_framework_work_stealing_enabled(void);
+
+/**
+ * Configure automatic switching of reactors between poll and interrupt mode.
+ *
+ * In hybrid mode, a polling reactor which did no work for idle_us microseconds
+ * switches to interrupt mode. A reactor in interrupt mode which is woken up
+ * wakeups times within idle_us microseconds switches back to poll mode. Each
+ * reactor decides on its own. Reactors stay in their current mode once hybrid
+ * mode is disabled.
+ *
+ * Hybrid mode requires the application to run with interrupt mode enabled, see
+ * spdk_interrupt_mode_enable().
+ *
+ * \param idle_us Idle time in microseconds before switching to interrupt mode.
+ * 0 disables hybrid mode.
+ * \param wakeups Number of wakeups within idle_us to switch back to poll mode.
+ *
+ * \return 0 on success, -EINVAL if wakeups is 0 or -ENOTSUP if interrupt mode
+ * is not enabled.
+ */
+int spdk_framework_set_hybrid_mode(uint32_t idle_us, uint32_t wakeups);
+
+/**
+ * Get the hybrid mode configuration.
+ *
+ * \param idle_us Idle time in microseconds before switching to interrupt mode,
+ * 0 if hybrid mode is disabled.
+ * \param wakeups Number of wakeups within idle_us to switch back to poll mode.
+ */
+void spdk_framework_get_hybrid_mode(uint32_t *idle_us, uint32_t *wakeups);
+
 #ifdef __cplusplus
 }
 #endif
@@ -58,9 +58,11 @@ struct spdk_nvmf_subsystem;
 struct spdk_nvmf_ctrlr;
 struct spdk_nvmf_qpair;
 struct spdk_nvmf_request;
+struct spdk_histogram_data;
 struct spdk_bdev;
 struct spdk_nvmf_request;
 struct spdk_nvmf_host;
+struct spdk_nvmf_qos_policy;
 struct spdk_nvmf_subsystem_listener;
 struct spdk_nvmf_poll_group;
 struct spdk_json_write_ctx;
@@ -128,6 +130,12 @@ struct spdk_nvmf_listen_opts {
 	size_t opts_size;
 
 	const struct spdk_json_val *transport_specific;
+
+	/**
+	 * Require a TLS secure channel on this listener. Only supported by the TCP transport,
+	 * which then accepts connections through the "ssl" socket implementation.
+	 */
+	bool secure_channel;
 };
 
 /**
@@ -606,6 +614,167 @@ struct spdk_nvmf_host *spdk_nvmf_subsystem_get_next_host(struct spdk_nvmf_subsys
  */
 const char *spdk_nvmf_host_get_nqn(const struct spdk_nvmf_host *host);
 
+/**
+ * QoS limits enforced by the target on the I/O commands matching a QoS policy.
+ * A value of 0 means that the corresponding limit is not enforced.
+ */
+struct spdk_nvmf_qos_limits {
+	/** I/O commands per second. */
+	uint64_t rw_ios_per_sec;
+
+	/** Megabytes of data transferred per second. */
+	uint64_t rw_mbytes_per_sec;
+
+	/** Maximum number of outstanding I/O commands. */
+	uint32_t max_queue_depth;
+};
+
+/**
+ * Set the QoS limits for the I/O sent by a host and/or to a namespace of a subsystem.
+ *
+ * The limits are enforced in the poll groups before the I/O is submitted to the bdev.
+ * An I/O command is accounted against at most two policies: the most specific policy
+ * matching its host NQN (host and namespace, then host only) and the most specific
+ * policy matching any host (namespace, then the whole subsystem). It is only submitted
+ * once both of them have quota left; otherwise it is queued until the next timeslice.
+ *
+ * Setting all the limits to 0 removes the policy.
+ *
+ * Must be called on the thread the subsystem was created on.
+ *
+ * \param subsystem Subsystem to modify.
+ * \param hostnqn NQN of the host the limits apply to, or NULL to apply them to all hosts.
+ * \param nsid ID of the namespace the limits apply to, or 0 to apply them to all namespaces.
+ * \param limits QoS limits to set.
+ *
+ * \return 0 on success, or negated errno value on failure.
+ */
+int spdk_nvmf_subsystem_set_qos_limits(struct spdk_nvmf_subsystem *subsystem,
+				       const char *hostnqn, uint32_t nsid,
+				       const struct spdk_nvmf_qos_limits *limits);
+
+/**
+ * Get the first QoS policy of a subsystem.
+ *
+ * \param subsystem Subsystem to query.
+ *
+ * \return first QoS policy of the subsystem, or NULL if no policy is set.
+ */
+struct spdk_nvmf_qos_policy *spdk_nvmf_subsystem_get_first_qos_policy(
+	struct spdk_nvmf_subsystem *subsystem);
+
+/**
+ * Get the next QoS policy of a subsystem.
+ *
+ * \param subsystem Subsystem to query.
+ * \param prev_policy Previous policy returned from this function.
+ *
+ * \return next QoS policy of the subsystem, or NULL if there are no more policies.
+ */
+struct spdk_nvmf_qos_policy *spdk_nvmf_subsystem_get_next_qos_policy(
+	struct spdk_nvmf_subsystem *subsystem,
+	struct spdk_nvmf_qos_policy *prev_policy);
+
+/**
+ * Get the host NQN a QoS policy applies to.
+ *
+ * \param policy QoS policy to query.
+ *
+ * \return NQN of the host, or NULL if the policy applies to all hosts.
+ */
+const char *spdk_nvmf_qos_policy_get_hostnqn(const struct spdk_nvmf_qos_policy *policy);
+
+/**
+ * Get the ID of the namespace a QoS policy applies to.
+ *
+ * \param policy QoS policy to query.
+ *
+ * \return ID of the namespace, or 0 if the policy applies to all namespaces.
+ */
+uint32_t spdk_nvmf_qos_policy_get_nsid(const struct spdk_nvmf_qos_policy *policy);
+
+/**
+ * Get the limits of a QoS policy.
+ *
+ * \param policy QoS policy to query.
+ * \param limits Output parameter for the limits.
+ */
+void spdk_nvmf_qos_policy_get_limits(const struct spdk_nvmf_qos_policy *policy,
+				     struct spdk_nvmf_qos_limits *limits);
+
+/**
+ * Stages of an I/O command for which the target collects latency histograms.
+ */
+enum spdk_nvmf_latency_type {
+	/**
+	 * From the arrival of the command capsule until its submission to the backend.
+	 * Includes any data transfer from the host and any time spent queued in the target.
+	 */
+	SPDK_NVMF_LATENCY_QUEUE = 0,
+
+	/** From the submission to the backend until the backend completes the command */
+	SPDK_NVMF_LATENCY_BACKEND,
+
+	/** From the completion by the backend until the response is handed to the transport */
+	SPDK_NVMF_LATENCY_RESPONSE,
+
+	/** From the arrival of the command capsule until the response is handed to the transport */
+	SPDK_NVMF_LATENCY_TOTAL,
+
+	SPDK_NVMF_LATENCY_NUM_TYPES,
+};
+
+typedef void (*spdk_nvmf_subsystem_histogram_status_cb)(void *cb_arg, int status);
+typedef void (*spdk_nvmf_subsystem_histogram_data_cb)(void *cb_arg, int status,
+		struct spdk_histogram_data **histograms);
+
+/**
+ * Enable or disable collecting I/O latency histograms on a subsystem.
+ *
+ * Latencies are measured in ticks. Disabling the histograms discards the data
+ * collected so far.
+ *
+ * \param subsystem Subsystem to change.
+ * \param cb_fn Callback function to be called when the histograms are enabled or disabled.
+ * \param cb_arg Argument to pass to cb_fn.
+ * \param enable Enable (true) or disable (false) the histograms.
+ */
+void spdk_nvmf_subsystem_histogram_enable(struct spdk_nvmf_subsystem *subsystem,
+		spdk_nvmf_subsystem_histogram_status_cb cb_fn,
+		void *cb_arg, bool enable);
+
+/**
+ * Check whether I/O latency histograms are enabled on a subsystem.
+ *
+ * \param subsystem Subsystem to query.
+ *
+ * \return true if the histograms are enabled, false otherwise.
+ */
+bool spdk_nvmf_subsystem_histogram_enabled(const struct spdk_nvmf_subsystem *subsystem);
+
+/**
+ * Get aggregated I/O latency histograms of a subsystem, one of its controllers or
+ * one of its queue pairs.
+ *
+ * The subsystem histograms include the I/O of the queue pairs that were
+ * disconnected since the histograms were enabled. The controller and queue pair
+ * histograms only include the queue pairs that are currently connected.
+ *
+ * \param subsystem Subsystem to query.
+ * \param cntlid Controller ID to aggregate, or 0 for all the controllers of the subsystem.
+ * \param qid Queue pair ID of the controller to aggregate, or -1 for all of its queue pairs.
+ * Ignored if cntlid is 0.
+ * \param histograms Array of SPDK_NVMF_LATENCY_NUM_TYPES histograms, indexed by
+ * enum spdk_nvmf_latency_type, to which the data is added. They must have been
+ * allocated with spdk_histogram_data_alloc().
+ * \param cb_fn Callback function to be called with the histograms.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void spdk_nvmf_subsystem_histogram_get(struct spdk_nvmf_subsystem *subsystem,
+				       uint16_t cntlid, int32_t qid,
+				       struct spdk_histogram_data **histograms,
+				       spdk_nvmf_subsystem_histogram_data_cb cb_fn, void *cb_arg);
+
 /**
  * Accept new connections on the address provided.
  *
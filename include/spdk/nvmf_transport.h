@@ -58,6 +58,8 @@
 
 #define SPDK_NVMF_DEFAULT_ACCEPT_POLL_RATE_US 10000
 
+struct spdk_nvmf_latency_histograms;
+
 union nvmf_h2c_msg {
 	struct spdk_nvmf_capsule_cmd			nvmf_cmd;
 	struct spdk_nvme_cmd				nvme_cmd;
@@ -122,6 +124,17 @@ struct spdk_nvmf_request {
 	struct spdk_bdev_io		*zcopy_bdev_io; /* Contains the bdev_io when using ZCOPY */
 	enum spdk_nvmf_zcopy_phase	zcopy_phase;
 
+	/* QoS policies (host and any host) this request is accounted against */
+	struct spdk_nvmf_qos_policy	*qos_policy[2];
+
+	/*
+	 * Tick counts at the stages of the request, only recorded while latency histograms
+	 * are enabled on the qpair. Transports may set recv_tsc when the command capsule
+	 * arrives, otherwise it is set when the request is executed.
+	 */
+	uint64_t			recv_tsc;
+	uint64_t			submit_tsc;
+
 	TAILQ_ENTRY(spdk_nvmf_request)	link;
 };
 
@@ -150,6 +163,9 @@ struct spdk_nvmf_qpair {
 
 	struct spdk_nvmf_request		*first_fused_req;
 
+	/* I/O latency histograms, NULL unless enabled on the subsystem */
+	struct spdk_nvmf_latency_histograms	*histograms;
+
 	TAILQ_HEAD(, spdk_nvmf_request)		outstanding;
 	TAILQ_ENTRY(spdk_nvmf_qpair)		link;
 };
@@ -112,6 +112,17 @@ struct spdk_governor {
 	 */
 	int (*get_core_capabilities)(uint32_t lcore_id, struct spdk_governor_capabilities *capabilities);
 
+	/**
+	 * Allow a given core to enter only the idle states which it can exit within the given
+	 * latency. Optional, may be NULL.
+	 *
+	 * \param lcore_id Core number.
+	 * \param latency_us Maximum exit latency in microseconds. UINT32_MAX allows all idle states.
+	 *
+	 * \return 0 on success, negative on error.
+	 */
+	int (*set_core_idle_latency)(uint32_t lcore_id, uint32_t latency_us);
+
 	/**
 	 * Initialize a governor.
 	 *
@@ -177,6 +188,8 @@ struct spdk_scheduler_thread_info {
 	struct spdk_thread_stats total_stats;
 	/* stats during the last scheduling period */
 	struct spdk_thread_stats current_stats;
+	/* NUMA node of the devices the thread does I/O to, or SPDK_ENV_SOCKET_ID_ANY */
+	int32_t numa_id;
 };
 
 /**
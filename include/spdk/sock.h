@@ -139,6 +139,54 @@ struct spdk_sock_impl_opts {
 	 * Enable or disable use of zero copy flow on send for client sockets. Used by posix socket module.
 	 */
 	bool enable_zerocopy_send_client;
+
+	/**
+	 * Let the kernel do TLS record encryption and decryption after the handshake,
+	 * if both OpenSSL and the kernel support it. Used by ssl socket module.
+	 */
+	bool enable_ktls;
+
+	/**
+	 * TLS 1.3 pre-shared key, as a hex string. Used by ssl socket module.
+	 */
+	char *psk_key;
+
+	/**
+	 * Identity of the TLS pre-shared key. Used by ssl socket module.
+	 */
+	char *psk_identity;
+
+	/**
+	 * Maximum rate, in bytes per second, at which each new socket sends data.
+	 * 0 means unlimited. See spdk_sock_set_send_rate(). Used by posix, ssl and
+	 * uring socket modules.
+	 */
+	uint64_t send_rate_limit;
+
+	/**
+	 * Number of bytes a rate limited socket may send back to back. 0 selects
+	 * 10 ms worth of send_rate_limit. Used by posix, ssl and uring socket modules.
+	 */
+	uint32_t send_burst_size;
+
+	/**
+	 * Time in microseconds each poll of a sock group busy polls the NAPI context of
+	 * its sockets, 0 to disable. Best combined with PLACEMENT_NAPI, so that all sockets
+	 * of a group share one NAPI context. Used by posix and ssl socket modules.
+	 */
+	uint32_t busy_poll_usecs;
+
+	/**
+	 * Number of buffers of the provided buffer ring each sock group shares between its
+	 * sockets to receive data. Must be a power of 2 between 8 and 32768, or 0 to poll each
+	 * socket and read into its receive pipe instead. Used by uring socket module.
+	 */
+	uint32_t recv_ring_buf_count;
+
+	/**
+	 * Size in bytes of each buffer of the provided buffer ring. Used by uring socket module.
+	 */
+	uint32_t recv_ring_buf_size;
 };
 
 /**
@@ -336,6 +384,34 @@ void spdk_sock_writev_async(struct spdk_sock *sock, struct spdk_sock_request *re
  */
 ssize_t spdk_sock_readv(struct spdk_sock *sock, struct iovec *iov, int iovcnt);
 
+/**
+ * Get a pointer to data received on the given socket, without copying it.
+ *
+ * The data stays in the socket's receive buffer and must be given back with
+ * spdk_sock_recv_return() before the socket is read again or closed. Only one buffer
+ * may be lent at a time. Requires the socket to buffer received data, see
+ * spdk_sock_set_recvbuf() and the `enable_recv_pipe` option.
+ *
+ * \param sock Socket to receive from.
+ * \param buf Set to the received data.
+ *
+ * \return the number of contiguous bytes at *buf on success, 0 if the connection was
+ * closed, -1 on failure with errno set. errno is EAGAIN if no data is available and
+ * ENOTSUP if the socket does not buffer received data.
+ */
+ssize_t spdk_sock_recv_lend(struct spdk_sock *sock, void **buf);
+
+/**
+ * Give back a buffer lent by spdk_sock_recv_lend(), consuming its first len bytes.
+ * The rest of the data is returned by the next receive on the socket.
+ *
+ * \param sock Socket the buffer was lent from.
+ * \param len Number of bytes consumed, not larger than the size of the lent buffer.
+ *
+ * \return 0 on success, -1 on failure with errno set.
+ */
+int spdk_sock_recv_return(struct spdk_sock *sock, size_t len);
+
 /**
  * Set the value used to specify the low water mark (in bytes) for this socket.
  *
@@ -366,6 +442,24 @@ int spdk_sock_set_recvbuf(struct spdk_sock *sock, int sz);
  */
 int spdk_sock_set_sendbuf(struct spdk_sock *sock, int sz);
 
+/**
+ * Limit the rate at which the given socket sends data.
+ *
+ * Requests queued with spdk_sock_writev_async() are held back once the socket has
+ * used up its token bucket, and are sent as the bucket refills. A socket in a group
+ * sends them when the group is polled. Otherwise they are sent by the next
+ * spdk_sock_flush() or spdk_sock_writev_async() after the bucket refilled. When
+ * supported, the kernel is also asked to pace the socket's packets at the same rate,
+ * so that a burst does not reach the wire at once.
+ *
+ * \param sock Socket to limit.
+ * \param rate Maximum rate in bytes per second, 0 to remove the limit.
+ * \param burst Size of the token bucket in bytes, 0 for 10 ms worth of rate.
+ *
+ * \return 0 on success, -1 on failure with errno set.
+ */
+int spdk_sock_set_send_rate(struct spdk_sock *sock, uint64_t rate, uint32_t burst);
+
 /**
  * Check whether the address of socket is ipv6.
  *
@@ -216,6 +216,19 @@ typedef void (*spdk_channel_for_each_cpl)(struct spdk_io_channel_iter *i, int st
 /* Power of 2 minus 1 is optimal for memory consumption */
 #define SPDK_DEFAULT_MSG_MEMPOOL_SIZE (262144 - 1)
 
+/* Maximum number of messages sent by a single spdk_thread_send_msg_batch() call */
+#define SPDK_THREAD_MSG_BATCH_MAX	64
+
+/* Number of NUMA nodes an I/O device can be bound to, see spdk_io_device_set_numa_id() */
+#define SPDK_THREAD_MAX_NUMA_NODES	64
+
+/* Number of buckets in the histogram of poller invocation cost, as reported by the
+ * thread_get_pollers RPC. Bucket 0 counts invocations shorter than
+ * 2^(SPDK_POLLER_TSC_HISTOGRAM_SHIFT + 1) ticks, each next bucket doubles the range
+ * and the last one also counts all longer invocations. */
+#define SPDK_POLLER_TSC_HISTOGRAM_BUCKETS	16
+#define SPDK_POLLER_TSC_HISTOGRAM_SHIFT		7
+
 /**
  * Initialize the threading library. Must be called once prior to allocating any threads.
  *
@@ -442,6 +455,20 @@ const char *spdk_thread_get_name(const struct spdk_thread *thread);
  */
 uint64_t spdk_thread_get_id(const struct spdk_thread *thread);
 
+/**
+ * Get the NUMA node a thread should preferably run on.
+ *
+ * This is the node of the devices behind most of the thread's I/O channels, as set by
+ * spdk_io_device_set_numa_id(). If several nodes have the same number of channels,
+ * the thread has no affinity. It must be called from the thread itself or from the
+ * reactor that is currently running it.
+ *
+ * \param thread Thread to query.
+ *
+ * \return the NUMA node ID or SPDK_ENV_SOCKET_ID_ANY if the thread has no device affinity.
+ */
+int32_t spdk_thread_get_numa_id(struct spdk_thread *thread);
+
 /**
  * Get the thread by the ID.
  *
@@ -489,6 +516,27 @@ uint64_t spdk_thread_get_last_tsc(struct spdk_thread *thread);
  */
 int spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx);
 
+/**
+ * Send multiple messages to the given thread.
+ *
+ * All messages are enqueued to the destination thread with a single ring operation and
+ * the thread is notified once, which is cheaper than calling spdk_thread_send_msg() for
+ * each of them. Messages are executed in the order of the ctxs array. Either all or none
+ * of the messages are sent.
+ *
+ * \param thread The target thread.
+ * \param fn This function will be called on the given thread for each context.
+ * \param ctxs Array of contexts, each passed to a separate call of fn.
+ * \param count Number of entries in ctxs. Must not exceed SPDK_THREAD_MSG_BATCH_MAX.
+ *
+ * \return 0 on success
+ * \return -EINVAL if count is too large
+ * \return -ENOMEM if the messages could not be allocated
+ * \return -EIO if the messages could not be sent to the destination thread
+ */
+int spdk_thread_send_msg_batch(const struct spdk_thread *thread, spdk_msg_fn fn, void **ctxs,
+			       uint32_t count);
+
 /**
  * Send a message to the given thread. Only one critical message can be outstanding at the same
  * time. It's intended to use this function in any cases that might interrupt the execution of the
@@ -660,6 +708,21 @@ void spdk_io_device_register(void *io_device, spdk_io_channel_create_cb create_c
  */
 void spdk_io_device_unregister(void *io_device, spdk_io_device_unregister_cb unregister_cb);
 
+/**
+ * Set the NUMA node of the hardware behind an I/O device.
+ *
+ * Schedulers use it to keep threads holding I/O channels to this device on the same node.
+ * I/O devices are not bound to any node by default.
+ *
+ * \param io_device The pointer to io_device context.
+ * \param numa_id NUMA node ID below SPDK_THREAD_MAX_NUMA_NODES, e.g. from
+ * spdk_pci_device_get_socket_id(), or SPDK_ENV_SOCKET_ID_ANY.
+ *
+ * \return 0 on success, -ENODEV if the io_device is not registered, -EINVAL if
+ * numa_id is out of range.
+ */
+int spdk_io_device_set_numa_id(void *io_device, int32_t numa_id);
+
 /**
  * Get an I/O channel for the specified io_device to be used by the calling thread.
  *
@@ -40,6 +40,9 @@
 #include "spdk/queue.h"
 
 struct spdk_accel_task;
+struct spdk_accel_sequence;
+struct sw_accel_comp_ctx;
+struct sw_accel_crypto_ctx;
 
 void spdk_accel_task_complete(struct spdk_accel_task *task, int status);
 
@@ -49,11 +52,25 @@ struct accel_io_channel {
 	struct spdk_io_channel		*sw_engine_ch;
 	void				*task_pool_base;
 	TAILQ_HEAD(, spdk_accel_task)	task_pool;
+	void				*seq_pool_base;
+	TAILQ_HEAD(, spdk_accel_sequence)	seq_pool;
 };
 
 struct sw_accel_io_channel {
 	struct spdk_poller		*completion_poller;
 	TAILQ_HEAD(, spdk_accel_task)	tasks_to_complete;
+	/* Compression stream state, allocated on first use */
+	struct sw_accel_comp_ctx	*comp_ctx;
+	/* Cipher state, allocated on first use */
+	struct sw_accel_crypto_ctx	*crypto_ctx;
+};
+
+struct spdk_accel_crypto_key {
+	uint8_t				key[SPDK_ACCEL_AES_XTS_256_KEY_SIZE];
+	uint8_t				key2[SPDK_ACCEL_AES_XTS_256_KEY_SIZE];
+	size_t				key_size;
+	/* Expanded key schedules of the software engine */
+	void				*priv;
 };
 
 struct spdk_accel_task {
@@ -65,22 +82,51 @@ struct spdk_accel_task {
 			struct iovec		*iovs; /* iovs passed by the caller */
 			uint32_t		iovcnt; /* iovcnt passed by the caller */
 		} v;
+		struct {
+			void		**srcs; /* sources passed by the caller */
+			uint32_t	cnt; /* number of sources */
+		} nsrcs;
+		struct {
+			void		**data;
+			void		**parity;
+			const uint32_t	*erased;
+			uint32_t	ndata;
+			uint32_t	nparity;
+			uint32_t	nerased;
+		} ec;
 		void				*src;
 	};
 	union {
 		void			*dst;
 		void			*src2;
+		struct {
+			struct iovec	*iovs;
+			uint32_t	iovcnt;
+		} d;
 	};
 	union {
 		void				*dst2;
 		uint32_t			seed;
 		uint64_t			fill_pattern;
+		uint32_t			*output_size;
+		struct {
+			struct spdk_accel_crypto_key	*key;
+			uint64_t			iv;
+			uint32_t			block_size;
+		} crypto;
 	};
 	uint32_t			*crc_dst;
 	enum accel_opcode		op_code;
 	uint64_t			nbytes;
 	int				flags;
 	int				status;
+	/* Sequence this task is a step of, NULL for a standalone operation */
+	struct spdk_accel_sequence	*seq;
+	spdk_accel_step_cb		step_cb_fn;
+	void				*step_cb_arg;
+	/* The work of this step is done by the previous step of the sequence */
+	bool				fused;
+	TAILQ_ENTRY(spdk_accel_task)	seq_link;
 	TAILQ_ENTRY(spdk_accel_task)	link;
 };
 
@@ -50,6 +50,10 @@ struct spdk_event {
 	spdk_event_fn		fn;
 	void			*arg1;
 	void			*arg2;
+
+	/* Enqueue time and source lcore, set only if latency tracking is enabled */
+	uint64_t		tsc;
+	uint32_t		src_lcore;
 };
 
 enum spdk_reactor_state {
@@ -65,6 +69,13 @@ struct spdk_lw_thread {
 	uint64_t			tsc_start;
 	uint32_t                        lcore;
 	bool				resched;
+	/* Set while a reactor polls this thread. Taken by the home reactor on every
+	 * iteration and by another reactor which stole the thread. */
+	bool				running;
+	/* Set while the thread is offered to, or being run by, another reactor */
+	bool				offered;
+	/* NUMA node of the thread's devices, only updated while no other reactor runs it */
+	int32_t				numa_id;
 	/* stats over a lifetime of a thread */
 	struct spdk_thread_stats	total_stats;
 	/* stats during the last scheduling period */
@@ -114,6 +125,25 @@ struct spdk_reactor {
 
 	struct spdk_fd_group				*fgrp;
 	int						resched_fd;
+
+	/* Lightweight thread offered to idle reactors when work stealing is enabled */
+	struct spdk_lw_thread				*steal_slot;
+	/* Only changed by this reactor, see spdk_framework_enable_work_stealing().
+	 * work_stealing allows offering and stealing threads, lw_thread_shared makes
+	 * the reactor acquire its threads before polling them. */
+	bool						work_stealing;
+	bool						lw_thread_shared;
+
+	/* Hybrid mode state. In poll mode, hybrid_tsc is the last time the reactor had work.
+	 * In interrupt mode, it is the start of the window the wakeups are counted in. */
+	uint64_t					hybrid_tsc;
+	uint64_t					hybrid_busy_tsc;
+	uint32_t					hybrid_wakeups;
+	bool						hybrid_in_interrupt;
+	bool						hybrid_switch_pending;
+
+	/* Queueing latency of the received events, allocated when the first one is recorded */
+	struct spdk_msg_latency_table			*event_latency;
 } __attribute__((aligned(SPDK_CACHE_LINE_SIZE)));
 
 int spdk_reactors_init(size_t msg_mempool_size);
@@ -70,6 +70,13 @@ struct spdk_sock {
 		uint8_t		closed		: 1;
 		uint8_t		reserved	: 7;
 	} flags;
+	/* Token bucket limiting the send rate, see spdk_sock_set_send_rate() */
+	struct {
+		uint64_t	rate;
+		uint64_t	burst;
+		uint64_t	tokens;
+		uint64_t	last_tsc;
+	} send_limit;
 };
 
 struct spdk_sock_group {
@@ -92,6 +99,8 @@ struct spdk_sock_map {
 struct spdk_net_impl {
 	const char *name;
 	int priority;
+	/* Only used when asked for by name, never when falling back through all implementations */
+	bool by_name_only;
 
 	int (*getaddr)(struct spdk_sock *sock, char *saddr, int slen, uint16_t *sport, char *caddr,
 		       int clen, uint16_t *cport);
@@ -102,6 +111,8 @@ struct spdk_net_impl {
 	ssize_t (*recv)(struct spdk_sock *sock, void *buf, size_t len);
 	ssize_t (*readv)(struct spdk_sock *sock, struct iovec *iov, int iovcnt);
 	ssize_t (*writev)(struct spdk_sock *sock, struct iovec *iov, int iovcnt);
+	ssize_t (*recv_lend)(struct spdk_sock *sock, void **buf);
+	int (*recv_return)(struct spdk_sock *sock, size_t len);
 
 	void (*writev_async)(struct spdk_sock *sock, struct spdk_sock_request *req);
 	int (*flush)(struct spdk_sock *sock);
@@ -109,6 +120,7 @@ struct spdk_net_impl {
 	int (*set_recvlowat)(struct spdk_sock *sock, int nbytes);
 	int (*set_recvbuf)(struct spdk_sock *sock, int sz);
 	int (*set_sendbuf)(struct spdk_sock *sock, int sz);
+	int (*set_pacing_rate)(struct spdk_sock *sock, uint64_t rate);
 
 	bool (*is_ipv6)(struct spdk_sock *sock);
 	bool (*is_ipv4)(struct spdk_sock *sock);
@@ -243,6 +255,23 @@ spdk_sock_abort_requests(struct spdk_sock *sock)
 	return rc;
 }
 
+/**
+ * Refill the send token bucket of a rate limited socket and return the number of
+ * bytes it may send now.
+ */
+uint64_t spdk_sock_send_budget(struct spdk_sock *sock);
+
+/**
+ * Take the bytes sent on the socket out of its send token bucket.
+ */
+static inline void
+spdk_sock_send_charge(struct spdk_sock *sock, size_t bytes)
+{
+	if (spdk_unlikely(sock->send_limit.rate != 0)) {
+		sock->send_limit.tokens -= bytes < sock->send_limit.tokens ? bytes : sock->send_limit.tokens;
+	}
+}
+
 static inline int
 spdk_sock_prep_reqs(struct spdk_sock *_sock, struct iovec *iovs, int index,
 		    struct spdk_sock_request **last_req)
@@ -250,6 +279,7 @@ spdk_sock_prep_reqs(struct spdk_sock *_sock, struct iovec *iovs, int index,
 	int iovcnt, i;
 	struct spdk_sock_request *req;
 	unsigned int offset;
+	uint64_t budget = UINT64_MAX;
 
 	/* Gather an iov */
 	iovcnt = index;
@@ -257,6 +287,13 @@ spdk_sock_prep_reqs(struct spdk_sock *_sock, struct iovec *iovs, int index,
 		goto end;
 	}
 
+	if (spdk_unlikely(_sock->send_limit.rate != 0)) {
+		budget = spdk_sock_send_budget(_sock);
+		if (budget == 0) {
+			goto end;
+		}
+	}
+
 	if (last_req != NULL && *last_req != NULL) {
 		req = TAILQ_NEXT(*last_req, internal.link);
 	} else {
@@ -275,6 +312,14 @@ spdk_sock_prep_reqs(struct spdk_sock *_sock, struct iovec *iovs, int index,
 
 			iovs[iovcnt].iov_base = SPDK_SOCK_REQUEST_IOV(req, i)->iov_base + offset;
 			iovs[iovcnt].iov_len = SPDK_SOCK_REQUEST_IOV(req, i)->iov_len - offset;
+
+			/* Stop at the end of the send budget */
+			if (spdk_unlikely(iovs[iovcnt].iov_len >= budget)) {
+				iovs[iovcnt].iov_len = budget;
+				iovcnt++;
+				goto end;
+			}
+			budget -= iovs[iovcnt].iov_len;
 			iovcnt++;
 
 			offset = 0;
@@ -42,6 +42,29 @@ struct spdk_poller;
 struct spdk_poller_stats {
 	uint64_t	run_count;
 	uint64_t	busy_count;
+	/* Ticks spent in the poller function */
+	uint64_t	tsc;
+	uint64_t	tsc_histogram[SPDK_POLLER_TSC_HISTOGRAM_BUCKETS];
+};
+
+/* Number of distinct (source, function) pairs tracked per message queue */
+#define SPDK_MSG_LATENCY_TABLE_SIZE		64
+
+/* Time messages of a single (source, function) pair spent waiting in a queue */
+struct spdk_msg_latency_stats {
+	/* Source thread ID for messages, source lcore for events */
+	uint64_t	src_id;
+	void		*fn;
+	uint64_t	count;
+	uint64_t	total_tsc;
+	uint64_t	max_tsc;
+};
+
+struct spdk_msg_latency_table {
+	uint64_t			generation;
+	/* Number of messages not accounted because the table was full */
+	uint64_t			dropped;
+	struct spdk_msg_latency_stats	entries[SPDK_MSG_LATENCY_TABLE_SIZE];
 };
 
 struct io_device;
@@ -68,4 +91,25 @@ struct spdk_poller *spdk_thread_get_next_paused_poller(struct spdk_poller *prev)
 struct spdk_io_channel *spdk_thread_get_first_io_channel(struct spdk_thread *thread);
 struct spdk_io_channel *spdk_thread_get_next_io_channel(struct spdk_io_channel *prev);
 
+/**
+ * Enable or disable stamping of messages and events with the time they were queued at.
+ * Enabling it also discards the latency statistics gathered so far.
+ */
+void spdk_msg_latency_tracking_enable(bool enable);
+bool spdk_msg_latency_tracking_is_enabled(void);
+
+/**
+ * Account wait_tsc ticks spent in a queue by a message from src_id calling fn. The
+ * table is allocated on first use and must be freed by the caller.
+ */
+void spdk_msg_latency_record(struct spdk_msg_latency_table **table, uint64_t src_id, void *fn,
+			     uint64_t wait_tsc);
+
+/**
+ * Get the message queueing latency statistics of the thread. Must be called from
+ * that thread. Returns NULL if nothing was recorded since tracking was enabled.
+ */
+const struct spdk_msg_latency_table *spdk_msg_latency_get(struct spdk_msg_latency_table *table);
+const struct spdk_msg_latency_table *spdk_thread_get_msg_latency(struct spdk_thread *thread);
+
 #endif /* SPDK_INTERNAL_THREAD_H_ */
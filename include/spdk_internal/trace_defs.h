@@ -120,6 +120,8 @@
 /* Thread tracepoint definitions */
 #define TRACE_THREAD_IOCH_GET		SPDK_TPOINT_ID(TRACE_GROUP_THREAD, 0x0)
 #define TRACE_THREAD_IOCH_PUT		SPDK_TPOINT_ID(TRACE_GROUP_THREAD, 0x1)
+#define TRACE_THREAD_MSG_WAIT		SPDK_TPOINT_ID(TRACE_GROUP_THREAD, 0x2)
+#define TRACE_THREAD_EVENT_WAIT		SPDK_TPOINT_ID(TRACE_GROUP_THREAD, 0x3)
 
 /* Blobfs tracepoint definitions */
 #define TRACE_BLOBFS_XATTR_START	SPDK_TPOINT_ID(TRACE_GROUP_BLOBFS, 0x0)
@@ -41,12 +41,22 @@
 #include "spdk/thread.h"
 #include "spdk/json.h"
 #include "spdk/crc32.h"
+#include "spdk/ec.h"
 #include "spdk/util.h"
+#include "spdk/xor.h"
 
 #ifdef SPDK_CONFIG_PMDK
 #include "libpmem.h"
 #endif
 
+#ifdef SPDK_CONFIG_ISAL
+#include "isa-l/include/igzip_lib.h"
+#endif
+
+#ifdef SPDK_CONFIG_IPSEC_MB
+#include <intel-ipsec-mb.h>
+#endif
+
 /* Accelerator Engine Framework: The following provides a top level
  * generic API for the accelerator functions defined here. Modules,
  * such as the one in /module/accel/ioat, supply the implementation
@@ -56,6 +66,18 @@
 
 #define ALIGN_4K			0x1000
 #define MAX_TASKS_PER_CHANNEL		0x800
+#define MAX_SEQUENCES_PER_CHANNEL	0x800
+/* Amount of data copied before it is checksummed, small enough to still be in cache */
+#define SW_COPY_CRC32C_CHUNK_SIZE	0x2000
+#define SPDK_ACCEL_AES_BLOCK_SIZE	16
+
+struct spdk_accel_sequence {
+	struct accel_io_channel			*ch;
+	TAILQ_HEAD(, spdk_accel_task)		tasks;
+	spdk_accel_completion_cb		cb_fn;
+	void					*cb_arg;
+	TAILQ_ENTRY(spdk_accel_sequence)	link;
+};
 
 /* Largest context size for all accel modules */
 static size_t g_max_accel_module_size = 0;
@@ -77,6 +99,17 @@ static int _sw_accel_compare(void *src1, void *src2, size_t nbytes);
 static void _sw_accel_fill(void *dst, uint8_t fill, size_t nbytes, int flags);
 static void _sw_accel_crc32c(uint32_t *dst, void *src, uint32_t seed, size_t nbytes);
 static void _sw_accel_crc32cv(uint32_t *dst, struct iovec *iov, uint32_t iovcnt, uint32_t seed);
+static void _sw_accel_copy_crc32c(void *dst, void *src, uint32_t *crc_dst, uint32_t seed,
+				  uint64_t nbytes, int flags);
+static bool _sw_accel_supports_compression(void);
+static int _sw_accel_compress(struct spdk_accel_task *accel_task);
+static int _sw_accel_decompress(struct spdk_accel_task *accel_task);
+static bool _sw_accel_supports_crypto(void);
+static int _sw_accel_crypto_key_init(struct spdk_accel_crypto_key *key);
+static void _sw_accel_crypto_key_fini(struct spdk_accel_crypto_key *key);
+static int _sw_accel_crypt(struct spdk_accel_task *accel_task);
+static int sw_accel_execute(struct spdk_accel_task *accel_task);
+static void accel_sequence_task_complete(struct spdk_accel_task *accel_task, int status);
 
 /* Registration of hw modules (currently supports only 1 at a time) */
 void
@@ -119,6 +152,11 @@ spdk_accel_task_complete(struct spdk_accel_task *accel_task, int status)
 	spdk_accel_completion_cb	cb_fn = accel_task->cb_fn;
 	void				*cb_arg = accel_task->cb_arg;
 
+	if (accel_task->seq != NULL) {
+		accel_sequence_task_complete(accel_task, status);
+		return;
+	}
+
 	/* We should put the accel_task into the list firstly in order to avoid
 	 * the accel task list is exhausted when there is recursive call to
 	 * allocate accel_task in user's call back function (cb_fn)
@@ -145,6 +183,8 @@ _get_task(struct accel_io_channel *accel_ch, spdk_accel_completion_cb cb_fn, voi
 	accel_task->cb_fn = cb_fn;
 	accel_task->cb_arg = cb_arg;
 	accel_task->accel_ch = accel_ch;
+	accel_task->seq = NULL;
+	accel_task->fused = false;
 
 	return accel_task;
 }
@@ -408,8 +448,7 @@ spdk_accel_submit_copy_crc32c(struct spdk_io_channel *ch, void *dst, void *src,
 		if (rc) {
 			return rc;
 		}
-		_sw_accel_copy(dst, src, (size_t)nbytes, flags);
-		_sw_accel_crc32c(crc_dst, src, seed, (size_t)nbytes);
+		_sw_accel_copy_crc32c(dst, src, crc_dst, seed, nbytes, flags);
 		_add_to_comp_list(accel_ch, accel_task, 0);
 		return 0;
 	}
@@ -465,216 +504,1071 @@ spdk_accel_submit_copy_crc32cv(struct spdk_io_channel *ch, void *dst, struct iov
 	}
 }
 
-/* Helper function when when accel modules register with the framework. */
-void spdk_accel_module_list_add(struct spdk_accel_module_if *accel_module)
-{
-	TAILQ_INSERT_TAIL(&spdk_accel_module_list, accel_module, tailq);
-	if (accel_module->get_ctx_size && accel_module->get_ctx_size() > g_max_accel_module_size) {
-		g_max_accel_module_size = accel_module->get_ctx_size();
-	}
-}
-
-/* Framework level channel create callback. */
-static int
-accel_engine_create_cb(void *io_device, void *ctx_buf)
+/* Accel framework public API for XOR function */
+int
+spdk_accel_submit_xor(struct spdk_io_channel *ch, void *dst, void **sources, uint32_t nsrcs,
+		      uint64_t nbytes, spdk_accel_completion_cb cb_fn, void *cb_arg)
 {
-	struct accel_io_channel	*accel_ch = ctx_buf;
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
 	struct spdk_accel_task *accel_task;
-	uint8_t *task_mem;
-	int i;
+	int rc;
 
-	accel_ch->task_pool_base = calloc(MAX_TASKS_PER_CHANNEL, g_max_accel_module_size);
-	if (accel_ch->task_pool_base == NULL) {
-		return -ENOMEM;
+	if (sources == NULL || nsrcs < 2) {
+		SPDK_ERRLOG("XOR requires at least 2 sources\n");
+		return -EINVAL;
 	}
 
-	TAILQ_INIT(&accel_ch->task_pool);
-	task_mem = accel_ch->task_pool_base;
-	for (i = 0 ; i < MAX_TASKS_PER_CHANNEL; i++) {
-		accel_task = (struct spdk_accel_task *)task_mem;
-		TAILQ_INSERT_TAIL(&accel_ch->task_pool, accel_task, link);
-		task_mem += g_max_accel_module_size;
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
 	}
 
-	/* Set sw engine channel for operations where hw engine does not support. */
-	accel_ch->sw_engine_ch = g_sw_accel_engine->get_io_channel();
-	assert(accel_ch->sw_engine_ch != NULL);
+	accel_task->dst = dst;
+	accel_task->nsrcs.srcs = sources;
+	accel_task->nsrcs.cnt = nsrcs;
+	accel_task->nbytes = nbytes;
+	accel_task->op_code = ACCEL_OPC_XOR;
 
-	if (g_hw_accel_engine != NULL) {
-		accel_ch->engine_ch = g_hw_accel_engine->get_io_channel();
-		accel_ch->engine = g_hw_accel_engine;
+	if (_is_supported(accel_ch->engine, ACCEL_OPC_XOR)) {
+		return accel_ch->engine->submit_tasks(accel_ch->engine_ch, accel_task);
 	} else {
-		/* No hw engine enabled, use sw. */
-		accel_ch->engine_ch = accel_ch->sw_engine_ch;
-		accel_ch->engine = g_sw_accel_engine;
+		rc = spdk_xor_gen(dst, sources, nsrcs, (size_t)nbytes);
+		_add_to_comp_list(accel_ch, accel_task, rc);
+		return 0;
 	}
-	assert(accel_ch->engine_ch != NULL);
-
-	return 0;
 }
 
-/* Framework level channel destroy callback. */
-static void
-accel_engine_destroy_cb(void *io_device, void *ctx_buf)
+/* Accel framework public API for erasure code encode function */
+int
+spdk_accel_submit_ec_encode(struct spdk_io_channel *ch, void **data, uint32_t ndata,
+			    void **parity, uint32_t nparity, uint64_t nbytes,
+			    spdk_accel_completion_cb cb_fn, void *cb_arg)
 {
-	struct accel_io_channel	*accel_ch = ctx_buf;
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+	int rc;
 
-	if (accel_ch->sw_engine_ch != accel_ch->engine_ch) {
-		spdk_put_io_channel(accel_ch->sw_engine_ch);
+	if (ndata == 0 || ndata > SPDK_EC_MAX_DATA_BUFS ||
+	    nparity == 0 || nparity > SPDK_EC_MAX_PARITY_BUFS) {
+		SPDK_ERRLOG("Unsupported stripe of %u data and %u parity buffers\n", ndata, nparity);
+		return -EINVAL;
 	}
-	spdk_put_io_channel(accel_ch->engine_ch);
-	free(accel_ch->task_pool_base);
-}
 
-struct spdk_io_channel *
-spdk_accel_engine_get_io_channel(void)
-{
-	return spdk_get_io_channel(&spdk_accel_module_list);
-}
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
 
-static void
-accel_engine_module_initialize(void)
-{
-	struct spdk_accel_module_if *accel_engine_module;
+	accel_task->ec.data = data;
+	accel_task->ec.ndata = ndata;
+	accel_task->ec.parity = parity;
+	accel_task->ec.nparity = nparity;
+	accel_task->ec.erased = NULL;
+	accel_task->ec.nerased = 0;
+	accel_task->nbytes = nbytes;
+	accel_task->op_code = ACCEL_OPC_EC_ENCODE;
 
-	TAILQ_FOREACH(accel_engine_module, &spdk_accel_module_list, tailq) {
-		accel_engine_module->module_init();
+	if (_is_supported(accel_ch->engine, ACCEL_OPC_EC_ENCODE)) {
+		return accel_ch->engine->submit_tasks(accel_ch->engine_ch, accel_task);
+	} else {
+		rc = spdk_ec_encode(data, ndata, parity, nparity, (size_t)nbytes);
+		_add_to_comp_list(accel_ch, accel_task, rc);
+		return 0;
 	}
 }
 
+/* Accel framework public API for erasure code decode function */
 int
-spdk_accel_engine_initialize(void)
+spdk_accel_submit_ec_decode(struct spdk_io_channel *ch, void **data, uint32_t ndata,
+			    void **parity, uint32_t nparity, const uint32_t *erased,
+			    uint32_t nerased, uint64_t nbytes,
+			    spdk_accel_completion_cb cb_fn, void *cb_arg)
 {
-	SPDK_NOTICELOG("Accel engine initialized to use software engine.\n");
-	accel_engine_module_initialize();
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+	int rc;
 
-	/*
-	 * We need a unique identifier for the accel engine framework, so use the
-	 *  spdk_accel_module_list address for this purpose.
-	 */
-	spdk_io_device_register(&spdk_accel_module_list, accel_engine_create_cb, accel_engine_destroy_cb,
-				sizeof(struct accel_io_channel), "accel_module");
+	if (ndata == 0 || ndata > SPDK_EC_MAX_DATA_BUFS ||
+	    nparity == 0 || nparity > SPDK_EC_MAX_PARITY_BUFS) {
+		SPDK_ERRLOG("Unsupported stripe of %u data and %u parity buffers\n", ndata, nparity);
+		return -EINVAL;
+	}
 
-	return 0;
+	if (erased == NULL || nerased == 0 || nerased > nparity) {
+		SPDK_ERRLOG("Cannot reconstruct %u buffers with %u parity buffers\n", nerased, nparity);
+		return -EINVAL;
+	}
+
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
+
+	accel_task->ec.data = data;
+	accel_task->ec.ndata = ndata;
+	accel_task->ec.parity = parity;
+	accel_task->ec.nparity = nparity;
+	accel_task->ec.erased = erased;
+	accel_task->ec.nerased = nerased;
+	accel_task->nbytes = nbytes;
+	accel_task->op_code = ACCEL_OPC_EC_DECODE;
+
+	if (_is_supported(accel_ch->engine, ACCEL_OPC_EC_DECODE)) {
+		return accel_ch->engine->submit_tasks(accel_ch->engine_ch, accel_task);
+	} else {
+		rc = spdk_ec_decode(data, ndata, parity, nparity, erased, nerased, (size_t)nbytes);
+		_add_to_comp_list(accel_ch, accel_task, rc);
+		return 0;
+	}
 }
 
-static void
-accel_engine_module_finish_cb(void)
+static int
+_check_comp_iovs(struct iovec *dst_iovs, uint32_t dst_iovcnt, struct iovec *src_iovs,
+		 uint32_t src_iovcnt)
 {
-	spdk_accel_fini_cb cb_fn = g_fini_cb_fn;
+	if (dst_iovs == NULL || dst_iovcnt == 0 || src_iovs == NULL || src_iovcnt == 0) {
+		SPDK_ERRLOG("Source and destination buffers are required\n");
+		return -EINVAL;
+	}
 
-	cb_fn(g_fini_cb_arg);
-	g_fini_cb_fn = NULL;
-	g_fini_cb_arg = NULL;
+	return 0;
 }
 
-void
-spdk_accel_write_config_json(struct spdk_json_write_ctx *w)
+/* Accel framework public API for compress function */
+int
+spdk_accel_submit_compress(struct spdk_io_channel *ch, struct iovec *dst_iovs,
+			   uint32_t dst_iovcnt, struct iovec *src_iovs, uint32_t src_iovcnt,
+			   uint32_t *output_size, spdk_accel_completion_cb cb_fn, void *cb_arg)
 {
-	struct spdk_accel_module_if *accel_engine_module;
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+	int rc;
 
-	/*
-	 * The accel fw has no config, there may be some in
-	 * the engines/modules though.
-	 */
-	spdk_json_write_array_begin(w);
-	TAILQ_FOREACH(accel_engine_module, &spdk_accel_module_list, tailq) {
-		if (accel_engine_module->write_config_json) {
-			accel_engine_module->write_config_json(w);
-		}
+	rc = _check_comp_iovs(dst_iovs, dst_iovcnt, src_iovs, src_iovcnt);
+	if (rc != 0) {
+		return rc;
 	}
-	spdk_json_write_array_end(w);
-}
 
-void
-spdk_accel_engine_module_finish(void)
-{
-	if (!g_accel_engine_module) {
-		g_accel_engine_module = TAILQ_FIRST(&spdk_accel_module_list);
-	} else {
-		g_accel_engine_module = TAILQ_NEXT(g_accel_engine_module, tailq);
+	if (output_size == NULL) {
+		return -EINVAL;
 	}
 
-	if (!g_accel_engine_module) {
-		accel_engine_module_finish_cb();
-		return;
+	if (!_is_supported(accel_ch->engine, ACCEL_OPC_COMPRESS) &&
+	    !_sw_accel_supports_compression()) {
+		return -ENOTSUP;
 	}
 
-	if (g_accel_engine_module->module_fini) {
-		spdk_thread_send_msg(spdk_get_thread(), g_accel_engine_module->module_fini, NULL);
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
+
+	accel_task->v.iovs = src_iovs;
+	accel_task->v.iovcnt = src_iovcnt;
+	accel_task->d.iovs = dst_iovs;
+	accel_task->d.iovcnt = dst_iovcnt;
+	accel_task->output_size = output_size;
+	accel_task->op_code = ACCEL_OPC_COMPRESS;
+
+	if (_is_supported(accel_ch->engine, ACCEL_OPC_COMPRESS)) {
+		return accel_ch->engine->submit_tasks(accel_ch->engine_ch, accel_task);
 	} else {
-		spdk_accel_engine_module_finish();
+		rc = _sw_accel_compress(accel_task);
+		_add_to_comp_list(accel_ch, accel_task, rc);
+		return 0;
 	}
 }
 
-void
-spdk_accel_engine_finish(spdk_accel_fini_cb cb_fn, void *cb_arg)
+/* Accel framework public API for decompress function */
+int
+spdk_accel_submit_decompress(struct spdk_io_channel *ch, struct iovec *dst_iovs,
+			     uint32_t dst_iovcnt, struct iovec *src_iovs, uint32_t src_iovcnt,
+			     uint32_t *output_size, spdk_accel_completion_cb cb_fn, void *cb_arg)
 {
-	assert(cb_fn != NULL);
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+	int rc;
 
-	g_fini_cb_fn = cb_fn;
-	g_fini_cb_arg = cb_arg;
+	rc = _check_comp_iovs(dst_iovs, dst_iovcnt, src_iovs, src_iovcnt);
+	if (rc != 0) {
+		return rc;
+	}
 
-	spdk_io_device_unregister(&spdk_accel_module_list, NULL);
-	spdk_accel_engine_module_finish();
-}
+	if (!_is_supported(accel_ch->engine, ACCEL_OPC_DECOMPRESS) &&
+	    !_sw_accel_supports_compression()) {
+		return -ENOTSUP;
+	}
 
-/*
- * The SW Accelerator module is "built in" here (rest of file)
- */
-static bool
-sw_accel_supports_opcode(enum accel_opcode opc)
-{
-	return false;
-}
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
 
-static inline void
-_pmem_memcpy(void *dst, const void *src, size_t len)
-{
-#ifdef SPDK_CONFIG_PMDK
-	int is_pmem = pmem_is_pmem(dst, len);
+	accel_task->v.iovs = src_iovs;
+	accel_task->v.iovcnt = src_iovcnt;
+	accel_task->d.iovs = dst_iovs;
+	accel_task->d.iovcnt = dst_iovcnt;
+	accel_task->output_size = output_size;
+	accel_task->op_code = ACCEL_OPC_DECOMPRESS;
 
-	if (is_pmem) {
-		pmem_memcpy_persist(dst, src, len);
+	if (_is_supported(accel_ch->engine, ACCEL_OPC_DECOMPRESS)) {
+		return accel_ch->engine->submit_tasks(accel_ch->engine_ch, accel_task);
 	} else {
-		memcpy(dst, src, len);
-		pmem_msync(dst, len);
+		rc = _sw_accel_decompress(accel_task);
+		_add_to_comp_list(accel_ch, accel_task, rc);
+		return 0;
 	}
-#else
-	SPDK_ERRLOG("Function not defined without SPDK_CONFIG_PMDK enabled.\n");
-	assert(0);
-#endif
 }
 
-static void
-_sw_accel_dualcast(void *dst1, void *dst2, void *src, size_t nbytes, int flags)
+int
+spdk_accel_crypto_key_create(const void *key, const void *key2, size_t key_size,
+			     struct spdk_accel_crypto_key **_key)
 {
-	if (flags & ACCEL_FLAG_PERSISTENT) {
-		_pmem_memcpy(dst1, src, nbytes);
-		_pmem_memcpy(dst2, src, nbytes);
-	} else {
-		memcpy(dst1, src, nbytes);
-		memcpy(dst2, src, nbytes);
+	struct spdk_accel_crypto_key *crypto_key;
+	int rc;
+
+	if (key == NULL || key2 == NULL || _key == NULL) {
+		return -EINVAL;
 	}
-}
 
-static void
-_sw_accel_copy(void *dst, void *src, size_t nbytes, int flags)
-{
+	if (key_size != SPDK_ACCEL_AES_XTS_128_KEY_SIZE &&
+	    key_size != SPDK_ACCEL_AES_XTS_256_KEY_SIZE) {
+		SPDK_ERRLOG("Unsupported AES-XTS key size %zu\n", key_size);
+		return -EINVAL;
+	}
 
-	if (flags & ACCEL_FLAG_PERSISTENT) {
-		_pmem_memcpy(dst, src, nbytes);
-	} else {
-		memcpy(dst, src, nbytes);
+	/* IEEE 1619 requires the two keys to be independent */
+	if (memcmp(key, key2, key_size) == 0) {
+		SPDK_ERRLOG("The data and tweak keys of an AES-XTS key must differ\n");
+		return -EINVAL;
 	}
+
+	crypto_key = calloc(1, sizeof(*crypto_key));
+	if (crypto_key == NULL) {
+		return -ENOMEM;
+	}
+
+	memcpy(crypto_key->key, key, key_size);
+	memcpy(crypto_key->key2, key2, key_size);
+	crypto_key->key_size = key_size;
+
+	rc = _sw_accel_crypto_key_init(crypto_key);
+	if (rc != 0) {
+		spdk_accel_crypto_key_destroy(crypto_key);
+		return rc;
+	}
+
+	*_key = crypto_key;
+
+	return 0;
 }
 
-static void
-_sw_accel_copyv(void *dst, struct iovec *iov, uint32_t iovcnt, int flags)
+void
+spdk_accel_crypto_key_destroy(struct spdk_accel_crypto_key *key)
 {
-	uint32_t i;
+	if (key == NULL) {
+		return;
+	}
 
-	for (i = 0; i < iovcnt; i++) {
+	_sw_accel_crypto_key_fini(key);
+	explicit_bzero(key, sizeof(*key));
+	free(key);
+}
+
+static int
+_check_crypto_args(struct spdk_accel_crypto_key *key, struct iovec *dst_iovs,
+		   uint32_t dst_iovcnt, struct iovec *src_iovs, uint32_t src_iovcnt,
+		   uint32_t block_size)
+{
+	uint64_t src_len = 0, dst_len = 0;
+	uint32_t i;
+	int rc;
+
+	rc = _check_comp_iovs(dst_iovs, dst_iovcnt, src_iovs, src_iovcnt);
+	if (rc != 0) {
+		return rc;
+	}
+
+	if (key == NULL || block_size == 0 || block_size % SPDK_ACCEL_AES_BLOCK_SIZE != 0) {
+		return -EINVAL;
+	}
+
+	/* Keeping every AES block within a single buffer lets the engines cipher buffers whole */
+	for (i = 0; i < src_iovcnt; i++) {
+		if (src_iovs[i].iov_len % SPDK_ACCEL_AES_BLOCK_SIZE != 0) {
+			return -EINVAL;
+		}
+		src_len += src_iovs[i].iov_len;
+	}
+
+	for (i = 0; i < dst_iovcnt; i++) {
+		if (dst_iovs[i].iov_len % SPDK_ACCEL_AES_BLOCK_SIZE != 0) {
+			return -EINVAL;
+		}
+		dst_len += dst_iovs[i].iov_len;
+	}
+
+	if (src_len == 0 || src_len % block_size != 0 || dst_len < src_len) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int
+_accel_submit_crypt(struct spdk_io_channel *ch, enum accel_opcode op_code,
+		    struct spdk_accel_crypto_key *key, struct iovec *dst_iovs, uint32_t dst_iovcnt,
+		    struct iovec *src_iovs, uint32_t src_iovcnt, uint64_t iv, uint32_t block_size,
+		    spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+	int rc;
+
+	rc = _check_crypto_args(key, dst_iovs, dst_iovcnt, src_iovs, src_iovcnt, block_size);
+	if (rc != 0) {
+		return rc;
+	}
+
+	if (!_is_supported(accel_ch->engine, op_code) && !_sw_accel_supports_crypto()) {
+		return -ENOTSUP;
+	}
+
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
+
+	accel_task->v.iovs = src_iovs;
+	accel_task->v.iovcnt = src_iovcnt;
+	accel_task->d.iovs = dst_iovs;
+	accel_task->d.iovcnt = dst_iovcnt;
+	accel_task->crypto.key = key;
+	accel_task->crypto.iv = iv;
+	accel_task->crypto.block_size = block_size;
+	accel_task->op_code = op_code;
+
+	if (_is_supported(accel_ch->engine, op_code)) {
+		return accel_ch->engine->submit_tasks(accel_ch->engine_ch, accel_task);
+	} else {
+		rc = _sw_accel_crypt(accel_task);
+		_add_to_comp_list(accel_ch, accel_task, rc);
+		return 0;
+	}
+}
+
+/* Accel framework public API for encrypt function */
+int
+spdk_accel_submit_encrypt(struct spdk_io_channel *ch, struct spdk_accel_crypto_key *key,
+			  struct iovec *dst_iovs, uint32_t dst_iovcnt,
+			  struct iovec *src_iovs, uint32_t src_iovcnt,
+			  uint64_t iv, uint32_t block_size,
+			  spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	return _accel_submit_crypt(ch, ACCEL_OPC_ENCRYPT, key, dst_iovs, dst_iovcnt, src_iovs,
+				   src_iovcnt, iv, block_size, cb_fn, cb_arg);
+}
+
+/* Accel framework public API for decrypt function */
+int
+spdk_accel_submit_decrypt(struct spdk_io_channel *ch, struct spdk_accel_crypto_key *key,
+			  struct iovec *dst_iovs, uint32_t dst_iovcnt,
+			  struct iovec *src_iovs, uint32_t src_iovcnt,
+			  uint64_t iv, uint32_t block_size,
+			  spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	return _accel_submit_crypt(ch, ACCEL_OPC_DECRYPT, key, dst_iovs, dst_iovcnt, src_iovs,
+				   src_iovcnt, iv, block_size, cb_fn, cb_arg);
+}
+
+static struct spdk_accel_task *
+accel_sequence_get_task(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_sequence *seq = *pseq;
+	struct spdk_accel_task *accel_task;
+
+	if (seq == NULL) {
+		seq = TAILQ_FIRST(&accel_ch->seq_pool);
+		if (seq == NULL) {
+			return NULL;
+		}
+	} else if (seq->ch != accel_ch) {
+		SPDK_ERRLOG("All steps of a sequence must use the same channel\n");
+		return NULL;
+	}
+
+	accel_task = _get_task(accel_ch, NULL, NULL);
+	if (accel_task == NULL) {
+		return NULL;
+	}
+
+	if (*pseq == NULL) {
+		TAILQ_REMOVE(&accel_ch->seq_pool, seq, link);
+		TAILQ_INIT(&seq->tasks);
+		seq->ch = accel_ch;
+		seq->cb_fn = NULL;
+		seq->cb_arg = NULL;
+		*pseq = seq;
+	}
+
+	accel_task->seq = seq;
+	accel_task->step_cb_fn = cb_fn;
+	accel_task->step_cb_arg = cb_arg;
+	TAILQ_INSERT_TAIL(&seq->tasks, accel_task, seq_link);
+
+	return accel_task;
+}
+
+/* Accel framework public API for appending a copy to a sequence */
+int
+spdk_accel_append_copy(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+		       void *dst, void *src, uint64_t nbytes, int flags,
+		       spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct spdk_accel_task *accel_task;
+
+	accel_task = accel_sequence_get_task(pseq, ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
+
+	accel_task->dst = dst;
+	accel_task->src = src;
+	accel_task->v.iovcnt = 0;
+	accel_task->nbytes = nbytes;
+	accel_task->flags = flags;
+	accel_task->op_code = ACCEL_OPC_COPY;
+
+	return 0;
+}
+
+/* Accel framework public API for appending a fill to a sequence */
+int
+spdk_accel_append_fill(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+		       void *dst, uint8_t fill, uint64_t nbytes, int flags,
+		       spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct spdk_accel_task *accel_task;
+
+	accel_task = accel_sequence_get_task(pseq, ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
+
+	accel_task->dst = dst;
+	memset(&accel_task->fill_pattern, fill, sizeof(uint64_t));
+	accel_task->nbytes = nbytes;
+	accel_task->flags = flags;
+	accel_task->op_code = ACCEL_OPC_FILL;
+
+	return 0;
+}
+
+/* Accel framework public API for appending a compare to a sequence */
+int
+spdk_accel_append_compare(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			  void *src1, void *src2, uint64_t nbytes,
+			  spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct spdk_accel_task *accel_task;
+
+	accel_task = accel_sequence_get_task(pseq, ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
+
+	accel_task->src = src1;
+	accel_task->src2 = src2;
+	accel_task->nbytes = nbytes;
+	accel_task->op_code = ACCEL_OPC_COMPARE;
+
+	return 0;
+}
+
+/* Accel framework public API for appending a CRC-32C to a sequence */
+int
+spdk_accel_append_crc32c(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			 uint32_t *crc_dst, void *src, uint32_t seed, uint64_t nbytes,
+			 spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct spdk_accel_task *accel_task;
+
+	accel_task = accel_sequence_get_task(pseq, ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
+
+	accel_task->crc_dst = crc_dst;
+	accel_task->src = src;
+	accel_task->v.iovcnt = 0;
+	accel_task->seed = seed;
+	accel_task->nbytes = nbytes;
+	accel_task->op_code = ACCEL_OPC_CRC32C;
+
+	return 0;
+}
+
+/* Accel framework public API for appending a chained CRC-32C to a sequence */
+int
+spdk_accel_append_crc32cv(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			  uint32_t *crc_dst, struct iovec *iov, uint32_t iov_cnt, uint32_t seed,
+			  spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct spdk_accel_task *accel_task;
+
+	if (iov == NULL || iov_cnt == 0) {
+		SPDK_ERRLOG("iov should not be NULL or empty\n");
+		return -EINVAL;
+	}
+
+	accel_task = accel_sequence_get_task(pseq, ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
+
+	accel_task->v.iovs = iov;
+	accel_task->v.iovcnt = iov_cnt;
+	accel_task->crc_dst = crc_dst;
+	accel_task->seed = seed;
+	accel_task->op_code = ACCEL_OPC_CRC32C;
+
+	return 0;
+}
+
+static int
+_accel_append_comp(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+		   enum accel_opcode op_code, struct iovec *dst_iovs, uint32_t dst_iovcnt,
+		   struct iovec *src_iovs, uint32_t src_iovcnt, uint32_t *output_size,
+		   spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+	int rc;
+
+	rc = _check_comp_iovs(dst_iovs, dst_iovcnt, src_iovs, src_iovcnt);
+	if (rc != 0) {
+		return rc;
+	}
+
+	if (!_is_supported(accel_ch->engine, op_code) && !_sw_accel_supports_compression()) {
+		return -ENOTSUP;
+	}
+
+	accel_task = accel_sequence_get_task(pseq, ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
+
+	accel_task->v.iovs = src_iovs;
+	accel_task->v.iovcnt = src_iovcnt;
+	accel_task->d.iovs = dst_iovs;
+	accel_task->d.iovcnt = dst_iovcnt;
+	accel_task->output_size = output_size;
+	accel_task->op_code = op_code;
+
+	return 0;
+}
+
+/* Accel framework public API for appending a compression to a sequence */
+int
+spdk_accel_append_compress(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			   struct iovec *dst_iovs, uint32_t dst_iovcnt,
+			   struct iovec *src_iovs, uint32_t src_iovcnt,
+			   uint32_t *output_size, spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	if (output_size == NULL) {
+		return -EINVAL;
+	}
+
+	return _accel_append_comp(pseq, ch, ACCEL_OPC_COMPRESS, dst_iovs, dst_iovcnt, src_iovs,
+				  src_iovcnt, output_size, cb_fn, cb_arg);
+}
+
+/* Accel framework public API for appending a decompression to a sequence */
+int
+spdk_accel_append_decompress(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			     struct iovec *dst_iovs, uint32_t dst_iovcnt,
+			     struct iovec *src_iovs, uint32_t src_iovcnt,
+			     uint32_t *output_size, spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	return _accel_append_comp(pseq, ch, ACCEL_OPC_DECOMPRESS, dst_iovs, dst_iovcnt, src_iovs,
+				  src_iovcnt, output_size, cb_fn, cb_arg);
+}
+
+static int
+_accel_append_crypt(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+		    enum accel_opcode op_code, struct spdk_accel_crypto_key *key,
+		    struct iovec *dst_iovs, uint32_t dst_iovcnt,
+		    struct iovec *src_iovs, uint32_t src_iovcnt, uint64_t iv, uint32_t block_size,
+		    spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+	int rc;
+
+	rc = _check_crypto_args(key, dst_iovs, dst_iovcnt, src_iovs, src_iovcnt, block_size);
+	if (rc != 0) {
+		return rc;
+	}
+
+	if (!_is_supported(accel_ch->engine, op_code) && !_sw_accel_supports_crypto()) {
+		return -ENOTSUP;
+	}
+
+	accel_task = accel_sequence_get_task(pseq, ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
+
+	accel_task->v.iovs = src_iovs;
+	accel_task->v.iovcnt = src_iovcnt;
+	accel_task->d.iovs = dst_iovs;
+	accel_task->d.iovcnt = dst_iovcnt;
+	accel_task->crypto.key = key;
+	accel_task->crypto.iv = iv;
+	accel_task->crypto.block_size = block_size;
+	accel_task->op_code = op_code;
+
+	return 0;
+}
+
+/* Accel framework public API for appending an encryption to a sequence */
+int
+spdk_accel_append_encrypt(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			  struct spdk_accel_crypto_key *key,
+			  struct iovec *dst_iovs, uint32_t dst_iovcnt,
+			  struct iovec *src_iovs, uint32_t src_iovcnt,
+			  uint64_t iv, uint32_t block_size,
+			  spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	return _accel_append_crypt(pseq, ch, ACCEL_OPC_ENCRYPT, key, dst_iovs, dst_iovcnt,
+				   src_iovs, src_iovcnt, iv, block_size, cb_fn, cb_arg);
+}
+
+/* Accel framework public API for appending a decryption to a sequence */
+int
+spdk_accel_append_decrypt(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			  struct spdk_accel_crypto_key *key,
+			  struct iovec *dst_iovs, uint32_t dst_iovcnt,
+			  struct iovec *src_iovs, uint32_t src_iovcnt,
+			  uint64_t iv, uint32_t block_size,
+			  spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	return _accel_append_crypt(pseq, ch, ACCEL_OPC_DECRYPT, key, dst_iovs, dst_iovcnt,
+				   src_iovs, src_iovcnt, iv, block_size, cb_fn, cb_arg);
+}
+
+/* Releases a step and the steps fused into it, calling their step callbacks. */
+static void
+accel_sequence_step_done(struct spdk_accel_sequence *seq, struct spdk_accel_task *accel_task)
+{
+	struct spdk_accel_task *next;
+	spdk_accel_step_cb cb_fn;
+	void *cb_arg;
+
+	do {
+		next = TAILQ_NEXT(accel_task, seq_link);
+		cb_fn = accel_task->step_cb_fn;
+		cb_arg = accel_task->step_cb_arg;
+
+		TAILQ_REMOVE(&seq->tasks, accel_task, seq_link);
+		TAILQ_INSERT_HEAD(&seq->ch->task_pool, accel_task, link);
+		if (cb_fn != NULL) {
+			cb_fn(cb_arg);
+		}
+
+		accel_task = next;
+	} while (accel_task != NULL && accel_task->fused);
+}
+
+static void
+accel_sequence_complete(struct spdk_accel_sequence *seq, int status)
+{
+	spdk_accel_completion_cb cb_fn = seq->cb_fn;
+	void *cb_arg = seq->cb_arg;
+	struct spdk_accel_task *accel_task;
+
+	/* Steps that did not run after a failure are released the same way */
+	while ((accel_task = TAILQ_FIRST(&seq->tasks))) {
+		accel_sequence_step_done(seq, accel_task);
+	}
+
+	TAILQ_INSERT_HEAD(&seq->ch->seq_pool, seq, link);
+
+	if (cb_fn != NULL) {
+		cb_fn(cb_arg, status);
+	}
+}
+
+/* Whether two single buffer steps can be executed as one copy with CRC-32C. The CRC-32C
+ * may either be calculated over the source of the copy or over its destination, which
+ * holds the same data once the copy is done.
+ */
+static bool
+accel_sequence_can_fuse(struct accel_io_channel *accel_ch, struct spdk_accel_task *first,
+			struct spdk_accel_task *second)
+{
+	struct spdk_accel_task *copy, *crc;
+
+	if (!_is_supported(accel_ch->engine, ACCEL_OPC_COPY_CRC32C) &&
+	    (_is_supported(accel_ch->engine, ACCEL_OPC_COPY) ||
+	     _is_supported(accel_ch->engine, ACCEL_OPC_CRC32C))) {
+		return false;
+	}
+
+	if (first->op_code == ACCEL_OPC_COPY && second->op_code == ACCEL_OPC_CRC32C) {
+		copy = first;
+		crc = second;
+		if (crc->src != copy->src && crc->src != copy->dst) {
+			return false;
+		}
+	} else if (first->op_code == ACCEL_OPC_CRC32C && second->op_code == ACCEL_OPC_COPY) {
+		crc = first;
+		copy = second;
+		if (crc->src != copy->src) {
+			return false;
+		}
+	} else {
+		return false;
+	}
+
+	return crc->v.iovcnt == 0 && crc->nbytes == copy->nbytes;
+}
+
+static void
+accel_sequence_fuse(struct spdk_accel_sequence *seq)
+{
+	struct spdk_accel_task *accel_task, *next;
+
+	accel_task = TAILQ_FIRST(&seq->tasks);
+	while (accel_task != NULL) {
+		next = TAILQ_NEXT(accel_task, seq_link);
+		if (next == NULL || !accel_sequence_can_fuse(seq->ch, accel_task, next)) {
+			accel_task = next;
+			continue;
+		}
+
+		/* The first of the two steps does the work of both */
+		if (accel_task->op_code == ACCEL_OPC_COPY) {
+			accel_task->crc_dst = next->crc_dst;
+			accel_task->seed = next->seed;
+		} else {
+			accel_task->dst = next->dst;
+			accel_task->flags = next->flags;
+		}
+		accel_task->v.iovcnt = 0;
+		accel_task->op_code = ACCEL_OPC_COPY_CRC32C;
+		next->fused = true;
+
+		accel_task = TAILQ_NEXT(next, seq_link);
+	}
+}
+
+/* Executes the steps of a sequence until one of them has to be completed asynchronously. */
+static void
+accel_sequence_process(struct spdk_accel_sequence *seq)
+{
+	struct accel_io_channel *accel_ch = seq->ch;
+	struct spdk_accel_task *accel_task, *next;
+	int rc;
+
+	while ((accel_task = TAILQ_FIRST(&seq->tasks))) {
+		if (_is_supported(accel_ch->engine, accel_task->op_code)) {
+			/* The sequence continues from spdk_accel_task_complete() */
+			rc = accel_ch->engine->submit_tasks(accel_ch->engine_ch, accel_task);
+			if (rc != 0) {
+				_add_to_comp_list(accel_ch, accel_task, rc);
+			}
+			return;
+		}
+
+		rc = sw_accel_execute(accel_task);
+
+		next = TAILQ_NEXT(accel_task, seq_link);
+		while (next != NULL && next->fused) {
+			next = TAILQ_NEXT(next, seq_link);
+		}
+
+		/* Software steps run back to back. Only the last one, or a failed one, goes
+		 * through the completion poller, so the sequence never completes on the
+		 * caller's stack. */
+		if (rc != 0 || next == NULL) {
+			_add_to_comp_list(accel_ch, accel_task, rc);
+			return;
+		}
+
+		accel_sequence_step_done(seq, accel_task);
+	}
+}
+
+static void
+accel_sequence_task_complete(struct spdk_accel_task *accel_task, int status)
+{
+	struct spdk_accel_sequence *seq = accel_task->seq;
+
+	accel_sequence_step_done(seq, accel_task);
+
+	if (status != 0 || TAILQ_EMPTY(&seq->tasks)) {
+		accel_sequence_complete(seq, status);
+	} else {
+		accel_sequence_process(seq);
+	}
+}
+
+int
+spdk_accel_sequence_finish(struct spdk_accel_sequence *seq,
+			   spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	if (seq == NULL || TAILQ_EMPTY(&seq->tasks)) {
+		return -EINVAL;
+	}
+
+	seq->cb_fn = cb_fn;
+	seq->cb_arg = cb_arg;
+
+	accel_sequence_fuse(seq);
+	accel_sequence_process(seq);
+
+	return 0;
+}
+
+void
+spdk_accel_sequence_abort(struct spdk_accel_sequence *seq)
+{
+	if (seq == NULL) {
+		return;
+	}
+
+	assert(seq->cb_fn == NULL);
+	accel_sequence_complete(seq, -ECANCELED);
+}
+
+/* Helper function when when accel modules register with the framework. */
+void spdk_accel_module_list_add(struct spdk_accel_module_if *accel_module)
+{
+	TAILQ_INSERT_TAIL(&spdk_accel_module_list, accel_module, tailq);
+	if (accel_module->get_ctx_size && accel_module->get_ctx_size() > g_max_accel_module_size) {
+		g_max_accel_module_size = accel_module->get_ctx_size();
+	}
+}
+
+/* Framework level channel create callback. */
+static int
+accel_engine_create_cb(void *io_device, void *ctx_buf)
+{
+	struct accel_io_channel	*accel_ch = ctx_buf;
+	struct spdk_accel_task *accel_task;
+	struct spdk_accel_sequence *seq;
+	uint8_t *task_mem;
+	int i;
+
+	accel_ch->task_pool_base = calloc(MAX_TASKS_PER_CHANNEL, g_max_accel_module_size);
+	if (accel_ch->task_pool_base == NULL) {
+		return -ENOMEM;
+	}
+
+	TAILQ_INIT(&accel_ch->task_pool);
+	task_mem = accel_ch->task_pool_base;
+	for (i = 0 ; i < MAX_TASKS_PER_CHANNEL; i++) {
+		accel_task = (struct spdk_accel_task *)task_mem;
+		TAILQ_INSERT_TAIL(&accel_ch->task_pool, accel_task, link);
+		task_mem += g_max_accel_module_size;
+	}
+
+	accel_ch->seq_pool_base = calloc(MAX_SEQUENCES_PER_CHANNEL, sizeof(struct spdk_accel_sequence));
+	if (accel_ch->seq_pool_base == NULL) {
+		free(accel_ch->task_pool_base);
+		return -ENOMEM;
+	}
+
+	TAILQ_INIT(&accel_ch->seq_pool);
+	for (i = 0; i < MAX_SEQUENCES_PER_CHANNEL; i++) {
+		seq = (struct spdk_accel_sequence *)accel_ch->seq_pool_base + i;
+		TAILQ_INSERT_TAIL(&accel_ch->seq_pool, seq, link);
+	}
+
+	/* Set sw engine channel for operations where hw engine does not support. */
+	accel_ch->sw_engine_ch = g_sw_accel_engine->get_io_channel();
+	assert(accel_ch->sw_engine_ch != NULL);
+
+	if (g_hw_accel_engine != NULL) {
+		accel_ch->engine_ch = g_hw_accel_engine->get_io_channel();
+		accel_ch->engine = g_hw_accel_engine;
+	} else {
+		/* No hw engine enabled, use sw. */
+		accel_ch->engine_ch = accel_ch->sw_engine_ch;
+		accel_ch->engine = g_sw_accel_engine;
+	}
+	assert(accel_ch->engine_ch != NULL);
+
+	return 0;
+}
+
+/* Framework level channel destroy callback. */
+static void
+accel_engine_destroy_cb(void *io_device, void *ctx_buf)
+{
+	struct accel_io_channel	*accel_ch = ctx_buf;
+
+	if (accel_ch->sw_engine_ch != accel_ch->engine_ch) {
+		spdk_put_io_channel(accel_ch->sw_engine_ch);
+	}
+	spdk_put_io_channel(accel_ch->engine_ch);
+	free(accel_ch->task_pool_base);
+	free(accel_ch->seq_pool_base);
+}
+
+struct spdk_io_channel *
+spdk_accel_engine_get_io_channel(void)
+{
+	return spdk_get_io_channel(&spdk_accel_module_list);
+}
+
+static void
+accel_engine_module_initialize(void)
+{
+	struct spdk_accel_module_if *accel_engine_module;
+
+	TAILQ_FOREACH(accel_engine_module, &spdk_accel_module_list, tailq) {
+		accel_engine_module->module_init();
+	}
+}
+
+int
+spdk_accel_engine_initialize(void)
+{
+	SPDK_NOTICELOG("Accel engine initialized to use software engine.\n");
+	accel_engine_module_initialize();
+
+	/*
+	 * We need a unique identifier for the accel engine framework, so use the
+	 *  spdk_accel_module_list address for this purpose.
+	 */
+	spdk_io_device_register(&spdk_accel_module_list, accel_engine_create_cb, accel_engine_destroy_cb,
+				sizeof(struct accel_io_channel), "accel_module");
+
+	return 0;
+}
+
+static void
+accel_engine_module_finish_cb(void)
+{
+	spdk_accel_fini_cb cb_fn = g_fini_cb_fn;
+
+	cb_fn(g_fini_cb_arg);
+	g_fini_cb_fn = NULL;
+	g_fini_cb_arg = NULL;
+}
+
+void
+spdk_accel_write_config_json(struct spdk_json_write_ctx *w)
+{
+	struct spdk_accel_module_if *accel_engine_module;
+
+	/*
+	 * The accel fw has no config, there may be some in
+	 * the engines/modules though.
+	 */
+	spdk_json_write_array_begin(w);
+	TAILQ_FOREACH(accel_engine_module, &spdk_accel_module_list, tailq) {
+		if (accel_engine_module->write_config_json) {
+			accel_engine_module->write_config_json(w);
+		}
+	}
+	spdk_json_write_array_end(w);
+}
+
+void
+spdk_accel_engine_module_finish(void)
+{
+	if (!g_accel_engine_module) {
+		g_accel_engine_module = TAILQ_FIRST(&spdk_accel_module_list);
+	} else {
+		g_accel_engine_module = TAILQ_NEXT(g_accel_engine_module, tailq);
+	}
+
+	if (!g_accel_engine_module) {
+		accel_engine_module_finish_cb();
+		return;
+	}
+
+	if (g_accel_engine_module->module_fini) {
+		spdk_thread_send_msg(spdk_get_thread(), g_accel_engine_module->module_fini, NULL);
+	} else {
+		spdk_accel_engine_module_finish();
+	}
+}
+
+void
+spdk_accel_engine_finish(spdk_accel_fini_cb cb_fn, void *cb_arg)
+{
+	assert(cb_fn != NULL);
+
+	g_fini_cb_fn = cb_fn;
+	g_fini_cb_arg = cb_arg;
+
+	spdk_io_device_unregister(&spdk_accel_module_list, NULL);
+	spdk_accel_engine_module_finish();
+}
+
+/*
+ * The SW Accelerator module is "built in" here (rest of file)
+ */
+static bool
+sw_accel_supports_opcode(enum accel_opcode opc)
+{
+	return false;
+}
+
+static inline void
+_pmem_memcpy(void *dst, const void *src, size_t len)
+{
+#ifdef SPDK_CONFIG_PMDK
+	int is_pmem = pmem_is_pmem(dst, len);
+
+	if (is_pmem) {
+		pmem_memcpy_persist(dst, src, len);
+	} else {
+		memcpy(dst, src, len);
+		pmem_msync(dst, len);
+	}
+#else
+	SPDK_ERRLOG("Function not defined without SPDK_CONFIG_PMDK enabled.\n");
+	assert(0);
+#endif
+}
+
+static void
+_sw_accel_dualcast(void *dst1, void *dst2, void *src, size_t nbytes, int flags)
+{
+	if (flags & ACCEL_FLAG_PERSISTENT) {
+		_pmem_memcpy(dst1, src, nbytes);
+		_pmem_memcpy(dst2, src, nbytes);
+	} else {
+		memcpy(dst1, src, nbytes);
+		memcpy(dst2, src, nbytes);
+	}
+}
+
+static void
+_sw_accel_copy(void *dst, void *src, size_t nbytes, int flags)
+{
+
+	if (flags & ACCEL_FLAG_PERSISTENT) {
+		_pmem_memcpy(dst, src, nbytes);
+	} else {
+		memcpy(dst, src, nbytes);
+	}
+}
+
+static void
+_sw_accel_copyv(void *dst, struct iovec *iov, uint32_t iovcnt, int flags)
+{
+	uint32_t i;
+
+	for (i = 0; i < iovcnt; i++) {
 		assert(iov[i].iov_base != NULL);
 		if (flags & ACCEL_FLAG_PERSISTENT) {
 			_pmem_memcpy(dst, iov[i].iov_base, (size_t)iov[i].iov_len);
@@ -725,6 +1619,578 @@ _sw_accel_crc32cv(uint32_t *crc_dst, struct iovec *iov, uint32_t iovcnt, uint32_
 	*crc_dst = spdk_crc32c_iov_update(iov, iovcnt, ~seed);
 }
 
+static void
+_sw_accel_copy_crc32c(void *dst, void *src, uint32_t *crc_dst, uint32_t seed, uint64_t nbytes,
+		      int flags)
+{
+	uint32_t crc = ~seed;
+	size_t len;
+
+	if (flags & ACCEL_FLAG_PERSISTENT) {
+		_sw_accel_copy(dst, src, (size_t)nbytes, flags);
+		_sw_accel_crc32c(crc_dst, src, seed, (size_t)nbytes);
+		return;
+	}
+
+	/* Checksum each chunk right after copying it, so the data is only read from
+	 * memory once. */
+	while (nbytes > 0) {
+		len = spdk_min(nbytes, SW_COPY_CRC32C_CHUNK_SIZE);
+		memcpy(dst, src, len);
+		crc = spdk_crc32c_update(src, len, crc);
+		dst += len;
+		src += len;
+		nbytes -= len;
+	}
+
+	*crc_dst = crc;
+}
+
+#ifdef SPDK_CONFIG_ISAL
+/* Level 1 is the fastest ISA-L level that still searches for matches */
+#define SW_ACCEL_COMP_LEVEL		1
+
+struct sw_accel_comp_ctx {
+	struct isal_zstream	stream;
+	struct inflate_state	state;
+	uint8_t			level_buf[ISAL_DEF_LVL1_DEFAULT];
+};
+
+static bool
+_sw_accel_supports_compression(void)
+{
+	return true;
+}
+
+static struct sw_accel_comp_ctx *
+_sw_accel_get_comp_ctx(struct spdk_accel_task *accel_task)
+{
+	struct sw_accel_io_channel *sw_ch = spdk_io_channel_get_ctx(accel_task->accel_ch->sw_engine_ch);
+
+	/* The stream state is too large for the stack and most channels never need it */
+	if (sw_ch->comp_ctx == NULL) {
+		sw_ch->comp_ctx = calloc(1, sizeof(*sw_ch->comp_ctx));
+	}
+
+	return sw_ch->comp_ctx;
+}
+
+static int
+_sw_accel_compress(struct spdk_accel_task *accel_task)
+{
+	struct sw_accel_comp_ctx *ctx = _sw_accel_get_comp_ctx(accel_task);
+	struct iovec *siov = accel_task->v.iovs, *diov = accel_task->d.iovs;
+	uint32_t s = 0, d = 0;
+	struct isal_zstream *stream;
+	int rc;
+
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	stream = &ctx->stream;
+	isal_deflate_init(stream);
+	stream->level = SW_ACCEL_COMP_LEVEL;
+	stream->level_buf = ctx->level_buf;
+	stream->level_buf_size = sizeof(ctx->level_buf);
+	/* The init doesn't touch the buffers, which may still be the previous task's */
+	stream->avail_in = 0;
+	stream->avail_out = 0;
+
+	do {
+		/* Move on to the next buffer as soon as the stream is done with the current one */
+		if (stream->avail_in == 0 && s < accel_task->v.iovcnt) {
+			stream->next_in = siov[s].iov_base;
+			stream->avail_in = siov[s].iov_len;
+			s++;
+		}
+		if (stream->avail_out == 0) {
+			if (d == accel_task->d.iovcnt) {
+				return -ENOSPC;
+			}
+			stream->next_out = diov[d].iov_base;
+			stream->avail_out = diov[d].iov_len;
+			d++;
+		}
+		stream->end_of_stream = (s == accel_task->v.iovcnt);
+
+		rc = isal_deflate(stream);
+		if (rc != COMP_OK) {
+			SPDK_ERRLOG("isal_deflate failed with error %d\n", rc);
+			return -EIO;
+		}
+	} while (stream->internal_state.state != ZSTATE_END);
+
+	*accel_task->output_size = stream->total_out;
+
+	return 0;
+}
+
+static int
+_sw_accel_decompress(struct spdk_accel_task *accel_task)
+{
+	struct sw_accel_comp_ctx *ctx = _sw_accel_get_comp_ctx(accel_task);
+	struct iovec *siov = accel_task->v.iovs, *diov = accel_task->d.iovs;
+	uint32_t s = 0, d = 0;
+	struct inflate_state *state;
+	int rc;
+
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	state = &ctx->state;
+	isal_inflate_init(state);
+	state->avail_in = 0;
+	state->avail_out = 0;
+
+	do {
+		if (state->avail_in == 0 && s < accel_task->v.iovcnt) {
+			state->next_in = siov[s].iov_base;
+			state->avail_in = siov[s].iov_len;
+			s++;
+		}
+		if (state->avail_out == 0) {
+			if (d == accel_task->d.iovcnt) {
+				return -ENOSPC;
+			}
+			state->next_out = diov[d].iov_base;
+			state->avail_out = diov[d].iov_len;
+			d++;
+		}
+
+		rc = isal_inflate(state);
+		if (rc < 0) {
+			SPDK_ERRLOG("isal_inflate failed with error %d\n", rc);
+			return -EIO;
+		}
+
+		/* Inflate only stops early when it runs out of either input or output space */
+		if (state->block_state != ISAL_BLOCK_FINISH && state->avail_out != 0 &&
+		    state->avail_in == 0 && s == accel_task->v.iovcnt) {
+			SPDK_ERRLOG("Deflate stream is truncated\n");
+			return -EIO;
+		}
+	} while (state->block_state != ISAL_BLOCK_FINISH);
+
+	if (accel_task->output_size != NULL) {
+		*accel_task->output_size = state->total_out;
+	}
+
+	return 0;
+}
+#else
+static bool
+_sw_accel_supports_compression(void)
+{
+	return false;
+}
+
+static int
+_sw_accel_compress(struct spdk_accel_task *accel_task)
+{
+	return -ENOTSUP;
+}
+
+static int
+_sw_accel_decompress(struct spdk_accel_task *accel_task)
+{
+	return -ENOTSUP;
+}
+#endif
+
+#ifdef SPDK_CONFIG_IPSEC_MB
+/* Number of data units whose tweaks are computed with a single job */
+#define SW_ACCEL_XTS_MAX_UNITS		256
+/* Size of an expanded AES-256 key schedule, 15 round keys */
+#define SW_ACCEL_AES_KEY_SCHED_SIZE	(15 * SPDK_ACCEL_AES_BLOCK_SIZE)
+
+struct sw_accel_crypto_key {
+	uint8_t	enc_keys[SW_ACCEL_AES_KEY_SCHED_SIZE] __attribute__((aligned(16)));
+	uint8_t	dec_keys[SW_ACCEL_AES_KEY_SCHED_SIZE] __attribute__((aligned(16)));
+	uint8_t	tweak_enc_keys[SW_ACCEL_AES_KEY_SCHED_SIZE] __attribute__((aligned(16)));
+	uint8_t	tweak_dec_keys[SW_ACCEL_AES_KEY_SCHED_SIZE] __attribute__((aligned(16)));
+};
+
+struct sw_accel_crypto_ctx {
+	IMB_MGR		*mgr;
+	uint8_t		tweaks[SW_ACCEL_XTS_MAX_UNITS][SPDK_ACCEL_AES_BLOCK_SIZE];
+};
+
+/* Position within an iovec array, advanced one AES block at a time */
+struct sw_accel_iov_iter {
+	struct iovec	*iovs;
+	uint32_t	iovcnt;
+	uint32_t	idx;
+	size_t		off;
+};
+
+static bool
+_sw_accel_supports_crypto(void)
+{
+	return true;
+}
+
+static IMB_MGR *
+_sw_accel_alloc_mb_mgr(void)
+{
+	IMB_MGR *mgr;
+
+	mgr = alloc_mb_mgr(0);
+	if (mgr == NULL) {
+		return NULL;
+	}
+
+	/* The AVX512 flavor uses VAES when the CPU has it */
+	if (mgr->features & IMB_FEATURE_AVX512_SKX) {
+		init_mb_mgr_avx512(mgr);
+	} else if (mgr->features & IMB_FEATURE_AVX2) {
+		init_mb_mgr_avx2(mgr);
+	} else if (mgr->features & IMB_FEATURE_AVX) {
+		init_mb_mgr_avx(mgr);
+	} else {
+		init_mb_mgr_sse(mgr);
+	}
+
+	return mgr;
+}
+
+static int
+_sw_accel_crypto_key_init(struct spdk_accel_crypto_key *key)
+{
+	struct sw_accel_crypto_key *priv;
+	IMB_MGR *mgr;
+
+	/* Keys are created rarely, so a short lived manager is good enough to expand them */
+	mgr = _sw_accel_alloc_mb_mgr();
+	if (mgr == NULL) {
+		return -ENOMEM;
+	}
+
+	priv = calloc(1, sizeof(*priv));
+	if (priv == NULL) {
+		free_mb_mgr(mgr);
+		return -ENOMEM;
+	}
+
+	if (key->key_size == SPDK_ACCEL_AES_XTS_128_KEY_SIZE) {
+		IMB_AES_KEYEXP_128(mgr, key->key, priv->enc_keys, priv->dec_keys);
+		IMB_AES_KEYEXP_128(mgr, key->key2, priv->tweak_enc_keys, priv->tweak_dec_keys);
+	} else {
+		IMB_AES_KEYEXP_256(mgr, key->key, priv->enc_keys, priv->dec_keys);
+		IMB_AES_KEYEXP_256(mgr, key->key2, priv->tweak_enc_keys, priv->tweak_dec_keys);
+	}
+
+	free_mb_mgr(mgr);
+	key->priv = priv;
+
+	return 0;
+}
+
+static void
+_sw_accel_crypto_key_fini(struct spdk_accel_crypto_key *key)
+{
+	if (key->priv != NULL) {
+		explicit_bzero(key->priv, sizeof(struct sw_accel_crypto_key));
+		free(key->priv);
+		key->priv = NULL;
+	}
+}
+
+static void
+_sw_accel_free_crypto_ctx(struct sw_accel_crypto_ctx *ctx)
+{
+	if (ctx != NULL) {
+		free_mb_mgr(ctx->mgr);
+		free(ctx);
+	}
+}
+
+static struct sw_accel_crypto_ctx *
+_sw_accel_get_crypto_ctx(struct spdk_accel_task *accel_task)
+{
+	struct sw_accel_io_channel *sw_ch = spdk_io_channel_get_ctx(accel_task->accel_ch->sw_engine_ch);
+	struct sw_accel_crypto_ctx *ctx;
+
+	if (sw_ch->crypto_ctx == NULL) {
+		ctx = calloc(1, sizeof(*ctx));
+		if (ctx == NULL) {
+			return NULL;
+		}
+
+		ctx->mgr = _sw_accel_alloc_mb_mgr();
+		if (ctx->mgr == NULL) {
+			free(ctx);
+			return NULL;
+		}
+
+		sw_ch->crypto_ctx = ctx;
+	}
+
+	return sw_ch->crypto_ctx;
+}
+
+static uint8_t *
+_sw_accel_iov_iter_next(struct sw_accel_iov_iter *iter)
+{
+	uint8_t *block;
+
+	while (iter->off == iter->iovs[iter->idx].iov_len) {
+		iter->idx++;
+		iter->off = 0;
+		assert(iter->idx < iter->iovcnt);
+	}
+
+	block = (uint8_t *)iter->iovs[iter->idx].iov_base + iter->off;
+	iter->off += SPDK_ACCEL_AES_BLOCK_SIZE;
+
+	return block;
+}
+
+/* Multiply the tweak by the primitive element of GF(2^128), as defined by IEEE 1619 */
+static inline void
+_sw_accel_xts_next_tweak(uint64_t tweak[2])
+{
+	uint64_t carry = tweak[1] >> 63;
+
+	tweak[1] = (tweak[1] << 1) | (tweak[0] >> 63);
+	tweak[0] = (tweak[0] << 1) ^ (carry * 0x87);
+}
+
+static inline void
+_sw_accel_xor_block(uint8_t *dst, const uint8_t *src, const uint64_t tweak[2])
+{
+	uint64_t d[2];
+
+	memcpy(d, src, sizeof(d));
+	d[0] ^= tweak[0];
+	d[1] ^= tweak[1];
+	memcpy(dst, d, sizeof(d));
+}
+
+static int
+_sw_accel_ecb(IMB_MGR *mgr, IMB_CIPHER_DIRECTION dir, const void *enc_keys,
+	      const void *dec_keys, uint64_t key_len, struct sw_accel_iov_iter *iter, uint64_t len)
+{
+	IMB_JOB *job;
+	uint64_t seg_len;
+	int rc = 0;
+
+	while (len > 0) {
+		if (iter->off == iter->iovs[iter->idx].iov_len) {
+			iter->idx++;
+			iter->off = 0;
+			continue;
+		}
+
+		seg_len = spdk_min(len, iter->iovs[iter->idx].iov_len - iter->off);
+
+		job = IMB_GET_NEXT_JOB(mgr);
+		job->cipher_mode = IMB_CIPHER_ECB;
+		job->cipher_direction = dir;
+		job->chain_order = dir == IMB_DIR_ENCRYPT ? IMB_ORDER_CIPHER_HASH : IMB_ORDER_HASH_CIPHER;
+		job->hash_alg = IMB_AUTH_NULL;
+		job->enc_keys = enc_keys;
+		job->dec_keys = dec_keys;
+		job->key_len_in_bytes = key_len;
+		job->src = (uint8_t *)iter->iovs[iter->idx].iov_base + iter->off;
+		job->dst = (uint8_t *)iter->iovs[iter->idx].iov_base + iter->off;
+		job->cipher_start_src_offset_in_bytes = 0;
+		job->msg_len_to_cipher_in_bytes = seg_len;
+		job->iv = NULL;
+		job->iv_len_in_bytes = 0;
+
+		/* Each buffer is its own job, so the manager works on several of them in parallel */
+		job = IMB_SUBMIT_JOB(mgr);
+		while (job != NULL) {
+			if (job->status != IMB_STATUS_COMPLETED) {
+				rc = -EIO;
+			}
+			job = IMB_GET_COMPLETED_JOB(mgr);
+		}
+
+		iter->off += seg_len;
+		len -= seg_len;
+	}
+
+	while ((job = IMB_FLUSH_JOB(mgr)) != NULL) {
+		if (job->status != IMB_STATUS_COMPLETED) {
+			rc = -EIO;
+		}
+	}
+
+	return rc;
+}
+
+/*
+ * ipsec-mb has no AES-XTS cipher mode, so XTS is built from its multi-buffer AES-ECB: the
+ * tweaks of a batch of data units are encrypted with a single job, the data is whitened
+ * with the tweaks, encrypted in place and whitened again.
+ */
+static int
+_sw_accel_crypt(struct spdk_accel_task *accel_task)
+{
+	struct sw_accel_crypto_ctx *ctx = _sw_accel_get_crypto_ctx(accel_task);
+	struct spdk_accel_crypto_key *key = accel_task->crypto.key;
+	struct sw_accel_crypto_key *priv = key->priv;
+	uint32_t blocks_per_unit = accel_task->crypto.block_size / SPDK_ACCEL_AES_BLOCK_SIZE;
+	IMB_CIPHER_DIRECTION dir;
+	struct sw_accel_iov_iter src, dst, start, tweak_iter;
+	struct iovec tweak_iov;
+	uint64_t tweak[2], unit = 0, nunits = 0, len;
+	uint32_t i, j, batch;
+	uint8_t *block;
+	int rc;
+
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	dir = accel_task->op_code == ACCEL_OPC_ENCRYPT ? IMB_DIR_ENCRYPT : IMB_DIR_DECRYPT;
+
+	for (i = 0; i < accel_task->v.iovcnt; i++) {
+		nunits += accel_task->v.iovs[i].iov_len;
+	}
+	nunits /= accel_task->crypto.block_size;
+
+	src = (struct sw_accel_iov_iter) { accel_task->v.iovs, accel_task->v.iovcnt, 0, 0 };
+	dst = (struct sw_accel_iov_iter) { accel_task->d.iovs, accel_task->d.iovcnt, 0, 0 };
+
+	while (unit < nunits) {
+		batch = spdk_min(nunits - unit, SW_ACCEL_XTS_MAX_UNITS);
+		len = (uint64_t)batch * accel_task->crypto.block_size;
+
+		/* The tweak of each data unit is its sequence number, encrypted with the tweak key */
+		for (i = 0; i < batch; i++) {
+			tweak[0] = accel_task->crypto.iv + unit + i;
+			tweak[1] = 0;
+			memcpy(ctx->tweaks[i], tweak, sizeof(tweak));
+		}
+		tweak_iov.iov_base = ctx->tweaks;
+		tweak_iov.iov_len = batch * SPDK_ACCEL_AES_BLOCK_SIZE;
+		tweak_iter = (struct sw_accel_iov_iter) { &tweak_iov, 1, 0, 0 };
+		rc = _sw_accel_ecb(ctx->mgr, IMB_DIR_ENCRYPT, priv->tweak_enc_keys, priv->tweak_dec_keys,
+				   key->key_size, &tweak_iter, tweak_iov.iov_len);
+		if (rc != 0) {
+			return rc;
+		}
+
+		start = dst;
+		for (i = 0; i < batch; i++) {
+			memcpy(tweak, ctx->tweaks[i], sizeof(tweak));
+			for (j = 0; j < blocks_per_unit; j++) {
+				_sw_accel_xor_block(_sw_accel_iov_iter_next(&dst),
+						    _sw_accel_iov_iter_next(&src), tweak);
+				_sw_accel_xts_next_tweak(tweak);
+			}
+		}
+
+		dst = start;
+		rc = _sw_accel_ecb(ctx->mgr, dir, priv->enc_keys, priv->dec_keys, key->key_size,
+				   &dst, len);
+		if (rc != 0) {
+			return rc;
+		}
+
+		dst = start;
+		for (i = 0; i < batch; i++) {
+			memcpy(tweak, ctx->tweaks[i], sizeof(tweak));
+			for (j = 0; j < blocks_per_unit; j++) {
+				block = _sw_accel_iov_iter_next(&dst);
+				_sw_accel_xor_block(block, block, tweak);
+				_sw_accel_xts_next_tweak(tweak);
+			}
+		}
+
+		unit += batch;
+	}
+
+	return 0;
+}
+#else
+static bool
+_sw_accel_supports_crypto(void)
+{
+	return false;
+}
+
+static int
+_sw_accel_crypto_key_init(struct spdk_accel_crypto_key *key)
+{
+	return 0;
+}
+
+static void
+_sw_accel_crypto_key_fini(struct spdk_accel_crypto_key *key)
+{
+}
+
+static void
+_sw_accel_free_crypto_ctx(struct sw_accel_crypto_ctx *ctx)
+{
+	assert(ctx == NULL);
+}
+
+static int
+_sw_accel_crypt(struct spdk_accel_task *accel_task)
+{
+	return -ENOTSUP;
+}
+#endif
+
+/* Executes a step of a sequence that the engine does not support. */
+static int
+sw_accel_execute(struct spdk_accel_task *accel_task)
+{
+	int rc;
+
+	switch (accel_task->op_code) {
+	case ACCEL_OPC_COPY:
+		rc = _check_flags(accel_task->flags);
+		if (rc == 0) {
+			_sw_accel_copy(accel_task->dst, accel_task->src, (size_t)accel_task->nbytes,
+				       accel_task->flags);
+		}
+		return rc;
+	case ACCEL_OPC_FILL:
+		rc = _check_flags(accel_task->flags);
+		if (rc == 0) {
+			_sw_accel_fill(accel_task->dst, (uint8_t)accel_task->fill_pattern,
+				       (size_t)accel_task->nbytes, accel_task->flags);
+		}
+		return rc;
+	case ACCEL_OPC_COMPARE:
+		rc = _sw_accel_compare(accel_task->src, accel_task->src2, (size_t)accel_task->nbytes);
+		return rc == 0 ? 0 : -EILSEQ;
+	case ACCEL_OPC_CRC32C:
+		if (accel_task->v.iovcnt == 0) {
+			_sw_accel_crc32c(accel_task->crc_dst, accel_task->src, accel_task->seed,
+					 accel_task->nbytes);
+		} else {
+			_sw_accel_crc32cv(accel_task->crc_dst, accel_task->v.iovs, accel_task->v.iovcnt,
+					  accel_task->seed);
+		}
+		return 0;
+	case ACCEL_OPC_COPY_CRC32C:
+		rc = _check_flags(accel_task->flags);
+		if (rc == 0) {
+			_sw_accel_copy_crc32c(accel_task->dst, accel_task->src, accel_task->crc_dst,
+					      accel_task->seed, accel_task->nbytes, accel_task->flags);
+		}
+		return rc;
+	case ACCEL_OPC_COMPRESS:
+		return _sw_accel_compress(accel_task);
+	case ACCEL_OPC_DECOMPRESS:
+		return _sw_accel_decompress(accel_task);
+	case ACCEL_OPC_ENCRYPT:
+	case ACCEL_OPC_DECRYPT:
+		return _sw_accel_crypt(accel_task);
+	default:
+		assert(false);
+		return -EINVAL;
+	}
+}
+
 static struct spdk_io_channel *sw_accel_get_io_channel(void);
 
 
@@ -772,6 +2238,8 @@ sw_accel_destroy_cb(void *io_device, void *ctx_buf)
 	struct sw_accel_io_channel *sw_ch = ctx_buf;
 
 	spdk_poller_unregister(&sw_ch->completion_poller);
+	free(sw_ch->comp_ctx);
+	_sw_accel_free_crypto_ctx(sw_ch->crypto_ctx);
 }
 
 static struct spdk_io_channel *sw_accel_get_io_channel(void)
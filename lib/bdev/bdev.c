@@ -6828,6 +6828,24 @@ bdev_set_qos_limit_done(struct set_qos_limit_ctx *ctx, int status)
 	free(ctx);
 }
 
+static void
+bdev_qos_send_queued_ios(struct spdk_thread *thread, void **ios, uint32_t num_ios)
+{
+	uint32_t i;
+	int rc;
+
+	rc = spdk_thread_send_msg_batch(thread, _bdev_io_submit, ios, num_ios);
+	if (spdk_likely(rc == 0)) {
+		return;
+	}
+
+	/* A batch is sent all or nothing, its messages can't always be allocated at once.
+	 * Fall back to sending the I/O one at a time. */
+	for (i = 0; i < num_ios; i++) {
+		spdk_thread_send_msg(thread, _bdev_io_submit, ios[i]);
+	}
+}
+
 static void
 bdev_disable_qos_done(void *cb_arg)
 {
@@ -6835,6 +6853,9 @@ bdev_disable_qos_done(void *cb_arg)
 	struct spdk_bdev *bdev = ctx->bdev;
 	struct spdk_bdev_io *bdev_io;
 	struct spdk_bdev_qos *qos;
+	struct spdk_thread *thread = NULL, *io_thread;
+	void *ios[SPDK_THREAD_MSG_BATCH_MAX];
+	uint32_t num_ios = 0;
 
 	pthread_mutex_lock(&bdev->internal.mutex);
 	qos = bdev->internal.qos;
@@ -6855,8 +6876,18 @@ bdev_disable_qos_done(void *cb_arg)
 			bdev_io->internal.io_submit_ch = NULL;
 		}
 
-		spdk_thread_send_msg(spdk_bdev_io_get_thread(bdev_io),
-				     _bdev_io_submit, bdev_io);
+		/* Consecutive I/O from the same thread are sent back in a single batch. */
+		io_thread = spdk_bdev_io_get_thread(bdev_io);
+		if (num_ios == SPDK_COUNTOF(ios) || (num_ios > 0 && io_thread != thread)) {
+			bdev_qos_send_queued_ios(thread, ios, num_ios);
+			num_ios = 0;
+		}
+		thread = io_thread;
+		ios[num_ios++] = bdev_io;
+	}
+
+	if (num_ios > 0) {
+		bdev_qos_send_queued_ios(thread, ios, num_ios);
 	}
 
 	if (qos->thread != NULL) {
@@ -154,6 +154,111 @@ SPDK_RPC_REGISTER("framework_monitor_context_switch", rpc_framework_monitor_cont
 		  SPDK_RPC_RUNTIME)
 SPDK_RPC_REGISTER_ALIAS_DEPRECATED(framework_monitor_context_switch, context_switch_monitor)
 
+struct rpc_framework_work_stealing {
+	bool enabled;
+};
+
+static const struct spdk_json_object_decoder rpc_framework_work_stealing_decoders[] = {
+	{"enabled", offsetof(struct rpc_framework_work_stealing, enabled), spdk_json_decode_bool},
+};
+
+static void
+rpc_framework_work_stealing_done(void *cb_arg)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+	struct spdk_json_write_ctx *w;
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+
+	spdk_json_write_named_bool(w, "enabled", spdk_framework_work_stealing_enabled());
+
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+
+static void
+rpc_framework_work_stealing(struct spdk_jsonrpc_request *request,
+			    const struct spdk_json_val *params)
+{
+	struct rpc_framework_work_stealing req = {};
+	int rc;
+
+	if (params == NULL) {
+		rpc_framework_work_stealing_done(request);
+		return;
+	}
+
+	if (spdk_json_decode_object(params, rpc_framework_work_stealing_decoders,
+				    SPDK_COUNTOF(rpc_framework_work_stealing_decoders),
+				    &req)) {
+		SPDK_DEBUGLOG(app_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		return;
+	}
+
+	rc = spdk_framework_enable_work_stealing(req.enabled, rpc_framework_work_stealing_done,
+						 request);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+	}
+}
+
+SPDK_RPC_REGISTER("framework_work_stealing", rpc_framework_work_stealing, SPDK_RPC_RUNTIME)
+
+struct rpc_framework_hybrid_mode {
+	uint32_t idle_threshold;
+	uint32_t wakeup_threshold;
+};
+
+static const struct spdk_json_object_decoder rpc_framework_hybrid_mode_decoders[] = {
+	{"idle_threshold", offsetof(struct rpc_framework_hybrid_mode, idle_threshold), spdk_json_decode_uint32},
+	{"wakeup_threshold", offsetof(struct rpc_framework_hybrid_mode, wakeup_threshold), spdk_json_decode_uint32, true},
+};
+
+static void
+rpc_framework_hybrid_mode(struct spdk_jsonrpc_request *request,
+			  const struct spdk_json_val *params)
+{
+	struct rpc_framework_hybrid_mode req = {};
+	struct spdk_json_write_ctx *w;
+	int rc;
+
+	if (params != NULL) {
+		spdk_framework_get_hybrid_mode(&req.idle_threshold, &req.wakeup_threshold);
+		if (req.wakeup_threshold == 0) {
+			req.wakeup_threshold = 1;
+		}
+
+		if (spdk_json_decode_object(params, rpc_framework_hybrid_mode_decoders,
+					    SPDK_COUNTOF(rpc_framework_hybrid_mode_decoders),
+					    &req)) {
+			SPDK_DEBUGLOG(app_rpc, "spdk_json_decode_object failed\n");
+			spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+			return;
+		}
+
+		rc = spdk_framework_set_hybrid_mode(req.idle_threshold, req.wakeup_threshold);
+		if (rc != 0) {
+			spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+			return;
+		}
+	}
+
+	spdk_framework_get_hybrid_mode(&req.idle_threshold, &req.wakeup_threshold);
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+
+	spdk_json_write_named_uint32(w, "idle_threshold", req.idle_threshold);
+	spdk_json_write_named_uint32(w, "wakeup_threshold", req.wakeup_threshold);
+
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+
+SPDK_RPC_REGISTER("framework_hybrid_mode", rpc_framework_hybrid_mode, SPDK_RPC_RUNTIME)
+
 struct rpc_get_stats_ctx {
 	struct spdk_jsonrpc_request *request;
 	struct spdk_json_write_ctx *w;
@@ -256,6 +361,7 @@ rpc_get_poller(struct spdk_poller *poller, struct spdk_json_write_ctx *w)
 {
 	struct spdk_poller_stats stats;
 	uint64_t period_ticks;
+	int i;
 
 	period_ticks = spdk_poller_get_period_ticks(poller);
 	spdk_poller_get_stats(poller, &stats);
@@ -269,6 +375,12 @@ rpc_get_poller(struct spdk_poller *poller, struct spdk_json_write_ctx *w)
 	if (period_ticks) {
 		spdk_json_write_named_uint64(w, "period_ticks", period_ticks);
 	}
+	spdk_json_write_named_uint64(w, "tsc", stats.tsc);
+	spdk_json_write_named_array_begin(w, "tsc_histogram");
+	for (i = 0; i < SPDK_POLLER_TSC_HISTOGRAM_BUCKETS; i++) {
+		spdk_json_write_uint64(w, stats.tsc_histogram[i]);
+	}
+	spdk_json_write_array_end(w);
 	spdk_json_write_object_end(w);
 }
 
@@ -366,6 +478,99 @@ rpc_thread_get_io_channels(struct spdk_jsonrpc_request *request,
 
 SPDK_RPC_REGISTER("thread_get_io_channels", rpc_thread_get_io_channels, SPDK_RPC_RUNTIME);
 
+struct rpc_framework_msg_latency_tracking {
+	bool enabled;
+};
+
+static const struct spdk_json_object_decoder rpc_framework_msg_latency_tracking_decoders[] = {
+	{"enabled", offsetof(struct rpc_framework_msg_latency_tracking, enabled), spdk_json_decode_bool},
+};
+
+static void
+rpc_framework_msg_latency_tracking(struct spdk_jsonrpc_request *request,
+				   const struct spdk_json_val *params)
+{
+	struct rpc_framework_msg_latency_tracking req = {};
+	struct spdk_json_write_ctx *w;
+
+	if (params != NULL) {
+		if (spdk_json_decode_object(params, rpc_framework_msg_latency_tracking_decoders,
+					    SPDK_COUNTOF(rpc_framework_msg_latency_tracking_decoders),
+					    &req)) {
+			SPDK_DEBUGLOG(app_rpc, "spdk_json_decode_object failed\n");
+			spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+			return;
+		}
+
+		spdk_msg_latency_tracking_enable(req.enabled);
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+
+	spdk_json_write_named_bool(w, "enabled", spdk_msg_latency_tracking_is_enabled());
+
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+
+SPDK_RPC_REGISTER("framework_msg_latency_tracking", rpc_framework_msg_latency_tracking,
+		  SPDK_RPC_RUNTIME)
+
+static void
+rpc_write_msg_latency(const struct spdk_msg_latency_table *table, const char *src_name,
+		      struct spdk_json_write_ctx *w)
+{
+	const struct spdk_msg_latency_stats *entry;
+	uint32_t i;
+
+	spdk_json_write_named_uint64(w, "dropped", table != NULL ? table->dropped : 0);
+	spdk_json_write_named_array_begin(w, "latency");
+	for (i = 0; table != NULL && i < SPDK_MSG_LATENCY_TABLE_SIZE; i++) {
+		entry = &table->entries[i];
+		if (entry->fn == NULL) {
+			continue;
+		}
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_uint64(w, src_name, entry->src_id);
+		spdk_json_write_named_string_fmt(w, "fn", "%p", entry->fn);
+		spdk_json_write_named_uint64(w, "count", entry->count);
+		spdk_json_write_named_uint64(w, "total_tsc", entry->total_tsc);
+		spdk_json_write_named_uint64(w, "max_tsc", entry->max_tsc);
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+}
+
+static void
+_rpc_thread_get_msg_latency(void *arg)
+{
+	struct rpc_get_stats_ctx *ctx = arg;
+	struct spdk_thread *thread = spdk_get_thread();
+
+	spdk_json_write_object_begin(ctx->w);
+	spdk_json_write_named_string(ctx->w, "name", spdk_thread_get_name(thread));
+	spdk_json_write_named_uint64(ctx->w, "id", spdk_thread_get_id(thread));
+	rpc_write_msg_latency(spdk_thread_get_msg_latency(thread), "src_thread", ctx->w);
+	spdk_json_write_object_end(ctx->w);
+}
+
+static void
+rpc_thread_get_msg_latency(struct spdk_jsonrpc_request *request,
+			   const struct spdk_json_val *params)
+{
+	if (params) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "'thread_get_msg_latency' requires no arguments");
+		return;
+	}
+
+	rpc_thread_get_stats_for_each(request, _rpc_thread_get_msg_latency);
+}
+
+SPDK_RPC_REGISTER("thread_get_msg_latency", rpc_thread_get_msg_latency, SPDK_RPC_RUNTIME)
+
 static void
 rpc_framework_get_reactors_done(void *arg1, void *arg2)
 {
@@ -462,6 +667,57 @@ rpc_framework_get_reactors(struct spdk_jsonrpc_request *request,
 
 SPDK_RPC_REGISTER("framework_get_reactors", rpc_framework_get_reactors, SPDK_RPC_RUNTIME)
 
+static void
+_rpc_framework_get_event_latency(void *arg1, void *arg2)
+{
+	struct rpc_get_stats_ctx *ctx = arg1;
+	uint32_t current_core;
+	struct spdk_reactor *reactor;
+
+	current_core = spdk_env_get_current_core();
+	reactor = spdk_reactor_get(current_core);
+
+	assert(reactor != NULL);
+
+	spdk_json_write_object_begin(ctx->w);
+	spdk_json_write_named_uint32(ctx->w, "lcore", current_core);
+	rpc_write_msg_latency(spdk_msg_latency_get(reactor->event_latency), "src_lcore", ctx->w);
+	spdk_json_write_object_end(ctx->w);
+}
+
+static void
+rpc_framework_get_event_latency(struct spdk_jsonrpc_request *request,
+				const struct spdk_json_val *params)
+{
+	struct rpc_get_stats_ctx *ctx;
+
+	if (params) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "`framework_get_event_latency` requires no arguments");
+		return;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Memory allocation error");
+		return;
+	}
+
+	ctx->request = request;
+	ctx->w = spdk_jsonrpc_begin_result(ctx->request);
+
+	spdk_json_write_object_begin(ctx->w);
+	spdk_json_write_named_uint64(ctx->w, "tick_rate", spdk_get_ticks_hz());
+	spdk_json_write_named_array_begin(ctx->w, "reactors");
+
+	spdk_for_each_reactor(_rpc_framework_get_event_latency, ctx, NULL,
+			      rpc_framework_get_reactors_done);
+}
+
+SPDK_RPC_REGISTER("framework_get_event_latency", rpc_framework_get_event_latency,
+		  SPDK_RPC_RUNTIME)
+
 struct rpc_set_scheduler_ctx {
 	char *name;
 	uint64_t period;
@@ -35,6 +35,8 @@
 #include "spdk/likely.h"
 
 #include "spdk_internal/event.h"
+#include "spdk_internal/thread.h"
+#include "spdk_internal/trace_defs.h"
 #include "spdk_internal/usdt.h"
 
 #include "spdk/log.h"
@@ -44,6 +46,7 @@
 #include "spdk/scheduler.h"
 #include "spdk/string.h"
 #include "spdk/fd_group.h"
+#include "spdk/trace.h"
 
 #ifdef __linux__
 #include <sys/prctl.h>
@@ -62,6 +65,13 @@ static struct spdk_cpuset g_reactor_core_mask;
 static enum spdk_reactor_state	g_reactor_state = SPDK_REACTOR_STATE_UNINITIALIZED;
 
 static bool g_framework_context_switch_monitor_enabled = true;
+static bool g_framework_work_stealing_enabled = false;
+static bool g_framework_work_stealing_switching = false;
+static spdk_framework_work_stealing_cb g_framework_work_stealing_cb_fn;
+static void *g_framework_work_stealing_cb_arg;
+static uint32_t g_framework_hybrid_idle_us = 0;
+static uint64_t g_framework_hybrid_idle_tsc = 0;
+static uint32_t g_framework_hybrid_wakeups = 0;
 
 static struct spdk_mempool *g_spdk_event_mempool = NULL;
 
@@ -312,6 +322,7 @@ spdk_reactors_fini(void)
 		}
 
 		reactor_interrupt_fini(reactor);
+		free(reactor->event_latency);
 
 		if (g_core_infos != NULL) {
 			free(g_core_infos[i].thread_infos);
@@ -507,6 +518,13 @@ spdk_event_call(struct spdk_event *event)
 	assert(reactor != NULL);
 	assert(reactor->events != NULL);
 
+	if (spdk_unlikely(spdk_msg_latency_tracking_is_enabled())) {
+		event->tsc = spdk_get_ticks();
+		event->src_lcore = current_core;
+	} else {
+		event->tsc = 0;
+	}
+
 	rc = spdk_ring_enqueue(reactor->events, (void **)&event, 1, NULL);
 	if (rc != 1) {
 		assert(false);
@@ -531,6 +549,153 @@ spdk_event_call(struct spdk_event *event)
 	}
 }
 
+/* Work stealing between reactors.
+ *
+ * Each reactor has a single steal_slot. When more than one of its lightweight
+ * threads was busy during an iteration, it offers one of them in the slot. A reactor
+ * that found nothing to do takes the offer, polls the thread once and gives it back.
+ * lw_thread->running guarantees that a thread is polled by a single reactor at a time,
+ * while lw_thread->offered keeps the home reactor from moving or destroying a thread
+ * that another reactor may still reference.
+ */
+static inline bool
+_lw_thread_acquire(struct spdk_lw_thread *lw_thread)
+{
+	bool expected = false;
+
+	return __atomic_compare_exchange_n(&lw_thread->running, &expected, true, false,
+					   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static inline void
+_lw_thread_release(struct spdk_lw_thread *lw_thread)
+{
+	__atomic_store_n(&lw_thread->running, false, __ATOMIC_RELEASE);
+}
+
+/* Without work stealing no other reactor polls our threads, so skip the locked CAS. */
+static inline bool
+_reactor_lw_thread_acquire(struct spdk_reactor *reactor, struct spdk_lw_thread *lw_thread)
+{
+	return !reactor->lw_thread_shared || _lw_thread_acquire(lw_thread);
+}
+
+static inline void
+_reactor_lw_thread_release(struct spdk_reactor *reactor, struct spdk_lw_thread *lw_thread)
+{
+	if (reactor->lw_thread_shared) {
+		_lw_thread_release(lw_thread);
+	}
+}
+
+static bool
+_lw_thread_is_stealable(struct spdk_reactor *reactor, struct spdk_lw_thread *lw_thread)
+{
+	struct spdk_thread *thread = spdk_thread_get_from_ctx(lw_thread);
+
+	/* Events are executed on the first thread, so keep it at home. */
+	if (lw_thread == TAILQ_FIRST(&reactor->threads)) {
+		return false;
+	}
+
+	if (lw_thread->resched || spdk_thread_is_exited(thread)) {
+		return false;
+	}
+
+	return spdk_cpuset_count(spdk_thread_get_cpumask(thread)) > 1;
+}
+
+static void
+_reactor_offer_lw_thread(struct spdk_reactor *reactor, struct spdk_lw_thread *lw_thread)
+{
+	struct spdk_lw_thread *expected = NULL;
+
+	if (__atomic_load_n(&lw_thread->offered, __ATOMIC_ACQUIRE)) {
+		return;
+	}
+
+	__atomic_store_n(&lw_thread->offered, true, __ATOMIC_RELAXED);
+	if (!__atomic_compare_exchange_n(&reactor->steal_slot, &expected, lw_thread, false,
+					 __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+		/* The previous offer was not taken yet. */
+		__atomic_store_n(&lw_thread->offered, false, __ATOMIC_RELAXED);
+	}
+}
+
+/* Returns true if no other reactor can reference the thread anymore. */
+static bool
+_reactor_withdraw_lw_thread(struct spdk_reactor *reactor, struct spdk_lw_thread *lw_thread)
+{
+	struct spdk_lw_thread *expected = lw_thread;
+
+	if (!__atomic_load_n(&lw_thread->offered, __ATOMIC_ACQUIRE)) {
+		return true;
+	}
+
+	if (__atomic_compare_exchange_n(&reactor->steal_slot, &expected, NULL, false,
+					__ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+		__atomic_store_n(&lw_thread->offered, false, __ATOMIC_RELAXED);
+		return true;
+	}
+
+	/* The offer was taken and the thread may be running on another reactor. */
+	return false;
+}
+
+static void
+_reactor_steal_lw_thread(struct spdk_reactor *reactor)
+{
+	struct spdk_reactor *victim;
+	struct spdk_lw_thread *lw_thread;
+	struct spdk_thread *thread;
+	uint32_t i, lcore;
+	uint64_t now;
+	int rc;
+
+	if (spdk_unlikely(g_reactor_state != SPDK_REACTOR_STATE_RUNNING ||
+			  spdk_interrupt_mode_is_enabled())) {
+		return;
+	}
+
+	/* Start with the next core, so that offers are not always taken by the same reactor. */
+	lcore = reactor->lcore;
+	for (i = 1; i < spdk_env_get_core_count(); i++) {
+		lcore = spdk_env_get_next_core(lcore);
+		if (lcore == UINT32_MAX) {
+			lcore = spdk_env_get_first_core();
+		}
+
+		victim = spdk_reactor_get(lcore);
+		if (victim == NULL || victim == reactor ||
+		    __atomic_load_n(&victim->steal_slot, __ATOMIC_RELAXED) == NULL) {
+			continue;
+		}
+
+		lw_thread = __atomic_exchange_n(&victim->steal_slot, NULL, __ATOMIC_ACQ_REL);
+		if (lw_thread == NULL) {
+			continue;
+		}
+
+		thread = spdk_thread_get_from_ctx(lw_thread);
+		if (spdk_cpuset_get_cpu(spdk_thread_get_cpumask(thread), reactor->lcore) &&
+		    _lw_thread_acquire(lw_thread)) {
+			rc = spdk_thread_poll(thread, 0, reactor->tsc_last);
+			_lw_thread_release(lw_thread);
+
+			now = spdk_thread_get_last_tsc(thread);
+			if (rc == 0) {
+				reactor->idle_tsc += now - reactor->tsc_last;
+			} else if (rc > 0) {
+				reactor->busy_tsc += now - reactor->tsc_last;
+			}
+			reactor->tsc_last = now;
+		}
+
+		__atomic_store_n(&lw_thread->offered, false, __ATOMIC_RELEASE);
+		return;
+	}
+}
+
 static inline int
 event_queue_run_batch(void *arg)
 {
@@ -539,6 +704,8 @@ event_queue_run_batch(void *arg)
 	void *events[SPDK_EVENT_BATCH_SIZE];
 	struct spdk_thread *thread;
 	struct spdk_lw_thread *lw_thread;
+	uint64_t now = 0, wait_tsc;
+	bool shared;
 
 #ifdef DEBUG
 	/*
@@ -586,8 +753,14 @@ event_queue_run_batch(void *arg)
 	 * that must occur on an SPDK thread. To accomodate those, try to
 	 * run them on the first thread in the list, if it exists. */
 	lw_thread = TAILQ_FIRST(&reactor->threads);
+	/* The events may switch work stealing, so release the thread the way it was acquired. */
+	shared = reactor->lw_thread_shared;
 	if (lw_thread) {
 		thread = spdk_thread_get_from_ctx(lw_thread);
+		/* Another reactor may be polling this thread for a single iteration. */
+		while (spdk_unlikely(shared && !_lw_thread_acquire(lw_thread))) {
+			spdk_pause();
+		}
 	} else {
 		thread = NULL;
 	}
@@ -598,12 +771,26 @@ event_queue_run_batch(void *arg)
 		assert(event != NULL);
 		spdk_set_thread(thread);
 
+		if (spdk_unlikely(event->tsc != 0)) {
+			if (now == 0) {
+				now = spdk_get_ticks();
+			}
+			wait_tsc = now > event->tsc ? now - event->tsc : 0;
+			spdk_msg_latency_record(&reactor->event_latency, event->src_lcore, event->fn, wait_tsc);
+			spdk_trace_record_tsc(now, TRACE_THREAD_EVENT_WAIT, 0, 0, (uintptr_t)event->fn,
+					      event->src_lcore, wait_tsc);
+		}
+
 		SPDK_DTRACE_PROBE3(event_exec, event->fn,
 				   event->arg1, event->arg2);
 		event->fn(event->arg1, event->arg2);
 		spdk_set_thread(NULL);
 	}
 
+	if (lw_thread && shared) {
+		_lw_thread_release(lw_thread);
+	}
+
 	spdk_mempool_put_bulk(g_spdk_event_mempool, events, count);
 
 	return (int)count;
@@ -648,6 +835,121 @@ spdk_framework_context_switch_monitor_enabled(void)
 	return g_framework_context_switch_monitor_enabled;
 }
 
+static void
+_reactors_work_stealing_done(void *arg1, void *arg2)
+{
+	g_framework_work_stealing_switching = false;
+	g_framework_work_stealing_cb_fn(g_framework_work_stealing_cb_arg);
+}
+
+static void
+_reactor_enable_work_stealing(void *arg1, void *arg2)
+{
+	struct spdk_reactor *reactor = spdk_reactor_get(spdk_env_get_current_core());
+
+	assert(reactor != NULL);
+	reactor->lw_thread_shared = true;
+	reactor->work_stealing = true;
+}
+
+static void
+_reactor_unshare_lw_threads(void *arg1, void *arg2)
+{
+	struct spdk_reactor *reactor = spdk_reactor_get(spdk_env_get_current_core());
+
+	assert(reactor != NULL);
+	reactor->lw_thread_shared = false;
+}
+
+static void
+_reactors_work_stealing_stopped(void *arg1, void *arg2)
+{
+	/* Every reactor finished the iteration it may have stolen a thread in, so the
+	 * threads can be polled without acquiring them. */
+	spdk_for_each_reactor(_reactor_unshare_lw_threads, NULL, NULL,
+			      _reactors_work_stealing_done);
+}
+
+static void
+_reactor_stop_work_stealing(void *arg1, void *arg2)
+{
+	struct spdk_reactor *reactor = spdk_reactor_get(spdk_env_get_current_core());
+	struct spdk_lw_thread *lw_thread;
+
+	assert(reactor != NULL);
+	reactor->work_stealing = false;
+
+	lw_thread = __atomic_exchange_n(&reactor->steal_slot, NULL, __ATOMIC_ACQ_REL);
+	if (lw_thread != NULL) {
+		__atomic_store_n(&lw_thread->offered, false, __ATOMIC_RELEASE);
+	}
+}
+
+int
+spdk_framework_enable_work_stealing(bool enable, spdk_framework_work_stealing_cb cb_fn,
+				    void *cb_arg)
+{
+	if (spdk_get_thread() != _spdk_get_app_thread()) {
+		SPDK_ERRLOG("It is only permitted within spdk application thread.\n");
+		return -EPERM;
+	}
+
+	if (g_framework_work_stealing_switching) {
+		return -EBUSY;
+	}
+
+	g_framework_work_stealing_switching = true;
+	g_framework_work_stealing_enabled = enable;
+	g_framework_work_stealing_cb_fn = cb_fn;
+	g_framework_work_stealing_cb_arg = cb_arg;
+
+	/* A reactor only polls threads of other reactors once it acquires its own. When
+	 * disabling, acquiring is only dropped after no reactor can be stealing anymore. */
+	if (enable) {
+		spdk_for_each_reactor(_reactor_enable_work_stealing, NULL, NULL,
+				      _reactors_work_stealing_done);
+	} else {
+		spdk_for_each_reactor(_reactor_stop_work_stealing, NULL, NULL,
+				      _reactors_work_stealing_stopped);
+	}
+
+	return 0;
+}
+
+bool
+spdk_framework_work_stealing_enabled(void)
+{
+	return g_framework_work_stealing_enabled;
+}
+
+int
+spdk_framework_set_hybrid_mode(uint32_t idle_us, uint32_t wakeups)
+{
+	if (idle_us > 0) {
+		if (wakeups == 0) {
+			return -EINVAL;
+		}
+
+		/* Threads can only run in interrupt mode if all their pollers do */
+		if (!spdk_interrupt_mode_is_enabled()) {
+			return -ENOTSUP;
+		}
+	}
+
+	g_framework_hybrid_wakeups = wakeups;
+	g_framework_hybrid_idle_us = idle_us;
+	g_framework_hybrid_idle_tsc = idle_us * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+
+	return 0;
+}
+
+void
+spdk_framework_get_hybrid_mode(uint32_t *idle_us, uint32_t *wakeups)
+{
+	*idle_us = g_framework_hybrid_idle_us;
+	*wakeups = g_framework_hybrid_wakeups;
+}
+
 static void
 _set_thread_name(const char *thread_name)
 {
@@ -735,6 +1037,10 @@ _reactors_scheduler_update_core_mode(void *ctx)
 	for (i = g_scheduler_core_number; i < SPDK_ENV_LCORE_ID_ANY; i = spdk_env_get_next_core(i)) {
 		reactor = spdk_reactor_get(i);
 		assert(reactor != NULL);
+		/* In hybrid mode reactors with threads switch to poll mode on their own */
+		if (g_framework_hybrid_idle_tsc > 0 && !g_core_infos[i].interrupt_mode) {
+			continue;
+		}
 		if (reactor->in_interrupt != g_core_infos[i].interrupt_mode) {
 			/* Switch next found reactor to new state */
 			rc = spdk_reactor_set_interrupt_mode(i, g_core_infos[i].interrupt_mode,
@@ -826,6 +1132,13 @@ _reactors_scheduler_gather_metrics(void *arg1, void *arg2)
 			core_info->thread_infos[i].thread_id = spdk_thread_get_id(thread);
 			core_info->thread_infos[i].total_stats = lw_thread->total_stats;
 			core_info->thread_infos[i].current_stats = lw_thread->current_stats;
+			/* The I/O channels can only be looked at while no other reactor polls the
+			 * thread. Otherwise keep the node found during an earlier period. */
+			if (_reactor_lw_thread_acquire(reactor, lw_thread)) {
+				lw_thread->numa_id = spdk_thread_get_numa_id(thread);
+				_reactor_lw_thread_release(reactor, lw_thread);
+			}
+			core_info->thread_infos[i].numa_id = lw_thread->numa_id;
 			core_info->threads_count++;
 			assert(core_info->threads_count <= reactor->thread_count);
 			i++;
@@ -875,6 +1188,10 @@ reactor_post_process_lw_thread(struct spdk_reactor *reactor, struct spdk_lw_thre
 	struct spdk_thread *thread = spdk_thread_get_from_ctx(lw_thread);
 
 	if (spdk_unlikely(lw_thread->resched)) {
+		if (!_reactor_withdraw_lw_thread(reactor, lw_thread)) {
+			/* Retry once the other reactor is done with the thread */
+			return false;
+		}
 		lw_thread->resched = false;
 		_reactor_remove_lw_thread(reactor, lw_thread);
 		_reactor_schedule_thread(thread);
@@ -882,7 +1199,8 @@ reactor_post_process_lw_thread(struct spdk_reactor *reactor, struct spdk_lw_thre
 	}
 
 	if (spdk_unlikely(spdk_thread_is_exited(thread) &&
-			  spdk_thread_is_idle(thread))) {
+			  spdk_thread_is_idle(thread) &&
+			  _reactor_withdraw_lw_thread(reactor, lw_thread))) {
 		_reactor_remove_lw_thread(reactor, lw_thread);
 		spdk_thread_destroy(thread);
 		return true;
@@ -891,23 +1209,101 @@ reactor_post_process_lw_thread(struct spdk_reactor *reactor, struct spdk_lw_thre
 	return false;
 }
 
-static void
+static int
 reactor_interrupt_run(struct spdk_reactor *reactor)
 {
 	int block_timeout = -1; /* _EPOLL_WAIT_FOREVER */
 
-	spdk_fd_group_wait(reactor->fgrp, block_timeout);
+	return spdk_fd_group_wait(reactor->fgrp, block_timeout);
+}
+
+/* Returns true if the reactor should switch to the other mode */
+static bool
+_reactor_hybrid_check(struct spdk_reactor *reactor, uint64_t now, bool work)
+{
+	if (reactor->hybrid_in_interrupt != reactor->in_interrupt) {
+		/* Mode changed, start over */
+		reactor->hybrid_in_interrupt = reactor->in_interrupt;
+		reactor->hybrid_tsc = now;
+		reactor->hybrid_wakeups = 0;
+	}
+
+	if (reactor->hybrid_switch_pending) {
+		return false;
+	}
+
+	if (!reactor->in_interrupt) {
+		if (work) {
+			reactor->hybrid_tsc = now;
+			return false;
+		}
+
+		return now - reactor->hybrid_tsc > g_framework_hybrid_idle_tsc;
+	}
+
+	if (!work) {
+		return false;
+	}
+
+	if (now - reactor->hybrid_tsc > g_framework_hybrid_idle_tsc) {
+		reactor->hybrid_tsc = now;
+		reactor->hybrid_wakeups = 0;
+	}
+
+	return ++reactor->hybrid_wakeups >= g_framework_hybrid_wakeups;
+}
+
+static void
+_reactor_hybrid_set_mode_done(void *ctx)
+{
+	struct spdk_reactor *reactor = ctx;
+
+	reactor->hybrid_switch_pending = false;
+}
+
+static void
+_reactor_hybrid_set_mode(void *ctx)
+{
+	struct spdk_reactor *reactor = ctx;
+	int rc;
+
+	rc = spdk_reactor_set_interrupt_mode(reactor->lcore, !reactor->hybrid_in_interrupt,
+					     _reactor_hybrid_set_mode_done, reactor);
+	if (rc != 0) {
+		/* Most likely the scheduler is switching this reactor, try again later */
+		SPDK_DEBUGLOG(reactor, "Hybrid mode switch of reactor %u failed: %d\n", reactor->lcore, rc);
+		reactor->hybrid_switch_pending = false;
+	}
+}
+
+static void
+_reactor_hybrid_update(struct spdk_reactor *reactor, uint64_t now, bool work)
+{
+	if (reactor->fgrp == NULL || !_reactor_hybrid_check(reactor, now, work)) {
+		return;
+	}
+
+	/* Measure from scratch in case the switch does not happen */
+	reactor->hybrid_tsc = now;
+	reactor->hybrid_wakeups = 0;
+
+	/* Only the app thread may switch reactor modes */
+	reactor->hybrid_switch_pending = true;
+	if (spdk_thread_send_msg(_spdk_get_app_thread(), _reactor_hybrid_set_mode, reactor) != 0) {
+		reactor->hybrid_switch_pending = false;
+	}
 }
 
 static void
 _reactor_run(struct spdk_reactor *reactor)
 {
 	struct spdk_thread	*thread;
-	struct spdk_lw_thread	*lw_thread, *tmp;
+	struct spdk_lw_thread	*lw_thread, *tmp, *offer = NULL;
+	uint32_t		busy_count = 0;
 	uint64_t		now;
 	int			rc;
 
-	event_queue_run_batch(reactor);
+	rc = event_queue_run_batch(reactor);
 
 	/* If no threads are present on the reactor,
 	 * tsc_last gets outdated. Update it to track
@@ -916,22 +1312,45 @@ _reactor_run(struct spdk_reactor *reactor)
 		now = spdk_get_ticks();
 		reactor->idle_tsc += now - reactor->tsc_last;
 		reactor->tsc_last = now;
+		if (reactor->work_stealing && rc == 0) {
+			_reactor_steal_lw_thread(reactor);
+		}
 		return;
 	}
 
 	TAILQ_FOREACH_SAFE(lw_thread, &reactor->threads, link, tmp) {
 		thread = spdk_thread_get_from_ctx(lw_thread);
+		if (spdk_unlikely(!_reactor_lw_thread_acquire(reactor, lw_thread))) {
+			/* Stolen by another reactor for this iteration */
+			continue;
+		}
+
 		rc = spdk_thread_poll(thread, 0, reactor->tsc_last);
+		_reactor_lw_thread_release(reactor, lw_thread);
 
 		now = spdk_thread_get_last_tsc(thread);
 		if (rc == 0) {
 			reactor->idle_tsc += now - reactor->tsc_last;
 		} else if (rc > 0) {
 			reactor->busy_tsc += now - reactor->tsc_last;
+			busy_count++;
+			if (reactor->work_stealing && _lw_thread_is_stealable(reactor, lw_thread)) {
+				offer = lw_thread;
+			}
 		}
 		reactor->tsc_last = now;
 
-		reactor_post_process_lw_thread(reactor, lw_thread);
+		if (reactor_post_process_lw_thread(reactor, lw_thread) && offer == lw_thread) {
+			offer = NULL;
+		}
+	}
+
+	if (reactor->work_stealing) {
+		if (busy_count > 1 && offer != NULL) {
+			_reactor_offer_lw_thread(reactor, offer);
+		} else if (busy_count == 0) {
+			_reactor_steal_lw_thread(reactor);
+		}
 	}
 }
 
@@ -943,6 +1362,7 @@ reactor_run(void *arg)
 	struct spdk_lw_thread	*lw_thread, *tmp;
 	char			thread_name[32];
 	uint64_t		last_sched = 0;
+	int			rc;
 
 	SPDK_NOTICELOG("Reactor started on core %u\n", reactor->lcore);
 
@@ -957,9 +1377,17 @@ reactor_run(void *arg)
 	while (1) {
 		/* Execute interrupt process fn if this reactor currently runs in interrupt state */
 		if (spdk_unlikely(reactor->in_interrupt)) {
-			reactor_interrupt_run(reactor);
+			rc = reactor_interrupt_run(reactor);
+			if (spdk_unlikely(g_framework_hybrid_idle_tsc > 0)) {
+				_reactor_hybrid_update(reactor, spdk_get_ticks(), rc > 0);
+			}
 		} else {
 			_reactor_run(reactor);
+			if (spdk_unlikely(g_framework_hybrid_idle_tsc > 0)) {
+				_reactor_hybrid_update(reactor, reactor->tsc_last,
+						       reactor->busy_tsc != reactor->hybrid_busy_tsc);
+				reactor->hybrid_busy_tsc = reactor->busy_tsc;
+			}
 		}
 
 		if (g_framework_context_switch_monitor_enabled) {
@@ -985,13 +1413,20 @@ reactor_run(void *arg)
 
 	TAILQ_FOREACH(lw_thread, &reactor->threads, link) {
 		thread = spdk_thread_get_from_ctx(lw_thread);
+		while (!_lw_thread_acquire(lw_thread)) {
+			spdk_pause();
+		}
 		spdk_set_thread(thread);
 		spdk_thread_exit(thread);
+		_lw_thread_release(lw_thread);
 	}
 
 	while (!TAILQ_EMPTY(&reactor->threads)) {
 		TAILQ_FOREACH_SAFE(lw_thread, &reactor->threads, link, tmp) {
 			thread = spdk_thread_get_from_ctx(lw_thread);
+			if (!_reactor_withdraw_lw_thread(reactor, lw_thread)) {
+				continue;
+			}
 			spdk_set_thread(thread);
 			if (spdk_thread_is_exited(thread)) {
 				_reactor_remove_lw_thread(reactor, lw_thread);
@@ -1200,6 +1635,7 @@ _reactor_schedule_thread(struct spdk_thread *thread)
 	assert(lw_thread != NULL);
 	core = lw_thread->lcore;
 	memset(lw_thread, 0, sizeof(*lw_thread));
+	lw_thread->numa_id = SPDK_ENV_SOCKET_ID_ANY;
 
 	if (current_lcore != SPDK_ENV_LCORE_ID_ANY) {
 		local_reactor = spdk_reactor_get(current_lcore);
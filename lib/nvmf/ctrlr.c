@@ -4046,6 +4046,212 @@ nvmf_ctrlr_process_io_cmd(struct spdk_nvmf_request *req)
 	}
 }
 
+static void
+nvmf_qos_policy_update_timeslice(struct spdk_nvmf_qos_policy *policy, uint64_t now)
+{
+	uint64_t timeslice, prev_timeslice;
+	int64_t remaining, quota;
+	int i;
+
+	timeslice = now / policy->timeslice_ticks;
+	prev_timeslice = __atomic_load_n(&policy->timeslice, __ATOMIC_RELAXED);
+	if (spdk_likely(timeslice == prev_timeslice)) {
+		return;
+	}
+
+	/* Only the poll group that moves the policy to the new timeslice refills its quota */
+	if (!__atomic_compare_exchange_n(&policy->timeslice, &prev_timeslice, timeslice, false,
+					 __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+		return;
+	}
+
+	for (i = 0; i < NVMF_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		quota = policy->quota_per_timeslice[i];
+		if (quota == 0) {
+			continue;
+		}
+
+		/* Carry over any deficit, but don't let an idle period accumulate quota */
+		remaining = __atomic_load_n(&policy->remaining_this_timeslice[i], __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&policy->remaining_this_timeslice[i], &remaining,
+						    remaining < 0 ? remaining + quota : quota, false,
+						    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+		}
+	}
+}
+
+static bool
+nvmf_qos_policy_allows(struct spdk_nvmf_qos_policy *policy, uint64_t now)
+{
+	int i;
+
+	if (policy->limits.max_queue_depth > 0 &&
+	    __atomic_load_n(&policy->ref, __ATOMIC_RELAXED) > policy->limits.max_queue_depth) {
+		return false;
+	}
+
+	nvmf_qos_policy_update_timeslice(policy, now);
+
+	for (i = 0; i < NVMF_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		if (policy->quota_per_timeslice[i] > 0 &&
+		    __atomic_load_n(&policy->remaining_this_timeslice[i], __ATOMIC_RELAXED) <= 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void
+nvmf_qos_policy_charge(struct spdk_nvmf_qos_policy *policy, uint32_t length)
+{
+	__atomic_add_fetch(&policy->ref, 1, __ATOMIC_RELAXED);
+
+	if (policy->quota_per_timeslice[NVMF_QOS_RW_IOPS_RATE_LIMIT] > 0) {
+		__atomic_sub_fetch(&policy->remaining_this_timeslice[NVMF_QOS_RW_IOPS_RATE_LIMIT], 1,
+				   __ATOMIC_RELAXED);
+	}
+
+	if (policy->quota_per_timeslice[NVMF_QOS_RW_BPS_RATE_LIMIT] > 0) {
+		__atomic_sub_fetch(&policy->remaining_this_timeslice[NVMF_QOS_RW_BPS_RATE_LIMIT], length,
+				   __ATOMIC_RELAXED);
+	}
+}
+
+/*
+ * Returns false if the QoS policies of the request's host or namespace are out of
+ * quota. Otherwise, accounts the request against them and returns true.
+ */
+static bool
+nvmf_qos_admit(struct spdk_nvmf_ctrlr *ctrlr, struct spdk_nvmf_request *req)
+{
+	struct nvmf_ctrlr_qos *qos;
+	struct spdk_nvmf_qos_policy *host_policy, *any_host_policy;
+	uint32_t nsid = req->cmd->nvme_cmd.nsid;
+	uint64_t now;
+
+	qos = __atomic_load_n(&ctrlr->qos, __ATOMIC_ACQUIRE);
+	if (spdk_likely(qos == NULL)) {
+		return true;
+	}
+
+	if (nsid - 1 < qos->num_ns) {
+		host_policy = qos->ns[nsid - 1].host;
+		any_host_policy = qos->ns[nsid - 1].any_host;
+	} else {
+		host_policy = qos->host_default;
+		any_host_policy = qos->any_host_default;
+	}
+
+	/* The second command of a fused operation has to follow the first one immediately,
+	 * so fused commands are accounted for, but never held back.
+	 */
+	if (!(req->cmd->nvme_cmd.fuse & SPDK_NVME_CMD_FUSE_MASK)) {
+		now = spdk_get_ticks();
+		if (host_policy != NULL && !nvmf_qos_policy_allows(host_policy, now)) {
+			return false;
+		}
+		if (any_host_policy != NULL && !nvmf_qos_policy_allows(any_host_policy, now)) {
+			return false;
+		}
+	}
+
+	if (host_policy != NULL) {
+		nvmf_qos_policy_charge(host_policy, req->length);
+		req->qos_policy[0] = host_policy;
+	}
+	if (any_host_policy != NULL) {
+		nvmf_qos_policy_charge(any_host_policy, req->length);
+		req->qos_policy[1] = any_host_policy;
+	}
+
+	return true;
+}
+
+static void
+nvmf_qos_release(struct spdk_nvmf_request *req)
+{
+	int i;
+
+	for (i = 0; i < (int)SPDK_COUNTOF(req->qos_policy); i++) {
+		if (req->qos_policy[i] != NULL) {
+			nvmf_qos_policy_put(req->qos_policy[i]);
+			req->qos_policy[i] = NULL;
+		}
+	}
+}
+
+static int
+nvmf_qos_poll(void *ctx)
+{
+	struct spdk_nvmf_subsystem_poll_group *sgroup = ctx;
+	struct spdk_nvmf_request *req;
+	TAILQ_HEAD(, spdk_nvmf_request) reqs;
+	int count = 0;
+
+	/* Requests that are still over the limits go back to sgroup->qos_queued,
+	 * so swap the list out first to keep the order of the requests.
+	 */
+	TAILQ_INIT(&reqs);
+	TAILQ_SWAP(&reqs, &sgroup->qos_queued, spdk_nvmf_request, link);
+
+	while (!TAILQ_EMPTY(&reqs)) {
+		req = TAILQ_FIRST(&reqs);
+		TAILQ_REMOVE(&reqs, req, link);
+		spdk_nvmf_request_exec(req);
+		count++;
+	}
+
+	if (TAILQ_EMPTY(&sgroup->qos_queued)) {
+		spdk_poller_unregister(&sgroup->qos_poller);
+	}
+
+	return count > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+static void
+nvmf_qpair_latency_recv(struct spdk_nvmf_qpair *qpair, struct spdk_nvmf_request *req)
+{
+	if (spdk_unlikely(qpair->histograms == NULL)) {
+		/* First I/O since the histograms were enabled */
+		qpair->histograms = nvmf_latency_histograms_alloc();
+		if (qpair->histograms == NULL) {
+			return;
+		}
+	}
+
+	if (spdk_unlikely(req->zcopy_phase != NVMF_ZCOPY_PHASE_NONE)) {
+		/* zcopy requests complete more than once, so they are not tracked */
+		req->recv_tsc = 0;
+	} else if (req->recv_tsc == 0) {
+		req->recv_tsc = spdk_get_ticks();
+	}
+}
+
+static void
+nvmf_qpair_latency_tally(struct spdk_nvmf_qpair *qpair, uint64_t recv_tsc, uint64_t submit_tsc,
+			 uint64_t complete_tsc)
+{
+	struct spdk_nvmf_latency_histograms *histograms = qpair->histograms;
+	uint64_t now;
+
+	/* The histograms may have been disabled while the request was outstanding */
+	if (histograms == NULL) {
+		return;
+	}
+
+	now = spdk_get_ticks();
+
+	/* Requests that failed before reaching the backend have no submission time */
+	if (submit_tsc != 0) {
+		spdk_histogram_data_tally(histograms->data[SPDK_NVMF_LATENCY_QUEUE], submit_tsc - recv_tsc);
+		spdk_histogram_data_tally(histograms->data[SPDK_NVMF_LATENCY_BACKEND],
+					  complete_tsc - submit_tsc);
+	}
+	spdk_histogram_data_tally(histograms->data[SPDK_NVMF_LATENCY_RESPONSE], now - complete_tsc);
+	spdk_histogram_data_tally(histograms->data[SPDK_NVMF_LATENCY_TOTAL], now - recv_tsc);
+}
+
 static void
 nvmf_qpair_request_cleanup(struct spdk_nvmf_qpair *qpair)
 {
@@ -4085,6 +4291,7 @@ _nvmf_request_complete(void *ctx)
 	uint32_t nsid;
 	bool paused;
 	uint8_t opcode;
+	uint64_t recv_tsc = 0, submit_tsc = 0, complete_tsc = 0;
 
 	rsp->sqid = 0;
 	rsp->status.p = 0;
@@ -4139,10 +4346,22 @@ _nvmf_request_complete(void *ctx)
 		break;
 	}
 
+	if (spdk_unlikely(req->recv_tsc != 0)) {
+		recv_tsc = req->recv_tsc;
+		submit_tsc = req->submit_tsc;
+		complete_tsc = spdk_get_ticks();
+		req->recv_tsc = 0;
+		req->submit_tsc = 0;
+	}
+
 	if (nvmf_transport_req_complete(req)) {
 		SPDK_ERRLOG("Transport request completion error!\n");
 	}
 
+	if (spdk_unlikely(recv_tsc != 0)) {
+		nvmf_qpair_latency_tally(qpair, recv_tsc, submit_tsc, complete_tsc);
+	}
+
 	/* AER cmd is an exception */
 	if (sgroup && !is_aer) {
 		if (spdk_unlikely(opcode == SPDK_NVME_OPC_FABRIC ||
@@ -4159,6 +4378,8 @@ _nvmf_request_complete(void *ctx)
 				if (spdk_likely(nsid - 1 < sgroup->num_ns)) {
 					sgroup->ns_info[nsid - 1].io_outstanding--;
 				}
+
+				nvmf_qos_release(req);
 			}
 		}
 
@@ -4250,6 +4471,10 @@ static bool nvmf_check_subsystem_active(struct spdk_nvmf_request *req)
 			}
 			sgroup->mgmt_io_outstanding++;
 		} else {
+			if (spdk_unlikely(sgroup->histograms != NULL)) {
+				nvmf_qpair_latency_recv(qpair, req);
+			}
+
 			nsid = req->cmd->nvme_cmd.nsid;
 
 			/* NOTE: This implicitly also checks for 0, since 0 - 1 wraps around to UINT32_MAX. */
@@ -4283,6 +4508,16 @@ static bool nvmf_check_subsystem_active(struct spdk_nvmf_request *req)
 				return false;
 			}
 
+			if (spdk_unlikely(!nvmf_qos_admit(qpair->ctrlr, req))) {
+				/* Over the QoS limits. Retry on the next timeslice. */
+				TAILQ_INSERT_TAIL(&sgroup->qos_queued, req, link);
+				if (sgroup->qos_poller == NULL) {
+					sgroup->qos_poller = SPDK_POLLER_REGISTER(nvmf_qos_poll, sgroup,
+							     NVMF_QOS_TIMESLICE_IN_USEC);
+				}
+				return false;
+			}
+
 			ns_info->io_outstanding++;
 		}
 
@@ -4322,6 +4557,9 @@ spdk_nvmf_request_exec(struct spdk_nvmf_request *req)
 	} else if (spdk_unlikely(nvmf_qpair_is_admin_queue(qpair))) {
 		status = nvmf_ctrlr_process_admin_cmd(req);
 	} else {
+		if (spdk_unlikely(req->recv_tsc != 0)) {
+			req->submit_tsc = spdk_get_ticks();
+		}
 		status = nvmf_ctrlr_process_io_cmd(req);
 	}
 
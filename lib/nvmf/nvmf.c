@@ -135,6 +135,8 @@ nvmf_tgt_cleanup_poll_group(struct spdk_nvmf_poll_group *group)
 		}
 
 		free(sgroup->ns_info);
+		spdk_poller_unregister(&sgroup->qos_poller);
+		nvmf_latency_histograms_free(sgroup->histograms);
 	}
 
 	free(group->sgroups);
@@ -449,6 +451,9 @@ nvmf_write_subsystem_config_json(struct spdk_json_write_ctx *w,
 	const struct spdk_nvme_transport_id *trid;
 	struct spdk_nvmf_ns *ns;
 	struct spdk_nvmf_ns_opts ns_opts;
+	struct spdk_nvmf_qos_policy *policy;
+	struct spdk_nvmf_qos_limits qos_limits;
+	const char *hostnqn;
 	uint32_t max_namespaces;
 	char uuid_str[SPDK_UUID_STRING_LEN];
 
@@ -568,6 +573,35 @@ nvmf_write_subsystem_config_json(struct spdk_json_write_ctx *w,
 		/* } */
 		spdk_json_write_object_end(w);
 	}
+
+	for (policy = spdk_nvmf_subsystem_get_first_qos_policy(subsystem); policy != NULL;
+	     policy = spdk_nvmf_subsystem_get_next_qos_policy(subsystem, policy)) {
+		hostnqn = spdk_nvmf_qos_policy_get_hostnqn(policy);
+		spdk_nvmf_qos_policy_get_limits(policy, &qos_limits);
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "method", "nvmf_subsystem_set_qos_limits");
+
+		/*     "params" : { */
+		spdk_json_write_named_object_begin(w, "params");
+
+		spdk_json_write_named_string(w, "nqn", spdk_nvmf_subsystem_get_nqn(subsystem));
+		if (hostnqn != NULL) {
+			spdk_json_write_named_string(w, "host", hostnqn);
+		}
+		if (spdk_nvmf_qos_policy_get_nsid(policy) != 0) {
+			spdk_json_write_named_uint32(w, "nsid", spdk_nvmf_qos_policy_get_nsid(policy));
+		}
+		spdk_json_write_named_uint64(w, "rw_ios_per_sec", qos_limits.rw_ios_per_sec);
+		spdk_json_write_named_uint64(w, "rw_mbytes_per_sec", qos_limits.rw_mbytes_per_sec);
+		spdk_json_write_named_uint32(w, "max_queue_depth", qos_limits.max_queue_depth);
+
+		/*     } "params" */
+		spdk_json_write_object_end(w);
+
+		/* } */
+		spdk_json_write_object_end(w);
+	}
 }
 
 void
@@ -624,11 +658,12 @@ nvmf_listen_opts_copy(struct spdk_nvmf_listen_opts *opts,
     } \
 
 	SET_FIELD(transport_specific);
+	SET_FIELD(secure_channel);
 #undef SET_FIELD
 
 	/* Do not remove this statement, you should always update this statement when you adding a new field,
 	 * and do not forget to add the SET_FIELD statement for your added field. */
-	SPDK_STATIC_ASSERT(sizeof(struct spdk_nvmf_listen_opts) == 16, "Incorrect size");
+	SPDK_STATIC_ASSERT(sizeof(struct spdk_nvmf_listen_opts) == 24, "Incorrect size");
 }
 
 void
@@ -1061,12 +1096,28 @@ _nvmf_qpair_destroy(void *ctx, int status)
 			if (req->qpair == qpair) {
 				TAILQ_REMOVE(&sgroup->queued, req, link);
 				if (nvmf_transport_req_free(req)) {
-					SPDK_ERRLOG("Transport request free error!/n");
+					SPDK_ERRLOG("Transport request free error!\n");
 				}
 			}
 		}
+		TAILQ_FOREACH_SAFE(req, &sgroup->qos_queued, link, tmp) {
+			if (req->qpair == qpair) {
+				TAILQ_REMOVE(&sgroup->qos_queued, req, link);
+				if (nvmf_transport_req_free(req)) {
+					SPDK_ERRLOG("Transport request free error!\n");
+				}
+			}
+		}
+
+		/* Keep the latencies of the qpair in the subsystem's histograms */
+		if (qpair->histograms != NULL && sgroup->histograms != NULL) {
+			nvmf_latency_histograms_merge(sgroup->histograms->data, qpair->histograms);
+		}
 	}
 
+	nvmf_latency_histograms_free(qpair->histograms);
+	qpair->histograms = NULL;
+
 	qpair_ctx->ctrlr = ctrlr;
 	spdk_nvmf_poll_group_remove(qpair);
 	nvmf_transport_qpair_fini(qpair, _nvmf_transport_qpair_fini_complete, qpair_ctx);
@@ -1379,6 +1430,7 @@ nvmf_poll_group_add_subsystem(struct spdk_nvmf_poll_group *group,
 	uint32_t i;
 
 	TAILQ_INIT(&sgroup->queued);
+	TAILQ_INIT(&sgroup->qos_queued);
 
 	rc = poll_group_update_subsystem(group, subsystem);
 	if (rc) {
@@ -1386,6 +1438,14 @@ nvmf_poll_group_add_subsystem(struct spdk_nvmf_poll_group *group,
 		goto fini;
 	}
 
+	if (subsystem->histogram_enabled && sgroup->histograms == NULL) {
+		sgroup->histograms = nvmf_latency_histograms_alloc();
+		if (sgroup->histograms == NULL) {
+			SPDK_ERRLOG("Unable to allocate latency histograms for subsystem %s\n",
+				    subsystem->subnqn);
+		}
+	}
+
 	sgroup->state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
 
 	for (i = 0; i < sgroup->num_ns; i++) {
@@ -1434,6 +1494,9 @@ _nvmf_poll_group_remove_subsystem_cb(void *ctx, int status)
 	sgroup->num_ns = 0;
 	free(sgroup->ns_info);
 	sgroup->ns_info = NULL;
+	spdk_poller_unregister(&sgroup->qos_poller);
+	nvmf_latency_histograms_free(sgroup->histograms);
+	sgroup->histograms = NULL;
 fini:
 	free(qpair_ctx);
 	if (cpl_fn) {
@@ -1691,3 +1754,205 @@ spdk_nvmf_poll_group_dump_stat(struct spdk_nvmf_poll_group *group, struct spdk_j
 	spdk_json_write_array_end(w);
 	spdk_json_write_object_end(w);
 }
+
+struct nvmf_histogram_ctx {
+	struct spdk_nvmf_subsystem			*subsystem;
+	spdk_nvmf_subsystem_histogram_status_cb		status_cb_fn;
+	spdk_nvmf_subsystem_histogram_data_cb		data_cb_fn;
+	void						*cb_arg;
+	int						status;
+
+	/* Used to get the histograms */
+	uint16_t					cntlid;
+	int32_t						qid;
+	struct spdk_histogram_data			**histograms;
+};
+
+static void
+nvmf_histogram_disable_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct nvmf_histogram_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_nvmf_subsystem *subsystem = ctx->subsystem;
+
+	pthread_mutex_lock(&subsystem->mutex);
+	subsystem->histogram_in_progress = false;
+	pthread_mutex_unlock(&subsystem->mutex);
+
+	ctx->status_cb_fn(ctx->cb_arg, ctx->status);
+	free(ctx);
+}
+
+static void
+nvmf_histogram_disable_on_pg(struct spdk_io_channel_iter *i)
+{
+	struct nvmf_histogram_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct spdk_nvmf_poll_group *group = spdk_io_channel_get_ctx(ch);
+	struct spdk_nvmf_subsystem_poll_group *sgroup = &group->sgroups[ctx->subsystem->id];
+	struct spdk_nvmf_qpair *qpair;
+
+	nvmf_latency_histograms_free(sgroup->histograms);
+	sgroup->histograms = NULL;
+
+	TAILQ_FOREACH(qpair, &group->qpairs, link) {
+		if (qpair->ctrlr != NULL && qpair->ctrlr->subsys == ctx->subsystem) {
+			nvmf_latency_histograms_free(qpair->histograms);
+			qpair->histograms = NULL;
+		}
+	}
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+nvmf_histogram_enable_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct nvmf_histogram_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_nvmf_subsystem *subsystem = ctx->subsystem;
+
+	if (status != 0) {
+		ctx->status = status;
+		subsystem->histogram_enabled = false;
+		spdk_for_each_channel(subsystem->tgt, nvmf_histogram_disable_on_pg, ctx,
+				      nvmf_histogram_disable_done);
+		return;
+	}
+
+	pthread_mutex_lock(&subsystem->mutex);
+	subsystem->histogram_in_progress = false;
+	pthread_mutex_unlock(&subsystem->mutex);
+
+	ctx->status_cb_fn(ctx->cb_arg, 0);
+	free(ctx);
+}
+
+static void
+nvmf_histogram_enable_on_pg(struct spdk_io_channel_iter *i)
+{
+	struct nvmf_histogram_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct spdk_nvmf_poll_group *group = spdk_io_channel_get_ctx(ch);
+	struct spdk_nvmf_subsystem_poll_group *sgroup = &group->sgroups[ctx->subsystem->id];
+
+	/* The qpairs allocate their own histograms on their next I/O. Poll groups that
+	 * don't have the subsystem yet allocate the histograms when it is added.
+	 */
+	if (sgroup->state != SPDK_NVMF_SUBSYSTEM_INACTIVE && sgroup->histograms == NULL) {
+		sgroup->histograms = nvmf_latency_histograms_alloc();
+		if (sgroup->histograms == NULL) {
+			spdk_for_each_channel_continue(i, -ENOMEM);
+			return;
+		}
+	}
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+void
+spdk_nvmf_subsystem_histogram_enable(struct spdk_nvmf_subsystem *subsystem,
+				     spdk_nvmf_subsystem_histogram_status_cb cb_fn,
+				     void *cb_arg, bool enable)
+{
+	struct nvmf_histogram_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->subsystem = subsystem;
+	ctx->status_cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	pthread_mutex_lock(&subsystem->mutex);
+	if (subsystem->histogram_in_progress) {
+		pthread_mutex_unlock(&subsystem->mutex);
+		free(ctx);
+		cb_fn(cb_arg, -EAGAIN);
+		return;
+	}
+
+	subsystem->histogram_in_progress = true;
+	pthread_mutex_unlock(&subsystem->mutex);
+
+	subsystem->histogram_enabled = enable;
+
+	if (enable) {
+		spdk_for_each_channel(subsystem->tgt, nvmf_histogram_enable_on_pg, ctx,
+				      nvmf_histogram_enable_done);
+	} else {
+		spdk_for_each_channel(subsystem->tgt, nvmf_histogram_disable_on_pg, ctx,
+				      nvmf_histogram_disable_done);
+	}
+}
+
+bool
+spdk_nvmf_subsystem_histogram_enabled(const struct spdk_nvmf_subsystem *subsystem)
+{
+	return subsystem->histogram_enabled;
+}
+
+static void
+nvmf_histogram_get_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct nvmf_histogram_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	ctx->data_cb_fn(ctx->cb_arg, status, ctx->histograms);
+	free(ctx);
+}
+
+static void
+nvmf_histogram_get_on_pg(struct spdk_io_channel_iter *i)
+{
+	struct nvmf_histogram_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct spdk_nvmf_poll_group *group = spdk_io_channel_get_ctx(ch);
+	struct spdk_nvmf_subsystem_poll_group *sgroup = &group->sgroups[ctx->subsystem->id];
+	struct spdk_nvmf_qpair *qpair;
+
+	if (ctx->cntlid == 0 && sgroup->histograms != NULL) {
+		nvmf_latency_histograms_merge(ctx->histograms, sgroup->histograms);
+	}
+
+	TAILQ_FOREACH(qpair, &group->qpairs, link) {
+		if (qpair->histograms == NULL || qpair->ctrlr == NULL ||
+		    qpair->ctrlr->subsys != ctx->subsystem) {
+			continue;
+		}
+
+		if (ctx->cntlid != 0 && (qpair->ctrlr->cntlid != ctx->cntlid ||
+					 (ctx->qid >= 0 && qpair->qid != ctx->qid))) {
+			continue;
+		}
+
+		nvmf_latency_histograms_merge(ctx->histograms, qpair->histograms);
+	}
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+void
+spdk_nvmf_subsystem_histogram_get(struct spdk_nvmf_subsystem *subsystem,
+				  uint16_t cntlid, int32_t qid,
+				  struct spdk_histogram_data **histograms,
+				  spdk_nvmf_subsystem_histogram_data_cb cb_fn, void *cb_arg)
+{
+	struct nvmf_histogram_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM, histograms);
+		return;
+	}
+
+	ctx->subsystem = subsystem;
+	ctx->data_cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	ctx->cntlid = cntlid;
+	ctx->qid = qid;
+	ctx->histograms = histograms;
+
+	spdk_for_each_channel(subsystem->tgt, nvmf_histogram_get_on_pg, ctx,
+			      nvmf_histogram_get_done);
+}
@@ -98,6 +98,60 @@ struct spdk_nvmf_host {
 	TAILQ_ENTRY(spdk_nvmf_host)	link;
 };
 
+#define NVMF_QOS_TIMESLICE_IN_USEC		1000
+#define NVMF_QOS_MIN_IO_PER_TIMESLICE		1
+#define NVMF_QOS_MIN_BYTE_PER_TIMESLICE		512
+
+enum nvmf_qos_rate_limit_type {
+	NVMF_QOS_RW_IOPS_RATE_LIMIT,
+	NVMF_QOS_RW_BPS_RATE_LIMIT,
+	NVMF_QOS_NUM_RATE_LIMIT_TYPES
+};
+
+struct spdk_nvmf_qos_policy {
+	/* Empty if the policy applies to any host */
+	char				hostnqn[SPDK_NVMF_NQN_MAX_LEN + 1];
+	/* 0 if the policy applies to all namespaces */
+	uint32_t			nsid;
+	struct spdk_nvmf_qos_limits	limits;
+
+	/* Allowed number of I/Os and bytes per timeslice, 0 if unlimited */
+	uint64_t			quota_per_timeslice[NVMF_QOS_NUM_RATE_LIMIT_TYPES];
+	uint64_t			timeslice_ticks;
+
+	/*
+	 * The fields below are shared by all poll groups and only accessed atomically.
+	 * The remaining quota may go negative; the deficit is carried over to the next
+	 * timeslice.
+	 */
+	int64_t				remaining_this_timeslice[NVMF_QOS_NUM_RATE_LIMIT_TYPES];
+	uint64_t			timeslice;
+	/* One reference for the subsystem's list plus one per outstanding I/O */
+	uint32_t			ref;
+
+	TAILQ_ENTRY(spdk_nvmf_qos_policy) link;
+};
+
+/*
+ * QoS policies resolved for the host of a controller. Never modified once published in
+ * ctrlr->qos; it is replaced as a whole when the subsystem's policies change, so the
+ * poll groups can read it without taking the subsystem mutex.
+ */
+struct nvmf_ctrlr_qos {
+	/* Policies used for the namespaces that are not in ns[] */
+	struct spdk_nvmf_qos_policy	*host_default;
+	struct spdk_nvmf_qos_policy	*any_host_default;
+	uint32_t			num_ns;
+	struct {
+		struct spdk_nvmf_qos_policy	*host;
+		struct spdk_nvmf_qos_policy	*any_host;
+	} ns[];
+};
+
+struct spdk_nvmf_latency_histograms {
+	struct spdk_histogram_data	*data[SPDK_NVMF_LATENCY_NUM_TYPES];
+};
+
 struct spdk_nvmf_subsystem_listener {
 	struct spdk_nvmf_subsystem			*subsystem;
 	spdk_nvmf_tgt_subsystem_listen_done_fn		cb_fn;
@@ -161,6 +215,13 @@ struct spdk_nvmf_subsystem_poll_group {
 	enum spdk_nvmf_subsystem_state		state;
 
 	TAILQ_HEAD(, spdk_nvmf_request)		queued;
+
+	/* Requests held back by QoS, resubmitted by qos_poller every timeslice */
+	TAILQ_HEAD(, spdk_nvmf_request)		qos_queued;
+	struct spdk_poller			*qos_poller;
+
+	/* Latency histograms of the qpairs that were destroyed, NULL unless enabled */
+	struct spdk_nvmf_latency_histograms	*histograms;
 };
 
 struct spdk_nvmf_registrant {
@@ -279,6 +340,9 @@ struct spdk_nvmf_ctrlr {
 	bool				acre_enabled;
 	bool				dynamic_ctrlr;
 
+	/* QoS policies for this host, NULL if none applies. Only accessed atomically. */
+	struct nvmf_ctrlr_qos		*qos;
+
 	TAILQ_ENTRY(spdk_nvmf_ctrlr)	link;
 };
 
@@ -329,6 +393,9 @@ struct spdk_nvmf_subsystem {
 	bool						destroying;
 	bool						async_destroy;
 
+	bool						histogram_enabled;
+	bool						histogram_in_progress;
+
 	struct spdk_nvmf_tgt				*tgt;
 
 	/* Array of pointers to namespaces of size max_nsid indexed by nsid - 1 */
@@ -347,6 +414,8 @@ struct spdk_nvmf_subsystem {
 	 * are added or removed dynamically. */
 	pthread_mutex_t					mutex;
 	TAILQ_HEAD(, spdk_nvmf_host)			hosts;
+	/* QoS policies, protected by the mutex as well */
+	TAILQ_HEAD(, spdk_nvmf_qos_policy)		qos_policies;
 	TAILQ_HEAD(, spdk_nvmf_subsystem_listener)	listeners;
 	struct spdk_bit_array				*used_listener_ids;
 
@@ -515,6 +584,63 @@ nvmf_qpair_is_admin_queue(struct spdk_nvmf_qpair *qpair)
 	return qpair->qid == 0;
 }
 
+static inline void
+nvmf_qos_policy_put(struct spdk_nvmf_qos_policy *policy)
+{
+	if (__atomic_sub_fetch(&policy->ref, 1, __ATOMIC_ACQ_REL) == 0) {
+		free(policy);
+	}
+}
+
+static inline void
+nvmf_latency_histograms_free(struct spdk_nvmf_latency_histograms *histograms)
+{
+	int i;
+
+	if (histograms == NULL) {
+		return;
+	}
+
+	for (i = 0; i < SPDK_NVMF_LATENCY_NUM_TYPES; i++) {
+		spdk_histogram_data_free(histograms->data[i]);
+	}
+
+	free(histograms);
+}
+
+static inline struct spdk_nvmf_latency_histograms *
+nvmf_latency_histograms_alloc(void)
+{
+	struct spdk_nvmf_latency_histograms *histograms;
+	int i;
+
+	histograms = calloc(1, sizeof(*histograms));
+	if (histograms == NULL) {
+		return NULL;
+	}
+
+	for (i = 0; i < SPDK_NVMF_LATENCY_NUM_TYPES; i++) {
+		histograms->data[i] = spdk_histogram_data_alloc();
+		if (histograms->data[i] == NULL) {
+			nvmf_latency_histograms_free(histograms);
+			return NULL;
+		}
+	}
+
+	return histograms;
+}
+
+static inline void
+nvmf_latency_histograms_merge(struct spdk_histogram_data **dst,
+			      const struct spdk_nvmf_latency_histograms *src)
+{
+	int i;
+
+	for (i = 0; i < SPDK_NVMF_LATENCY_NUM_TYPES; i++) {
+		spdk_histogram_data_merge(dst[i], src->data[i]);
+	}
+}
+
 /**
  * Initiates a zcopy start operation
  *
@@ -32,6 +32,7 @@
  *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "spdk/base64.h"
 #include "spdk/bdev.h"
 #include "spdk/log.h"
 #include "spdk/rpc.h"
@@ -301,6 +302,34 @@ dump_nvmf_subsystem(struct spdk_json_write_ctx *w, struct spdk_nvmf_subsystem *s
 			spdk_json_write_object_end(w);
 		}
 		spdk_json_write_array_end(w);
+
+		if (spdk_nvmf_subsystem_get_first_qos_policy(subsystem) != NULL) {
+			struct spdk_nvmf_qos_policy *policy;
+			struct spdk_nvmf_qos_limits limits;
+			const char *hostnqn;
+			uint32_t nsid;
+
+			spdk_json_write_named_array_begin(w, "qos_limits");
+			for (policy = spdk_nvmf_subsystem_get_first_qos_policy(subsystem); policy != NULL;
+			     policy = spdk_nvmf_subsystem_get_next_qos_policy(subsystem, policy)) {
+				hostnqn = spdk_nvmf_qos_policy_get_hostnqn(policy);
+				nsid = spdk_nvmf_qos_policy_get_nsid(policy);
+				spdk_nvmf_qos_policy_get_limits(policy, &limits);
+
+				spdk_json_write_object_begin(w);
+				if (hostnqn != NULL) {
+					spdk_json_write_named_string(w, "host", hostnqn);
+				}
+				if (nsid != 0) {
+					spdk_json_write_named_uint32(w, "nsid", nsid);
+				}
+				spdk_json_write_named_uint64(w, "rw_ios_per_sec", limits.rw_ios_per_sec);
+				spdk_json_write_named_uint64(w, "rw_mbytes_per_sec", limits.rw_mbytes_per_sec);
+				spdk_json_write_named_uint32(w, "max_queue_depth", limits.max_queue_depth);
+				spdk_json_write_object_end(w);
+			}
+			spdk_json_write_array_end(w);
+		}
 	}
 	spdk_json_write_object_end(w);
 }
@@ -665,12 +694,14 @@ struct nvmf_rpc_listener_ctx {
 	enum nvmf_rpc_listen_op		op;
 	bool				response_sent;
 	struct spdk_nvmf_listen_opts	opts;
+	bool				secure_channel;
 };
 
 static const struct spdk_json_object_decoder nvmf_rpc_listener_decoder[] = {
 	{"nqn", offsetof(struct nvmf_rpc_listener_ctx, nqn), spdk_json_decode_string},
 	{"listen_address", offsetof(struct nvmf_rpc_listener_ctx, address), decode_rpc_listen_address},
 	{"tgt_name", offsetof(struct nvmf_rpc_listener_ctx, tgt_name), spdk_json_decode_string, true},
+	{"secure_channel", offsetof(struct nvmf_rpc_listener_ctx, secure_channel), spdk_json_decode_bool, true},
 };
 
 static void
@@ -923,6 +954,7 @@ rpc_nvmf_subsystem_add_listener(struct spdk_jsonrpc_request *request,
 	ctx->op = NVMF_RPC_LISTEN_ADD;
 	spdk_nvmf_listen_opts_init(&ctx->opts, sizeof(ctx->opts));
 	ctx->opts.transport_specific = params;
+	ctx->opts.secure_channel = ctx->secure_channel;
 
 	rc = spdk_nvmf_subsystem_pause(subsystem, 0, nvmf_rpc_listen_paused, ctx);
 	if (rc != 0) {
@@ -1654,6 +1686,316 @@ rpc_nvmf_subsystem_allow_any_host(struct spdk_jsonrpc_request *request,
 SPDK_RPC_REGISTER("nvmf_subsystem_allow_any_host", rpc_nvmf_subsystem_allow_any_host,
 		  SPDK_RPC_RUNTIME)
 
+struct nvmf_rpc_qos_ctx {
+	char *nqn;
+	char *host;
+	char *tgt_name;
+	uint32_t nsid;
+	struct spdk_nvmf_qos_limits limits;
+};
+
+static const struct spdk_json_object_decoder nvmf_rpc_subsystem_qos_decoder[] = {
+	{"nqn", offsetof(struct nvmf_rpc_qos_ctx, nqn), spdk_json_decode_string},
+	{"host", offsetof(struct nvmf_rpc_qos_ctx, host), spdk_json_decode_string, true},
+	{"nsid", offsetof(struct nvmf_rpc_qos_ctx, nsid), spdk_json_decode_uint32, true},
+	{"rw_ios_per_sec", offsetof(struct nvmf_rpc_qos_ctx, limits.rw_ios_per_sec), spdk_json_decode_uint64, true},
+	{"rw_mbytes_per_sec", offsetof(struct nvmf_rpc_qos_ctx, limits.rw_mbytes_per_sec), spdk_json_decode_uint64, true},
+	{"max_queue_depth", offsetof(struct nvmf_rpc_qos_ctx, limits.max_queue_depth), spdk_json_decode_uint32, true},
+	{"tgt_name", offsetof(struct nvmf_rpc_qos_ctx, tgt_name), spdk_json_decode_string, true},
+};
+
+static void
+nvmf_rpc_qos_ctx_free(struct nvmf_rpc_qos_ctx *ctx)
+{
+	free(ctx->nqn);
+	free(ctx->host);
+	free(ctx->tgt_name);
+}
+
+static void
+rpc_nvmf_subsystem_set_qos_limits(struct spdk_jsonrpc_request *request,
+				  const struct spdk_json_val *params)
+{
+	struct nvmf_rpc_qos_ctx ctx = {};
+	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_tgt *tgt;
+	int rc;
+
+	if (spdk_json_decode_object(params, nvmf_rpc_subsystem_qos_decoder,
+				    SPDK_COUNTOF(nvmf_rpc_subsystem_qos_decoder),
+				    &ctx)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_qos_ctx_free(&ctx);
+		return;
+	}
+
+	tgt = spdk_nvmf_get_tgt(ctx.tgt_name);
+	if (!tgt) {
+		SPDK_ERRLOG("Unable to find a target object.\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Unable to find a target.");
+		nvmf_rpc_qos_ctx_free(&ctx);
+		return;
+	}
+
+	subsystem = spdk_nvmf_tgt_find_subsystem(tgt, ctx.nqn);
+	if (!subsystem) {
+		SPDK_ERRLOG("Unable to find subsystem with NQN %s\n", ctx.nqn);
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_qos_ctx_free(&ctx);
+		return;
+	}
+
+	rc = spdk_nvmf_subsystem_set_qos_limits(subsystem, ctx.host, ctx.nsid, &ctx.limits);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		nvmf_rpc_qos_ctx_free(&ctx);
+		return;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+	nvmf_rpc_qos_ctx_free(&ctx);
+}
+SPDK_RPC_REGISTER("nvmf_subsystem_set_qos_limits", rpc_nvmf_subsystem_set_qos_limits,
+		  SPDK_RPC_RUNTIME)
+
+struct nvmf_rpc_histogram_ctx {
+	char *nqn;
+	char *tgt_name;
+	bool enable;
+	uint16_t cntlid;
+	int32_t qid;
+	struct spdk_jsonrpc_request *request;
+	struct spdk_histogram_data *histograms[SPDK_NVMF_LATENCY_NUM_TYPES];
+};
+
+static const char *g_nvmf_latency_type_names[SPDK_NVMF_LATENCY_NUM_TYPES] = {
+	[SPDK_NVMF_LATENCY_QUEUE] = "queue",
+	[SPDK_NVMF_LATENCY_BACKEND] = "backend",
+	[SPDK_NVMF_LATENCY_RESPONSE] = "response",
+	[SPDK_NVMF_LATENCY_TOTAL] = "total",
+};
+
+static const struct spdk_json_object_decoder nvmf_rpc_subsystem_enable_histogram_decoder[] = {
+	{"nqn", offsetof(struct nvmf_rpc_histogram_ctx, nqn), spdk_json_decode_string},
+	{"enable", offsetof(struct nvmf_rpc_histogram_ctx, enable), spdk_json_decode_bool},
+	{"tgt_name", offsetof(struct nvmf_rpc_histogram_ctx, tgt_name), spdk_json_decode_string, true},
+};
+
+static const struct spdk_json_object_decoder nvmf_rpc_subsystem_get_histogram_decoder[] = {
+	{"nqn", offsetof(struct nvmf_rpc_histogram_ctx, nqn), spdk_json_decode_string},
+	{"cntlid", offsetof(struct nvmf_rpc_histogram_ctx, cntlid), spdk_json_decode_uint16, true},
+	{"qid", offsetof(struct nvmf_rpc_histogram_ctx, qid), spdk_json_decode_int32, true},
+	{"tgt_name", offsetof(struct nvmf_rpc_histogram_ctx, tgt_name), spdk_json_decode_string, true},
+};
+
+static void
+nvmf_rpc_histogram_ctx_free(struct nvmf_rpc_histogram_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < SPDK_NVMF_LATENCY_NUM_TYPES; i++) {
+		spdk_histogram_data_free(ctx->histograms[i]);
+	}
+
+	free(ctx->nqn);
+	free(ctx->tgt_name);
+	free(ctx);
+}
+
+static struct spdk_nvmf_subsystem *
+nvmf_rpc_histogram_find_subsystem(struct nvmf_rpc_histogram_ctx *ctx)
+{
+	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_tgt *tgt;
+
+	tgt = spdk_nvmf_get_tgt(ctx->tgt_name);
+	if (!tgt) {
+		SPDK_ERRLOG("Unable to find a target object.\n");
+		spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Unable to find a target.");
+		return NULL;
+	}
+
+	subsystem = spdk_nvmf_tgt_find_subsystem(tgt, ctx->nqn);
+	if (!subsystem) {
+		SPDK_ERRLOG("Unable to find subsystem with NQN %s\n", ctx->nqn);
+		spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		return NULL;
+	}
+
+	return subsystem;
+}
+
+static void
+rpc_nvmf_subsystem_enable_histogram_done(void *cb_arg, int status)
+{
+	struct nvmf_rpc_histogram_ctx *ctx = cb_arg;
+
+	if (status != 0) {
+		spdk_jsonrpc_send_error_response(ctx->request, status, spdk_strerror(-status));
+	} else {
+		spdk_jsonrpc_send_bool_response(ctx->request, true);
+	}
+
+	nvmf_rpc_histogram_ctx_free(ctx);
+}
+
+static void
+rpc_nvmf_subsystem_enable_histogram(struct spdk_jsonrpc_request *request,
+				    const struct spdk_json_val *params)
+{
+	struct nvmf_rpc_histogram_ctx *ctx;
+	struct spdk_nvmf_subsystem *subsystem;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+		return;
+	}
+
+	ctx->request = request;
+
+	if (spdk_json_decode_object(params, nvmf_rpc_subsystem_enable_histogram_decoder,
+				    SPDK_COUNTOF(nvmf_rpc_subsystem_enable_histogram_decoder),
+				    ctx)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_histogram_ctx_free(ctx);
+		return;
+	}
+
+	subsystem = nvmf_rpc_histogram_find_subsystem(ctx);
+	if (!subsystem) {
+		nvmf_rpc_histogram_ctx_free(ctx);
+		return;
+	}
+
+	spdk_nvmf_subsystem_histogram_enable(subsystem, rpc_nvmf_subsystem_enable_histogram_done, ctx,
+					     ctx->enable);
+}
+SPDK_RPC_REGISTER("nvmf_subsystem_enable_histogram", rpc_nvmf_subsystem_enable_histogram,
+		  SPDK_RPC_RUNTIME)
+
+static int
+nvmf_rpc_write_histogram(struct spdk_json_write_ctx *w, const char *name,
+			 struct spdk_histogram_data *histogram)
+{
+	char *encoded_histogram;
+	size_t src_len, dst_len;
+	int rc;
+
+	src_len = SPDK_HISTOGRAM_NUM_BUCKETS(histogram) * sizeof(uint64_t);
+	dst_len = spdk_base64_get_encoded_strlen(src_len) + 1;
+
+	encoded_histogram = malloc(dst_len);
+	if (encoded_histogram == NULL) {
+		return -ENOMEM;
+	}
+
+	rc = spdk_base64_encode(encoded_histogram, histogram->bucket, src_len);
+	if (rc != 0) {
+		free(encoded_histogram);
+		return rc;
+	}
+
+	spdk_json_write_named_object_begin(w, name);
+	spdk_json_write_named_string(w, "histogram", encoded_histogram);
+	spdk_json_write_named_int64(w, "bucket_shift", histogram->bucket_shift);
+	spdk_json_write_named_int64(w, "tsc_rate", spdk_get_ticks_hz());
+	spdk_json_write_object_end(w);
+
+	free(encoded_histogram);
+
+	return 0;
+}
+
+static void
+rpc_nvmf_subsystem_get_histogram_done(void *cb_arg, int status,
+				      struct spdk_histogram_data **histograms)
+{
+	struct nvmf_rpc_histogram_ctx *ctx = cb_arg;
+	struct spdk_json_write_ctx *w;
+	int i, rc;
+
+	if (status != 0) {
+		spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 spdk_strerror(-status));
+		nvmf_rpc_histogram_ctx_free(ctx);
+		return;
+	}
+
+	w = spdk_jsonrpc_begin_result(ctx->request);
+	spdk_json_write_object_begin(w);
+	for (i = 0; i < SPDK_NVMF_LATENCY_NUM_TYPES; i++) {
+		rc = nvmf_rpc_write_histogram(w, g_nvmf_latency_type_names[i], histograms[i]);
+		if (rc != 0) {
+			SPDK_ERRLOG("Unable to encode %s histogram: %s\n", g_nvmf_latency_type_names[i],
+				    spdk_strerror(-rc));
+		}
+	}
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(ctx->request, w);
+
+	nvmf_rpc_histogram_ctx_free(ctx);
+}
+
+static void
+rpc_nvmf_subsystem_get_histogram(struct spdk_jsonrpc_request *request,
+				 const struct spdk_json_val *params)
+{
+	struct nvmf_rpc_histogram_ctx *ctx;
+	struct spdk_nvmf_subsystem *subsystem;
+	int i;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+		return;
+	}
+
+	ctx->request = request;
+	ctx->qid = -1;
+
+	if (spdk_json_decode_object(params, nvmf_rpc_subsystem_get_histogram_decoder,
+				    SPDK_COUNTOF(nvmf_rpc_subsystem_get_histogram_decoder),
+				    ctx)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_histogram_ctx_free(ctx);
+		return;
+	}
+
+	subsystem = nvmf_rpc_histogram_find_subsystem(ctx);
+	if (!subsystem) {
+		nvmf_rpc_histogram_ctx_free(ctx);
+		return;
+	}
+
+	if (!spdk_nvmf_subsystem_histogram_enabled(subsystem)) {
+		spdk_jsonrpc_send_error_response_fmt(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						     "Histograms are not enabled on subsystem %s", ctx->nqn);
+		nvmf_rpc_histogram_ctx_free(ctx);
+		return;
+	}
+
+	for (i = 0; i < SPDK_NVMF_LATENCY_NUM_TYPES; i++) {
+		ctx->histograms[i] = spdk_histogram_data_alloc();
+		if (ctx->histograms[i] == NULL) {
+			spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+			nvmf_rpc_histogram_ctx_free(ctx);
+			return;
+		}
+	}
+
+	spdk_nvmf_subsystem_histogram_get(subsystem, ctx->cntlid, ctx->qid, ctx->histograms,
+					  rpc_nvmf_subsystem_get_histogram_done, ctx);
+}
+SPDK_RPC_REGISTER("nvmf_subsystem_get_histogram", rpc_nvmf_subsystem_get_histogram,
+		  SPDK_RPC_RUNTIME)
+
 struct nvmf_rpc_target_ctx {
 	char *name;
 	uint32_t max_subsystems;
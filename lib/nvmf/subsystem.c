@@ -297,6 +297,7 @@ spdk_nvmf_subsystem_create(struct spdk_nvmf_tgt *tgt,
 	pthread_mutex_init(&subsystem->mutex, NULL);
 	TAILQ_INIT(&subsystem->listeners);
 	TAILQ_INIT(&subsystem->hosts);
+	TAILQ_INIT(&subsystem->qos_policies);
 	TAILQ_INIT(&subsystem->ctrlrs);
 	subsystem->used_listener_ids = spdk_bit_array_create(NVMF_MAX_LISTENERS_PER_SUBSYSTEM);
 	if (subsystem->used_listener_ids == NULL) {
@@ -438,6 +439,7 @@ spdk_nvmf_subsystem_destroy(struct spdk_nvmf_subsystem *subsystem, nvmf_subsyste
 			    void *cpl_cb_arg)
 {
 	struct spdk_nvmf_host *host, *host_tmp;
+	struct spdk_nvmf_qos_policy *policy, *policy_tmp;
 
 	if (!subsystem) {
 		return -EINVAL;
@@ -470,6 +472,11 @@ spdk_nvmf_subsystem_destroy(struct spdk_nvmf_subsystem *subsystem, nvmf_subsyste
 		nvmf_subsystem_remove_host(subsystem, host);
 	}
 
+	TAILQ_FOREACH_SAFE(policy, &subsystem->qos_policies, link, policy_tmp) {
+		TAILQ_REMOVE(&subsystem->qos_policies, policy, link);
+		nvmf_qos_policy_put(policy);
+	}
+
 	pthread_mutex_unlock(&subsystem->mutex);
 
 	subsystem->async_destroy_cb = cpl_cb;
@@ -1041,6 +1048,280 @@ spdk_nvmf_host_get_nqn(const struct spdk_nvmf_host *host)
 	return host->nqn;
 }
 
+/* Must hold subsystem->mutex while calling this function */
+static struct spdk_nvmf_qos_policy *
+nvmf_subsystem_find_qos_policy(struct spdk_nvmf_subsystem *subsystem, const char *hostnqn,
+			       uint32_t nsid)
+{
+	struct spdk_nvmf_qos_policy *policy;
+
+	TAILQ_FOREACH(policy, &subsystem->qos_policies, link) {
+		if (policy->nsid == nsid && strcmp(policy->hostnqn, hostnqn) == 0) {
+			return policy;
+		}
+	}
+
+	return NULL;
+}
+
+/* Must hold subsystem->mutex while calling this function */
+static int
+nvmf_subsystem_resolve_qos(struct spdk_nvmf_subsystem *subsystem, const char *hostnqn,
+			   struct nvmf_ctrlr_qos **_qos)
+{
+	struct spdk_nvmf_qos_policy *policy;
+	struct nvmf_ctrlr_qos *qos;
+	uint32_t num_ns = 0, i;
+	bool found = false;
+
+	*_qos = NULL;
+
+	TAILQ_FOREACH(policy, &subsystem->qos_policies, link) {
+		if (policy->hostnqn[0] == '\0' || strcmp(policy->hostnqn, hostnqn) == 0) {
+			num_ns = spdk_max(num_ns, policy->nsid);
+			found = true;
+		}
+	}
+
+	if (!found) {
+		return 0;
+	}
+
+	qos = calloc(1, sizeof(*qos) + num_ns * sizeof(qos->ns[0]));
+	if (qos == NULL) {
+		return -ENOMEM;
+	}
+
+	qos->host_default = nvmf_subsystem_find_qos_policy(subsystem, hostnqn, 0);
+	qos->any_host_default = nvmf_subsystem_find_qos_policy(subsystem, "", 0);
+	qos->num_ns = num_ns;
+
+	for (i = 0; i < num_ns; i++) {
+		policy = nvmf_subsystem_find_qos_policy(subsystem, hostnqn, i + 1);
+		qos->ns[i].host = policy != NULL ? policy : qos->host_default;
+
+		policy = nvmf_subsystem_find_qos_policy(subsystem, "", i + 1);
+		qos->ns[i].any_host = policy != NULL ? policy : qos->any_host_default;
+	}
+
+	*_qos = qos;
+
+	return 0;
+}
+
+static struct spdk_nvmf_qos_policy *
+nvmf_qos_policy_create(const char *hostnqn, uint32_t nsid, const struct spdk_nvmf_qos_limits *limits)
+{
+	struct spdk_nvmf_qos_policy *policy;
+	uint64_t quota;
+	int i;
+
+	policy = calloc(1, sizeof(*policy));
+	if (policy == NULL) {
+		return NULL;
+	}
+
+	snprintf(policy->hostnqn, sizeof(policy->hostnqn), "%s", hostnqn != NULL ? hostnqn : "");
+	policy->nsid = nsid;
+	policy->limits = *limits;
+
+	if (limits->rw_ios_per_sec > 0) {
+		quota = limits->rw_ios_per_sec * NVMF_QOS_TIMESLICE_IN_USEC / SPDK_SEC_TO_USEC;
+		policy->quota_per_timeslice[NVMF_QOS_RW_IOPS_RATE_LIMIT] =
+			spdk_max(quota, NVMF_QOS_MIN_IO_PER_TIMESLICE);
+	}
+
+	if (limits->rw_mbytes_per_sec > 0) {
+		quota = limits->rw_mbytes_per_sec * 1024 * 1024 * NVMF_QOS_TIMESLICE_IN_USEC / SPDK_SEC_TO_USEC;
+		policy->quota_per_timeslice[NVMF_QOS_RW_BPS_RATE_LIMIT] =
+			spdk_max(quota, NVMF_QOS_MIN_BYTE_PER_TIMESLICE);
+	}
+
+	for (i = 0; i < NVMF_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		policy->remaining_this_timeslice[i] = policy->quota_per_timeslice[i];
+	}
+
+	policy->timeslice_ticks = spdk_max(NVMF_QOS_TIMESLICE_IN_USEC * spdk_get_ticks_hz() /
+					   SPDK_SEC_TO_USEC, 1);
+	policy->timeslice = spdk_get_ticks() / policy->timeslice_ticks;
+	policy->ref = 1;
+
+	return policy;
+}
+
+struct nvmf_qos_retire_ctx {
+	struct spdk_nvmf_qos_policy	*policy;
+	uint32_t			num_qos;
+	struct nvmf_ctrlr_qos		*qos[];
+};
+
+static void
+nvmf_qos_retire(struct nvmf_qos_retire_ctx *ctx)
+{
+	uint32_t i;
+
+	for (i = 0; i < ctx->num_qos; i++) {
+		free(ctx->qos[i]);
+	}
+
+	/* I/O still outstanding against the policy hold their own references */
+	if (ctx->policy != NULL) {
+		nvmf_qos_policy_put(ctx->policy);
+	}
+
+	free(ctx);
+}
+
+static void
+nvmf_qos_retire_on_pg(struct spdk_io_channel_iter *i)
+{
+	/* Nothing to do here. Once every poll group has processed this message, none of them
+	 * can still be reading the controller QoS tables that were replaced. */
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+nvmf_qos_retire_done(struct spdk_io_channel_iter *i, int status)
+{
+	nvmf_qos_retire(spdk_io_channel_iter_get_ctx(i));
+}
+
+int
+spdk_nvmf_subsystem_set_qos_limits(struct spdk_nvmf_subsystem *subsystem,
+				   const char *hostnqn, uint32_t nsid,
+				   const struct spdk_nvmf_qos_limits *limits)
+{
+	struct spdk_nvmf_qos_policy *policy = NULL, *old_policy;
+	struct nvmf_qos_retire_ctx *ctx;
+	struct spdk_nvmf_ctrlr *ctrlr;
+	uint32_t num_ctrlrs = 0, i;
+	int rc = 0;
+
+	assert(spdk_get_thread() == subsystem->thread);
+
+	if (hostnqn != NULL && !nvmf_valid_nqn(hostnqn)) {
+		return -EINVAL;
+	}
+
+	if (nsid > subsystem->max_nsid) {
+		SPDK_ERRLOG("Invalid NSID %" PRIu32 " for QoS policy\n", nsid);
+		return -EINVAL;
+	}
+
+	if (limits->rw_ios_per_sec > 0 || limits->rw_mbytes_per_sec > 0 ||
+	    limits->max_queue_depth > 0) {
+		policy = nvmf_qos_policy_create(hostnqn, nsid, limits);
+		if (policy == NULL) {
+			return -ENOMEM;
+		}
+	}
+
+	TAILQ_FOREACH(ctrlr, &subsystem->ctrlrs, link) {
+		num_ctrlrs++;
+	}
+
+	ctx = calloc(1, sizeof(*ctx) + num_ctrlrs * sizeof(ctx->qos[0]));
+	if (ctx == NULL) {
+		free(policy);
+		return -ENOMEM;
+	}
+
+	pthread_mutex_lock(&subsystem->mutex);
+
+	old_policy = nvmf_subsystem_find_qos_policy(subsystem, hostnqn != NULL ? hostnqn : "", nsid);
+	if (policy != NULL) {
+		if (old_policy != NULL) {
+			TAILQ_INSERT_AFTER(&subsystem->qos_policies, old_policy, policy, link);
+		} else {
+			TAILQ_INSERT_TAIL(&subsystem->qos_policies, policy, link);
+		}
+	}
+	if (old_policy != NULL) {
+		TAILQ_REMOVE(&subsystem->qos_policies, old_policy, link);
+	}
+
+	/* Resolve the policies of all the controllers before publishing any of them */
+	i = 0;
+	TAILQ_FOREACH(ctrlr, &subsystem->ctrlrs, link) {
+		rc = nvmf_subsystem_resolve_qos(subsystem, ctrlr->hostnqn, &ctx->qos[i]);
+		if (rc != 0) {
+			break;
+		}
+		i++;
+	}
+
+	if (rc != 0) {
+		if (old_policy != NULL) {
+			if (policy != NULL) {
+				TAILQ_INSERT_BEFORE(policy, old_policy, link);
+			} else {
+				TAILQ_INSERT_TAIL(&subsystem->qos_policies, old_policy, link);
+			}
+		}
+		if (policy != NULL) {
+			TAILQ_REMOVE(&subsystem->qos_policies, policy, link);
+		}
+		pthread_mutex_unlock(&subsystem->mutex);
+
+		ctx->num_qos = i;
+		nvmf_qos_retire(ctx);
+		free(policy);
+		return rc;
+	}
+
+	i = 0;
+	TAILQ_FOREACH(ctrlr, &subsystem->ctrlrs, link) {
+		ctx->qos[i] = __atomic_exchange_n(&ctrlr->qos, ctx->qos[i], __ATOMIC_ACQ_REL);
+		i++;
+	}
+
+	pthread_mutex_unlock(&subsystem->mutex);
+
+	ctx->policy = old_policy;
+	ctx->num_qos = num_ctrlrs;
+
+	if (num_ctrlrs == 0) {
+		/* No poll group can be looking at the old policy */
+		nvmf_qos_retire(ctx);
+	} else {
+		spdk_for_each_channel(subsystem->tgt, nvmf_qos_retire_on_pg, ctx, nvmf_qos_retire_done);
+	}
+
+	return 0;
+}
+
+struct spdk_nvmf_qos_policy *
+spdk_nvmf_subsystem_get_first_qos_policy(struct spdk_nvmf_subsystem *subsystem)
+{
+	return TAILQ_FIRST(&subsystem->qos_policies);
+}
+
+struct spdk_nvmf_qos_policy *
+spdk_nvmf_subsystem_get_next_qos_policy(struct spdk_nvmf_subsystem *subsystem,
+					struct spdk_nvmf_qos_policy *prev_policy)
+{
+	return TAILQ_NEXT(prev_policy, link);
+}
+
+const char *
+spdk_nvmf_qos_policy_get_hostnqn(const struct spdk_nvmf_qos_policy *policy)
+{
+	return policy->hostnqn[0] != '\0' ? policy->hostnqn : NULL;
+}
+
+uint32_t
+spdk_nvmf_qos_policy_get_nsid(const struct spdk_nvmf_qos_policy *policy)
+{
+	return policy->nsid;
+}
+
+void
+spdk_nvmf_qos_policy_get_limits(const struct spdk_nvmf_qos_policy *policy,
+				struct spdk_nvmf_qos_limits *limits)
+{
+	*limits = policy->limits;
+}
+
 struct spdk_nvmf_subsystem_listener *
 nvmf_subsystem_find_listener(struct spdk_nvmf_subsystem *subsystem,
 			     const struct spdk_nvme_transport_id *trid)
@@ -1951,6 +2232,7 @@ nvmf_subsystem_gen_cntlid(struct spdk_nvmf_subsystem *subsystem)
 int
 nvmf_subsystem_add_ctrlr(struct spdk_nvmf_subsystem *subsystem, struct spdk_nvmf_ctrlr *ctrlr)
 {
+	int rc;
 
 	if (ctrlr->dynamic_ctrlr) {
 		ctrlr->cntlid = nvmf_subsystem_gen_cntlid(subsystem);
@@ -1964,6 +2246,14 @@ nvmf_subsystem_add_ctrlr(struct spdk_nvmf_subsystem *subsystem, struct spdk_nvmf
 		return -EEXIST;
 	}
 
+	pthread_mutex_lock(&subsystem->mutex);
+	rc = nvmf_subsystem_resolve_qos(subsystem, ctrlr->hostnqn, &ctrlr->qos);
+	pthread_mutex_unlock(&subsystem->mutex);
+	if (rc != 0) {
+		SPDK_ERRLOG("Unable to resolve QoS policies of ctrlr %u\n", ctrlr->cntlid);
+		return rc;
+	}
+
 	TAILQ_INSERT_TAIL(&subsystem->ctrlrs, ctrlr, link);
 
 	SPDK_DTRACE_PROBE3(nvmf_subsystem_add_ctrlr, subsystem->subnqn, ctrlr, ctrlr->hostnqn);
@@ -1982,6 +2272,10 @@ nvmf_subsystem_remove_ctrlr(struct spdk_nvmf_subsystem *subsystem,
 	SPDK_DEBUGLOG(nvmf, "remove ctrlr %p id 0x%x from subsys %p %s\n", ctrlr, ctrlr->cntlid, subsystem,
 		      subsystem->subnqn);
 	TAILQ_REMOVE(&subsystem->ctrlrs, ctrlr, link);
+
+	/* All of the controller's qpairs are gone, so nothing can be using its QoS table */
+	free(ctrlr->qos);
+	ctrlr->qos = NULL;
 }
 
 struct spdk_nvmf_ctrlr *
@@ -340,6 +340,7 @@ struct spdk_nvmf_tcp_poll_group {
 struct spdk_nvmf_tcp_port {
 	const struct spdk_nvme_transport_id	*trid;
 	struct spdk_sock			*listen_sock;
+	bool					secure_channel;
 	TAILQ_ENTRY(spdk_nvmf_tcp_port)		link;
 };
 
@@ -787,11 +788,13 @@ nvmf_tcp_listen(struct spdk_nvmf_transport *transport, const struct spdk_nvme_tr
 	}
 
 	port->trid = trid;
+	port->secure_channel = listen_opts->secure_channel;
 	opts.opts_size = sizeof(opts);
 	spdk_sock_get_default_opts(&opts);
 	opts.priority = ttransport->tcp_opts.sock_priority;
+	/* The TLS handshake and record layer are handled by the ssl socket implementation */
 	port->listen_sock = spdk_sock_listen_ext(trid->traddr, trsvcid_int,
-			    NULL, &opts);
+			    port->secure_channel ? "ssl" : NULL, &opts);
 	if (port->listen_sock == NULL) {
 		SPDK_ERRLOG("spdk_sock_listen(%s, %d) failed: %s (%d)\n",
 			    trid->traddr, trsvcid_int,
@@ -1235,14 +1238,28 @@ nvmf_tcp_discover(struct spdk_nvmf_transport *transport,
 		  struct spdk_nvme_transport_id *trid,
 		  struct spdk_nvmf_discovery_log_page_entry *entry)
 {
+	struct spdk_nvmf_tcp_transport *ttransport;
+	struct spdk_nvmf_tcp_port *port;
+	bool secure_channel = false;
+
+	ttransport = SPDK_CONTAINEROF(transport, struct spdk_nvmf_tcp_transport, transport);
+
+	pthread_mutex_lock(&ttransport->lock);
+	port = nvmf_tcp_find_port(ttransport, trid);
+	if (port != NULL) {
+		secure_channel = port->secure_channel;
+	}
+	pthread_mutex_unlock(&ttransport->lock);
+
 	entry->trtype = SPDK_NVMF_TRTYPE_TCP;
 	entry->adrfam = trid->adrfam;
-	entry->treq.secure_channel = SPDK_NVMF_TREQ_SECURE_CHANNEL_NOT_REQUIRED;
+	entry->treq.secure_channel = secure_channel ? SPDK_NVMF_TREQ_SECURE_CHANNEL_REQUIRED :
+				     SPDK_NVMF_TREQ_SECURE_CHANNEL_NOT_REQUIRED;
 
 	spdk_strcpy_pad(entry->trsvcid, trid->trsvcid, sizeof(entry->trsvcid), ' ');
 	spdk_strcpy_pad(entry->traddr, trid->traddr, sizeof(entry->traddr), ' ');
 
-	entry->tsas.tcp.sectype = SPDK_NVME_TCP_SECURITY_NONE;
+	entry->tsas.tcp.sectype = secure_channel ? SPDK_NVME_TCP_SECURITY_TLS : SPDK_NVME_TCP_SECURITY_NONE;
 }
 
 static struct spdk_nvmf_tcp_control_msg_list *
@@ -1543,6 +1560,9 @@ nvmf_tcp_capsule_cmd_hdr_handle(struct spdk_nvmf_tcp_transport *ttransport,
 		return;
 	}
 
+	/* Measure the latency of the request from the arrival of its capsule */
+	tcp_req->req.recv_tsc = tqpair->qpair.histograms != NULL ? spdk_get_ticks() : 0;
+
 	pdu->req = tcp_req;
 	assert(tcp_req->state == TCP_REQUEST_STATE_NEW);
 	nvmf_tcp_req_process(ttransport, tcp_req);
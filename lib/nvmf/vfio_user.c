@@ -86,6 +86,18 @@
 
 #define NVMF_VFIO_USER_DEFAULT_MAX_QPAIRS_PER_CTRLR (NVMF_VFIO_USER_MAX_QPAIRS_PER_CTRLR / 4)
 
+/*
+ * Unless disable_lazy_mem_register is set, guest memory regions are registered
+ * with spdk_mem_register() in chunks of this size, the first time a command
+ * transfers data to or from the chunk.
+ */
+#define NVMF_VFIO_USER_MEM_REGISTER_CHUNK_SIZE	(128 * 1024 * 1024)
+
+/* The emulated CMB lives in BAR2, in 4KiB size units */
+#define NVME_CMB_BIR		0x2
+#define NVME_CMB_SZU_SHIFT	SHIFT_4KB
+#define NVME_CMB_MAX_SIZE	(1ULL << 31)
+
 struct nvmf_vfio_user_req;
 
 typedef int (*nvmf_vfio_user_req_cb_fn)(struct nvmf_vfio_user_req *req, void *cb_arg);
@@ -130,6 +142,8 @@ SPDK_STATIC_ASSERT(sizeof(struct nvme_migr_cq_state) == 0x20, "Incorrect size");
  * | vfio_user_nvme_migr_header | nvmf controller data | queue pairs | BARs |
  * -------------------------------------------------------------------------
  *
+ * followed by the contents of the CMB (BAR2), at the next page boundary, if there is one.
+ *
  * Keep vfio_user_nvme_migr_header as a fixed 0x1000 length, all new added fields
  * can use the reserved space at the end of the data structure.
  */
@@ -172,10 +186,13 @@ struct vfio_user_nvme_migr_header {
 	uint64_t	nvmf_data_offset;
 	uint64_t	nvmf_data_len;
 
+	/* CMBMSC, the CMB contents are BAR2 */
+	uint64_t	cmbmsc;
+
 	/* Reserved memory space for new added fields, the
 	 * field is always at the end of this data structure.
 	 */
-	uint8_t		unused[3356];
+	uint8_t		unused[3348];
 };
 SPDK_STATIC_ASSERT(sizeof(struct vfio_user_nvme_migr_header) == 0x1000, "Incorrect size");
 
@@ -227,6 +244,8 @@ struct nvme_q_mapping {
 	dma_sg_t *sg;
 	/* Client PRP of queue. */
 	uint64_t prp1;
+	/* Queue lives in the emulated CMB, so there's no sg to unmap. */
+	bool in_cmb;
 };
 
 enum nvmf_vfio_user_sq_state {
@@ -381,6 +400,28 @@ struct nvmf_vfio_user_ctrlr {
 	bool					self_kick_requested;
 };
 
+enum nvmf_vfio_user_mem_chunk_state {
+	VFIO_USER_MEM_CHUNK_UNREGISTERED = 0,
+	VFIO_USER_MEM_CHUNK_REGISTERED,
+	/* Waiting for the registration thread */
+	VFIO_USER_MEM_CHUNK_PENDING,
+	/* Registration failed, don't retry it on every command */
+	VFIO_USER_MEM_CHUNK_FAILED,
+};
+
+struct nvmf_vfio_user_mem_region {
+	void					*vaddr;
+	size_t					len;
+
+	/*
+	 * State of each chunk of the region, indexed by offset / chunk size.
+	 * NULL if the whole region was registered at once.
+	 */
+	uint8_t					*chunks;
+
+	TAILQ_ENTRY(nvmf_vfio_user_mem_region)	link;
+};
+
 struct nvmf_vfio_user_endpoint {
 	struct nvmf_vfio_user_transport		*transport;
 	vfu_ctx_t				*vfu_ctx;
@@ -398,12 +439,23 @@ struct nvmf_vfio_user_endpoint {
 	int					migr_fd;
 	void					*migr_data;
 
+	/* Emulated controller memory buffer, shared with the client through BAR2 */
+	int					cmb_fd;
+	void					*cmb;
+	size_t					cmb_size;
+	bool					cmb_data_supported;
+	union spdk_nvme_cmbmsc_register		cmbmsc;
+
 	struct spdk_nvme_transport_id		trid;
 	const struct spdk_nvmf_subsystem	*subsystem;
 
 	struct nvmf_vfio_user_ctrlr		*ctrlr;
 	pthread_mutex_t				lock;
 
+	/* Guest memory regions registered with the SPDK memory maps, protected by mem_lock */
+	TAILQ_HEAD(, nvmf_vfio_user_mem_region)	mem_regions;
+	pthread_mutex_t				mem_lock;
+
 	bool					need_async_destroy;
 
 	TAILQ_ENTRY(nvmf_vfio_user_endpoint)	link;
@@ -413,6 +465,8 @@ struct nvmf_vfio_user_transport_opts {
 	bool					disable_mappable_bar0;
 	bool					disable_adaptive_irq;
 	bool					disable_shadow_doorbells;
+	bool					disable_lazy_mem_register;
+	uint64_t				cmb_size;
 };
 
 struct nvmf_vfio_user_transport {
@@ -425,6 +479,13 @@ struct nvmf_vfio_user_transport {
 	pthread_mutex_t				pg_lock;
 	TAILQ_HEAD(, nvmf_vfio_user_poll_group)	poll_groups;
 	struct nvmf_vfio_user_poll_group	*next_pg;
+
+	/* Registers guest memory chunks on behalf of the poll groups */
+	pthread_t				mem_tid;
+	pthread_mutex_t				mem_thread_lock;
+	pthread_cond_t				mem_thread_cond;
+	bool					mem_register_pending;
+	bool					mem_thread_exit;
 };
 
 /*
@@ -436,6 +497,9 @@ nvmf_vfio_user_req_free(struct spdk_nvmf_request *req);
 static struct nvmf_vfio_user_req *
 get_nvmf_vfio_user_req(struct nvmf_vfio_user_sq *sq);
 
+static bool
+in_interrupt_mode(struct nvmf_vfio_user_transport *vu_transport);
+
 /*
  * Local process virtual address of a queue.
  */
@@ -492,6 +556,19 @@ sq_head_advance(struct nvmf_vfio_user_sq *sq)
 	}
 }
 
+static inline void
+sq_head_rewind(struct nvmf_vfio_user_sq *sq)
+{
+	assert(sq != NULL);
+
+	assert(*sq_headp(sq) < sq->size);
+	if (spdk_unlikely(*sq_headp(sq) == 0)) {
+		*sq_headp(sq) = sq->size - 1;
+	} else {
+		(*sq_headp(sq))--;
+	}
+}
+
 static inline void
 cq_tail_advance(struct nvmf_vfio_user_cq *cq)
 {
@@ -548,11 +625,17 @@ io_q_exists(struct nvmf_vfio_user_ctrlr *vu_ctrlr, const uint16_t qid, const boo
 }
 
 static inline size_t
-vfio_user_migr_data_len(void)
+vfio_user_migr_cmb_offset(void)
 {
 	return SPDK_ALIGN_CEIL(sizeof(struct vfio_user_nvme_migr_state), PAGE_SIZE);
 }
 
+static inline size_t
+vfio_user_migr_data_len(const struct nvmf_vfio_user_endpoint *endpoint)
+{
+	return vfio_user_migr_cmb_offset() + endpoint->cmb_size;
+}
+
 static int
 vfio_user_handle_intr(void *ctx);
 
@@ -585,6 +668,35 @@ self_kick(struct nvmf_vfio_user_ctrlr *ctrlr)
 				    ctrlr);
 }
 
+/*
+ * Translate a client address that points into the emulated CMB. The CMB is
+ * shared memory that we already have mapped, so there's no need to go through
+ * libvfio-user's DMA regions. Returns NULL if the range isn't in the CMB.
+ */
+static inline void *
+cmb_map_one(struct nvmf_vfio_user_endpoint *endpoint, uint64_t addr, uint64_t len)
+{
+	union spdk_nvme_cmbmsc_register cmbmsc;
+	uint64_t cba, offset;
+
+	cmbmsc.raw = endpoint->cmbmsc.raw;
+	if (spdk_likely(!cmbmsc.bits.cmse)) {
+		return NULL;
+	}
+
+	cba = (uint64_t)cmbmsc.bits.cba << 12;
+	if (addr < cba) {
+		return NULL;
+	}
+
+	offset = addr - cba;
+	if (offset >= endpoint->cmb_size || len > endpoint->cmb_size - offset) {
+		return NULL;
+	}
+
+	return (uint8_t *)endpoint->cmb + offset;
+}
+
 /*
  * Make the given DMA address and length available (locally mapped) via iov.
  */
@@ -843,6 +955,231 @@ ctrlr_id(struct nvmf_vfio_user_ctrlr *ctrlr)
 	return endpoint_id(ctrlr->endpoint);
 }
 
+static void
+vfio_user_mem_region_free(struct nvmf_vfio_user_mem_region *region)
+{
+	size_t offset, len;
+	uint32_t i;
+	int ret;
+
+	if (region->chunks == NULL) {
+		ret = spdk_mem_unregister(region->vaddr, region->len);
+		if (ret) {
+			SPDK_ERRLOG("Memory region unregister %p-%p failed, ret=%d\n",
+				    region->vaddr, region->vaddr + region->len, ret);
+		}
+	} else {
+		for (i = 0, offset = 0; offset < region->len; i++, offset += len) {
+			len = spdk_min(region->len - offset, NVMF_VFIO_USER_MEM_REGISTER_CHUNK_SIZE);
+			if (region->chunks[i] != VFIO_USER_MEM_CHUNK_REGISTERED) {
+				continue;
+			}
+
+			ret = spdk_mem_unregister(region->vaddr + offset, len);
+			if (ret) {
+				SPDK_ERRLOG("Memory region unregister %p-%p failed, ret=%d\n",
+					    region->vaddr + offset, region->vaddr + offset + len, ret);
+			}
+		}
+	}
+
+	free(region->chunks);
+	free(region);
+}
+
+/* Must hold endpoint->mem_lock while calling this function */
+static struct nvmf_vfio_user_mem_region *
+vfio_user_find_mem_region(struct nvmf_vfio_user_endpoint *endpoint, void *vaddr)
+{
+	struct nvmf_vfio_user_mem_region *region;
+
+	TAILQ_FOREACH(region, &endpoint->mem_regions, link) {
+		if (vaddr >= region->vaddr && vaddr < region->vaddr + region->len) {
+			return region;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Register the chunks that poll groups are waiting for. Runs on the registration
+ * thread, so the poll groups never wait for the global memory map lock.
+ */
+static void
+vfio_user_mem_register_pending(struct nvmf_vfio_user_endpoint *endpoint)
+{
+	struct nvmf_vfio_user_mem_region *region;
+	size_t offset, len;
+	uint32_t i;
+	int ret;
+
+	pthread_mutex_lock(&endpoint->mem_lock);
+	TAILQ_FOREACH(region, &endpoint->mem_regions, link) {
+		if (region->chunks == NULL) {
+			continue;
+		}
+
+		for (i = 0, offset = 0; offset < region->len; i++, offset += len) {
+			len = spdk_min(region->len - offset, NVMF_VFIO_USER_MEM_REGISTER_CHUNK_SIZE);
+			if (region->chunks[i] != VFIO_USER_MEM_CHUNK_PENDING) {
+				continue;
+			}
+
+			SPDK_DEBUGLOG(nvmf_vfio, "%s: register IOVA %p-%p\n", endpoint_id(endpoint),
+				      region->vaddr + offset, region->vaddr + offset + len);
+
+			ret = spdk_mem_register(region->vaddr + offset, len);
+			if (ret) {
+				SPDK_ERRLOG("Memory region register %p-%p failed, ret=%d\n",
+					    region->vaddr + offset, region->vaddr + offset + len, ret);
+				region->chunks[i] = VFIO_USER_MEM_CHUNK_FAILED;
+			} else {
+				region->chunks[i] = VFIO_USER_MEM_CHUNK_REGISTERED;
+			}
+		}
+	}
+	pthread_mutex_unlock(&endpoint->mem_lock);
+}
+
+static void *
+vfio_user_mem_register_thread(void *arg)
+{
+	struct nvmf_vfio_user_transport *vu_transport = arg;
+	struct nvmf_vfio_user_endpoint *endpoint;
+
+	pthread_mutex_lock(&vu_transport->mem_thread_lock);
+	while (!vu_transport->mem_thread_exit) {
+		if (!vu_transport->mem_register_pending) {
+			pthread_cond_wait(&vu_transport->mem_thread_cond, &vu_transport->mem_thread_lock);
+			continue;
+		}
+
+		/* Chunks marked pending from now on need another pass */
+		vu_transport->mem_register_pending = false;
+		pthread_mutex_unlock(&vu_transport->mem_thread_lock);
+
+		pthread_mutex_lock(&vu_transport->lock);
+		TAILQ_FOREACH(endpoint, &vu_transport->endpoints, link) {
+			vfio_user_mem_register_pending(endpoint);
+		}
+		pthread_mutex_unlock(&vu_transport->lock);
+
+		pthread_mutex_lock(&vu_transport->mem_thread_lock);
+	}
+	pthread_mutex_unlock(&vu_transport->mem_thread_lock);
+
+	return NULL;
+}
+
+static void
+vfio_user_mem_register_kick(struct nvmf_vfio_user_transport *vu_transport)
+{
+	pthread_mutex_lock(&vu_transport->mem_thread_lock);
+	vu_transport->mem_register_pending = true;
+	pthread_cond_signal(&vu_transport->mem_thread_cond);
+	pthread_mutex_unlock(&vu_transport->mem_thread_lock);
+}
+
+/*
+ * Look up the chunks backing a buffer and hand the unregistered ones to the
+ * registration thread. Returns false if the buffer isn't ready to be used yet.
+ */
+static bool
+vfio_user_mem_check_chunks(struct nvmf_vfio_user_endpoint *endpoint, void *vaddr, size_t len)
+{
+	struct nvmf_vfio_user_mem_region *region;
+	void *chunk_vaddr, *end = vaddr + len;
+	size_t chunk_len, offset;
+	bool ready = true, kick = false;
+	uint32_t i;
+
+	/* The registration thread holds the lock while it registers, don't wait for it */
+	if (pthread_mutex_trylock(&endpoint->mem_lock) != 0) {
+		return false;
+	}
+
+	while (vaddr < end) {
+		region = vfio_user_find_mem_region(endpoint, vaddr);
+		if (region == NULL) {
+			/* Not registrable memory, the backend may not need it registered anyway */
+			break;
+		}
+
+		if (region->chunks == NULL) {
+			vaddr = region->vaddr + region->len;
+			continue;
+		}
+
+		offset = vaddr - region->vaddr;
+		i = offset / NVMF_VFIO_USER_MEM_REGISTER_CHUNK_SIZE;
+		chunk_vaddr = region->vaddr + (size_t)i * NVMF_VFIO_USER_MEM_REGISTER_CHUNK_SIZE;
+		chunk_len = spdk_min(region->len - (chunk_vaddr - region->vaddr),
+				     NVMF_VFIO_USER_MEM_REGISTER_CHUNK_SIZE);
+
+		switch (region->chunks[i]) {
+		case VFIO_USER_MEM_CHUNK_UNREGISTERED:
+			region->chunks[i] = VFIO_USER_MEM_CHUNK_PENDING;
+			kick = true;
+		/* FALLTHROUGH */
+		case VFIO_USER_MEM_CHUNK_PENDING:
+			ready = false;
+			break;
+		default:
+			break;
+		}
+
+		vaddr = chunk_vaddr + chunk_len;
+	}
+	pthread_mutex_unlock(&endpoint->mem_lock);
+
+	if (kick) {
+		vfio_user_mem_register_kick(endpoint->transport);
+	}
+
+	return ready;
+}
+
+/*
+ * Make sure the guest memory backing a request's data buffers is registered
+ * with the SPDK memory maps before the buffers are handed to the bdev layer.
+ * Returns false if the request has to wait for the registration thread.
+ */
+static inline bool
+vfio_user_req_mem_ready(struct nvmf_vfio_user_ctrlr *ctrlr, struct spdk_nvmf_request *req)
+{
+	void *vaddr;
+	size_t len;
+	bool ready = true;
+	uint32_t i;
+
+	if (ctrlr->transport->transport_opts.disable_lazy_mem_register) {
+		return true;
+	}
+
+	for (i = 0; i < req->iovcnt; i++) {
+		vaddr = req->iov[i].iov_base;
+		len = req->iov[i].iov_len;
+
+		/*
+		 * Chunks are registered as a whole, so a buffer no larger than a chunk is
+		 * covered once its first and last byte are. That's a lock-free lookup.
+		 */
+		if (spdk_likely(len <= NVMF_VFIO_USER_MEM_REGISTER_CHUNK_SIZE &&
+				spdk_vtophys(vaddr, NULL) != SPDK_VTOPHYS_ERROR &&
+				spdk_vtophys(vaddr + len - 1, NULL) != SPDK_VTOPHYS_ERROR)) {
+			continue;
+		}
+
+		/* Keep going, so that all of the request's chunks go in the same batch */
+		if (!vfio_user_mem_check_chunks(ctrlr->endpoint, vaddr, len)) {
+			ready = false;
+		}
+	}
+
+	return ready;
+}
+
 /*
  * For each queue, update the location of its doorbell to the correct location:
  * either our own BAR0, or the guest's configured shadow doorbell area.
@@ -1028,6 +1365,8 @@ ctrlr_interrupt_enabled(struct nvmf_vfio_user_ctrlr *vu_ctrlr)
 static void
 nvmf_vfio_user_destroy_endpoint(struct nvmf_vfio_user_endpoint *endpoint)
 {
+	struct nvmf_vfio_user_mem_region *region;
+
 	SPDK_DEBUGLOG(nvmf_vfio, "destroy endpoint %s\n", endpoint_id(endpoint));
 
 	spdk_interrupt_unregister(&endpoint->accept_intr);
@@ -1042,7 +1381,7 @@ nvmf_vfio_user_destroy_endpoint(struct nvmf_vfio_user_endpoint *endpoint)
 	}
 
 	if (endpoint->migr_data) {
-		munmap(endpoint->migr_data, vfio_user_migr_data_len());
+		munmap(endpoint->migr_data, vfio_user_migr_data_len(endpoint));
 	}
 
 	if (endpoint->migr_fd > 0) {
@@ -1053,7 +1392,26 @@ nvmf_vfio_user_destroy_endpoint(struct nvmf_vfio_user_endpoint *endpoint)
 		vfu_destroy_ctx(endpoint->vfu_ctx);
 	}
 
+	/* Destroying the vfu_ctx removes the DMA regions, so this is only a safety net */
+	while (!TAILQ_EMPTY(&endpoint->mem_regions)) {
+		region = TAILQ_FIRST(&endpoint->mem_regions);
+		TAILQ_REMOVE(&endpoint->mem_regions, region, link);
+		vfio_user_mem_region_free(region);
+	}
+
+	if (endpoint->cmb) {
+		if (endpoint->cmb_data_supported) {
+			spdk_mem_unregister(endpoint->cmb, endpoint->cmb_size);
+		}
+		munmap(endpoint->cmb, endpoint->cmb_size);
+	}
+
+	if (endpoint->cmb_fd >= 0) {
+		close(endpoint->cmb_fd);
+	}
+
 	pthread_mutex_destroy(&endpoint->lock);
+	pthread_mutex_destroy(&endpoint->mem_lock);
 	free(endpoint);
 }
 
@@ -1070,6 +1428,16 @@ nvmf_vfio_user_destroy(struct spdk_nvmf_transport *transport,
 	vu_transport = SPDK_CONTAINEROF(transport, struct nvmf_vfio_user_transport,
 					transport);
 
+	if (!vu_transport->transport_opts.disable_lazy_mem_register) {
+		pthread_mutex_lock(&vu_transport->mem_thread_lock);
+		vu_transport->mem_thread_exit = true;
+		pthread_cond_signal(&vu_transport->mem_thread_cond);
+		pthread_mutex_unlock(&vu_transport->mem_thread_lock);
+		pthread_join(vu_transport->mem_tid, NULL);
+	}
+	pthread_mutex_destroy(&vu_transport->mem_thread_lock);
+	pthread_cond_destroy(&vu_transport->mem_thread_cond);
+
 	pthread_mutex_destroy(&vu_transport->lock);
 	pthread_mutex_destroy(&vu_transport->pg_lock);
 
@@ -1103,6 +1471,16 @@ static const struct spdk_json_object_decoder vfio_user_transport_opts_decoder[]
 		offsetof(struct nvmf_vfio_user_transport, transport_opts.disable_shadow_doorbells),
 		spdk_json_decode_bool, true
 	},
+	{
+		"disable_lazy_mem_register",
+		offsetof(struct nvmf_vfio_user_transport, transport_opts.disable_lazy_mem_register),
+		spdk_json_decode_bool, true
+	},
+	{
+		"cmb_size",
+		offsetof(struct nvmf_vfio_user_transport, transport_opts.cmb_size),
+		spdk_json_decode_uint64, true
+	},
 };
 
 static struct spdk_nvmf_transport *
@@ -1138,6 +1516,23 @@ nvmf_vfio_user_create(struct spdk_nvmf_transport_opts *opts)
 	}
 	TAILQ_INIT(&vu_transport->poll_groups);
 
+	err = pthread_mutex_init(&vu_transport->mem_thread_lock, NULL);
+	if (err != 0) {
+		pthread_mutex_destroy(&vu_transport->lock);
+		pthread_mutex_destroy(&vu_transport->pg_lock);
+		SPDK_ERRLOG("Pthread initialisation failed (%d)\n", err);
+		goto err;
+	}
+
+	err = pthread_cond_init(&vu_transport->mem_thread_cond, NULL);
+	if (err != 0) {
+		pthread_mutex_destroy(&vu_transport->lock);
+		pthread_mutex_destroy(&vu_transport->pg_lock);
+		pthread_mutex_destroy(&vu_transport->mem_thread_lock);
+		SPDK_ERRLOG("Pthread initialisation failed (%d)\n", err);
+		goto err;
+	}
+
 	if (opts->transport_specific != NULL &&
 	    spdk_json_decode_object_relaxed(opts->transport_specific, vfio_user_transport_opts_decoder,
 					    SPDK_COUNTOF(vfio_user_transport_opts_decoder),
@@ -1163,18 +1558,42 @@ nvmf_vfio_user_create(struct spdk_nvmf_transport_opts *opts)
 		vu_transport->transport_opts.disable_shadow_doorbells = true;
 	}
 
+	if (vu_transport->transport_opts.cmb_size != 0 &&
+	    (!spdk_u64_is_pow2(vu_transport->transport_opts.cmb_size) ||
+	     vu_transport->transport_opts.cmb_size < VALUE_2MB ||
+	     vu_transport->transport_opts.cmb_size > NVME_CMB_MAX_SIZE)) {
+		SPDK_ERRLOG("Invalid cmb_size=%" PRIu64 ", must be a power of 2 between %llu and %llu\n",
+			    vu_transport->transport_opts.cmb_size, VALUE_2MB, NVME_CMB_MAX_SIZE);
+		goto cleanup;
+	}
+
 	SPDK_DEBUGLOG(nvmf_vfio, "vfio_user transport: disable_mappable_bar0=%d\n",
 		      vu_transport->transport_opts.disable_mappable_bar0);
 	SPDK_DEBUGLOG(nvmf_vfio, "vfio_user transport: disable_adaptive_irq=%d\n",
 		      vu_transport->transport_opts.disable_adaptive_irq);
 	SPDK_DEBUGLOG(nvmf_vfio, "vfio_user transport: disable_shadow_doorbells=%d\n",
 		      vu_transport->transport_opts.disable_shadow_doorbells);
+	SPDK_DEBUGLOG(nvmf_vfio, "vfio_user transport: disable_lazy_mem_register=%d\n",
+		      vu_transport->transport_opts.disable_lazy_mem_register);
+	SPDK_DEBUGLOG(nvmf_vfio, "vfio_user transport: cmb_size=%" PRIu64 "\n",
+		      vu_transport->transport_opts.cmb_size);
+
+	if (!vu_transport->transport_opts.disable_lazy_mem_register) {
+		err = pthread_create(&vu_transport->mem_tid, NULL, vfio_user_mem_register_thread,
+				     vu_transport);
+		if (err != 0) {
+			SPDK_ERRLOG("Failed to create memory registration thread (%d)\n", err);
+			goto cleanup;
+		}
+	}
 
 	return &vu_transport->transport;
 
 cleanup:
 	pthread_mutex_destroy(&vu_transport->lock);
 	pthread_mutex_destroy(&vu_transport->pg_lock);
+	pthread_mutex_destroy(&vu_transport->mem_thread_lock);
+	pthread_cond_destroy(&vu_transport->mem_thread_cond);
 err:
 	free(vu_transport);
 	return NULL;
@@ -1227,11 +1646,19 @@ map_q(struct nvmf_vfio_user_ctrlr *vu_ctrlr, struct nvme_q_mapping *mapping,
 		len = q_size * sizeof(struct spdk_nvme_cmd);
 	}
 
-	ret = map_one(vu_ctrlr->endpoint->vfu_ctx, mapping->prp1, len,
-		      mapping->sg, &mapping->iov,
-		      is_cq ? PROT_READ | PROT_WRITE : PROT_READ);
-	if (ret == NULL) {
-		return -EFAULT;
+	/* Only SQs may be placed in the CMB, we don't advertise CMBSZ.CQS */
+	ret = is_cq ? NULL : cmb_map_one(vu_ctrlr->endpoint, mapping->prp1, len);
+	if (ret != NULL) {
+		mapping->iov.iov_base = ret;
+		mapping->iov.iov_len = len;
+		mapping->in_cmb = true;
+	} else {
+		ret = map_one(vu_ctrlr->endpoint->vfu_ctx, mapping->prp1, len,
+			      mapping->sg, &mapping->iov,
+			      is_cq ? PROT_READ | PROT_WRITE : PROT_READ);
+		if (ret == NULL) {
+			return -EFAULT;
+		}
 	}
 
 	if (unmap) {
@@ -1245,9 +1672,12 @@ static inline void
 unmap_q(struct nvmf_vfio_user_ctrlr *vu_ctrlr, struct nvme_q_mapping *mapping)
 {
 	if (q_addr(mapping) != NULL) {
-		vfu_unmap_sg(vu_ctrlr->endpoint->vfu_ctx, mapping->sg,
-			     &mapping->iov, 1);
+		if (!mapping->in_cmb) {
+			vfu_unmap_sg(vu_ctrlr->endpoint->vfu_ctx, mapping->sg,
+				     &mapping->iov, 1);
+		}
 		mapping->iov.iov_base = NULL;
+		mapping->in_cmb = false;
 	}
 }
 
@@ -1524,6 +1954,23 @@ _map_one(void *prv, uint64_t addr, uint64_t len, int prot)
 	vu_req = SPDK_CONTAINEROF(req, struct nvmf_vfio_user_req, req);
 	sq = SPDK_CONTAINEROF(qpair, struct nvmf_vfio_user_sq, qpair);
 
+	/*
+	 * Data and PRP lists in the CMB don't need any translation, and there's
+	 * nothing to unmap when the request completes, so they don't take an iov.
+	 * PRP lists and SGL segments are only ever read; data buffers are mapped
+	 * writable, and may only live in the CMB if it was registered for I/O.
+	 */
+	ret = cmb_map_one(sq->ctrlr->endpoint, addr, len);
+	if (ret != NULL) {
+		if (spdk_unlikely((prot & PROT_WRITE) &&
+				  !sq->ctrlr->endpoint->cmb_data_supported)) {
+			vu_req->rsp.status.sct = SPDK_NVME_SCT_GENERIC;
+			vu_req->rsp.status.sc = SPDK_NVME_SC_INVALID_CONTROLLER_MEM_BUF;
+			return NULL;
+		}
+		return ret;
+	}
+
 	assert(vu_req->iovcnt < NVMF_VFIO_USER_MAX_IOVECS);
 	ret = map_one(sq->ctrlr->endpoint->vfu_ctx, addr, len,
 		      vu_req_to_sg_t(vu_req, vu_req->iovcnt),
@@ -2379,6 +2826,19 @@ handle_sq_tdbl_write(struct nvmf_vfio_user_ctrlr *ctrlr, const uint32_t new_tail
 		sq_head_advance(sq);
 
 		err = consume_cmd(ctrlr, sq, cmd);
+		if (spdk_unlikely(err == -EAGAIN)) {
+			/*
+			 * The command's memory is still being registered, leave it
+			 * and the ones behind it on the SQ. In interrupt mode nothing
+			 * would poll the SQ again, so kick ourselves.
+			 */
+			sq_head_rewind(sq);
+			count--;
+			if (in_interrupt_mode(ctrlr->transport)) {
+				self_kick(ctrlr);
+			}
+			break;
+		}
 		if (err != 0) {
 			return err;
 		}
@@ -2387,6 +2847,70 @@ handle_sq_tdbl_write(struct nvmf_vfio_user_ctrlr *ctrlr, const uint32_t new_tail
 	return count;
 }
 
+static void
+vfio_user_mem_region_add(struct nvmf_vfio_user_endpoint *endpoint, void *vaddr, size_t len)
+{
+	struct nvmf_vfio_user_mem_region *region;
+	uint32_t num_chunks;
+	int ret;
+
+	region = calloc(1, sizeof(*region));
+	if (region == NULL) {
+		SPDK_ERRLOG("Unable to allocate memory region %p-%p\n", vaddr, vaddr + len);
+		return;
+	}
+
+	region->vaddr = vaddr;
+	region->len = len;
+
+	if (endpoint->transport->transport_opts.disable_lazy_mem_register) {
+		ret = spdk_mem_register(vaddr, len);
+		if (ret) {
+			SPDK_ERRLOG("Memory region register %p-%p failed, ret=%d\n",
+				    vaddr, vaddr + len, ret);
+			free(region);
+			return;
+		}
+	} else {
+		/*
+		 * Registration updates every SPDK memory map under a global lock, which takes
+		 * a while for large VMs. Defer it until commands actually use the memory, so
+		 * that the time to start or resume a VM doesn't depend on its memory size.
+		 */
+		num_chunks = SPDK_CEIL_DIV(len, NVMF_VFIO_USER_MEM_REGISTER_CHUNK_SIZE);
+		region->chunks = calloc(num_chunks, sizeof(*region->chunks));
+		if (region->chunks == NULL) {
+			SPDK_ERRLOG("Unable to allocate memory region %p-%p\n", vaddr, vaddr + len);
+			free(region);
+			return;
+		}
+	}
+
+	pthread_mutex_lock(&endpoint->mem_lock);
+	TAILQ_INSERT_TAIL(&endpoint->mem_regions, region, link);
+	pthread_mutex_unlock(&endpoint->mem_lock);
+}
+
+static void
+vfio_user_mem_region_remove(struct nvmf_vfio_user_endpoint *endpoint, void *vaddr, size_t len)
+{
+	struct nvmf_vfio_user_mem_region *region;
+
+	pthread_mutex_lock(&endpoint->mem_lock);
+	TAILQ_FOREACH(region, &endpoint->mem_regions, link) {
+		if (region->vaddr == vaddr && region->len == len) {
+			TAILQ_REMOVE(&endpoint->mem_regions, region, link);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&endpoint->mem_lock);
+
+	/* The region is only tracked if it was mapped while a controller existed */
+	if (region != NULL) {
+		vfio_user_mem_region_free(region);
+	}
+}
+
 static void
 memory_region_add_cb(vfu_ctx_t *vfu_ctx, vfu_dma_info_t *info)
 {
@@ -2428,11 +2952,7 @@ memory_region_add_cb(vfu_ctx_t *vfu_ctx, vfu_dma_info_t *info)
 	 * check the protection bits before registering.
 	 */
 	if (info->prot == (PROT_WRITE | PROT_READ)) {
-		ret = spdk_mem_register(info->mapping.iov_base, info->mapping.iov_len);
-		if (ret) {
-			SPDK_ERRLOG("Memory region register %p-%p failed, ret=%d\n",
-				    map_start, map_end, ret);
-		}
+		vfio_user_mem_region_add(endpoint, map_start, map_end - map_start);
 	}
 
 	pthread_mutex_lock(&endpoint->lock);
@@ -2476,7 +2996,6 @@ memory_region_remove_cb(vfu_ctx_t *vfu_ctx, vfu_dma_info_t *info)
 	struct nvmf_vfio_user_sq *sq;
 	struct nvmf_vfio_user_cq *cq;
 	void *map_start, *map_end;
-	int ret = 0;
 
 	if (!info->vaddr) {
 		return;
@@ -2535,11 +3054,7 @@ memory_region_remove_cb(vfu_ctx_t *vfu_ctx, vfu_dma_info_t *info)
 	}
 
 	if (info->prot == (PROT_WRITE | PROT_READ)) {
-		ret = spdk_mem_unregister(info->mapping.iov_base, info->mapping.iov_len);
-		if (ret) {
-			SPDK_ERRLOG("Memory region unregister %p-%p failed, ret=%d\n",
-				    map_start, map_end, ret);
-		}
+		vfio_user_mem_region_remove(endpoint, info->mapping.iov_base, info->mapping.iov_len);
 	}
 }
 
@@ -2617,6 +3132,16 @@ nvmf_vfio_user_prop_req_rsp(struct nvmf_vfio_user_req *req, void *cb_arg)
 		assert(sq->ctrlr != NULL);
 		assert(req != NULL);
 
+		if (req->req.cmd->prop_get_cmd.ofst == offsetof(struct spdk_nvme_registers, cap) &&
+		    sq->ctrlr->endpoint->cmb != NULL) {
+			union spdk_nvme_cap_register cap;
+
+			/* CAP is generic NVMe-oF state, the CMB is ours */
+			cap.raw = req->req.rsp->prop_get_rsp.value.u64;
+			cap.bits.cmbs = 1;
+			req->req.rsp->prop_get_rsp.value.u64 = cap.raw;
+		}
+
 		memcpy(req->req.data,
 		       &req->req.rsp->prop_get_rsp.value.u64,
 		       req->req.length);
@@ -2758,6 +3283,105 @@ vfio_user_property_access(struct nvmf_vfio_user_ctrlr *vu_ctrlr,
 	return count;
 }
 
+static bool
+is_cmb_reg(loff_t pos)
+{
+	return (pos >= (loff_t)offsetof(struct spdk_nvme_registers, cmbloc) &&
+		pos < (loff_t)offsetof(struct spdk_nvme_registers, cmbsz) + 4) ||
+	       (pos >= (loff_t)offsetof(struct spdk_nvme_registers, cmbmsc) &&
+		pos < (loff_t)offsetof(struct spdk_nvme_registers, cmbsts) + 4);
+}
+
+/*
+ * The CMB registers aren't NVMe-oF properties, so they're emulated here
+ * rather than in the generic controller code.
+ */
+static ssize_t
+handle_cmb_reg_access(struct nvmf_vfio_user_ctrlr *ctrlr, char *buf, size_t count,
+		      loff_t pos, bool is_write)
+{
+	struct nvmf_vfio_user_endpoint *endpoint = ctrlr->endpoint;
+	union spdk_nvme_cmbloc_register cmbloc = {};
+	union spdk_nvme_cmbsz_register cmbsz = {};
+	union spdk_nvme_cmbmsc_register cmbmsc;
+	struct spdk_nvme_registers regs = {};
+
+	if ((count != 4 && count != 8) || (pos & (count - 1)) != 0 ||
+	    pos + count > sizeof(regs)) {
+		SPDK_ERRLOG("%s: bad CMB register access %#lx-%#lx\n", ctrlr_id(ctrlr),
+			    pos, pos + count);
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (is_write) {
+		if (pos < (loff_t)offsetof(struct spdk_nvme_registers, cmbmsc) ||
+		    pos >= (loff_t)offsetof(struct spdk_nvme_registers, cmbsts)) {
+			/* CMBLOC, CMBSZ and CMBSTS are read only */
+			return count;
+		}
+
+		if (endpoint->cmb == NULL) {
+			return count;
+		}
+
+		regs.cmbmsc.raw = endpoint->cmbmsc.raw;
+		memcpy((uint8_t *)&regs + pos, buf, count);
+		cmbmsc.raw = regs.cmbmsc.raw;
+		/* CMSE can only be set along with CRE */
+		if (!cmbmsc.bits.cre) {
+			cmbmsc.bits.cmse = 0;
+		}
+
+		SPDK_DEBUGLOG(nvmf_vfio, "%s: CMBMSC %#" PRIx64 ", cre=%u cmse=%u cba=%#" PRIx64 "\n", ctrlr_id(ctrlr),
+			      cmbmsc.raw, (uint32_t)cmbmsc.bits.cre, (uint32_t)cmbmsc.bits.cmse,
+			      (uint64_t)cmbmsc.bits.cba << 12);
+		endpoint->cmbmsc.raw = cmbmsc.raw;
+		return count;
+	}
+
+	if (endpoint->cmb != NULL && endpoint->cmbmsc.bits.cre) {
+		cmbloc.bits.bir = NVME_CMB_BIR;
+		cmbloc.bits.ofst = 0;
+
+		cmbsz.bits.sqs = 1;
+		cmbsz.bits.lists = 1;
+		cmbsz.bits.rds = endpoint->cmb_data_supported;
+		cmbsz.bits.wds = endpoint->cmb_data_supported;
+		cmbsz.bits.szu = 0;
+		cmbsz.bits.sz = endpoint->cmb_size >> NVME_CMB_SZU_SHIFT;
+	}
+
+	regs.cmbloc.raw = cmbloc.raw;
+	regs.cmbsz.raw = cmbsz.raw;
+	regs.cmbmsc.raw = endpoint->cmbmsc.raw;
+	memcpy(buf, (uint8_t *)&regs + pos, count);
+
+	return count;
+}
+
+static ssize_t
+access_cmb_fn(vfu_ctx_t *vfu_ctx, char *buf, size_t count, loff_t pos,
+	      bool is_write)
+{
+	struct nvmf_vfio_user_endpoint *endpoint = vfu_get_private(vfu_ctx);
+
+	if (pos < 0 || (size_t)pos + count > endpoint->cmb_size) {
+		SPDK_ERRLOG("%s: access past end of CMB, want=%ld+%ld, max=%zu\n",
+			    endpoint_id(endpoint), pos, count, endpoint->cmb_size);
+		errno = ERANGE;
+		return -1;
+	}
+
+	if (is_write) {
+		memcpy((uint8_t *)endpoint->cmb + pos, buf, count);
+	} else {
+		memcpy(buf, (uint8_t *)endpoint->cmb + pos, count);
+	}
+
+	return count;
+}
+
 static ssize_t
 access_bar0_fn(vfu_ctx_t *vfu_ctx, char *buf, size_t count, loff_t pos,
 	       bool is_write)
@@ -2787,6 +3411,10 @@ access_bar0_fn(vfu_ctx_t *vfu_ctx, char *buf, size_t count, loff_t pos,
 		return ret;
 	}
 
+	if (is_cmb_reg(pos)) {
+		return handle_cmb_reg_access(ctrlr, buf, count, pos, is_write);
+	}
+
 	return vfio_user_property_access(ctrlr, buf, count, pos, is_write);
 }
 
@@ -3077,6 +3705,56 @@ vfio_user_migr_stream_to_data(struct nvmf_vfio_user_endpoint *endpoint,
 	return 0;
 }
 
+/* Save the CMB contents after the device state, SQs and PRP lists may live there */
+static void
+vfio_user_migr_save_cmb(struct nvmf_vfio_user_endpoint *endpoint,
+			struct vfio_user_nvme_migr_header *header)
+{
+	if (endpoint->cmb == NULL) {
+		return;
+	}
+
+	header->bar_offset[VFU_PCI_DEV_BAR2_REGION_IDX] = vfio_user_migr_cmb_offset();
+	header->bar_len[VFU_PCI_DEV_BAR2_REGION_IDX] = endpoint->cmb_size;
+	header->cmbmsc = endpoint->cmbmsc.raw;
+	memcpy(endpoint->migr_data + vfio_user_migr_cmb_offset(), endpoint->cmb, endpoint->cmb_size);
+}
+
+/* Restore the CMB before the queues, so that SQs placed in it can be mapped again */
+static int
+vfio_user_migr_restore_cmb(struct nvmf_vfio_user_endpoint *endpoint,
+			   const struct vfio_user_nvme_migr_header *header)
+{
+	uint64_t offset = header->bar_offset[VFU_PCI_DEV_BAR2_REGION_IDX];
+	uint64_t len = header->bar_len[VFU_PCI_DEV_BAR2_REGION_IDX];
+	union spdk_nvme_cmbmsc_register cmbmsc;
+
+	if (len == 0) {
+		/* The source had no CMB, it stays disabled */
+		return 0;
+	}
+
+	if (endpoint->cmb == NULL || len != endpoint->cmb_size) {
+		SPDK_ERRLOG("%s: CMB size mismatch, source %" PRIu64 ", destination %zu\n",
+			    endpoint_id(endpoint), len, endpoint->cmb == NULL ? 0 : endpoint->cmb_size);
+		return -EINVAL;
+	}
+
+	if (offset != vfio_user_migr_cmb_offset()) {
+		SPDK_ERRLOG("%s: bad CMB offset %#" PRIx64 "\n", endpoint_id(endpoint), offset);
+		return -EINVAL;
+	}
+
+	memcpy(endpoint->cmb, endpoint->migr_data + offset, len);
+
+	cmbmsc.raw = header->cmbmsc;
+	if (!cmbmsc.bits.cre) {
+		cmbmsc.bits.cmse = 0;
+	}
+	endpoint->cmbmsc.raw = cmbmsc.raw;
+
+	return 0;
+}
 
 static void
 vfio_user_migr_ctrlr_save_data(struct nvmf_vfio_user_ctrlr *vu_ctrlr)
@@ -3184,6 +3862,9 @@ vfio_user_migr_ctrlr_save_data(struct nvmf_vfio_user_ctrlr *vu_ctrlr)
 	migr_state.ctrlr_header.bar_len[VFU_PCI_DEV_CFG_REGION_IDX] = NVME_REG_CFG_SIZE;
 	memcpy(data_ptr, &migr_state.cfg, NVME_REG_CFG_SIZE);
 
+	/* Copy CMB */
+	vfio_user_migr_save_cmb(endpoint, &migr_state.ctrlr_header);
+
 	/* Copy nvme migration header finally */
 	memcpy(endpoint->migr_data, &migr_state.ctrlr_header, sizeof(struct vfio_user_nvme_migr_header));
 
@@ -3354,6 +4035,11 @@ vfio_user_migr_ctrlr_restore(struct nvmf_vfio_user_ctrlr *vu_ctrlr)
 		return rc;
 	}
 
+	rc = vfio_user_migr_restore_cmb(endpoint, &migr_state.ctrlr_header);
+	if (rc) {
+		return rc;
+	}
+
 	rc = vfio_user_migr_ctrlr_construct_qps(vu_ctrlr, &migr_state);
 	if (rc) {
 		return rc;
@@ -3440,7 +4126,7 @@ vfio_user_migration_device_state_transition(vfu_ctx_t *vfu_ctx, vfu_migr_state_t
 		break;
 	case VFU_MIGR_STATE_PRE_COPY:
 		assert(vu_ctrlr->state == VFIO_USER_CTRLR_PAUSED);
-		vu_ctrlr->migr_reg.pending_bytes = vfio_user_migr_data_len();
+		vu_ctrlr->migr_reg.pending_bytes = vfio_user_migr_data_len(endpoint);
 		vu_ctrlr->migr_reg.last_data_offset = 0;
 		vu_ctrlr->in_source_vm = true;
 		break;
@@ -3522,8 +4208,8 @@ vfio_user_migration_prepare_data(vfu_ctx_t *vfu_ctx, uint64_t *offset, uint64_t
 	struct nvmf_vfio_user_ctrlr *ctrlr = endpoint->ctrlr;
 	struct vfio_user_migration_region *migr_reg = &ctrlr->migr_reg;
 
-	if (migr_reg->last_data_offset == vfio_user_migr_data_len()) {
-		*offset = vfio_user_migr_data_len();
+	if (migr_reg->last_data_offset == vfio_user_migr_data_len(endpoint)) {
+		*offset = vfio_user_migr_data_len(endpoint);
 		if (size) {
 			*size = 0;
 		}
@@ -3531,10 +4217,10 @@ vfio_user_migration_prepare_data(vfu_ctx_t *vfu_ctx, uint64_t *offset, uint64_t
 	} else {
 		*offset = 0;
 		if (size) {
-			*size = vfio_user_migr_data_len();
+			*size = vfio_user_migr_data_len(endpoint);
 			if (ctrlr->state == VFIO_USER_CTRLR_MIGRATING) {
 				vfio_user_migr_ctrlr_save_data(ctrlr);
-				migr_reg->last_data_offset = vfio_user_migr_data_len();
+				migr_reg->last_data_offset = vfio_user_migr_data_len(endpoint);
 			}
 		}
 	}
@@ -3669,6 +4355,21 @@ vfio_user_dev_info_fill(struct nvmf_vfio_user_transport *vu_transport,
 		return ret;
 	}
 
+	if (endpoint->cmb != NULL) {
+		struct iovec cmb_sparse_mmap = {
+			.iov_base = (void *)0,
+			.iov_len = endpoint->cmb_size,
+		};
+
+		ret = vfu_setup_region(vfu_ctx, VFU_PCI_DEV_BAR2_REGION_IDX, endpoint->cmb_size,
+				       access_cmb_fn, VFU_REGION_FLAG_RW | VFU_REGION_FLAG_MEM,
+				       &cmb_sparse_mmap, 1, endpoint->cmb_fd, 0);
+		if (ret < 0) {
+			SPDK_ERRLOG("vfu_ctx %p failed to setup bar 2\n", vfu_ctx);
+			return ret;
+		}
+	}
+
 	ret = vfu_setup_region(vfu_ctx, VFU_PCI_DEV_BAR4_REGION_IDX, NVME_BAR4_SIZE,
 			       NULL, VFU_REGION_FLAG_RW, NULL, 0, -1, 0);
 	if (ret < 0) {
@@ -3710,9 +4411,9 @@ vfio_user_dev_info_fill(struct nvmf_vfio_user_transport *vu_transport,
 	vfu_setup_device_quiesce_cb(vfu_ctx, vfio_user_dev_quiesce_cb);
 
 	migr_sparse_mmap.iov_base = (void *)4096;
-	migr_sparse_mmap.iov_len = vfio_user_migr_data_len();
+	migr_sparse_mmap.iov_len = vfio_user_migr_data_len(endpoint);
 	ret = vfu_setup_region(vfu_ctx, VFU_PCI_DEV_MIGR_REGION_IDX,
-			       vfu_get_migr_register_area_size() + vfio_user_migr_data_len(),
+			       vfu_get_migr_register_area_size() + vfio_user_migr_data_len(endpoint),
 			       NULL, VFU_REGION_FLAG_RW | VFU_REGION_FLAG_MEM, &migr_sparse_mmap,
 			       1, endpoint->migr_fd, 0);
 	if (ret < 0) {
@@ -3861,6 +4562,8 @@ nvmf_vfio_user_create_ctrlr(struct nvmf_vfio_user_transport *transport,
 	ctrlr->transport = transport;
 	ctrlr->endpoint = endpoint;
 	ctrlr->bar0_doorbells = endpoint->bar0_doorbells;
+	/* The client has to enable the CMB again for a new controller */
+	endpoint->cmbmsc.raw = 0;
 	TAILQ_INIT(&ctrlr->connected_sqs);
 
 	/* Then, construct an admin queue pair */
@@ -3897,6 +4600,90 @@ out:
 	return err;
 }
 
+/*
+ * Map the CMB backing file at a 2MB aligned address, so that it can be
+ * registered with the SPDK memory maps and used for data transfers.
+ */
+static void *
+vfio_user_cmb_mmap(int fd, size_t size)
+{
+	void *reserved, *addr;
+	size_t head;
+
+	reserved = mmap(NULL, size + VALUE_2MB, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (reserved == MAP_FAILED) {
+		return MAP_FAILED;
+	}
+
+	addr = (void *)SPDK_ALIGN_CEIL((uintptr_t)reserved, VALUE_2MB);
+	head = (uintptr_t)addr - (uintptr_t)reserved;
+	if (head != 0) {
+		munmap(reserved, head);
+	}
+	munmap((uint8_t *)addr + size, VALUE_2MB - head);
+
+	addr = mmap(addr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+	if (addr == MAP_FAILED) {
+		munmap((uint8_t *)reserved + head, size);
+	}
+
+	return addr;
+}
+
+static int
+vfio_user_cmb_init(struct nvmf_vfio_user_endpoint *endpoint, uint64_t size)
+{
+	char path[PATH_MAX];
+	int ret;
+
+	ret = snprintf(path, PATH_MAX, "%s/cmb", endpoint_id(endpoint));
+	if (ret < 0 || ret >= PATH_MAX) {
+		SPDK_ERRLOG("%s: error to get CMB file path: %s.\n", endpoint_id(endpoint),
+			    spdk_strerror(errno));
+		return -1;
+	}
+
+	ret = open(path, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+	if (ret == -1) {
+		SPDK_ERRLOG("%s: failed to open CMB memory at %s: %s.\n",
+			    endpoint_id(endpoint), path, spdk_strerror(errno));
+		return ret;
+	}
+	unlink(path);
+
+	endpoint->cmb_fd = ret;
+	ret = ftruncate(endpoint->cmb_fd, size);
+	if (ret != 0) {
+		SPDK_ERRLOG("%s: error to ftruncate file %s: %s.\n", endpoint_id(endpoint), path,
+			    spdk_strerror(errno));
+		return ret;
+	}
+
+	endpoint->cmb = vfio_user_cmb_mmap(endpoint->cmb_fd, size);
+	if (endpoint->cmb == MAP_FAILED) {
+		SPDK_ERRLOG("%s: error to mmap file %s: %s.\n", endpoint_id(endpoint), path,
+			    spdk_strerror(errno));
+		endpoint->cmb = NULL;
+		return -1;
+	}
+	endpoint->cmb_size = size;
+
+	/*
+	 * SQs and PRP lists in the CMB are only ever touched by the CPU, but data
+	 * buffers are handed to the bdev layer, which may need to DMA to them.
+	 * Only advertise data support if the CMB can be registered.
+	 */
+	ret = spdk_mem_register(endpoint->cmb, size);
+	if (ret != 0) {
+		SPDK_WARNLOG("%s: CMB register failed, ret=%d, data in CMB is not supported\n",
+			     endpoint_id(endpoint), ret);
+	} else {
+		endpoint->cmb_data_supported = true;
+	}
+
+	return 0;
+}
+
 static int
 nvmf_vfio_user_listen(struct spdk_nvmf_transport *transport,
 		      const struct spdk_nvme_transport_id *trid,
@@ -3927,7 +4714,10 @@ nvmf_vfio_user_listen(struct spdk_nvmf_transport *transport,
 	}
 
 	pthread_mutex_init(&endpoint->lock, NULL);
+	pthread_mutex_init(&endpoint->mem_lock, NULL);
+	TAILQ_INIT(&endpoint->mem_regions);
 	endpoint->devmem_fd = -1;
+	endpoint->cmb_fd = -1;
 	memcpy(&endpoint->trid, trid, sizeof(endpoint->trid));
 	endpoint->transport = vu_transport;
 
@@ -3964,6 +4754,14 @@ nvmf_vfio_user_listen(struct spdk_nvmf_transport *transport,
 		goto out;
 	}
 
+	/* The migration data has room for the CMB contents */
+	if (vu_transport->transport_opts.cmb_size != 0) {
+		ret = vfio_user_cmb_init(endpoint, vu_transport->transport_opts.cmb_size);
+		if (ret != 0) {
+			goto out;
+		}
+	}
+
 	ret = snprintf(path, PATH_MAX, "%s/migr", endpoint_id(endpoint));
 	if (ret < 0 || ret >= PATH_MAX) {
 		SPDK_ERRLOG("%s: error to get migration file path: %s.\n", endpoint_id(endpoint),
@@ -3981,14 +4779,14 @@ nvmf_vfio_user_listen(struct spdk_nvmf_transport *transport,
 
 	endpoint->migr_fd = ret;
 	ret = ftruncate(endpoint->migr_fd,
-			vfu_get_migr_register_area_size() + vfio_user_migr_data_len());
+			vfu_get_migr_register_area_size() + vfio_user_migr_data_len(endpoint));
 	if (ret != 0) {
 		SPDK_ERRLOG("%s: error to ftruncate migration file %s: %s.\n", endpoint_id(endpoint), path,
 			    spdk_strerror(errno));
 		goto out;
 	}
 
-	endpoint->migr_data = mmap(NULL, vfio_user_migr_data_len(),
+	endpoint->migr_data = mmap(NULL, vfio_user_migr_data_len(endpoint),
 				   PROT_READ | PROT_WRITE, MAP_SHARED, endpoint->migr_fd, vfu_get_migr_register_area_size());
 	if (endpoint->migr_data == MAP_FAILED) {
 		SPDK_ERRLOG("%s: error to mmap file %s: %s.\n", endpoint_id(endpoint), path, spdk_strerror(errno));
@@ -4947,13 +5745,26 @@ handle_cmd_req(struct nvmf_vfio_user_ctrlr *ctrlr, struct spdk_nvme_cmd *cmd,
 	if (spdk_unlikely(err < 0)) {
 		SPDK_ERRLOG("%s: process NVMe command opc 0x%x failed\n",
 			    ctrlr_id(ctrlr), cmd->opc);
-		req->rsp->nvme_cpl.status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
-		req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+		/* Keep a more specific status set while mapping the command */
+		if (req->rsp->nvme_cpl.status.sc == SPDK_NVME_SC_SUCCESS) {
+			req->rsp->nvme_cpl.status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+			req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+		}
 		err = handle_cmd_rsp(vu_req, vu_req->cb_arg);
 		_nvmf_vfio_user_req_free(sq, vu_req);
 		return err;
 	}
 
+	if (spdk_unlikely(!vfio_user_req_mem_ready(ctrlr, req))) {
+		/* The command gets mapped again when it's retried */
+		if (vu_req->iovcnt) {
+			vfu_unmap_sg(ctrlr->endpoint->vfu_ctx, vu_req_to_sg_t(vu_req, 0),
+				     vu_req->iov, vu_req->iovcnt);
+		}
+		_nvmf_vfio_user_req_free(sq, vu_req);
+		return -EAGAIN;
+	}
+
 	vu_req->state = VFIO_USER_REQUEST_STATE_EXECUTING;
 	spdk_nvmf_request_exec(req);
 
@@ -43,6 +43,8 @@
 #define SPDK_SOCK_DEFAULT_PRIORITY 0
 #define SPDK_SOCK_DEFAULT_ZCOPY true
 #define SPDK_SOCK_DEFAULT_ACK_TIMEOUT 0
+/* Default send burst, in milliseconds worth of the send rate */
+#define SPDK_SOCK_SEND_BURST_MS 10
 
 #define SPDK_SOCK_OPTS_FIELD_OK(opts, field) (offsetof(struct spdk_sock_opts, field) + sizeof(opts->field) <= (opts->opts_size))
 
@@ -303,6 +305,21 @@ sock_init_opts(struct spdk_sock_opts *opts, struct spdk_sock_opts *opts_user)
 	}
 }
 
+static void
+sock_init_send_rate(struct spdk_sock *sock)
+{
+	struct spdk_sock_impl_opts impl_opts = {};
+	size_t len = sizeof(impl_opts);
+
+	if (sock->net_impl->get_opts == NULL || sock->net_impl->get_opts(&impl_opts, &len) != 0) {
+		return;
+	}
+
+	if (impl_opts.send_rate_limit != 0) {
+		spdk_sock_set_send_rate(sock, impl_opts.send_rate_limit, impl_opts.send_burst_size);
+	}
+}
+
 struct spdk_sock *
 spdk_sock_connect(const char *ip, int port, char *impl_name)
 {
@@ -337,6 +354,10 @@ spdk_sock_connect_ext(const char *ip, int port, char *_impl_name, struct spdk_so
 			continue;
 		}
 
+		if (!impl_name && impl->by_name_only) {
+			continue;
+		}
+
 		SPDK_DEBUGLOG(sock, "Creating a client socket using impl %s\n", impl->name);
 		sock_init_opts(&opts_local, opts);
 		sock = impl->connect(ip, port, &opts_local);
@@ -346,6 +367,7 @@ spdk_sock_connect_ext(const char *ip, int port, char *_impl_name, struct spdk_so
 			sock->net_impl = impl;
 			TAILQ_INIT(&sock->queued_reqs);
 			TAILQ_INIT(&sock->pending_reqs);
+			sock_init_send_rate(sock);
 			return sock;
 		}
 	}
@@ -387,6 +409,10 @@ spdk_sock_listen_ext(const char *ip, int port, char *_impl_name, struct spdk_soc
 			continue;
 		}
 
+		if (!impl_name && impl->by_name_only) {
+			continue;
+		}
+
 		SPDK_DEBUGLOG(sock, "Creating a listening socket using impl %s\n", impl->name);
 		sock_init_opts(&opts_local, opts);
 		sock = impl->listen(ip, port, &opts_local);
@@ -416,6 +442,7 @@ spdk_sock_accept(struct spdk_sock *sock)
 		new_sock->net_impl = sock->net_impl;
 		TAILQ_INIT(&new_sock->queued_reqs);
 		TAILQ_INIT(&new_sock->pending_reqs);
+		sock_init_send_rate(new_sock);
 	}
 
 	return new_sock;
@@ -474,6 +501,38 @@ spdk_sock_readv(struct spdk_sock *sock, struct iovec *iov, int iovcnt)
 	return sock->net_impl->readv(sock, iov, iovcnt);
 }
 
+ssize_t
+spdk_sock_recv_lend(struct spdk_sock *sock, void **buf)
+{
+	if (sock == NULL || sock->flags.closed) {
+		errno = EBADF;
+		return -1;
+	}
+
+	if (sock->net_impl->recv_lend == NULL) {
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	return sock->net_impl->recv_lend(sock, buf);
+}
+
+int
+spdk_sock_recv_return(struct spdk_sock *sock, size_t len)
+{
+	if (sock == NULL || sock->flags.closed) {
+		errno = EBADF;
+		return -1;
+	}
+
+	if (sock->net_impl->recv_return == NULL) {
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	return sock->net_impl->recv_return(sock, len);
+}
+
 ssize_t
 spdk_sock_writev(struct spdk_sock *sock, struct iovec *iov, int iovcnt)
 {
@@ -496,6 +555,15 @@ spdk_sock_writev_async(struct spdk_sock *sock, struct spdk_sock_request *req)
 	}
 
 	sock->net_impl->writev_async(sock, req);
+
+	/* A rate limited socket outside of a group has no poll to send the data held back
+	 * by its token bucket, so send it along with the next request once it refilled. */
+	if (spdk_unlikely(sock->send_limit.rate != 0) && sock->group_impl == NULL &&
+	    !TAILQ_EMPTY(&sock->queued_reqs) && spdk_sock_send_budget(sock) > 0) {
+		if (sock->net_impl->flush(sock) < 0) {
+			spdk_sock_abort_requests(sock);
+		}
+	}
 }
 
 int
@@ -531,6 +599,67 @@ spdk_sock_set_sendbuf(struct spdk_sock *sock, int sz)
 	return sock->net_impl->set_sendbuf(sock, sz);
 }
 
+int
+spdk_sock_set_send_rate(struct spdk_sock *sock, uint64_t rate, uint32_t burst)
+{
+	uint64_t bucket = burst;
+
+	if (sock == NULL || sock->flags.closed) {
+		errno = EBADF;
+		return -1;
+	}
+
+	if (sock->net_impl->set_pacing_rate != NULL &&
+	    sock->net_impl->set_pacing_rate(sock, rate) != 0) {
+		/* The token bucket still bounds the rate, only the pacing is lost */
+		SPDK_DEBUGLOG(sock, "Kernel pacing unavailable on sock %p (errno=%d)\n", sock, errno);
+	}
+
+	if (rate != 0 && bucket == 0) {
+		bucket = spdk_max(rate * SPDK_SOCK_SEND_BURST_MS / 1000, 1);
+	}
+
+	sock->send_limit.rate = rate;
+	sock->send_limit.burst = bucket;
+	sock->send_limit.tokens = bucket;
+	sock->send_limit.last_tsc = spdk_get_ticks();
+
+	return 0;
+}
+
+uint64_t
+spdk_sock_send_budget(struct spdk_sock *sock)
+{
+	uint64_t now, elapsed, hz, add;
+
+	assert(sock->send_limit.rate != 0);
+
+	now = spdk_get_ticks();
+	if (sock->send_limit.tokens == sock->send_limit.burst) {
+		/* A full bucket does not earn anything while idle */
+		sock->send_limit.last_tsc = now;
+		return sock->send_limit.tokens;
+	}
+
+	hz = spdk_get_ticks_hz();
+	elapsed = now - sock->send_limit.last_tsc;
+	if (elapsed >= hz) {
+		add = sock->send_limit.burst;
+	} else {
+		/* Split the product so that it cannot overflow */
+		add = (sock->send_limit.rate / hz) * elapsed +
+		      (sock->send_limit.rate % hz) * elapsed / hz;
+	}
+
+	/* Keep the fraction of a byte earned so far for the next refill */
+	if (add > 0) {
+		sock->send_limit.tokens = spdk_min(sock->send_limit.tokens + add, sock->send_limit.burst);
+		sock->send_limit.last_tsc = now;
+	}
+
+	return sock->send_limit.tokens;
+}
+
 bool
 spdk_sock_is_ipv6(struct spdk_sock *sock)
 {
@@ -850,6 +979,18 @@ spdk_sock_write_config_json(struct spdk_json_write_ctx *w)
 			spdk_json_write_named_uint32(w, "enable_placement_id", opts.enable_placement_id);
 			spdk_json_write_named_bool(w, "enable_zerocopy_send_server", opts.enable_zerocopy_send_server);
 			spdk_json_write_named_bool(w, "enable_zerocopy_send_client", opts.enable_zerocopy_send_client);
+			spdk_json_write_named_bool(w, "enable_ktls", opts.enable_ktls);
+			if (opts.psk_key) {
+				spdk_json_write_named_string(w, "psk_key", opts.psk_key);
+			}
+			if (opts.psk_identity) {
+				spdk_json_write_named_string(w, "psk_identity", opts.psk_identity);
+			}
+			spdk_json_write_named_uint64(w, "send_rate_limit", opts.send_rate_limit);
+			spdk_json_write_named_uint32(w, "send_burst_size", opts.send_burst_size);
+			spdk_json_write_named_uint32(w, "busy_poll_usecs", opts.busy_poll_usecs);
+			spdk_json_write_named_uint32(w, "recv_ring_buf_count", opts.recv_ring_buf_count);
+			spdk_json_write_named_uint32(w, "recv_ring_buf_size", opts.recv_ring_buf_size);
 			spdk_json_write_object_end(w);
 			spdk_json_write_object_end(w);
 		} else {
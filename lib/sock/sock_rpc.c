@@ -79,6 +79,16 @@ rpc_sock_impl_get_options(struct spdk_jsonrpc_request *request,
 	spdk_json_write_named_uint32(w, "enable_placement_id", sock_opts.enable_placement_id);
 	spdk_json_write_named_bool(w, "enable_zerocopy_send_server", sock_opts.enable_zerocopy_send_server);
 	spdk_json_write_named_bool(w, "enable_zerocopy_send_client", sock_opts.enable_zerocopy_send_client);
+	spdk_json_write_named_bool(w, "enable_ktls", sock_opts.enable_ktls);
+	/* The PSK itself is a secret and is never reported back */
+	if (sock_opts.psk_identity) {
+		spdk_json_write_named_string(w, "psk_identity", sock_opts.psk_identity);
+	}
+	spdk_json_write_named_uint64(w, "send_rate_limit", sock_opts.send_rate_limit);
+	spdk_json_write_named_uint32(w, "send_burst_size", sock_opts.send_burst_size);
+	spdk_json_write_named_uint32(w, "busy_poll_usecs", sock_opts.busy_poll_usecs);
+	spdk_json_write_named_uint32(w, "recv_ring_buf_count", sock_opts.recv_ring_buf_count);
+	spdk_json_write_named_uint32(w, "recv_ring_buf_size", sock_opts.recv_ring_buf_size);
 	spdk_json_write_object_end(w);
 	spdk_jsonrpc_end_result(request, w);
 	free(impl_name);
@@ -88,6 +98,8 @@ SPDK_RPC_REGISTER("sock_impl_get_options", rpc_sock_impl_get_options,
 
 struct spdk_rpc_sock_impl_set_opts {
 	char *impl_name;
+	char *psk_key;
+	char *psk_identity;
 	struct spdk_sock_impl_opts sock_opts;
 };
 
@@ -123,9 +135,49 @@ static const struct spdk_json_object_decoder rpc_sock_impl_set_opts_decoders[] =
 	{
 		"enable_zerocopy_send_client", offsetof(struct spdk_rpc_sock_impl_set_opts, sock_opts.enable_zerocopy_send_client),
 		spdk_json_decode_bool, true
+	},
+	{
+		"enable_ktls", offsetof(struct spdk_rpc_sock_impl_set_opts, sock_opts.enable_ktls),
+		spdk_json_decode_bool, true
+	},
+	{
+		"psk_key", offsetof(struct spdk_rpc_sock_impl_set_opts, psk_key),
+		spdk_json_decode_string, true
+	},
+	{
+		"psk_identity", offsetof(struct spdk_rpc_sock_impl_set_opts, psk_identity),
+		spdk_json_decode_string, true
+	},
+	{
+		"send_rate_limit", offsetof(struct spdk_rpc_sock_impl_set_opts, sock_opts.send_rate_limit),
+		spdk_json_decode_uint64, true
+	},
+	{
+		"send_burst_size", offsetof(struct spdk_rpc_sock_impl_set_opts, sock_opts.send_burst_size),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"busy_poll_usecs", offsetof(struct spdk_rpc_sock_impl_set_opts, sock_opts.busy_poll_usecs),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"recv_ring_buf_count", offsetof(struct spdk_rpc_sock_impl_set_opts, sock_opts.recv_ring_buf_count),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"recv_ring_buf_size", offsetof(struct spdk_rpc_sock_impl_set_opts, sock_opts.recv_ring_buf_size),
+		spdk_json_decode_uint32, true
 	}
 };
 
+static void
+free_rpc_sock_impl_set_opts(struct spdk_rpc_sock_impl_set_opts *opts)
+{
+	free(opts->impl_name);
+	free(opts->psk_key);
+	free(opts->psk_identity);
+}
+
 static void
 rpc_sock_impl_set_options(struct spdk_jsonrpc_request *request,
 			  const struct spdk_json_val *params)
@@ -138,6 +190,7 @@ rpc_sock_impl_set_options(struct spdk_jsonrpc_request *request,
 	if (spdk_json_decode_object(params, rpc_sock_impl_set_opts_decoders,
 				    SPDK_COUNTOF(rpc_sock_impl_set_opts_decoders), &opts)) {
 		SPDK_ERRLOG("spdk_json_decode_object() failed\n");
+		free_rpc_sock_impl_set_opts(&opts);
 		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
 						 "Invalid parameters");
 		return;
@@ -147,7 +200,7 @@ rpc_sock_impl_set_options(struct spdk_jsonrpc_request *request,
 	len = sizeof(opts.sock_opts);
 	rc = spdk_sock_impl_get_opts(opts.impl_name, &opts.sock_opts, &len);
 	if (rc) {
-		free(opts.impl_name);
+		free_rpc_sock_impl_set_opts(&opts);
 		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
 						 "Invalid parameters");
 		return;
@@ -157,21 +210,30 @@ rpc_sock_impl_set_options(struct spdk_jsonrpc_request *request,
 	if (spdk_json_decode_object(params, rpc_sock_impl_set_opts_decoders,
 				    SPDK_COUNTOF(rpc_sock_impl_set_opts_decoders), &opts)) {
 		SPDK_ERRLOG("spdk_json_decode_object() failed\n");
+		free_rpc_sock_impl_set_opts(&opts);
 		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
 						 "Invalid parameters");
 		return;
 	}
 
+	/* The strings in sock_opts belong to the implementation, only override them if requested */
+	if (opts.psk_key) {
+		opts.sock_opts.psk_key = opts.psk_key;
+	}
+	if (opts.psk_identity) {
+		opts.sock_opts.psk_identity = opts.psk_identity;
+	}
+
 	rc = spdk_sock_impl_set_opts(opts.impl_name, &opts.sock_opts, sizeof(opts.sock_opts));
 	if (rc != 0) {
-		free(opts.impl_name);
+		free_rpc_sock_impl_set_opts(&opts);
 		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
 						 "Invalid parameters");
 		return;
 	}
 
 	spdk_jsonrpc_send_bool_response(request, true);
-	free(opts.impl_name);
+	free_rpc_sock_impl_set_opts(&opts);
 }
 SPDK_RPC_REGISTER("sock_impl_set_options", rpc_sock_impl_set_options, SPDK_RPC_STARTUP)
 
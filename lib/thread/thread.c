@@ -60,6 +60,16 @@
 #define SPDK_MAX_POLLER_NAME_LEN	256
 #define SPDK_MAX_THREAD_NAME_LEN	256
 
+/* Timed pollers are kept in a hierarchical timing wheel. A level 0 slot spans a single
+ * timer unit (the largest power of two number of ticks not exceeding 1us), a slot of
+ * level n spans all slots of level n - 1. Pollers are moved to a lower level when the
+ * wheel reaches their slot, so both arming and expiring a poller is O(1).
+ */
+#define SPDK_TIMER_WHEEL_BITS		6
+#define SPDK_TIMER_WHEEL_SIZE		(1U << SPDK_TIMER_WHEEL_BITS)
+#define SPDK_TIMER_WHEEL_MASK		(SPDK_TIMER_WHEEL_SIZE - 1)
+#define SPDK_TIMER_WHEEL_LEVELS		6
+
 enum spdk_poller_state {
 	/* The poller is registered with a thread but not currently executing its fn. */
 	SPDK_POLLER_STATE_WAITING,
@@ -83,7 +93,9 @@ enum spdk_poller_state {
 
 struct spdk_poller {
 	TAILQ_ENTRY(spdk_poller)	tailq;
-	RB_ENTRY(spdk_poller)		node;
+	TAILQ_ENTRY(spdk_poller)	timer_link;
+	/* Timer wheel list the timed poller is on */
+	struct timed_pollers_head	*timer_head;
 
 	/* Current state of the poller; should only be accessed from the poller's thread. */
 	enum spdk_poller_state		state;
@@ -92,6 +104,7 @@ struct spdk_poller {
 	uint64_t			next_run_tick;
 	uint64_t			run_count;
 	uint64_t			busy_count;
+	uint64_t			tsc;
 	uint64_t			id;
 	spdk_poller_fn			fn;
 	void				*arg;
@@ -102,6 +115,24 @@ struct spdk_poller {
 	void				*set_intr_cb_arg;
 
 	char				name[SPDK_MAX_POLLER_NAME_LEN + 1];
+
+	uint64_t			tsc_histogram[SPDK_POLLER_TSC_HISTOGRAM_BUCKETS];
+};
+
+TAILQ_HEAD(timed_pollers_head, spdk_poller);
+
+struct timer_wheel {
+	/* Current position of the wheel in timer units */
+	uint64_t			cur;
+	uint32_t			shift;
+	uint32_t			count;
+	/* Each bit indicates whether the corresponding slot of a level is not empty */
+	uint64_t			bitmap[SPDK_TIMER_WHEEL_LEVELS];
+	struct timed_pollers_head	slots[SPDK_TIMER_WHEEL_LEVELS][SPDK_TIMER_WHEEL_SIZE];
+	/* Pollers which expire beyond the range of the wheel */
+	struct timed_pollers_head	overflow;
+	/* Pollers of the slot being expired */
+	struct timed_pollers_head	expiring;
 };
 
 enum spdk_thread_state {
@@ -117,6 +148,15 @@ enum spdk_thread_state {
 	SPDK_THREAD_STATE_EXITED,
 };
 
+/* Number of entries in the per-thread io_channel cache, must be a power of 2 */
+#define SPDK_IO_CHANNEL_CACHE_BITS	4
+#define SPDK_IO_CHANNEL_CACHE_SIZE	(1 << SPDK_IO_CHANNEL_CACHE_BITS)
+
+struct io_channel_cache_entry {
+	void				*io_device;
+	struct spdk_io_channel		*ch;
+};
+
 struct spdk_thread {
 	uint64_t			tsc_last;
 	struct spdk_thread_stats	stats;
@@ -130,8 +170,7 @@ struct spdk_thread {
 	/**
 	 * Contains pollers running on this thread with a periodic timer.
 	 */
-	RB_HEAD(timed_pollers_tree, spdk_poller)	timed_pollers;
-	struct spdk_poller				*first_timed_poller;
+	struct timer_wheel				timed_pollers;
 	/*
 	 * Contains paused pollers.  Pollers on this queue are waiting until
 	 * they are resumed (in which case they're put onto the active/timer
@@ -151,6 +190,12 @@ struct spdk_thread {
 	RB_HEAD(io_channel_tree, spdk_io_channel)	io_channels;
 	TAILQ_ENTRY(spdk_thread)			tailq;
 
+	/*
+	 * Direct-mapped cache of io_channels of this thread, indexed by a hash of the
+	 *  io_device. Only accessed by the thread itself, so it needs no locking.
+	 */
+	struct io_channel_cache_entry	io_channel_cache[SPDK_IO_CHANNEL_CACHE_SIZE];
+
 	char				name[SPDK_MAX_THREAD_NAME_LEN + 1];
 	struct spdk_cpuset		cpumask;
 	uint64_t			exit_timeout_tsc;
@@ -160,6 +205,9 @@ struct spdk_thread {
 	bool				poller_unregistered;
 	struct spdk_fd_group		*fgrp;
 
+	/* Queueing latency of the received messages, allocated when the first one is recorded */
+	struct spdk_msg_latency_table	*msg_latency;
+
 	/* User context allocated at the end */
 	uint8_t				ctx[0];
 };
@@ -185,6 +233,7 @@ struct io_device {
 	struct spdk_thread		*unregister_thread;
 	uint32_t			ctx_size;
 	uint32_t			for_each_count;
+	int32_t				numa_id;
 	RB_ENTRY(io_device)		node;
 
 	uint32_t			refcnt;
@@ -214,6 +263,10 @@ struct spdk_msg {
 	spdk_msg_fn		fn;
 	void			*arg;
 
+	/* Enqueue time and source thread ID, set only if latency tracking is enabled */
+	uint64_t		tsc;
+	uint64_t		src_id;
+
 	SLIST_ENTRY(spdk_msg)	link;
 };
 
@@ -225,8 +278,31 @@ static uint32_t g_thread_count = 0;
 
 static __thread struct spdk_thread *tls_thread = NULL;
 
+static bool g_msg_latency_tracking = false;
+/* Incremented each time tracking is enabled to invalidate the previously gathered stats */
+static uint64_t g_msg_latency_generation = 0;
+
 SPDK_TRACE_REGISTER_FN(thread_trace, "thread", TRACE_GROUP_THREAD)
 {
+	struct spdk_trace_tpoint_opts opts[] = {
+		{
+			"THREAD_MSG_WAIT", TRACE_THREAD_MSG_WAIT,
+			OWNER_NONE, OBJECT_NONE, 0,
+			{
+				{ "src_thread", SPDK_TRACE_ARG_TYPE_INT, 8 },
+				{ "wait_tsc", SPDK_TRACE_ARG_TYPE_INT, 8 },
+			}
+		},
+		{
+			"THREAD_EVENT_WAIT", TRACE_THREAD_EVENT_WAIT,
+			OWNER_NONE, OBJECT_NONE, 0,
+			{
+				{ "src_lcore", SPDK_TRACE_ARG_TYPE_INT, 8 },
+				{ "wait_tsc", SPDK_TRACE_ARG_TYPE_INT, 8 },
+			}
+		},
+	};
+
 	spdk_trace_register_description("THREAD_IOCH_GET",
 					TRACE_THREAD_IOCH_GET,
 					OWNER_NONE, OBJECT_NONE, 0,
@@ -235,30 +311,160 @@ SPDK_TRACE_REGISTER_FN(thread_trace, "thread", TRACE_GROUP_THREAD)
 					TRACE_THREAD_IOCH_PUT,
 					OWNER_NONE, OBJECT_NONE, 0,
 					SPDK_TRACE_ARG_TYPE_INT, "refcnt");
+	spdk_trace_register_description_ext(opts, SPDK_COUNTOF(opts));
 }
 
-/*
- * If this compare function returns zero when two next_run_ticks are equal,
- * the macro RB_INSERT() returns a pointer to the element with the same
- * next_run_tick.
- *
- * Fortunately, the macro RB_REMOVE() takes not a key but a pointer to the element
- * to remove as a parameter.
- *
- * Hence we allow RB_INSERT() to insert elements with the same keys on the right
- * side by returning 1 when two next_run_ticks are equal.
- */
-static inline int
-timed_poller_compare(struct spdk_poller *poller1, struct spdk_poller *poller2)
+static void
+timer_wheel_init(struct timer_wheel *wheel, uint64_t now)
 {
-	if (poller1->next_run_tick < poller2->next_run_tick) {
-		return -1;
+	uint64_t ticks_per_us = spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+	uint32_t level, slot;
+
+	wheel->shift = ticks_per_us > 1 ? spdk_u64log2(ticks_per_us) : 0;
+	wheel->cur = now >> wheel->shift;
+
+	for (level = 0; level < SPDK_TIMER_WHEEL_LEVELS; level++) {
+		for (slot = 0; slot < SPDK_TIMER_WHEEL_SIZE; slot++) {
+			TAILQ_INIT(&wheel->slots[level][slot]);
+		}
+	}
+	TAILQ_INIT(&wheel->overflow);
+	TAILQ_INIT(&wheel->expiring);
+}
+
+static void
+timer_wheel_add(struct timer_wheel *wheel, struct spdk_poller *poller)
+{
+	struct timed_pollers_head *head;
+	uint64_t expires, delta;
+	uint32_t level, slot;
+
+	expires = spdk_max(poller->next_run_tick >> wheel->shift, wheel->cur);
+	delta = expires - wheel->cur;
+
+	/* The level is chosen so that the poller's slot is reached before it expires. */
+	level = delta == 0 ? 0 : spdk_u64log2(delta) / SPDK_TIMER_WHEEL_BITS;
+	if (level < SPDK_TIMER_WHEEL_LEVELS) {
+		slot = (expires >> (SPDK_TIMER_WHEEL_BITS * level)) & SPDK_TIMER_WHEEL_MASK;
+		head = &wheel->slots[level][slot];
+		wheel->bitmap[level] |= 1ULL << slot;
 	} else {
-		return 1;
+		head = &wheel->overflow;
 	}
+
+	TAILQ_INSERT_TAIL(head, poller, timer_link);
+	poller->timer_head = head;
+	wheel->count++;
 }
 
-RB_GENERATE_STATIC(timed_pollers_tree, spdk_poller, node, timed_poller_compare);
+static inline uint32_t
+timer_wheel_index(struct timer_wheel *wheel, struct timed_pollers_head *head)
+{
+	/* Flat index of the list: slots of all levels first, then overflow and expiring. */
+	if (head == &wheel->overflow) {
+		return SPDK_TIMER_WHEEL_LEVELS * SPDK_TIMER_WHEEL_SIZE;
+	} else if (head == &wheel->expiring) {
+		return SPDK_TIMER_WHEEL_LEVELS * SPDK_TIMER_WHEEL_SIZE + 1;
+	}
+
+	return head - &wheel->slots[0][0];
+}
+
+static inline struct timed_pollers_head *
+timer_wheel_head(struct timer_wheel *wheel, uint32_t index)
+{
+	if (index < SPDK_TIMER_WHEEL_LEVELS * SPDK_TIMER_WHEEL_SIZE) {
+		return &wheel->slots[index / SPDK_TIMER_WHEEL_SIZE][index % SPDK_TIMER_WHEEL_SIZE];
+	} else if (index == SPDK_TIMER_WHEEL_LEVELS * SPDK_TIMER_WHEEL_SIZE) {
+		return &wheel->overflow;
+	} else if (index == SPDK_TIMER_WHEEL_LEVELS * SPDK_TIMER_WHEEL_SIZE + 1) {
+		return &wheel->expiring;
+	}
+
+	return NULL;
+}
+
+static void
+timer_wheel_remove(struct timer_wheel *wheel, struct spdk_poller *poller)
+{
+	struct timed_pollers_head *head = poller->timer_head;
+	uint32_t index;
+
+	assert(head != NULL);
+	assert(wheel->count > 0);
+
+	TAILQ_REMOVE(head, poller, timer_link);
+	poller->timer_head = NULL;
+	wheel->count--;
+
+	index = timer_wheel_index(wheel, head);
+	if (TAILQ_EMPTY(head) && index < SPDK_TIMER_WHEEL_LEVELS * SPDK_TIMER_WHEEL_SIZE) {
+		wheel->bitmap[index / SPDK_TIMER_WHEEL_SIZE] &= ~(1ULL << (index % SPDK_TIMER_WHEEL_SIZE));
+	}
+}
+
+static struct spdk_poller *
+timer_wheel_first_from(struct timer_wheel *wheel, uint32_t index)
+{
+	struct timed_pollers_head *head;
+
+	if (wheel->count == 0) {
+		return NULL;
+	}
+
+	while ((head = timer_wheel_head(wheel, index)) != NULL) {
+		if (!TAILQ_EMPTY(head)) {
+			return TAILQ_FIRST(head);
+		}
+		index++;
+	}
+
+	return NULL;
+}
+
+static void
+timer_wheel_requeue(struct timer_wheel *wheel, struct timed_pollers_head *head)
+{
+	struct timed_pollers_head pollers;
+	struct spdk_poller *poller;
+
+	if (TAILQ_EMPTY(head)) {
+		return;
+	}
+
+	TAILQ_INIT(&pollers);
+	while ((poller = TAILQ_FIRST(head)) != NULL) {
+		timer_wheel_remove(wheel, poller);
+		TAILQ_INSERT_TAIL(&pollers, poller, timer_link);
+	}
+
+	while ((poller = TAILQ_FIRST(&pollers)) != NULL) {
+		TAILQ_REMOVE(&pollers, poller, timer_link);
+		timer_wheel_add(wheel, poller);
+	}
+}
+
+/* Called when the wheel reaches the start of a level 0 rotation. Move pollers of the
+ * upper level slots which start now down the wheel.
+ */
+static void
+timer_wheel_cascade(struct timer_wheel *wheel)
+{
+	uint32_t level, shift;
+
+	for (level = 1; level < SPDK_TIMER_WHEEL_LEVELS; level++) {
+		shift = SPDK_TIMER_WHEEL_BITS * level;
+		if ((wheel->cur & ((1ULL << shift) - 1)) != 0) {
+			return;
+		}
+		timer_wheel_requeue(wheel,
+				    &wheel->slots[level][(wheel->cur >> shift) & SPDK_TIMER_WHEEL_MASK]);
+	}
+
+	if ((wheel->cur & ((1ULL << (SPDK_TIMER_WHEEL_BITS * SPDK_TIMER_WHEEL_LEVELS)) - 1)) == 0) {
+		timer_wheel_requeue(wheel, &wheel->overflow);
+	}
+}
 
 static inline struct spdk_thread *
 _get_thread(void)
@@ -373,12 +579,12 @@ _free_thread(struct spdk_thread *thread)
 		free(poller);
 	}
 
-	RB_FOREACH_SAFE(poller, timed_pollers_tree, &thread->timed_pollers, ptmp) {
+	while ((poller = spdk_thread_get_first_timed_poller(thread)) != NULL) {
 		if (poller->state != SPDK_POLLER_STATE_UNREGISTERED) {
 			SPDK_WARNLOG("timed_poller %s still registered at thread exit\n",
 				     poller->name);
 		}
-		RB_REMOVE(timed_pollers_tree, &thread->timed_pollers, poller);
+		timer_wheel_remove(&thread->timed_pollers, poller);
 		free(poller);
 	}
 
@@ -412,6 +618,7 @@ _free_thread(struct spdk_thread *thread)
 	}
 
 	spdk_ring_free(thread->messages);
+	free(thread->msg_latency);
 	free(thread);
 }
 
@@ -436,12 +643,12 @@ spdk_thread_create(const char *name, struct spdk_cpuset *cpumask)
 
 	RB_INIT(&thread->io_channels);
 	TAILQ_INIT(&thread->active_pollers);
-	RB_INIT(&thread->timed_pollers);
 	TAILQ_INIT(&thread->paused_pollers);
 	SLIST_INIT(&thread->msg_cache);
 	thread->msg_cache_count = 0;
 
 	thread->tsc_last = spdk_get_ticks();
+	timer_wheel_init(&thread->timed_pollers, thread->tsc_last);
 
 	/* Monotonic increasing ID is set to each created poller beginning at 1. Once the
 	 * ID exceeds UINT64_MAX a warning message is logged
@@ -539,7 +746,8 @@ thread_exit(struct spdk_thread *thread, uint64_t now)
 		}
 	}
 
-	RB_FOREACH(poller, timed_pollers_tree, &thread->timed_pollers) {
+	for (poller = spdk_thread_get_first_timed_poller(thread); poller != NULL;
+	     poller = spdk_thread_get_next_timed_poller(poller)) {
 		if (poller->state != SPDK_POLLER_STATE_UNREGISTERED) {
 			SPDK_INFOLOG(thread,
 				     "thread %s still has active timed poller %s\n",
@@ -676,7 +884,7 @@ msg_queue_run_batch(struct spdk_thread *thread, uint32_t max_msgs)
 {
 	unsigned count, i;
 	void *messages[SPDK_MSG_BATCH_SIZE];
-	uint64_t notify = 1;
+	uint64_t notify = 1, now = 0, wait_tsc;
 	int rc;
 
 #ifdef DEBUG
@@ -711,6 +919,16 @@ msg_queue_run_batch(struct spdk_thread *thread, uint32_t max_msgs)
 
 		assert(msg != NULL);
 
+		if (spdk_unlikely(msg->tsc != 0)) {
+			if (now == 0) {
+				now = spdk_get_ticks();
+			}
+			wait_tsc = now > msg->tsc ? now - msg->tsc : 0;
+			spdk_msg_latency_record(&thread->msg_latency, msg->src_id, msg->fn, wait_tsc);
+			spdk_trace_record_tsc(now, TRACE_THREAD_MSG_WAIT, 0, 0, (uintptr_t)msg->fn,
+					      msg->src_id, wait_tsc);
+		}
+
 		SPDK_DTRACE_PROBE2(msg_exec, msg->fn, msg->arg);
 
 		msg->fn(msg->arg);
@@ -731,41 +949,15 @@ msg_queue_run_batch(struct spdk_thread *thread, uint32_t max_msgs)
 static void
 poller_insert_timer(struct spdk_thread *thread, struct spdk_poller *poller, uint64_t now)
 {
-	struct spdk_poller *tmp __attribute__((unused));
-
 	poller->next_run_tick = now + poller->period_ticks;
 
-	/*
-	 * Insert poller in the thread's timed_pollers tree by next scheduled run time
-	 * as its key.
-	 */
-	tmp = RB_INSERT(timed_pollers_tree, &thread->timed_pollers, poller);
-	assert(tmp == NULL);
-
-	/* Update the cache only if it is empty or the inserted poller is earlier than it.
-	 * RB_MIN() is not necessary here because all pollers, which has exactly the same
-	 * next_run_tick as the existing poller, are inserted on the right side.
-	 */
-	if (thread->first_timed_poller == NULL ||
-	    poller->next_run_tick < thread->first_timed_poller->next_run_tick) {
-		thread->first_timed_poller = poller;
-	}
+	timer_wheel_add(&thread->timed_pollers, poller);
 }
 
 static inline void
 poller_remove_timer(struct spdk_thread *thread, struct spdk_poller *poller)
 {
-	struct spdk_poller *tmp __attribute__((unused));
-
-	tmp = RB_REMOVE(timed_pollers_tree, &thread->timed_pollers, poller);
-	assert(tmp != NULL);
-
-	/* This function is not used in any case that is performance critical.
-	 * Update the cache simply by RB_MIN() if it needs to be changed.
-	 */
-	if (thread->first_timed_poller == poller) {
-		thread->first_timed_poller = RB_MIN(timed_pollers_tree, &thread->timed_pollers);
-	}
+	timer_wheel_remove(&thread->timed_pollers, poller);
 }
 
 static void
@@ -793,8 +985,29 @@ thread_update_stats(struct spdk_thread *thread, uint64_t end,
 	thread->tsc_last = end;
 }
 
+/* Charge the poller with the ticks since *tsc and move *tsc to now. The end of one
+ * invocation is the start of the next one, so each invocation reads the TSC once.
+ */
+static inline void
+poller_update_tsc(struct spdk_poller *poller, uint64_t *tsc)
+{
+	uint64_t now = spdk_get_ticks();
+	uint32_t bucket = 0;
+	uint64_t cost;
+
+	cost = now - *tsc;
+	*tsc = now;
+	poller->tsc += cost;
+
+	if (cost >> (SPDK_POLLER_TSC_HISTOGRAM_SHIFT + 1)) {
+		bucket = 63 - __builtin_clzll(cost) - SPDK_POLLER_TSC_HISTOGRAM_SHIFT;
+		bucket = spdk_min(bucket, SPDK_POLLER_TSC_HISTOGRAM_BUCKETS - 1);
+	}
+	poller->tsc_histogram[bucket]++;
+}
+
 static inline int
-thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller)
+thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller, uint64_t *tsc)
 {
 	int rc;
 
@@ -817,6 +1030,7 @@ thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller)
 
 	poller->state = SPDK_POLLER_STATE_RUNNING;
 	rc = poller->fn(poller->arg);
+	poller_update_tsc(poller, tsc);
 
 	poller->run_count++;
 	if (rc > 0) {
@@ -855,7 +1069,7 @@ thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller)
 
 static inline int
 thread_execute_timed_poller(struct spdk_thread *thread, struct spdk_poller *poller,
-			    uint64_t now)
+			    uint64_t now, uint64_t *tsc)
 {
 	int rc;
 
@@ -876,6 +1090,7 @@ thread_execute_timed_poller(struct spdk_thread *thread, struct spdk_poller *poll
 
 	poller->state = SPDK_POLLER_STATE_RUNNING;
 	rc = poller->fn(poller->arg);
+	poller_update_tsc(poller, tsc);
 
 	poller->run_count++;
 	if (rc > 0) {
@@ -912,13 +1127,113 @@ thread_execute_timed_poller(struct spdk_thread *thread, struct spdk_poller *poll
 	return rc;
 }
 
+/* Move the wheel straight to target, e.g. after the thread was not polled for a long
+ * time, instead of walking all the slots in between. Pollers which expired meanwhile
+ * end up in the current slot.
+ */
+static void
+timer_wheel_jump(struct timer_wheel *wheel, uint64_t target)
+{
+	uint32_t index;
+
+	wheel->cur = target;
+	for (index = 0; index <= SPDK_TIMER_WHEEL_LEVELS * SPDK_TIMER_WHEEL_SIZE; index++) {
+		timer_wheel_requeue(wheel, timer_wheel_head(wheel, index));
+	}
+}
+
+static int
+thread_expire_timer_slot(struct spdk_thread *thread, uint32_t slot, uint64_t now,
+			 uint64_t *tsc)
+{
+	struct timer_wheel *wheel = &thread->timed_pollers;
+	struct spdk_poller *poller;
+	int rc = 0, timer_rc;
+
+	/* Move the slot aside, so that pollers re-armed or registered by the expired
+	 * pollers go back to the wheel instead of the list being walked.
+	 */
+	TAILQ_SWAP(&wheel->expiring, &wheel->slots[0][slot], spdk_poller, timer_link);
+	wheel->bitmap[0] &= ~(1ULL << slot);
+	TAILQ_FOREACH(poller, &wheel->expiring, timer_link) {
+		poller->timer_head = &wheel->expiring;
+	}
+
+	while ((poller = TAILQ_FIRST(&wheel->expiring)) != NULL) {
+		timer_wheel_remove(wheel, poller);
+
+		/* A slot spans a whole timer unit, but pollers never run early. */
+		if (now < poller->next_run_tick) {
+			timer_wheel_add(wheel, poller);
+			continue;
+		}
+
+		timer_rc = thread_execute_timed_poller(thread, poller, now, tsc);
+		if (timer_rc > rc) {
+			rc = timer_rc;
+		}
+	}
+
+	return rc;
+}
+
+static int
+thread_run_timed_pollers(struct spdk_thread *thread, uint64_t now, uint64_t *tsc)
+{
+	struct timer_wheel *wheel = &thread->timed_pollers;
+	uint64_t target = now >> wheel->shift;
+	uint64_t pending;
+	uint32_t slot;
+	int rc = 0, timer_rc;
+
+	if (wheel->count == 0) {
+		wheel->cur = spdk_max(wheel->cur, target);
+		return 0;
+	}
+
+	if (spdk_unlikely(target > wheel->cur &&
+			  target - wheel->cur > SPDK_TIMER_WHEEL_SIZE * SPDK_TIMER_WHEEL_SIZE)) {
+		timer_wheel_jump(wheel, target);
+	}
+
+	while (true) {
+		slot = wheel->cur & SPDK_TIMER_WHEEL_MASK;
+		if (wheel->bitmap[0] & (1ULL << slot)) {
+			timer_rc = thread_expire_timer_slot(thread, slot, now, tsc);
+			if (timer_rc > rc) {
+				rc = timer_rc;
+			}
+		}
+
+		if (wheel->cur >= target) {
+			break;
+		}
+
+		/* Skip empty slots up to the next one in use or the end of the rotation. */
+		pending = slot == SPDK_TIMER_WHEEL_MASK ? 0 : wheel->bitmap[0] & (~0ULL << (slot + 1));
+		if (pending != 0) {
+			wheel->cur += __builtin_ctzll(pending) - slot;
+		} else {
+			wheel->cur += SPDK_TIMER_WHEEL_SIZE - slot;
+		}
+		wheel->cur = spdk_min(wheel->cur, target);
+
+		if ((wheel->cur & SPDK_TIMER_WHEEL_MASK) == 0) {
+			timer_wheel_cascade(wheel);
+		}
+	}
+
+	return rc;
+}
+
 static int
 thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 {
 	uint32_t msg_count;
 	struct spdk_poller *poller, *tmp;
 	spdk_msg_fn critical_msg;
-	int rc = 0;
+	int rc = 0, timer_rc;
+	uint64_t tsc;
 
 	thread->tsc_last = now;
 
@@ -934,41 +1249,22 @@ thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 		rc = 1;
 	}
 
+	/* The first poller starts where the messages left off */
+	tsc = rc ? spdk_get_ticks() : now;
+
 	TAILQ_FOREACH_REVERSE_SAFE(poller, &thread->active_pollers,
 				   active_pollers_head, tailq, tmp) {
 		int poller_rc;
 
-		poller_rc = thread_execute_poller(thread, poller);
+		poller_rc = thread_execute_poller(thread, poller, &tsc);
 		if (poller_rc > rc) {
 			rc = poller_rc;
 		}
 	}
 
-	poller = thread->first_timed_poller;
-	while (poller != NULL) {
-		int timer_rc = 0;
-
-		if (now < poller->next_run_tick) {
-			break;
-		}
-
-		tmp = RB_NEXT(timed_pollers_tree, &thread->timed_pollers, poller);
-		RB_REMOVE(timed_pollers_tree, &thread->timed_pollers, poller);
-
-		/* Update the cache to the next timed poller in the list
-		 * only if the current poller is still the closest, otherwise,
-		 * do nothing because the cache has been already updated.
-		 */
-		if (thread->first_timed_poller == poller) {
-			thread->first_timed_poller = tmp;
-		}
-
-		timer_rc = thread_execute_timed_poller(thread, poller, now);
-		if (timer_rc > rc) {
-			rc = timer_rc;
-		}
-
-		poller = tmp;
+	timer_rc = thread_run_timed_pollers(thread, now, &tsc);
+	if (timer_rc > rc) {
+		rc = timer_rc;
 	}
 
 	return rc;
@@ -1022,7 +1318,8 @@ spdk_thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 				}
 			}
 
-			RB_FOREACH_SAFE(poller, timed_pollers_tree, &thread->timed_pollers, tmp) {
+			for (poller = spdk_thread_get_first_timed_poller(thread); poller != NULL; poller = tmp) {
+				tmp = spdk_thread_get_next_timed_poller(poller);
 				if (poller->state == SPDK_POLLER_STATE_UNREGISTERED) {
 					poller_remove_timer(thread, poller);
 					free(poller);
@@ -1048,14 +1345,48 @@ spdk_thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 uint64_t
 spdk_thread_next_poller_expiration(struct spdk_thread *thread)
 {
+	struct timer_wheel *wheel = &thread->timed_pollers;
 	struct spdk_poller *poller;
+	uint64_t bitmap, next_run_tick = UINT64_MAX;
+	uint32_t level, slot;
 
-	poller = thread->first_timed_poller;
-	if (poller) {
-		return poller->next_run_tick;
+	if (wheel->count == 0) {
+		return 0;
 	}
 
-	return 0;
+	/* The slots of a level cover consecutive time ranges starting at the current position
+	 * of the wheel, so the first slot in use holds the closest pollers of that level. A
+	 * poller of an upper level may still expire before the ones of the lower levels, so
+	 * every level is checked. The current slot of an upper level is the farthest one, as
+	 * it was cascaded down when the wheel reached it.
+	 */
+	for (level = 0; level < SPDK_TIMER_WHEEL_LEVELS; level++) {
+		bitmap = wheel->bitmap[level];
+		if (bitmap == 0) {
+			continue;
+		}
+
+		slot = (wheel->cur >> (SPDK_TIMER_WHEEL_BITS * level)) + (level == 0 ? 0 : 1);
+		slot &= SPDK_TIMER_WHEEL_MASK;
+		if (slot != 0) {
+			bitmap = (bitmap >> slot) | (bitmap << (SPDK_TIMER_WHEEL_SIZE - slot));
+		}
+		slot = (slot + __builtin_ctzll(bitmap)) & SPDK_TIMER_WHEEL_MASK;
+
+		TAILQ_FOREACH(poller, &wheel->slots[level][slot], timer_link) {
+			next_run_tick = spdk_min(next_run_tick, poller->next_run_tick);
+		}
+	}
+
+	TAILQ_FOREACH(poller, &wheel->overflow, timer_link) {
+		next_run_tick = spdk_min(next_run_tick, poller->next_run_tick);
+	}
+
+	TAILQ_FOREACH(poller, &wheel->expiring, timer_link) {
+		next_run_tick = spdk_min(next_run_tick, poller->next_run_tick);
+	}
+
+	return next_run_tick;
 }
 
 int
@@ -1068,7 +1399,7 @@ static bool
 thread_has_unpaused_pollers(struct spdk_thread *thread)
 {
 	if (TAILQ_EMPTY(&thread->active_pollers) &&
-	    RB_EMPTY(&thread->timed_pollers)) {
+	    thread->timed_pollers.count == 0) {
 		return false;
 	}
 
@@ -1127,6 +1458,37 @@ spdk_thread_get_id(const struct spdk_thread *thread)
 	return thread->id;
 }
 
+int32_t
+spdk_thread_get_numa_id(struct spdk_thread *thread)
+{
+	uint32_t channels[SPDK_THREAD_MAX_NUMA_NODES] = {};
+	struct spdk_io_channel *ch;
+	int32_t numa_id = SPDK_ENV_SOCKET_ID_ANY;
+	uint32_t max = 0;
+	int32_t i;
+	bool tie = false;
+
+	/* Count the channels to devices that are bound to a node. Channels to purely
+	 * logical devices (bdev layer, accel, ...) don't have a say. */
+	RB_FOREACH(ch, io_channel_tree, &thread->io_channels) {
+		if (ch->dev->numa_id != SPDK_ENV_SOCKET_ID_ANY) {
+			channels[ch->dev->numa_id]++;
+		}
+	}
+
+	for (i = 0; i < SPDK_THREAD_MAX_NUMA_NODES; i++) {
+		if (channels[i] > max) {
+			max = channels[i];
+			numa_id = i;
+			tie = false;
+		} else if (channels[i] == max && max > 0) {
+			tie = true;
+		}
+	}
+
+	return tie ? SPDK_ENV_SOCKET_ID_ANY : numa_id;
+}
+
 struct spdk_thread *
 spdk_thread_get_by_id(uint64_t id)
 {
@@ -1202,53 +1564,126 @@ thread_send_msg_notification(const struct spdk_thread *target_thread)
 	return 0;
 }
 
-int
-spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx)
+static int
+thread_get_msgs(struct spdk_msg **msgs, uint32_t count)
 {
 	struct spdk_thread *local_thread;
-	struct spdk_msg *msg;
-	int rc;
-
-	assert(thread != NULL);
-
-	if (spdk_unlikely(thread->state == SPDK_THREAD_STATE_EXITED)) {
-		SPDK_ERRLOG("Thread %s is marked as exited.\n", thread->name);
-		return -EIO;
-	}
+	uint32_t i = 0;
 
 	local_thread = _get_thread();
-
-	msg = NULL;
 	if (local_thread != NULL) {
-		if (local_thread->msg_cache_count > 0) {
-			msg = SLIST_FIRST(&local_thread->msg_cache);
-			assert(msg != NULL);
+		while (i < count && local_thread->msg_cache_count > 0) {
+			msgs[i] = SLIST_FIRST(&local_thread->msg_cache);
+			assert(msgs[i] != NULL);
 			SLIST_REMOVE_HEAD(&local_thread->msg_cache, link);
 			local_thread->msg_cache_count--;
+			i++;
 		}
 	}
 
-	if (msg == NULL) {
-		msg = spdk_mempool_get(g_spdk_msg_mempool);
-		if (!msg) {
+	if (i < count) {
+		if (spdk_mempool_get_bulk(g_spdk_msg_mempool, (void **)&msgs[i], count - i) != 0) {
 			SPDK_ERRLOG("msg could not be allocated\n");
+			if (i > 0) {
+				spdk_mempool_put_bulk(g_spdk_msg_mempool, (void **)msgs, i);
+			}
 			return -ENOMEM;
 		}
 	}
 
-	msg->fn = fn;
-	msg->arg = ctx;
+	return 0;
+}
+
+static int
+thread_enqueue_msgs(const struct spdk_thread *thread, struct spdk_msg **msgs, uint32_t count)
+{
+	struct spdk_thread *local_thread;
+	uint64_t tsc = 0, src_id = 0;
+	uint32_t i;
+	size_t rc;
+
+	if (spdk_unlikely(g_msg_latency_tracking)) {
+		tsc = spdk_get_ticks();
+		local_thread = _get_thread();
+		src_id = local_thread != NULL ? local_thread->id : 0;
+	}
+
+	for (i = 0; i < count; i++) {
+		msgs[i]->tsc = tsc;
+		msgs[i]->src_id = src_id;
+	}
 
-	rc = spdk_ring_enqueue(thread->messages, (void **)&msg, 1, NULL);
-	if (rc != 1) {
+	rc = spdk_ring_enqueue(thread->messages, (void **)msgs, count, NULL);
+	if (rc != count) {
 		SPDK_ERRLOG("msg could not be enqueued\n");
-		spdk_mempool_put(g_spdk_msg_mempool, msg);
+		spdk_mempool_put_bulk(g_spdk_msg_mempool, (void **)msgs, count);
 		return -EIO;
 	}
 
 	return thread_send_msg_notification(thread);
 }
 
+int
+spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx)
+{
+	struct spdk_msg *msg;
+	int rc;
+
+	assert(thread != NULL);
+
+	if (spdk_unlikely(thread->state == SPDK_THREAD_STATE_EXITED)) {
+		SPDK_ERRLOG("Thread %s is marked as exited.\n", thread->name);
+		return -EIO;
+	}
+
+	rc = thread_get_msgs(&msg, 1);
+	if (rc != 0) {
+		return rc;
+	}
+
+	msg->fn = fn;
+	msg->arg = ctx;
+
+	return thread_enqueue_msgs(thread, &msg, 1);
+}
+
+int
+spdk_thread_send_msg_batch(const struct spdk_thread *thread, spdk_msg_fn fn, void **ctxs,
+			   uint32_t count)
+{
+	struct spdk_msg *msgs[SPDK_THREAD_MSG_BATCH_MAX];
+	uint32_t i;
+	int rc;
+
+	assert(thread != NULL);
+
+	if (spdk_unlikely(count > SPDK_THREAD_MSG_BATCH_MAX)) {
+		SPDK_ERRLOG("Too many messages in a batch: %" PRIu32 "\n", count);
+		return -EINVAL;
+	}
+
+	if (count == 0) {
+		return 0;
+	}
+
+	if (spdk_unlikely(thread->state == SPDK_THREAD_STATE_EXITED)) {
+		SPDK_ERRLOG("Thread %s is marked as exited.\n", thread->name);
+		return -EIO;
+	}
+
+	rc = thread_get_msgs(msgs, count);
+	if (rc != 0) {
+		return rc;
+	}
+
+	for (i = 0; i < count; i++) {
+		msgs[i]->fn = fn;
+		msgs[i]->arg = ctxs[i];
+	}
+
+	return thread_enqueue_msgs(thread, msgs, count);
+}
+
 int
 spdk_thread_send_critical_msg(struct spdk_thread *thread, spdk_msg_fn fn)
 {
@@ -1772,6 +2207,8 @@ spdk_poller_get_stats(struct spdk_poller *poller, struct spdk_poller_stats *stat
 {
 	stats->run_count = poller->run_count;
 	stats->busy_count = poller->busy_count;
+	stats->tsc = poller->tsc;
+	memcpy(stats->tsc_histogram, poller->tsc_histogram, sizeof(stats->tsc_histogram));
 }
 
 struct spdk_poller *
@@ -1789,13 +2226,21 @@ spdk_thread_get_next_active_poller(struct spdk_poller *prev)
 struct spdk_poller *
 spdk_thread_get_first_timed_poller(struct spdk_thread *thread)
 {
-	return RB_MIN(timed_pollers_tree, &thread->timed_pollers);
+	return timer_wheel_first_from(&thread->timed_pollers, 0);
 }
 
 struct spdk_poller *
 spdk_thread_get_next_timed_poller(struct spdk_poller *prev)
 {
-	return RB_NEXT(timed_pollers_tree, &thread->timed_pollers, prev);
+	struct timer_wheel *wheel = &prev->thread->timed_pollers;
+	struct spdk_poller *poller;
+
+	poller = TAILQ_NEXT(prev, timer_link);
+	if (poller != NULL) {
+		return poller;
+	}
+
+	return timer_wheel_first_from(wheel, timer_wheel_index(wheel, prev->timer_head) + 1);
 }
 
 struct spdk_poller *
@@ -1822,6 +2267,82 @@ spdk_thread_get_next_io_channel(struct spdk_io_channel *prev)
 	return RB_NEXT(io_channel_tree, &thread->io_channels, prev);
 }
 
+void
+spdk_msg_latency_tracking_enable(bool enable)
+{
+	if (enable && !g_msg_latency_tracking) {
+		__atomic_fetch_add(&g_msg_latency_generation, 1, __ATOMIC_SEQ_CST);
+	}
+
+	g_msg_latency_tracking = enable;
+}
+
+bool
+spdk_msg_latency_tracking_is_enabled(void)
+{
+	return g_msg_latency_tracking;
+}
+
+void
+spdk_msg_latency_record(struct spdk_msg_latency_table **_table, uint64_t src_id, void *fn,
+			uint64_t wait_tsc)
+{
+	struct spdk_msg_latency_table *table = *_table;
+	struct spdk_msg_latency_stats *entry;
+	uint64_t generation = __atomic_load_n(&g_msg_latency_generation, __ATOMIC_RELAXED);
+	uint32_t i, idx;
+
+	if (spdk_unlikely(table == NULL)) {
+		table = calloc(1, sizeof(*table));
+		if (table == NULL) {
+			return;
+		}
+		table->generation = generation;
+		*_table = table;
+	} else if (spdk_unlikely(table->generation != generation)) {
+		memset(table, 0, sizeof(*table));
+		table->generation = generation;
+	}
+
+	/* Open addressing with linear probing, keyed on the (source, function) pair */
+	SPDK_STATIC_ASSERT(SPDK_MSG_LATENCY_TABLE_SIZE == 64, "Adjust the hash shift");
+	idx = (uint32_t)((((uintptr_t)fn ^ src_id) * 0x9E3779B97F4A7C15ULL) >> 58);
+
+	for (i = 0; i < SPDK_MSG_LATENCY_TABLE_SIZE; i++) {
+		entry = &table->entries[(idx + i) % SPDK_MSG_LATENCY_TABLE_SIZE];
+		if (entry->fn == NULL) {
+			entry->fn = fn;
+			entry->src_id = src_id;
+		} else if (entry->fn != fn || entry->src_id != src_id) {
+			continue;
+		}
+
+		entry->count++;
+		entry->total_tsc += wait_tsc;
+		entry->max_tsc = spdk_max(entry->max_tsc, wait_tsc);
+		return;
+	}
+
+	table->dropped++;
+}
+
+const struct spdk_msg_latency_table *
+spdk_msg_latency_get(struct spdk_msg_latency_table *table)
+{
+	if (table == NULL ||
+	    table->generation != __atomic_load_n(&g_msg_latency_generation, __ATOMIC_RELAXED)) {
+		return NULL;
+	}
+
+	return table;
+}
+
+const struct spdk_msg_latency_table *
+spdk_thread_get_msg_latency(struct spdk_thread *thread)
+{
+	return spdk_msg_latency_get(thread->msg_latency);
+}
+
 struct call_thread {
 	struct spdk_thread *cur_thread;
 	spdk_msg_fn fn;
@@ -1929,7 +2450,8 @@ spdk_thread_set_interrupt_mode(bool enable_interrupt)
 	}
 
 	/* Set pollers to expected mode */
-	RB_FOREACH_SAFE(poller, timed_pollers_tree, &thread->timed_pollers, tmp) {
+	for (poller = spdk_thread_get_first_timed_poller(thread); poller != NULL; poller = tmp) {
+		tmp = spdk_thread_get_next_timed_poller(poller);
 		poller_set_interrupt_mode(poller, enable_interrupt);
 	}
 	TAILQ_FOREACH_SAFE(poller, &thread->active_pollers, tailq, tmp) {
@@ -1989,6 +2511,7 @@ spdk_io_device_register(void *io_device, spdk_io_channel_create_cb create_cb,
 	dev->unregister_cb = NULL;
 	dev->ctx_size = ctx_size;
 	dev->for_each_count = 0;
+	dev->numa_id = SPDK_ENV_SOCKET_ID_ANY;
 	dev->unregistered = false;
 	dev->refcnt = 0;
 
@@ -2041,6 +2564,31 @@ io_device_free(struct io_device *dev)
 	}
 }
 
+int
+spdk_io_device_set_numa_id(void *io_device, int32_t numa_id)
+{
+	struct io_device *dev;
+
+	if (numa_id != SPDK_ENV_SOCKET_ID_ANY &&
+	    (numa_id < 0 || numa_id >= SPDK_THREAD_MAX_NUMA_NODES)) {
+		SPDK_ERRLOG("NUMA node %d out of range\n", numa_id);
+		return -EINVAL;
+	}
+
+	pthread_mutex_lock(&g_devlist_mutex);
+	dev = io_device_get(io_device);
+	if (dev == NULL) {
+		pthread_mutex_unlock(&g_devlist_mutex);
+		SPDK_ERRLOG("io_device %p not found\n", io_device);
+		return -ENODEV;
+	}
+
+	dev->numa_id = numa_id;
+	pthread_mutex_unlock(&g_devlist_mutex);
+
+	return 0;
+}
+
 void
 spdk_io_device_unregister(void *io_device, spdk_io_device_unregister_cb unregister_cb)
 {
@@ -2108,6 +2656,52 @@ thread_get_io_channel(struct spdk_thread *thread, struct io_device *dev)
 	return RB_FIND(io_channel_tree, &thread->io_channels, &find);
 }
 
+static inline struct io_channel_cache_entry *
+io_channel_cache_entry(struct spdk_thread *thread, void *io_device)
+{
+	uint64_t hash = (uintptr_t)io_device * 0x9E3779B97F4A7C15ULL;
+
+	return &thread->io_channel_cache[hash >> (64 - SPDK_IO_CHANNEL_CACHE_BITS)];
+}
+
+static inline void
+io_channel_cache_insert(struct spdk_thread *thread, struct spdk_io_channel *ch)
+{
+	struct io_channel_cache_entry *entry = io_channel_cache_entry(thread, ch->dev->io_device);
+
+	entry->io_device = ch->dev->io_device;
+	entry->ch = ch;
+}
+
+static inline void
+io_channel_cache_remove(struct spdk_thread *thread, struct spdk_io_channel *ch)
+{
+	struct io_channel_cache_entry *entry = io_channel_cache_entry(thread, ch->dev->io_device);
+
+	if (entry->ch == ch) {
+		entry->io_device = NULL;
+		entry->ch = NULL;
+	}
+}
+
+static inline struct spdk_io_channel *
+io_channel_cache_get(struct spdk_thread *thread, void *io_device)
+{
+	struct io_channel_cache_entry *entry = io_channel_cache_entry(thread, io_device);
+
+	/*
+	 * The channel holds a reference on its io_device, so the device cannot be freed
+	 *  underneath us. Channels of devices being unregistered are left to the slow path,
+	 *  which fails the lookup.
+	 */
+	if (entry->ch == NULL || entry->io_device != io_device ||
+	    spdk_unlikely(entry->ch->dev->unregistered)) {
+		return NULL;
+	}
+
+	return entry->ch;
+}
+
 struct spdk_io_channel *
 spdk_get_io_channel(void *io_device)
 {
@@ -2116,6 +2710,21 @@ spdk_get_io_channel(void *io_device)
 	struct io_device *dev;
 	int rc;
 
+	/*
+	 * Fast path without g_devlist_mutex. Only this thread adds or removes
+	 *  its own channels, so a cached channel is still valid.
+	 */
+	thread = _get_thread();
+	if (spdk_likely(thread != NULL && thread->state != SPDK_THREAD_STATE_EXITED)) {
+		ch = io_channel_cache_get(thread, io_device);
+		if (ch != NULL) {
+			ch->ref++;
+			spdk_trace_record(TRACE_THREAD_IOCH_GET, 0, 0,
+					  (uint64_t)spdk_io_channel_get_ctx(ch), ch->ref);
+			return ch;
+		}
+	}
+
 	pthread_mutex_lock(&g_devlist_mutex);
 	dev = io_device_get(io_device);
 	if (dev == NULL) {
@@ -2148,6 +2757,7 @@ spdk_get_io_channel(void *io_device)
 		 * An I/O channel already exists for this device on this
 		 *  thread, so return it.
 		 */
+		io_channel_cache_insert(thread, ch);
 		pthread_mutex_unlock(&g_devlist_mutex);
 		spdk_trace_record(TRACE_THREAD_IOCH_GET, 0, 0,
 				  (uint64_t)spdk_io_channel_get_ctx(ch), ch->ref);
@@ -2167,6 +2777,7 @@ spdk_get_io_channel(void *io_device)
 	ch->ref = 1;
 	ch->destroy_ref = 0;
 	RB_INSERT(io_channel_tree, &thread->io_channels, ch);
+	io_channel_cache_insert(thread, ch);
 
 	SPDK_DEBUGLOG(thread, "Get io_channel %p for io_device %s (%p) on thread %s refcnt %u\n",
 		      ch, dev->name, dev->io_device, thread->name, ch->ref);
@@ -2178,6 +2789,7 @@ spdk_get_io_channel(void *io_device)
 	rc = dev->create_cb(io_device, (uint8_t *)ch + sizeof(*ch));
 	if (rc != 0) {
 		pthread_mutex_lock(&g_devlist_mutex);
+		io_channel_cache_remove(thread, ch);
 		RB_REMOVE(io_channel_tree, &ch->thread->io_channels, ch);
 		dev->refcnt--;
 		free(ch);
@@ -2220,6 +2832,8 @@ put_io_channel(void *arg)
 		return;
 	}
 
+	io_channel_cache_remove(thread, ch);
+
 	pthread_mutex_lock(&g_devlist_mutex);
 	RB_REMOVE(io_channel_tree, &ch->thread->io_channels, ch);
 	pthread_mutex_unlock(&g_devlist_mutex);
@@ -0,0 +1,297 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk/ec.h"
+#include "spdk/config.h"
+#include "spdk/util.h"
+
+/* GF(2^8) with the polynomial x^8 + x^4 + x^3 + x^2 + 1, the same field as ISA-L */
+#define EC_GF_POLY	0x11d
+
+static uint8_t g_gf_log[256];
+static uint8_t g_gf_exp[512];
+
+__attribute__((constructor)) static void
+ec_gf_init(void)
+{
+	uint32_t i, x = 1;
+
+	for (i = 0; i < 255; i++) {
+		g_gf_exp[i] = x;
+		g_gf_log[x] = i;
+		x <<= 1;
+		if (x & 0x100) {
+			x ^= EC_GF_POLY;
+		}
+	}
+
+	/* Saves the modulo when adding two logarithms */
+	for (i = 255; i < SPDK_COUNTOF(g_gf_exp); i++) {
+		g_gf_exp[i] = g_gf_exp[i - 255];
+	}
+}
+
+static inline uint8_t
+ec_gf_mul(uint8_t a, uint8_t b)
+{
+	if (a == 0 || b == 0) {
+		return 0;
+	}
+
+	return g_gf_exp[g_gf_log[a] + g_gf_log[b]];
+}
+
+static inline uint8_t
+ec_gf_inv(uint8_t a)
+{
+	assert(a != 0);
+	return g_gf_exp[255 - g_gf_log[a]];
+}
+
+/*
+ * Row of the generator matrix for buffer idx. The data buffers are the identity, the
+ * parity buffers use a Cauchy matrix, built like ISA-L's gf_gen_cauchy1_matrix() so
+ * that parity is the same with and without ISA-L.
+ */
+static void
+ec_get_row(uint32_t ndata, uint32_t idx, uint8_t *row)
+{
+	uint32_t j;
+
+	for (j = 0; j < ndata; j++) {
+		if (idx < ndata) {
+			row[j] = idx == j ? 1 : 0;
+		} else {
+			row[j] = ec_gf_inv(idx ^ j);
+		}
+	}
+}
+
+/* Gauss-Jordan elimination, in is modified */
+static int
+ec_invert_matrix(uint8_t *in, uint8_t *out, uint32_t n)
+{
+	uint32_t i, j, l;
+	uint8_t t;
+
+	memset(out, 0, n * n);
+	for (i = 0; i < n; i++) {
+		out[i * n + i] = 1;
+	}
+
+	for (i = 0; i < n; i++) {
+		if (in[i * n + i] == 0) {
+			for (j = i + 1; j < n && in[j * n + i] == 0; j++) {
+			}
+			if (j == n) {
+				return -EINVAL;
+			}
+			for (l = 0; l < n; l++) {
+				t = in[i * n + l];
+				in[i * n + l] = in[j * n + l];
+				in[j * n + l] = t;
+				t = out[i * n + l];
+				out[i * n + l] = out[j * n + l];
+				out[j * n + l] = t;
+			}
+		}
+
+		t = ec_gf_inv(in[i * n + i]);
+		for (l = 0; l < n; l++) {
+			in[i * n + l] = ec_gf_mul(in[i * n + l], t);
+			out[i * n + l] = ec_gf_mul(out[i * n + l], t);
+		}
+
+		for (j = 0; j < n; j++) {
+			t = in[j * n + i];
+			if (j == i || t == 0) {
+				continue;
+			}
+			for (l = 0; l < n; l++) {
+				in[j * n + l] ^= ec_gf_mul(in[i * n + l], t);
+				out[j * n + l] ^= ec_gf_mul(out[i * n + l], t);
+			}
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Use Intelligent Storage Acceleration Library for line speed erasure coding
+ */
+
+#ifdef SPDK_CONFIG_ISAL
+#include "isa-l/include/erasure_code.h"
+
+static void
+ec_encode_rows(size_t len, uint32_t nsrcs, uint32_t ndsts, uint8_t *coef, void **srcs,
+	       void **dsts)
+{
+	uint8_t gftbls[32 * SPDK_EC_MAX_DATA_BUFS * SPDK_EC_MAX_PARITY_BUFS];
+
+	ec_init_tables(nsrcs, ndsts, coef, gftbls);
+	ec_encode_data(len, nsrcs, ndsts, gftbls, (uint8_t **)srcs, (uint8_t **)dsts);
+}
+
+#else
+
+static void
+ec_encode_rows(size_t len, uint32_t nsrcs, uint32_t ndsts, uint8_t *coef, void **srcs,
+	       void **dsts)
+{
+	uint8_t tbl[256], *src, *dst;
+	uint32_t r, j, x;
+	size_t off;
+
+	for (r = 0; r < ndsts; r++) {
+		dst = dsts[r];
+		for (j = 0; j < nsrcs; j++) {
+			/* Multiplication by this coefficient, as a lookup table */
+			for (x = 0; x < SPDK_COUNTOF(tbl); x++) {
+				tbl[x] = ec_gf_mul(coef[r * nsrcs + j], x);
+			}
+
+			src = srcs[j];
+			if (j == 0) {
+				for (off = 0; off < len; off++) {
+					dst[off] = tbl[src[off]];
+				}
+			} else {
+				for (off = 0; off < len; off++) {
+					dst[off] ^= tbl[src[off]];
+				}
+			}
+		}
+	}
+}
+
+#endif
+
+static int
+ec_check_geometry(uint32_t ndata, uint32_t nparity, size_t len)
+{
+	if (ndata == 0 || ndata > SPDK_EC_MAX_DATA_BUFS ||
+	    nparity == 0 || nparity > SPDK_EC_MAX_PARITY_BUFS || len > INT_MAX) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int
+spdk_ec_encode(void **data, uint32_t ndata, void **parity, uint32_t nparity, size_t len)
+{
+	uint8_t coef[SPDK_EC_MAX_PARITY_BUFS * SPDK_EC_MAX_DATA_BUFS];
+	uint32_t p;
+	int rc;
+
+	rc = ec_check_geometry(ndata, nparity, len);
+	if (rc != 0) {
+		return rc;
+	}
+
+	for (p = 0; p < nparity; p++) {
+		ec_get_row(ndata, ndata + p, &coef[p * ndata]);
+	}
+
+	ec_encode_rows(len, ndata, nparity, coef, data, parity);
+	return 0;
+}
+
+int
+spdk_ec_decode(void **data, uint32_t ndata, void **parity, uint32_t nparity,
+	       const uint32_t *erased, uint32_t nerased, size_t len)
+{
+	uint8_t matrix[SPDK_EC_MAX_DATA_BUFS * SPDK_EC_MAX_DATA_BUFS];
+	uint8_t inverse[SPDK_EC_MAX_DATA_BUFS * SPDK_EC_MAX_DATA_BUFS];
+	uint8_t coef[SPDK_EC_MAX_PARITY_BUFS * SPDK_EC_MAX_DATA_BUFS];
+	uint8_t row[SPDK_EC_MAX_DATA_BUFS], c;
+	void *srcs[SPDK_EC_MAX_DATA_BUFS], *dsts[SPDK_EC_MAX_PARITY_BUFS];
+	uint64_t erased_mask = 0;
+	uint32_t idx, r, i, j, s;
+	int rc;
+
+	rc = ec_check_geometry(ndata, nparity, len);
+	if (rc != 0) {
+		return rc;
+	}
+
+	if (nerased == 0 || nerased > nparity) {
+		return -EINVAL;
+	}
+
+	for (r = 0; r < nerased; r++) {
+		if (erased[r] >= ndata + nparity || (erased_mask & (1ULL << erased[r]))) {
+			return -EINVAL;
+		}
+		erased_mask |= 1ULL << erased[r];
+	}
+
+	/* Any ndata of the remaining buffers determine the stripe */
+	for (idx = 0, s = 0; s < ndata; idx++) {
+		if (erased_mask & (1ULL << idx)) {
+			continue;
+		}
+		ec_get_row(ndata, idx, &matrix[s * ndata]);
+		srcs[s++] = idx < ndata ? data[idx] : parity[idx - ndata];
+	}
+
+	rc = ec_invert_matrix(matrix, inverse, ndata);
+	if (rc != 0) {
+		return rc;
+	}
+
+	for (r = 0; r < nerased; r++) {
+		idx = erased[r];
+		if (idx < ndata) {
+			dsts[r] = data[idx];
+			memcpy(&coef[r * ndata], &inverse[idx * ndata], ndata);
+			continue;
+		}
+
+		/* A lost parity buffer is encoded again from the recovered data */
+		dsts[r] = parity[idx - ndata];
+		ec_get_row(ndata, idx, row);
+		for (i = 0; i < ndata; i++) {
+			c = 0;
+			for (j = 0; j < ndata; j++) {
+				c ^= ec_gf_mul(row[j], inverse[j * ndata + i]);
+			}
+			coef[r * ndata + i] = c;
+		}
+	}
+
+	ec_encode_rows(len, ndata, nerased, coef, srcs, dsts);
+	return 0;
+}
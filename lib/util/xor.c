@@ -0,0 +1,171 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk/xor.h"
+#include "spdk/config.h"
+#include "spdk/assert.h"
+#include "spdk/util.h"
+
+static void
+xor_gen_basic(void *dest, void **sources, uint32_t n, size_t len)
+{
+	uint8_t *d = dest;
+	uint64_t w, s;
+	size_t off;
+	uint32_t j;
+
+	/* Whole words first, memcpy() keeps unaligned buffers safe */
+	for (off = 0; off + sizeof(w) <= len; off += sizeof(w)) {
+		memcpy(&w, (uint8_t *)sources[0] + off, sizeof(w));
+		for (j = 1; j < n; j++) {
+			memcpy(&s, (uint8_t *)sources[j] + off, sizeof(s));
+			w ^= s;
+		}
+		memcpy(d + off, &w, sizeof(w));
+	}
+
+	for (; off < len; off++) {
+		d[off] = ((uint8_t *)sources[0])[off];
+		for (j = 1; j < n; j++) {
+			d[off] ^= ((uint8_t *)sources[j])[off];
+		}
+	}
+}
+
+/*
+ * Use Intelligent Storage Acceleration Library for line speed XOR
+ */
+
+#ifdef SPDK_CONFIG_ISAL
+#include "isa-l/include/raid.h"
+
+#define SPDK_XOR_BUF_ALIGN 32
+
+/* Sources are processed in groups that fit in the stack array given to ISA-L */
+#define SPDK_XOR_MAX_SRC	256
+
+static bool
+xor_buf_is_aligned(const void *buf, size_t alignment)
+{
+	return ((uintptr_t)buf & (alignment - 1)) == 0;
+}
+
+static bool
+xor_is_aligned(void *dest, void **sources, uint32_t n, size_t len, size_t alignment)
+{
+	uint32_t i;
+
+	if (len & (alignment - 1) || !xor_buf_is_aligned(dest, alignment)) {
+		return false;
+	}
+
+	for (i = 0; i < n; i++) {
+		if (!xor_buf_is_aligned(sources[i], alignment)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int
+xor_gen_isal(void *dest, void **sources, uint32_t n, size_t len)
+{
+	void *buffers[SPDK_XOR_MAX_SRC + 1];
+	uint32_t count;
+
+	if (len > INT_MAX) {
+		return -EINVAL;
+	}
+
+	/* Each group after the first one also takes the result so far as a source */
+	count = spdk_min(n, SPDK_XOR_MAX_SRC);
+	memcpy(buffers, sources, count * sizeof(buffers[0]));
+	buffers[count] = dest;
+	if (xor_gen(count + 1, len, buffers) != 0) {
+		return -EINVAL;
+	}
+
+	for (sources += count, n -= count; n > 0; sources += count, n -= count) {
+		count = spdk_min(n, SPDK_XOR_MAX_SRC - 1);
+		buffers[0] = dest;
+		memcpy(&buffers[1], sources, count * sizeof(buffers[0]));
+		buffers[count + 1] = dest;
+		if (xor_gen(count + 2, len, buffers) != 0) {
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+int
+spdk_xor_gen(void *dest, void **sources, uint32_t n, size_t len)
+{
+	if (n < 2) {
+		return -EINVAL;
+	}
+
+	if (xor_is_aligned(dest, sources, n, len, SPDK_XOR_BUF_ALIGN)) {
+		return xor_gen_isal(dest, sources, n, len);
+	}
+
+	xor_gen_basic(dest, sources, n, len);
+	return 0;
+}
+
+#else
+
+#define SPDK_XOR_BUF_ALIGN sizeof(uint64_t)
+
+int
+spdk_xor_gen(void *dest, void **sources, uint32_t n, size_t len)
+{
+	if (n < 2) {
+		return -EINVAL;
+	}
+
+	xor_gen_basic(dest, sources, n, len);
+	return 0;
+}
+
+#endif
+
+size_t
+spdk_xor_get_optimal_alignment(void)
+{
+	return SPDK_XOR_BUF_ALIGN;
+}
+
+SPDK_STATIC_ASSERT(SPDK_XOR_BUF_ALIGN > 0 && !(SPDK_XOR_BUF_ALIGN & (SPDK_XOR_BUF_ALIGN - 1)),
+		   "Must be power of 2");
@@ -127,6 +127,7 @@ DEPDIRS-env_dpdk_rpc := log $(JSON_LIBS)
 # module/sock
 DEPDIRS-sock_posix := log sock util
 DEPDIRS-sock_uring := log sock util
+DEPDIRS-sock_shm := log sock util
 
 # module/scheduler
 DEPDIRS-scheduler_dynamic := event log thread util json
@@ -111,6 +111,7 @@ endif
 SOCK_MODULES_LIST = sock_posix
 
 ifeq ($(OS), Linux)
+SOCK_MODULES_LIST += sock_shm
 ifeq ($(CONFIG_URING),y)
 SOCK_MODULES_LIST += sock_uring
 endif
@@ -3514,12 +3514,20 @@ static void
 nvme_ctrlr_create_done(struct nvme_ctrlr *nvme_ctrlr,
 		       struct nvme_async_probe_ctx *ctx)
 {
+	struct spdk_pci_device *pci_dev;
+
 	spdk_io_device_register(nvme_ctrlr,
 				bdev_nvme_create_ctrlr_channel_cb,
 				bdev_nvme_destroy_ctrlr_channel_cb,
 				sizeof(struct nvme_ctrlr_channel),
 				nvme_ctrlr->nbdev_ctrlr->name);
 
+	/* Let the scheduler keep the threads submitting I/O to a PCIe controller on its node */
+	pci_dev = spdk_nvme_ctrlr_get_pci_device(nvme_ctrlr->ctrlr);
+	if (pci_dev != NULL) {
+		spdk_io_device_set_numa_id(nvme_ctrlr, spdk_pci_device_get_socket_id(pci_dev));
+	}
+
 	nvme_ctrlr_populate_namespaces(nvme_ctrlr, ctx);
 }
 
@@ -39,8 +39,12 @@
 
 #include "spdk_internal/event.h"
 
+#include <rte_lcore.h>
 #include <rte_power.h>
 
+/* Cores whose idle states were limited by _set_core_idle_latency() */
+static bool g_idle_latency_set[RTE_MAX_LCORE];
+
 static uint32_t
 _get_core_curr_freq(uint32_t lcore_id)
 {
@@ -105,6 +109,85 @@ _get_core_capabilities(uint32_t lcore_id, struct spdk_governor_capabilities *cap
 	return 0;
 }
 
+#ifdef __linux__
+static int
+_get_core_cpu(uint32_t lcore_id)
+{
+	rte_cpuset_t cpuset = rte_lcore_cpuset(lcore_id);
+	int cpu;
+
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (CPU_ISSET(cpu, &cpuset)) {
+			return cpu;
+		}
+	}
+
+	return -ENODEV;
+}
+
+static int
+_set_core_idle_latency(uint32_t lcore_id, uint32_t latency_us)
+{
+	char path[PATH_MAX];
+	uint32_t state, exit_latency;
+	FILE *file;
+	int cpu, rc = 0;
+
+	if (lcore_id >= RTE_MAX_LCORE) {
+		return -EINVAL;
+	}
+
+	cpu = _get_core_cpu(lcore_id);
+	if (cpu < 0) {
+		return cpu;
+	}
+
+	/* Disable the cpuidle states of the core which take longer than latency_us to exit */
+	for (state = 0; rc == 0; state++) {
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpuidle/state%u/latency",
+			 cpu, state);
+		file = fopen(path, "r");
+		if (file == NULL) {
+			break;
+		}
+		if (fscanf(file, "%" SCNu32, &exit_latency) != 1) {
+			rc = -EIO;
+		}
+		fclose(file);
+		if (rc != 0) {
+			break;
+		}
+
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpuidle/state%u/disable",
+			 cpu, state);
+		file = fopen(path, "w");
+		if (file == NULL) {
+			rc = -errno;
+			break;
+		}
+		if (fprintf(file, "%d", exit_latency > latency_us ? 1 : 0) < 0) {
+			rc = -EIO;
+		}
+		if (fclose(file) != 0 && rc == 0) {
+			rc = -errno;
+		}
+	}
+
+	/* Errors are left to the caller, which may retry every scheduling period */
+	if (state == 0) {
+		return -ENOTSUP;
+	}
+
+	if (rc != 0) {
+		return rc;
+	}
+
+	g_idle_latency_set[lcore_id] = latency_us != UINT32_MAX;
+
+	return 0;
+}
+#endif
+
 static int
 _init_core(uint32_t lcore_id)
 {
@@ -170,6 +253,13 @@ _deinit(void)
 	uint32_t i;
 
 	SPDK_ENV_FOREACH_CORE(i) {
+#ifdef __linux__
+		/* Allow all idle states again */
+		if (i < RTE_MAX_LCORE && g_idle_latency_set[i] &&
+		    _set_core_idle_latency(i, UINT32_MAX) != 0) {
+			SPDK_ERRLOG("Failed to restore idle states of core%d\n", i);
+		}
+#endif
 		if (rte_power_exit(i) != 0) {
 			SPDK_ERRLOG("Failed to deinitialize on core%d\n", i);
 		}
@@ -184,6 +274,9 @@ static struct spdk_governor dpdk_governor = {
 	.set_core_freq_max = _set_core_freq_max,
 	.set_core_freq_min = _set_core_freq_min,
 	.get_core_capabilities = _get_core_capabilities,
+#ifdef __linux__
+	.set_core_idle_latency = _set_core_idle_latency,
+#endif
 	.init = _init,
 	.deinit = _deinit,
 };
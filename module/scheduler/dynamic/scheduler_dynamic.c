@@ -36,25 +36,86 @@
 #include "spdk/event.h"
 #include "spdk/log.h"
 #include "spdk/env.h"
+#include "spdk/string.h"
 
 #include "spdk/thread.h"
+#include "spdk/tree.h"
 #include "spdk_internal/event.h"
 #include "spdk/scheduler.h"
 #include "spdk_internal/usdt.h"
 
 static uint32_t g_main_lcore;
 
+enum core_power_state {
+	CORE_POWER_DEFAULT,
+	CORE_POWER_SAVE,
+	CORE_POWER_BOOST,
+};
+
+/* Upper bound of the back-off after failed governor calls, as a power of 2 periods */
+#define POWER_RETRY_MAX_SHIFT 10
+
+/* Failed governor calls for a core, e.g. when cpufreq or cpuidle is not accessible */
+struct power_retry {
+	uint32_t failures;
+	/* Scheduling period from which the call may be retried */
+	uint64_t next_period;
+};
+
 struct core_stats {
 	uint64_t busy;
 	uint64_t idle;
 	uint32_t thread_count;
+	int32_t numa_id;
+	/* Frequency and idle state limit last applied through the governor */
+	enum core_power_state power_state;
+	uint32_t idle_latency;
+	struct power_retry freq_retry;
+	struct power_retry idle_retry;
 };
 
 static struct core_stats *g_cores;
 
+/* Load history of a thread, kept across scheduling periods. */
+struct thread_load {
+	uint64_t thread_id;
+	/* Exponentially weighted busy and idle tsc, i.e. the predicted demand for the next period */
+	uint64_t busy;
+	uint64_t idle;
+	/* Core the thread was placed on in the last period */
+	uint32_t lcore;
+	bool moved;
+	/* Scheduling periods the thread was last seen in and last moved in */
+	uint64_t last_seen;
+	uint64_t last_move;
+	RB_ENTRY(thread_load) node;
+};
+
+static int
+thread_load_cmp(struct thread_load *load1, struct thread_load *load2)
+{
+	return (load1->thread_id < load2->thread_id ? -1 : load1->thread_id > load2->thread_id);
+}
+
+static RB_HEAD(thread_load_tree, thread_load) g_thread_loads = RB_INITIALIZER(g_thread_loads);
+RB_GENERATE_STATIC(thread_load_tree, thread_load, node, thread_load_cmp);
+
+/* Number of scheduling periods so far */
+static uint64_t g_period;
+
 uint8_t g_scheduler_load_limit = 20;
 uint8_t g_scheduler_core_limit = 80;
 uint8_t g_scheduler_core_busy = 95;
+/* Weight in % of the last period in the load history, 100 means no history at all */
+uint8_t g_scheduler_ewma_weight = 100;
+/* Width in % of the band around load_limit a thread has to cross to change from idle to active */
+uint8_t g_scheduler_hysteresis = 0;
+/* Number of periods a thread stays put after being moved */
+uint32_t g_scheduler_cooldown = 0;
+/* Drive the frequency of all cores, not only the main one */
+bool g_scheduler_power_aware = false;
+/* Maximum idle state exit latency in microseconds for cores running threads, 0 for no limit */
+uint32_t g_scheduler_latency_slo = 0;
 
 static uint8_t
 _busy_pct(uint64_t busy, uint64_t idle)
@@ -78,6 +139,103 @@ _get_thread_load(struct spdk_scheduler_thread_info *thread_info)
 	return _busy_pct(busy, idle);
 }
 
+static struct thread_load *
+_get_thread_load_history(uint64_t thread_id)
+{
+	struct thread_load find = {};
+
+	find.thread_id = thread_id;
+	return RB_FIND(thread_load_tree, &g_thread_loads, &find);
+}
+
+static uint64_t
+_ewma(uint64_t avg, uint64_t sample)
+{
+	return (sample * g_scheduler_ewma_weight + avg * (100 - g_scheduler_ewma_weight)) / 100;
+}
+
+static void
+_predict_thread_load(struct spdk_scheduler_thread_info *thread_info)
+{
+	struct thread_load *load;
+	struct core_stats *core = &g_cores[thread_info->lcore];
+	uint64_t busy = thread_info->current_stats.busy_tsc;
+	uint64_t idle = thread_info->current_stats.idle_tsc;
+	uint64_t tsc;
+
+	load = _get_thread_load_history(thread_info->thread_id);
+	if (load == NULL) {
+		load = calloc(1, sizeof(*load));
+		if (load == NULL) {
+			/* Schedule this thread on the last period alone */
+			return;
+		}
+		load->thread_id = thread_info->thread_id;
+		load->busy = busy;
+		load->idle = idle;
+		RB_INSERT(thread_load_tree, &g_thread_loads, load);
+	} else {
+		load->busy = _ewma(load->busy, busy);
+		load->idle = _ewma(load->idle, idle);
+	}
+
+	load->lcore = thread_info->lcore;
+	load->last_seen = g_period;
+
+	/* The rest of the scheduler works on the predicted demand instead of the last period.
+	 * Core stats are the sum of their threads, so replace this thread's share there too. */
+	tsc = core->busy + core->idle;
+	core->busy -= spdk_min(core->busy, busy);
+	core->busy = spdk_min(tsc, core->busy + load->busy);
+	core->idle = tsc - core->busy;
+
+	thread_info->current_stats.busy_tsc = load->busy;
+	thread_info->current_stats.idle_tsc = load->idle;
+}
+
+static void
+_record_thread_move(struct spdk_scheduler_thread_info *thread_info)
+{
+	struct thread_load *load;
+
+	load = _get_thread_load_history(thread_info->thread_id);
+	if (load != NULL && load->lcore != thread_info->lcore) {
+		load->lcore = thread_info->lcore;
+		load->moved = true;
+		load->last_move = g_period;
+	}
+}
+
+static void
+_prune_thread_loads(void)
+{
+	struct thread_load *load, *tmp;
+
+	/* Forget threads that are gone */
+	RB_FOREACH_SAFE(load, thread_load_tree, &g_thread_loads, tmp) {
+		if (load->last_seen != g_period) {
+			RB_REMOVE(thread_load_tree, &g_thread_loads, load);
+			free(load);
+		}
+	}
+}
+
+static bool
+_is_thread_active(struct spdk_scheduler_thread_info *thread_info)
+{
+	uint32_t limit = g_scheduler_load_limit;
+
+	/* A thread has to cross the whole hysteresis band around the load limit
+	 * to be moved off or back to the main core. */
+	if (thread_info->lcore == g_main_lcore) {
+		limit = spdk_min(limit + g_scheduler_hysteresis, 100);
+	} else {
+		limit -= spdk_min(limit, g_scheduler_hysteresis);
+	}
+
+	return _get_thread_load(thread_info) >= limit;
+}
+
 typedef void (*_foreach_fn)(struct spdk_scheduler_thread_info *thread_info);
 
 static void
@@ -168,6 +326,24 @@ _is_core_at_limit(uint32_t core_id)
 	return true;
 }
 
+static bool
+_is_thread_cooling_down(struct spdk_scheduler_thread_info *thread_info)
+{
+	struct thread_load *load;
+
+	load = _get_thread_load_history(thread_info->thread_id);
+	if (load == NULL || !load->moved) {
+		return false;
+	}
+
+	/* Threads on an overloaded core have to go regardless. */
+	if (_is_core_at_limit(thread_info->lcore)) {
+		return false;
+	}
+
+	return g_period - load->last_move <= g_scheduler_cooldown;
+}
+
 static bool
 _can_core_fit_thread(struct spdk_scheduler_thread_info *thread_info, uint32_t dst_core)
 {
@@ -203,15 +379,28 @@ _can_core_fit_thread(struct spdk_scheduler_thread_info *thread_info, uint32_t ds
 	return _busy_pct(new_busy_tsc, new_idle_tsc) < g_scheduler_core_limit;
 }
 
+static bool
+_is_core_local(uint32_t core_id, int32_t numa_id)
+{
+	/* Threads without device affinity and cores with unknown node are local everywhere. */
+	if (numa_id == SPDK_ENV_SOCKET_ID_ANY || g_cores[core_id].numa_id == SPDK_ENV_SOCKET_ID_ANY) {
+		return true;
+	}
+
+	return g_cores[core_id].numa_id == numa_id;
+}
+
 static uint32_t
 _find_optimal_core(struct spdk_scheduler_thread_info *thread_info)
 {
 	uint32_t i;
 	uint32_t current_lcore = thread_info->lcore;
 	uint32_t least_busy_lcore = thread_info->lcore;
+	uint32_t remote_lcore = UINT32_MAX;
 	struct spdk_thread *thread;
 	struct spdk_cpuset *cpumask;
 	bool core_at_limit = _is_core_at_limit(current_lcore);
+	bool core_is_local = _is_core_local(current_lcore, thread_info->numa_id);
 
 	thread = spdk_thread_get_by_id(thread_info->thread_id);
 	if (thread == NULL) {
@@ -235,7 +424,17 @@ _find_optimal_core(struct spdk_scheduler_thread_info *thread_info)
 		if (!_can_core_fit_thread(thread_info, i) || i == current_lcore) {
 			continue;
 		}
-		if (i == g_main_lcore) {
+		if (!_is_core_local(i, thread_info->numa_id)) {
+			/* Cross-node placement is the last resort, once no local core can fit the thread. */
+			if (remote_lcore == UINT32_MAX) {
+				remote_lcore = i;
+			}
+			continue;
+		}
+		if (!core_is_local) {
+			/* Thread runs away from its devices, bring it back to their node. */
+			return i;
+		} else if (i == g_main_lcore) {
 			/* First consider g_main_lcore, consolidate threads on main lcore if possible. */
 			return i;
 		} else if (i < current_lcore && current_lcore != g_main_lcore) {
@@ -248,8 +447,12 @@ _find_optimal_core(struct spdk_scheduler_thread_info *thread_info)
 	}
 
 	/* For cores over the limit, place the thread on least busy core
-	 * to balance threads. */
+	 * to balance threads. The local node is saturated at this point,
+	 * so prefer a remote core that can still fit the thread. */
 	if (core_at_limit) {
+		if (remote_lcore != UINT32_MAX) {
+			return remote_lcore;
+		}
 		return least_busy_lcore;
 	}
 
@@ -260,6 +463,8 @@ _find_optimal_core(struct spdk_scheduler_thread_info *thread_info)
 static int
 init(void)
 {
+	uint32_t i;
+
 	g_main_lcore = spdk_env_get_current_core();
 
 	if (spdk_governor_set("dpdk_governor") != 0) {
@@ -272,12 +477,36 @@ init(void)
 		return -ENOMEM;
 	}
 
+	SPDK_ENV_FOREACH_CORE(i) {
+		g_cores[i].numa_id = (int32_t)spdk_env_get_socket_id(i);
+		g_cores[i].idle_latency = UINT32_MAX;
+	}
+
 	return 0;
 }
 
 static void
 deinit(void)
 {
+	struct spdk_governor *governor = spdk_governor_get();
+	struct thread_load *load, *tmp;
+	uint32_t i;
+
+	/* Allow all idle states again on the cores limited by the latency SLO */
+	if (governor != NULL && governor->set_core_idle_latency != NULL) {
+		SPDK_ENV_FOREACH_CORE(i) {
+			if (g_cores[i].idle_latency != UINT32_MAX &&
+			    governor->set_core_idle_latency(i, UINT32_MAX) < 0) {
+				SPDK_ERRLOG("restoring idle states of core %u failed\n", i);
+			}
+		}
+	}
+
+	RB_FOREACH_SAFE(load, thread_load_tree, &g_thread_loads, tmp) {
+		RB_REMOVE(thread_load_tree, &g_thread_loads, load);
+		free(load);
+	}
+
 	free(g_cores);
 	g_cores = NULL;
 	spdk_governor_set(NULL);
@@ -286,7 +515,7 @@ deinit(void)
 static void
 _balance_idle(struct spdk_scheduler_thread_info *thread_info)
 {
-	if (_get_thread_load(thread_info) >= g_scheduler_load_limit) {
+	if (_is_thread_active(thread_info) || _is_thread_cooling_down(thread_info)) {
 		return;
 	}
 	/* This thread is idle, move it to the main core. */
@@ -298,7 +527,7 @@ _balance_active(struct spdk_scheduler_thread_info *thread_info)
 {
 	uint32_t target_lcore;
 
-	if (_get_thread_load(thread_info) < g_scheduler_load_limit) {
+	if (!_is_thread_active(thread_info) || _is_thread_cooling_down(thread_info)) {
 		return;
 	}
 
@@ -307,6 +536,84 @@ _balance_active(struct spdk_scheduler_thread_info *thread_info)
 	_move_thread(thread_info, target_lcore);
 }
 
+static bool
+_power_retry_due(struct power_retry *retry)
+{
+	return retry->failures == 0 || g_period >= retry->next_period;
+}
+
+/* Back off exponentially after a failure. Only the first failure in a row is worth
+ * logging, the following ones would just repeat it every period. */
+static bool
+_power_retry_failed(struct power_retry *retry)
+{
+	retry->failures++;
+	retry->next_period = g_period + (1ULL << spdk_min(retry->failures, POWER_RETRY_MAX_SHIFT));
+
+	return retry->failures == 1;
+}
+
+static void
+_balance_power(struct spdk_governor *governor)
+{
+	enum core_power_state state;
+	uint32_t i, latency;
+	int rc;
+
+	SPDK_ENV_FOREACH_CORE(i) {
+		/* Main core frequency follows its load, see balance(). Cores left without threads
+		 * go into interrupt mode at the lowest frequency. Other cores only run active
+		 * threads, so boost them. Once power awareness is disabled, restore the default. */
+		if (i != g_main_lcore) {
+			if (!g_scheduler_power_aware) {
+				state = CORE_POWER_DEFAULT;
+			} else {
+				state = g_cores[i].thread_count == 0 ? CORE_POWER_SAVE : CORE_POWER_BOOST;
+			}
+			if (state != g_cores[i].power_state && _power_retry_due(&g_cores[i].freq_retry)) {
+				if (state == CORE_POWER_SAVE) {
+					rc = governor->set_core_freq_min(i);
+				} else {
+					rc = governor->set_core_freq_max(i);
+				}
+				if (rc < 0) {
+					if (_power_retry_failed(&g_cores[i].freq_retry)) {
+						SPDK_ERRLOG("setting frequency for core %u failed\n", i);
+					}
+				} else {
+					g_cores[i].power_state = state;
+					g_cores[i].freq_retry.failures = 0;
+				}
+			}
+		}
+
+		if (governor->set_core_idle_latency == NULL) {
+			continue;
+		}
+
+		/* Unused cores may enter the deepest idle states, cores running threads
+		 * only the ones they can wake up from within the latency SLO. Without
+		 * an SLO, all idle states are allowed again. */
+		if (g_scheduler_latency_slo == 0 || g_cores[i].thread_count == 0) {
+			latency = UINT32_MAX;
+		} else {
+			latency = g_scheduler_latency_slo;
+		}
+		if (latency != g_cores[i].idle_latency && _power_retry_due(&g_cores[i].idle_retry)) {
+			rc = governor->set_core_idle_latency(i, latency);
+			if (rc < 0) {
+				if (_power_retry_failed(&g_cores[i].idle_retry)) {
+					SPDK_ERRLOG("setting idle latency for core %u failed: %s\n", i,
+						    spdk_strerror(-rc));
+				}
+			} else {
+				g_cores[i].idle_latency = latency;
+				g_cores[i].idle_retry.failures = 0;
+			}
+		}
+	}
+}
+
 static void
 balance(struct spdk_scheduler_core_info *cores_info, uint32_t cores_count)
 {
@@ -320,6 +627,8 @@ balance(struct spdk_scheduler_core_info *cores_info, uint32_t cores_count)
 
 	SPDK_DTRACE_PROBE1(dynsched_balance, cores_count);
 
+	g_period++;
+
 	SPDK_ENV_FOREACH_CORE(i) {
 		g_cores[i].thread_count = cores_info[i].threads_count;
 		g_cores[i].busy = cores_info[i].current_busy_tsc;
@@ -328,12 +637,18 @@ balance(struct spdk_scheduler_core_info *cores_info, uint32_t cores_count)
 	}
 	main_core = &g_cores[g_main_lcore];
 
+	/* Base all decisions on the load predicted from each thread's history. */
+	_foreach_thread(cores_info, _predict_thread_load);
+	_prune_thread_loads();
+
 	/* Distribute threads in two passes, to make sure updated core stats are considered on each pass.
 	 * 1) Move all idle threads to main core. */
 	_foreach_thread(cores_info, _balance_idle);
 	/* 2) Distribute active threads across all cores. */
 	_foreach_thread(cores_info, _balance_active);
 
+	_foreach_thread(cores_info, _record_thread_move);
+
 	/* Switch unused cores to interrupt mode and switch cores to polled mode
 	 * if they will be used after rebalancing */
 	SPDK_ENV_FOREACH_CORE(i) {
@@ -374,18 +689,30 @@ balance(struct spdk_scheduler_core_info *cores_info, uint32_t cores_count)
 			SPDK_ERRLOG("lowering frequency for core %u failed\n", g_main_lcore);
 		}
 	}
+
+	_balance_power(governor);
 }
 
 struct json_scheduler_opts {
 	uint8_t load_limit;
 	uint8_t core_limit;
 	uint8_t core_busy;
+	uint8_t ewma_weight;
+	uint8_t hysteresis;
+	uint32_t cooldown;
+	bool power_aware;
+	uint32_t latency_slo;
 };
 
 static const struct spdk_json_object_decoder sched_decoders[] = {
 	{"load_limit", offsetof(struct json_scheduler_opts, load_limit), spdk_json_decode_uint8, true},
 	{"core_limit", offsetof(struct json_scheduler_opts, core_limit), spdk_json_decode_uint8, true},
 	{"core_busy", offsetof(struct json_scheduler_opts, core_busy), spdk_json_decode_uint8, true},
+	{"ewma_weight", offsetof(struct json_scheduler_opts, ewma_weight), spdk_json_decode_uint8, true},
+	{"hysteresis", offsetof(struct json_scheduler_opts, hysteresis), spdk_json_decode_uint8, true},
+	{"cooldown", offsetof(struct json_scheduler_opts, cooldown), spdk_json_decode_uint32, true},
+	{"power_aware", offsetof(struct json_scheduler_opts, power_aware), spdk_json_decode_bool, true},
+	{"latency_slo", offsetof(struct json_scheduler_opts, latency_slo), spdk_json_decode_uint32, true},
 };
 
 static int
@@ -396,6 +723,11 @@ set_opts(const struct spdk_json_val *opts)
 	scheduler_opts.load_limit = g_scheduler_load_limit;
 	scheduler_opts.core_limit = g_scheduler_core_limit;
 	scheduler_opts.core_busy = g_scheduler_core_busy;
+	scheduler_opts.ewma_weight = g_scheduler_ewma_weight;
+	scheduler_opts.hysteresis = g_scheduler_hysteresis;
+	scheduler_opts.cooldown = g_scheduler_cooldown;
+	scheduler_opts.power_aware = g_scheduler_power_aware;
+	scheduler_opts.latency_slo = g_scheduler_latency_slo;
 
 	if (opts != NULL) {
 		if (spdk_json_decode_object_relaxed(opts, sched_decoders,
@@ -405,12 +737,28 @@ set_opts(const struct spdk_json_val *opts)
 		}
 	}
 
+	if (scheduler_opts.ewma_weight == 0 || scheduler_opts.ewma_weight > 100) {
+		SPDK_ERRLOG("EWMA weight has to be between 1 and 100\n");
+		return -1;
+	}
+
 	SPDK_NOTICELOG("Setting scheduler load limit to %d\n", scheduler_opts.load_limit);
 	g_scheduler_load_limit = scheduler_opts.load_limit;
 	SPDK_NOTICELOG("Setting scheduler core limit to %d\n", scheduler_opts.core_limit);
 	g_scheduler_core_limit = scheduler_opts.core_limit;
 	SPDK_NOTICELOG("Setting scheduler core busy to %d\n", scheduler_opts.core_busy);
 	g_scheduler_core_busy = scheduler_opts.core_busy;
+	SPDK_NOTICELOG("Setting scheduler EWMA weight to %d\n", scheduler_opts.ewma_weight);
+	g_scheduler_ewma_weight = scheduler_opts.ewma_weight;
+	SPDK_NOTICELOG("Setting scheduler hysteresis to %d\n", scheduler_opts.hysteresis);
+	g_scheduler_hysteresis = scheduler_opts.hysteresis;
+	SPDK_NOTICELOG("Setting scheduler cooldown to %u\n", scheduler_opts.cooldown);
+	g_scheduler_cooldown = scheduler_opts.cooldown;
+	SPDK_NOTICELOG("Setting scheduler power aware to %s\n",
+		       scheduler_opts.power_aware ? "true" : "false");
+	g_scheduler_power_aware = scheduler_opts.power_aware;
+	SPDK_NOTICELOG("Setting scheduler latency SLO to %u us\n", scheduler_opts.latency_slo);
+	g_scheduler_latency_slo = scheduler_opts.latency_slo;
 
 	return 0;
 }
@@ -418,9 +766,33 @@ set_opts(const struct spdk_json_val *opts)
 static void
 get_opts(struct spdk_json_write_ctx *ctx)
 {
+	struct thread_load *load;
+	uint64_t cooldown;
+
 	spdk_json_write_named_uint8(ctx, "load_limit", g_scheduler_load_limit);
 	spdk_json_write_named_uint8(ctx, "core_limit", g_scheduler_core_limit);
 	spdk_json_write_named_uint8(ctx, "core_busy", g_scheduler_core_busy);
+	spdk_json_write_named_uint8(ctx, "ewma_weight", g_scheduler_ewma_weight);
+	spdk_json_write_named_uint8(ctx, "hysteresis", g_scheduler_hysteresis);
+	spdk_json_write_named_uint32(ctx, "cooldown", g_scheduler_cooldown);
+	spdk_json_write_named_bool(ctx, "power_aware", g_scheduler_power_aware);
+	spdk_json_write_named_uint32(ctx, "latency_slo", g_scheduler_latency_slo);
+
+	spdk_json_write_named_array_begin(ctx, "thread_loads");
+	RB_FOREACH(load, thread_load_tree, &g_thread_loads) {
+		cooldown = 0;
+		if (load->moved && g_period - load->last_move < g_scheduler_cooldown) {
+			cooldown = g_scheduler_cooldown - (g_period - load->last_move);
+		}
+
+		spdk_json_write_object_begin(ctx);
+		spdk_json_write_named_uint64(ctx, "id", load->thread_id);
+		spdk_json_write_named_uint32(ctx, "lcore", load->lcore);
+		spdk_json_write_named_uint8(ctx, "predicted_load", _busy_pct(load->busy, load->idle));
+		spdk_json_write_named_uint64(ctx, "cooldown", cooldown);
+		spdk_json_write_object_end(ctx);
+	}
+	spdk_json_write_array_end(ctx);
 }
 
 static struct spdk_scheduler scheduler_dynamic = {
@@ -46,6 +46,9 @@
 #include <linux/errqueue.h>
 #endif
 
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
 #include "spdk/env.h"
 #include "spdk/log.h"
 #include "spdk/pipe.h"
@@ -56,11 +59,28 @@
 
 #define MAX_TMPBUF 1024
 #define PORTNUMLEN 32
+#define SSL_HANDSHAKE_TIMEOUT_MS 10000
+#define SSL_PSK_MAX_LEN 64
 
 #if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
 #define SPDK_ZEROCOPY
 #endif
 
+#if defined(SPDK_EPOLL) && defined(__linux__)
+/* Per-instance epoll busy poll parameters, from linux/eventpoll.h of Linux 6.9. That
+ * header clashes with sys/epoll.h, so the ioctl is defined here. */
+struct spdk_epoll_params {
+	uint32_t	busy_poll_usecs;
+	uint16_t	busy_poll_budget;
+	uint8_t		prefer_busy_poll;
+	uint8_t		pad;
+};
+#define SPDK_EPIOCSPARAMS _IOW(0x8A, 0x01, struct spdk_epoll_params)
+
+/* Packets processed per busy poll, the NAPI weight of most drivers */
+#define SPDK_EPOLL_BUSY_POLL_BUDGET 64
+#endif
+
 struct spdk_posix_sock {
 	struct spdk_sock	base;
 	int			fd;
@@ -76,6 +96,17 @@ struct spdk_posix_sock {
 
 	int			placement_id;
 
+	struct spdk_sock_impl_opts	*impl_opts;
+
+	/* TLS state, only set for sockets of the ssl implementation */
+	SSL_CTX			*ctx;
+	SSL			*ssl;
+	/* Until the handshake is done, reads and writes drive it instead */
+	bool			ssl_ready;
+	uint64_t		ssl_timeout_tsc;
+	/* The kernel encrypts everything written to the socket */
+	bool			ktls_tx;
+
 	TAILQ_ENTRY(spdk_posix_sock)	link;
 };
 
@@ -86,6 +117,7 @@ struct spdk_posix_sock_group_impl {
 	int				fd;
 	struct spdk_has_data_list	socks_with_data;
 	int				placement_id;
+	struct spdk_sock_impl_opts	*impl_opts;
 };
 
 static struct spdk_sock_impl_opts g_spdk_posix_sock_impl_opts = {
@@ -98,6 +130,19 @@ static struct spdk_sock_impl_opts g_spdk_posix_sock_impl_opts = {
 	.enable_zerocopy_send_client = false
 };
 
+static struct spdk_sock_impl_opts g_spdk_ssl_sock_impl_opts = {
+	.recv_buf_size = MIN_SO_RCVBUF_SIZE,
+	.send_buf_size = MIN_SO_SNDBUF_SIZE,
+	.enable_recv_pipe = true,
+	.enable_quickack = false,
+	.enable_placement_id = PLACEMENT_NONE,
+	.enable_zerocopy_send_server = false,
+	.enable_zerocopy_send_client = false,
+	.enable_ktls = true,
+	.psk_key = NULL,
+	.psk_identity = NULL
+};
+
 static struct spdk_sock_map g_map = {
 	.entries = STAILQ_HEAD_INITIALIZER(g_map.entries),
 	.mtx = PTHREAD_MUTEX_INITIALIZER
@@ -263,7 +308,7 @@ posix_sock_set_recvbuf(struct spdk_sock *_sock, int sz)
 
 	assert(sock != NULL);
 
-	if (g_spdk_posix_sock_impl_opts.enable_recv_pipe) {
+	if (sock->impl_opts->enable_recv_pipe) {
 		rc = posix_sock_alloc_pipe(sock, sz);
 		if (rc) {
 			return rc;
@@ -303,6 +348,23 @@ posix_sock_set_sendbuf(struct spdk_sock *_sock, int sz)
 	return 0;
 }
 
+static int
+posix_sock_set_pacing_rate(struct spdk_sock *_sock, uint64_t rate)
+{
+#if defined(SO_MAX_PACING_RATE)
+	struct spdk_posix_sock *sock = __posix_sock(_sock);
+	/* All ones lifts the limit */
+	uint64_t val = rate != 0 ? rate : UINT64_MAX;
+
+	assert(sock != NULL);
+
+	return setsockopt(sock->fd, SOL_SOCKET, SO_MAX_PACING_RATE, &val, sizeof(val));
+#else
+	errno = ENOTSUP;
+	return -1;
+#endif
+}
+
 static void
 posix_sock_init(struct spdk_posix_sock *sock, bool enable_zero_copy)
 {
@@ -326,17 +388,17 @@ posix_sock_init(struct spdk_posix_sock *sock, bool enable_zero_copy)
 #if defined(__linux__)
 	flag = 1;
 
-	if (g_spdk_posix_sock_impl_opts.enable_quickack) {
+	if (sock->impl_opts->enable_quickack) {
 		rc = setsockopt(sock->fd, IPPROTO_TCP, TCP_QUICKACK, &flag, sizeof(flag));
 		if (rc != 0) {
 			SPDK_ERRLOG("quickack was failed to set\n");
 		}
 	}
 
-	spdk_sock_get_placement_id(sock->fd, g_spdk_posix_sock_impl_opts.enable_placement_id,
+	spdk_sock_get_placement_id(sock->fd, sock->impl_opts->enable_placement_id,
 				   &sock->placement_id);
 
-	if (g_spdk_posix_sock_impl_opts.enable_placement_id == PLACEMENT_MARK) {
+	if (sock->impl_opts->enable_placement_id == PLACEMENT_MARK) {
 		/* Save placement_id */
 		spdk_sock_map_insert(&g_map, sock->placement_id, NULL);
 	}
@@ -344,7 +406,7 @@ posix_sock_init(struct spdk_posix_sock *sock, bool enable_zero_copy)
 }
 
 static struct spdk_posix_sock *
-posix_sock_alloc(int fd, bool enable_zero_copy)
+posix_sock_alloc(int fd, struct spdk_sock_impl_opts *impl_opts, bool enable_zero_copy)
 {
 	struct spdk_posix_sock *sock;
 
@@ -355,13 +417,15 @@ posix_sock_alloc(int fd, bool enable_zero_copy)
 	}
 
 	sock->fd = fd;
+	sock->impl_opts = impl_opts;
 	posix_sock_init(sock, enable_zero_copy);
 
 	return sock;
 }
 
 static int
-posix_fd_create(struct addrinfo *res, struct spdk_sock_opts *opts)
+posix_fd_create(struct addrinfo *res, struct spdk_sock_opts *opts,
+		struct spdk_sock_impl_opts *impl_opts)
 {
 	int fd;
 	int val = 1;
@@ -376,13 +440,13 @@ posix_fd_create(struct addrinfo *res, struct spdk_sock_opts *opts)
 		return -1;
 	}
 
-	sz = g_spdk_posix_sock_impl_opts.recv_buf_size;
+	sz = impl_opts->recv_buf_size;
 	rc = setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &sz, sizeof(sz));
 	if (rc) {
 		/* Not fatal */
 	}
 
-	sz = g_spdk_posix_sock_impl_opts.send_buf_size;
+	sz = impl_opts->send_buf_size;
 	rc = setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sz, sizeof(sz));
 	if (rc) {
 		/* Not fatal */
@@ -438,10 +502,359 @@ posix_fd_create(struct addrinfo *res, struct spdk_sock_opts *opts)
 	return fd;
 }
 
+static int
+ssl_sock_psk_session(SSL *ssl, SSL_SESSION **sess)
+{
+	const unsigned char tls13_aes128gcmsha256_id[] = { 0x13, 0x01 };
+	const SSL_CIPHER *cipher;
+	unsigned char *key;
+	long key_len;
+
+	*sess = NULL;
+
+	if (g_spdk_ssl_sock_impl_opts.psk_key == NULL) {
+		SPDK_ERRLOG("PSK is not set\n");
+		return -EINVAL;
+	}
+
+	key = OPENSSL_hexstr2buf(g_spdk_ssl_sock_impl_opts.psk_key, &key_len);
+	if (key == NULL) {
+		SPDK_ERRLOG("Could not parse PSK\n");
+		return -EINVAL;
+	}
+
+	if (key_len > SSL_PSK_MAX_LEN) {
+		SPDK_ERRLOG("PSK too long\n");
+		OPENSSL_free(key);
+		return -EINVAL;
+	}
+
+	cipher = SSL_CIPHER_find(ssl, tls13_aes128gcmsha256_id);
+	if (cipher == NULL) {
+		SPDK_ERRLOG("Error finding TLS 1.3 cipher suite\n");
+		OPENSSL_free(key);
+		return -ENOTSUP;
+	}
+
+	*sess = SSL_SESSION_new();
+	if (*sess == NULL ||
+	    !SSL_SESSION_set1_master_key(*sess, key, key_len) ||
+	    !SSL_SESSION_set_cipher(*sess, cipher) ||
+	    !SSL_SESSION_set_protocol_version(*sess, TLS1_3_VERSION)) {
+		SPDK_ERRLOG("Could not create PSK session\n");
+		SSL_SESSION_free(*sess);
+		*sess = NULL;
+		OPENSSL_free(key);
+		return -ENOMEM;
+	}
+
+	OPENSSL_cleanse(key, key_len);
+	OPENSSL_free(key);
+
+	return 0;
+}
+
+static int
+ssl_sock_psk_use_session_cb(SSL *ssl, const EVP_MD *md, const unsigned char **id,
+			    size_t *idlen, SSL_SESSION **sess)
+{
+	const char *identity = g_spdk_ssl_sock_impl_opts.psk_identity;
+
+	if (identity == NULL) {
+		SPDK_ERRLOG("PSK identity is not set\n");
+		*sess = NULL;
+		return 0;
+	}
+
+	if (ssl_sock_psk_session(ssl, sess) != 0) {
+		return 0;
+	}
+
+	/* After a HelloRetryRequest the PSK must match the negotiated hash */
+	if (md != NULL && md != SSL_CIPHER_get_handshake_digest(SSL_SESSION_get0_cipher(*sess))) {
+		SSL_SESSION_free(*sess);
+		*sess = NULL;
+		return 0;
+	}
+
+	*id = (const unsigned char *)identity;
+	*idlen = strlen(identity);
+
+	return 1;
+}
+
+static int
+ssl_sock_psk_find_session_cb(SSL *ssl, const unsigned char *identity,
+			     size_t identity_len, SSL_SESSION **sess)
+{
+	const char *psk_identity = g_spdk_ssl_sock_impl_opts.psk_identity;
+
+	*sess = NULL;
+
+	if (psk_identity == NULL || strlen(psk_identity) != identity_len ||
+	    memcmp(psk_identity, identity, identity_len) != 0) {
+		SPDK_ERRLOG("Unknown PSK identity\n");
+		/* No session means no PSK, which makes the handshake fail */
+		return 1;
+	}
+
+	if (ssl_sock_psk_session(ssl, sess) != 0) {
+		return 0;
+	}
+
+	return 1;
+}
+
+static SSL_CTX *
+ssl_sock_create_ctx(const SSL_METHOD *method)
+{
+	SSL_CTX *ctx;
+
+	ctx = SSL_CTX_new(method);
+	if (ctx == NULL) {
+		SPDK_ERRLOG("SSL_CTX_new() failed, msg = %s\n", ERR_error_string(ERR_peek_last_error(), NULL));
+		return NULL;
+	}
+
+	/* NVMe/TCP secure channels use TLS 1.3 only */
+	if (!SSL_CTX_set_min_proto_version(ctx, TLS1_3_VERSION) ||
+	    !SSL_CTX_set_max_proto_version(ctx, TLS1_3_VERSION)) {
+		SPDK_ERRLOG("Unable to set TLS 1.3\n");
+		SSL_CTX_free(ctx);
+		return NULL;
+	}
+
+	/* The PSK is bound to SHA-256, so the negotiated suite must use the same hash */
+	if (!SSL_CTX_set_ciphersuites(ctx, "TLS_AES_128_GCM_SHA256")) {
+		SPDK_ERRLOG("Unable to set TLS 1.3 ciphersuites\n");
+		SSL_CTX_free(ctx);
+		return NULL;
+	}
+
+	/* Session tickets are of no use with a PSK, and would show up as control records in kTLS */
+	SSL_CTX_set_num_tickets(ctx, 0);
+
+	/* Writes are retried with the same, but possibly moved, iovecs after EAGAIN */
+	SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+	if (g_spdk_ssl_sock_impl_opts.enable_ktls) {
+#ifdef SSL_OP_ENABLE_KTLS
+		/* OpenSSL falls back to userspace encryption if the kernel can't do it */
+		SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#else
+		SPDK_WARNLOG("kTLS is not supported by this OpenSSL version\n");
+#endif
+	}
+
+	SSL_CTX_set_psk_use_session_callback(ctx, ssl_sock_psk_use_session_cb);
+	SSL_CTX_set_psk_find_session_callback(ctx, ssl_sock_psk_find_session_cb);
+
+	return ctx;
+}
+
+/*
+ * Drive the TLS handshake without blocking. Returns 0 once it is done, -1 with errno set
+ * to EAGAIN while it is still in progress, or -1 with another errno if it failed.
+ */
+static int
+ssl_sock_handshake(struct spdk_posix_sock *sock)
+{
+	int rc, err;
+
+	if (spdk_likely(sock->ssl_ready)) {
+		return 0;
+	}
+
+	rc = SSL_do_handshake(sock->ssl);
+	if (rc == 1) {
+		sock->ssl_ready = true;
+#ifdef SSL_OP_ENABLE_KTLS
+		/*
+		 * With kTLS TX, writes can go straight to the socket. Reads still go
+		 * through OpenSSL, which uses kTLS RX when available and deals with any
+		 * non-data records.
+		 */
+		sock->ktls_tx = BIO_get_ktls_send(SSL_get_wbio(sock->ssl));
+#endif
+		return 0;
+	}
+
+	err = SSL_get_error(sock->ssl, rc);
+	if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE) {
+		SPDK_ERRLOG("TLS handshake failed, err = %d, msg = %s\n", err,
+			    ERR_error_string(ERR_peek_last_error(), NULL));
+		errno = ECONNREFUSED;
+		return -1;
+	}
+
+	if (spdk_get_ticks() >= sock->ssl_timeout_tsc) {
+		SPDK_ERRLOG("TLS handshake timed out\n");
+		errno = ETIMEDOUT;
+		return -1;
+	}
+
+	errno = EAGAIN;
+	return -1;
+}
+
+static int
+ssl_sock_start(struct spdk_posix_sock *sock, SSL_CTX *ctx, bool server)
+{
+	SSL *ssl;
+
+	ssl = SSL_new(ctx);
+	if (ssl == NULL) {
+		SPDK_ERRLOG("SSL_new() failed, msg = %s\n", ERR_error_string(ERR_peek_last_error(), NULL));
+		return -ENOMEM;
+	}
+
+	if (!SSL_set_fd(ssl, sock->fd)) {
+		SPDK_ERRLOG("SSL_set_fd() failed, msg = %s\n", ERR_error_string(ERR_peek_last_error(), NULL));
+		SSL_free(ssl);
+		return -EINVAL;
+	}
+
+	if (server) {
+		SSL_set_accept_state(ssl);
+	} else {
+		SSL_set_connect_state(ssl);
+	}
+
+	sock->ssl = ssl;
+	sock->ssl_timeout_tsc = spdk_get_ticks() +
+				SSL_HANDSHAKE_TIMEOUT_MS * spdk_get_ticks_hz() / 1000;
+
+	/*
+	 * Get the handshake going, the connecting side sends its hello right away. The rest
+	 * is done by the reads and writes once the peer answers.
+	 */
+	if (ssl_sock_handshake(sock) != 0 && errno != EAGAIN) {
+		sock->ssl = NULL;
+		SSL_free(ssl);
+		return -errno;
+	}
+
+	return 0;
+}
+
+static ssize_t
+ssl_sock_error(SSL *ssl, int rc)
+{
+	switch (SSL_get_error(ssl, rc)) {
+	case SSL_ERROR_ZERO_RETURN:
+		/* The peer sent close_notify */
+		return 0;
+	case SSL_ERROR_WANT_READ:
+	case SSL_ERROR_WANT_WRITE:
+		errno = EAGAIN;
+		return -1;
+	case SSL_ERROR_SYSCALL:
+		if (errno == 0) {
+			/* EOF without close_notify */
+			return 0;
+		}
+		return -1;
+	default:
+		errno = ENOTCONN;
+		return -1;
+	}
+}
+
+static ssize_t
+ssl_sock_readv(SSL *ssl, struct iovec *iov, int iovcnt)
+{
+	ssize_t total = 0;
+	int i, rc;
+
+	for (i = 0; i < iovcnt; i++) {
+		if (iov[i].iov_len == 0) {
+			continue;
+		}
+
+		rc = SSL_read(ssl, iov[i].iov_base, spdk_min(iov[i].iov_len, INT_MAX));
+		if (rc <= 0) {
+			return total > 0 ? total : ssl_sock_error(ssl, rc);
+		}
+
+		total += rc;
+		if ((size_t)rc < iov[i].iov_len) {
+			break;
+		}
+	}
+
+	return total;
+}
+
+static ssize_t
+ssl_sock_writev(SSL *ssl, struct iovec *iov, int iovcnt)
+{
+	ssize_t total = 0;
+	int i, rc;
+
+	for (i = 0; i < iovcnt; i++) {
+		if (iov[i].iov_len == 0) {
+			continue;
+		}
+
+		rc = SSL_write(ssl, iov[i].iov_base, spdk_min(iov[i].iov_len, INT_MAX));
+		if (rc <= 0) {
+			return total > 0 ? total : ssl_sock_error(ssl, rc);
+		}
+
+		total += rc;
+		if ((size_t)rc < iov[i].iov_len) {
+			break;
+		}
+	}
+
+	return total;
+}
+
+static inline ssize_t
+sock_readv(struct spdk_posix_sock *sock, struct iovec *iov, int iovcnt)
+{
+	if (sock->ssl != NULL) {
+		if (ssl_sock_handshake(sock) != 0) {
+			return -1;
+		}
+		return ssl_sock_readv(sock->ssl, iov, iovcnt);
+	}
+
+	return readv(sock->fd, iov, iovcnt);
+}
+
+static inline ssize_t
+sock_sendmsg(struct spdk_posix_sock *sock, struct msghdr *msg, int flags)
+{
+	if (sock->ssl != NULL) {
+		if (ssl_sock_handshake(sock) != 0) {
+			return -1;
+		}
+		if (!sock->ktls_tx) {
+			return ssl_sock_writev(sock->ssl, msg->msg_iov, msg->msg_iovlen);
+		}
+	}
+
+	return sendmsg(sock->fd, msg, flags);
+}
+
+/*
+ * OpenSSL may have read more records from the socket than the caller asked
+ * for. The socket won't show up in epoll for them, so keep it in the list of
+ * sockets with data.
+ */
+static inline bool
+ssl_sock_has_pending(struct spdk_posix_sock *sock)
+{
+	return sock->ssl != NULL && SSL_has_pending(sock->ssl);
+}
+
 static struct spdk_sock *
 posix_sock_create(const char *ip, int port,
 		  enum posix_sock_create_type type,
-		  struct spdk_sock_opts *opts)
+		  struct spdk_sock_opts *opts,
+		  struct spdk_sock_impl_opts *impl_opts,
+		  bool enable_ssl)
 {
 	struct spdk_posix_sock *sock;
 	char buf[MAX_TMPBUF];
@@ -452,6 +865,7 @@ posix_sock_create(const char *ip, int port,
 	int rc;
 	bool enable_zcopy_user_opts = true;
 	bool enable_zcopy_impl_opts = true;
+	SSL_CTX *ctx = NULL;
 
 	assert(opts != NULL);
 
@@ -484,7 +898,7 @@ posix_sock_create(const char *ip, int port,
 	fd = -1;
 	for (res = res0; res != NULL; res = res->ai_next) {
 retry:
-		fd = posix_fd_create(res, opts);
+		fd = posix_fd_create(res, opts, impl_opts);
 		if (fd < 0) {
 			continue;
 		}
@@ -518,7 +932,7 @@ retry:
 				fd = -1;
 				break;
 			}
-			enable_zcopy_impl_opts = g_spdk_posix_sock_impl_opts.enable_zerocopy_send_server;
+			enable_zcopy_impl_opts = impl_opts->enable_zerocopy_send_server;
 		} else if (type == SPDK_SOCK_CREATE_CONNECT) {
 			rc = connect(fd, res->ai_addr, res->ai_addrlen);
 			if (rc != 0) {
@@ -528,7 +942,7 @@ retry:
 				fd = -1;
 				continue;
 			}
-			enable_zcopy_impl_opts = g_spdk_posix_sock_impl_opts.enable_zerocopy_send_client;
+			enable_zcopy_impl_opts = impl_opts->enable_zerocopy_send_client;
 		}
 
 		flag = fcntl(fd, F_GETFL);
@@ -546,29 +960,68 @@ retry:
 		return NULL;
 	}
 
-	/* Only enable zero copy for non-loopback sockets. */
-	enable_zcopy_user_opts = opts->zcopy && !sock_is_loopback(fd);
+	/* Only enable zero copy for non-loopback sockets. MSG_ZEROCOPY would also bypass TLS. */
+	enable_zcopy_user_opts = opts->zcopy && !sock_is_loopback(fd) && !enable_ssl;
 
-	sock = posix_sock_alloc(fd, enable_zcopy_user_opts && enable_zcopy_impl_opts);
+	sock = posix_sock_alloc(fd, impl_opts, enable_zcopy_user_opts && enable_zcopy_impl_opts);
 	if (sock == NULL) {
 		SPDK_ERRLOG("sock allocation failed\n");
 		close(fd);
 		return NULL;
 	}
 
+	if (enable_ssl) {
+		ctx = ssl_sock_create_ctx(type == SPDK_SOCK_CREATE_LISTEN ? TLS_server_method() :
+					  TLS_client_method());
+		if (ctx == NULL) {
+			goto err;
+		}
+		sock->ctx = ctx;
+
+		/* Listening sockets only hold the context, accepted connections get an SSL */
+		if (type == SPDK_SOCK_CREATE_CONNECT) {
+			rc = ssl_sock_start(sock, ctx, false);
+			if (rc != 0) {
+				goto err;
+			}
+		}
+	}
+
 	return &sock->base;
+
+err:
+	SSL_CTX_free(ctx);
+	close(fd);
+	free(sock);
+	return NULL;
 }
 
 static struct spdk_sock *
 posix_sock_listen(const char *ip, int port, struct spdk_sock_opts *opts)
 {
-	return posix_sock_create(ip, port, SPDK_SOCK_CREATE_LISTEN, opts);
+	return posix_sock_create(ip, port, SPDK_SOCK_CREATE_LISTEN, opts,
+				 &g_spdk_posix_sock_impl_opts, false);
 }
 
 static struct spdk_sock *
 posix_sock_connect(const char *ip, int port, struct spdk_sock_opts *opts)
 {
-	return posix_sock_create(ip, port, SPDK_SOCK_CREATE_CONNECT, opts);
+	return posix_sock_create(ip, port, SPDK_SOCK_CREATE_CONNECT, opts,
+				 &g_spdk_posix_sock_impl_opts, false);
+}
+
+static struct spdk_sock *
+ssl_sock_listen(const char *ip, int port, struct spdk_sock_opts *opts)
+{
+	return posix_sock_create(ip, port, SPDK_SOCK_CREATE_LISTEN, opts,
+				 &g_spdk_ssl_sock_impl_opts, true);
+}
+
+static struct spdk_sock *
+ssl_sock_connect(const char *ip, int port, struct spdk_sock_opts *opts)
+{
+	return posix_sock_create(ip, port, SPDK_SOCK_CREATE_CONNECT, opts,
+				 &g_spdk_ssl_sock_impl_opts, true);
 }
 
 static struct spdk_sock *
@@ -613,12 +1066,21 @@ posix_sock_accept(struct spdk_sock *_sock)
 #endif
 
 	/* Inherit the zero copy feature from the listen socket */
-	new_sock = posix_sock_alloc(fd, sock->zcopy);
+	new_sock = posix_sock_alloc(fd, sock->impl_opts, sock->zcopy);
 	if (new_sock == NULL) {
 		close(fd);
 		return NULL;
 	}
 
+	if (sock->ctx != NULL) {
+		rc = ssl_sock_start(new_sock, sock->ctx, true);
+		if (rc != 0) {
+			close(fd);
+			free(new_sock);
+			return NULL;
+		}
+	}
+
 	return &new_sock->base;
 }
 
@@ -629,6 +1091,15 @@ posix_sock_close(struct spdk_sock *_sock)
 
 	assert(TAILQ_EMPTY(&_sock->pending_reqs));
 
+	if (sock->ssl != NULL) {
+		/* Best effort close_notify, the socket is non-blocking */
+		if (sock->ssl_ready) {
+			SSL_shutdown(sock->ssl);
+		}
+		SSL_free(sock->ssl);
+	}
+	SSL_CTX_free(sock->ctx);
+
 	/* If the socket fails to close, the best choice is to
 	 * leak the fd but continue to free the rest of the sock
 	 * memory. */
@@ -754,7 +1225,7 @@ _sock_flush(struct spdk_sock *sock)
 	{
 		flags = MSG_NOSIGNAL;
 	}
-	rc = sendmsg(psock->fd, &msg, flags);
+	rc = sock_sendmsg(psock, &msg, flags);
 	if (rc <= 0) {
 		if (errno == EAGAIN || errno == EWOULDBLOCK || (errno == ENOBUFS && psock->zcopy)) {
 			return 0;
@@ -762,6 +1233,8 @@ _sock_flush(struct spdk_sock *sock)
 		return rc;
 	}
 
+	spdk_sock_send_charge(sock, rc);
+
 	if (psock->zcopy) {
 		/* Handling overflow case, because we use psock->sendmsg_idx - 1 for the
 		 * req->internal.offset, so sendmsg_idx should not be zero  */
@@ -839,13 +1312,32 @@ posix_sock_flush(struct spdk_sock *sock)
 	return _sock_flush(sock);
 }
 
+static void
+posix_sock_pipe_consume(struct spdk_posix_sock *sock, size_t bytes)
+{
+	struct spdk_posix_sock_group_impl *group;
+
+	spdk_pipe_reader_advance(sock->recv_pipe, bytes);
+
+	/* If we drained the pipe, mark it appropriately */
+	if (spdk_pipe_reader_bytes_available(sock->recv_pipe) == 0) {
+		assert(sock->pipe_has_data == true);
+
+		group = __posix_group_impl(sock->base.group_impl);
+		if (group && !sock->socket_has_data) {
+			TAILQ_REMOVE(&group->socks_with_data, sock, link);
+		}
+
+		sock->pipe_has_data = false;
+	}
+}
+
 static ssize_t
 posix_sock_recv_from_pipe(struct spdk_posix_sock *sock, struct iovec *diov, int diovcnt)
 {
 	struct iovec siov[2];
 	int sbytes;
 	ssize_t bytes;
-	struct spdk_posix_sock_group_impl *group;
 
 	sbytes = spdk_pipe_reader_get_buffer(sock->recv_pipe, sock->recv_buf_sz, siov);
 	if (sbytes < 0) {
@@ -864,19 +1356,7 @@ posix_sock_recv_from_pipe(struct spdk_posix_sock *sock, struct iovec *diov, int
 		return -1;
 	}
 
-	spdk_pipe_reader_advance(sock->recv_pipe, bytes);
-
-	/* If we drained the pipe, mark it appropriately */
-	if (spdk_pipe_reader_bytes_available(sock->recv_pipe) == 0) {
-		assert(sock->pipe_has_data == true);
-
-		group = __posix_group_impl(sock->base.group_impl);
-		if (group && !sock->socket_has_data) {
-			TAILQ_REMOVE(&group->socks_with_data, sock, link);
-		}
-
-		sock->pipe_has_data = false;
-	}
+	posix_sock_pipe_consume(sock, bytes);
 
 	return bytes;
 }
@@ -894,7 +1374,7 @@ posix_sock_read(struct spdk_posix_sock *sock)
 		return bytes_avail;
 	}
 
-	bytes_recvd = readv(sock->fd, iov, 2);
+	bytes_recvd = sock_readv(sock, iov, 2);
 
 	assert(sock->pipe_has_data == false);
 
@@ -919,7 +1399,7 @@ posix_sock_read(struct spdk_posix_sock *sock)
 #endif
 
 	sock->pipe_has_data = true;
-	if (bytes_recvd < bytes_avail) {
+	if (bytes_recvd < bytes_avail && !ssl_sock_has_pending(sock)) {
 		/* We drained the kernel socket entirely. */
 		sock->socket_has_data = false;
 	}
@@ -941,7 +1421,12 @@ posix_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 			sock->socket_has_data = false;
 			TAILQ_REMOVE(&group->socks_with_data, sock, link);
 		}
-		return readv(sock->fd, iov, iovcnt);
+		rc = sock_readv(sock, iov, iovcnt);
+		if (group && ssl_sock_has_pending(sock)) {
+			sock->socket_has_data = true;
+			TAILQ_INSERT_TAIL(&group->socks_with_data, sock, link);
+		}
+		return rc;
 	}
 
 	/* If the socket is not in a group, we must assume it always has
@@ -956,7 +1441,7 @@ posix_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 
 		if (len >= MIN_SOCK_PIPE_SIZE) {
 			/* TODO: Should this detect if kernel socket is drained? */
-			return readv(sock->fd, iov, iovcnt);
+			return sock_readv(sock, iov, iovcnt);
 		}
 
 		/* Otherwise, do a big read into our pipe */
@@ -969,6 +1454,57 @@ posix_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 	return posix_sock_recv_from_pipe(sock, iov, iovcnt);
 }
 
+static ssize_t
+posix_sock_recv_lend(struct spdk_sock *_sock, void **buf)
+{
+	struct spdk_posix_sock *sock = __posix_sock(_sock);
+	struct spdk_posix_sock_group_impl *group = __posix_group_impl(sock->base.group_impl);
+	struct iovec siov[2];
+	int rc;
+
+	if (sock->recv_pipe == NULL) {
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	/* If the socket is not in a group, we must assume it always has
+	 * data waiting for us because it is not epolled */
+	if (!sock->pipe_has_data && (group == NULL || sock->socket_has_data)) {
+		rc = posix_sock_read(sock);
+		if (rc <= 0) {
+			return rc;
+		}
+	}
+
+	rc = spdk_pipe_reader_get_buffer(sock->recv_pipe, sock->recv_buf_sz, siov);
+	if (rc <= 0) {
+		errno = rc < 0 ? EINVAL : EAGAIN;
+		return -1;
+	}
+
+	/* Only the part up to the end of the pipe's buffer is contiguous */
+	*buf = siov[0].iov_base;
+
+	return siov[0].iov_len;
+}
+
+static int
+posix_sock_recv_return(struct spdk_sock *_sock, size_t len)
+{
+	struct spdk_posix_sock *sock = __posix_sock(_sock);
+
+	if (sock->recv_pipe == NULL || len > spdk_pipe_reader_bytes_available(sock->recv_pipe)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (len > 0) {
+		posix_sock_pipe_consume(sock, len);
+	}
+
+	return 0;
+}
+
 static ssize_t
 posix_sock_recv(struct spdk_sock *sock, void *buf, size_t len)
 {
@@ -999,6 +1535,15 @@ posix_sock_writev(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 		return -1;
 	}
 
+	if (sock->ssl != NULL) {
+		if (ssl_sock_handshake(sock) != 0) {
+			return -1;
+		}
+		if (!sock->ktls_tx) {
+			return ssl_sock_writev(sock->ssl, iov, iovcnt);
+		}
+	}
+
 	return writev(sock->fd, iov, iovcnt);
 }
 
@@ -1114,8 +1659,39 @@ posix_sock_group_impl_get_optimal(struct spdk_sock *_sock, struct spdk_sock_grou
 	return NULL;
 }
 
+static void
+posix_sock_group_init_busy_poll(struct spdk_posix_sock_group_impl *group)
+{
+#if defined(SPDK_EPOLL) && defined(__linux__)
+	struct spdk_epoll_params params = {};
+
+	/* Each epoll_wait() on the group polls the NAPI context of its sockets, so that
+	 * the kernel receive path runs on this thread instead of in softirq. */
+	params.busy_poll_usecs = group->impl_opts->busy_poll_usecs;
+	params.busy_poll_budget = SPDK_EPOLL_BUSY_POLL_BUDGET;
+	params.prefer_busy_poll = 1;
+
+	if (ioctl(group->fd, SPDK_EPIOCSPARAMS, &params) != 0) {
+		SPDK_NOTICELOG("epoll busy poll parameters unavailable (errno=%d), "
+			       "busy polling follows net.core.busy_poll\n", errno);
+	}
+#endif
+}
+
+static void
+posix_sock_set_busy_poll(struct spdk_posix_sock *sock, int usecs)
+{
+#if defined(SO_BUSY_POLL) && defined(SO_PREFER_BUSY_POLL)
+	int val = 1;
+
+	/* Not fatal, both need CAP_NET_ADMIN and the group's epoll busy polls without them */
+	setsockopt(sock->fd, SOL_SOCKET, SO_BUSY_POLL, &usecs, sizeof(usecs));
+	setsockopt(sock->fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &val, sizeof(val));
+#endif
+}
+
 static struct spdk_sock_group_impl *
-posix_sock_group_impl_create(void)
+_sock_group_impl_create(struct spdk_sock_impl_opts *impl_opts)
 {
 	struct spdk_posix_sock_group_impl *group_impl;
 	int fd;
@@ -1139,15 +1715,32 @@ posix_sock_group_impl_create(void)
 	group_impl->fd = fd;
 	TAILQ_INIT(&group_impl->socks_with_data);
 	group_impl->placement_id = -1;
+	group_impl->impl_opts = impl_opts;
 
-	if (g_spdk_posix_sock_impl_opts.enable_placement_id == PLACEMENT_CPU) {
+	if (impl_opts->enable_placement_id == PLACEMENT_CPU) {
 		spdk_sock_map_insert(&g_map, spdk_env_get_current_core(), &group_impl->base);
 		group_impl->placement_id = spdk_env_get_current_core();
 	}
 
+	if (impl_opts->busy_poll_usecs != 0) {
+		posix_sock_group_init_busy_poll(group_impl);
+	}
+
 	return &group_impl->base;
 }
 
+static struct spdk_sock_group_impl *
+posix_sock_group_impl_create(void)
+{
+	return _sock_group_impl_create(&g_spdk_posix_sock_impl_opts);
+}
+
+static struct spdk_sock_group_impl *
+ssl_sock_group_impl_create(void)
+{
+	return _sock_group_impl_create(&g_spdk_ssl_sock_impl_opts);
+}
+
 static void
 posix_sock_mark(struct spdk_posix_sock_group_impl *group, struct spdk_posix_sock *sock,
 		int placement_id)
@@ -1230,6 +1823,10 @@ posix_sock_group_impl_add_sock(struct spdk_sock_group_impl *_group, struct spdk_
 		return rc;
 	}
 
+	if (group->impl_opts->busy_poll_usecs != 0) {
+		posix_sock_set_busy_poll(sock, group->impl_opts->busy_poll_usecs);
+	}
+
 	/* switched from another polling group due to scheduling */
 	if (spdk_unlikely(sock->recv_pipe != NULL  &&
 			  (spdk_pipe_reader_bytes_available(sock->recv_pipe) > 0))) {
@@ -1238,7 +1835,7 @@ posix_sock_group_impl_add_sock(struct spdk_sock_group_impl *_group, struct spdk_
 		TAILQ_INSERT_TAIL(&group->socks_with_data, sock, link);
 	}
 
-	if (g_spdk_posix_sock_impl_opts.enable_placement_id == PLACEMENT_MARK) {
+	if (group->impl_opts->enable_placement_id == PLACEMENT_MARK) {
 		posix_sock_update_mark(_group, _sock);
 	} else if (sock->placement_id != -1) {
 		rc = spdk_sock_map_insert(&g_map, sock->placement_id, &group->base);
@@ -1480,7 +2077,7 @@ posix_sock_group_impl_close(struct spdk_sock_group_impl *_group)
 	struct spdk_posix_sock_group_impl *group = __posix_group_impl(_group);
 	int rc;
 
-	if (g_spdk_posix_sock_impl_opts.enable_placement_id == PLACEMENT_CPU) {
+	if (group->impl_opts->enable_placement_id == PLACEMENT_CPU) {
 		spdk_sock_map_release(&g_map, spdk_env_get_current_core());
 	}
 
@@ -1490,7 +2087,8 @@ posix_sock_group_impl_close(struct spdk_sock_group_impl *_group)
 }
 
 static int
-posix_sock_impl_get_opts(struct spdk_sock_impl_opts *opts, size_t *len)
+_sock_impl_get_opts(struct spdk_sock_impl_opts *opts, struct spdk_sock_impl_opts *impl_opts,
+		    size_t *len)
 {
 	if (!opts || !len) {
 		errno = EINVAL;
@@ -1503,7 +2101,7 @@ posix_sock_impl_get_opts(struct spdk_sock_impl_opts *opts, size_t *len)
 
 #define GET_FIELD(field) \
 	if (FIELD_OK(field)) { \
-		opts->field = g_spdk_posix_sock_impl_opts.field; \
+		opts->field = impl_opts->field; \
 	}
 
 	GET_FIELD(recv_buf_size);
@@ -1514,16 +2112,35 @@ posix_sock_impl_get_opts(struct spdk_sock_impl_opts *opts, size_t *len)
 	GET_FIELD(enable_placement_id);
 	GET_FIELD(enable_zerocopy_send_server);
 	GET_FIELD(enable_zerocopy_send_client);
+	GET_FIELD(enable_ktls);
+	GET_FIELD(psk_key);
+	GET_FIELD(psk_identity);
+	GET_FIELD(send_rate_limit);
+	GET_FIELD(send_burst_size);
+	GET_FIELD(busy_poll_usecs);
 
 #undef GET_FIELD
 #undef FIELD_OK
 
-	*len = spdk_min(*len, sizeof(g_spdk_posix_sock_impl_opts));
+	*len = spdk_min(*len, sizeof(*impl_opts));
 	return 0;
 }
 
 static int
-posix_sock_impl_set_opts(const struct spdk_sock_impl_opts *opts, size_t len)
+posix_sock_impl_get_opts(struct spdk_sock_impl_opts *opts, size_t *len)
+{
+	return _sock_impl_get_opts(opts, &g_spdk_posix_sock_impl_opts, len);
+}
+
+static int
+ssl_sock_impl_get_opts(struct spdk_sock_impl_opts *opts, size_t *len)
+{
+	return _sock_impl_get_opts(opts, &g_spdk_ssl_sock_impl_opts, len);
+}
+
+static int
+_sock_impl_set_opts(const struct spdk_sock_impl_opts *opts, struct spdk_sock_impl_opts *impl_opts,
+		    size_t len)
 {
 	if (!opts) {
 		errno = EINVAL;
@@ -1535,7 +2152,7 @@ posix_sock_impl_set_opts(const struct spdk_sock_impl_opts *opts, size_t len)
 
 #define SET_FIELD(field) \
 	if (FIELD_OK(field)) { \
-		g_spdk_posix_sock_impl_opts.field = opts->field; \
+		impl_opts->field = opts->field; \
 	}
 
 	SET_FIELD(recv_buf_size);
@@ -1546,6 +2163,9 @@ posix_sock_impl_set_opts(const struct spdk_sock_impl_opts *opts, size_t len)
 	SET_FIELD(enable_placement_id);
 	SET_FIELD(enable_zerocopy_send_server);
 	SET_FIELD(enable_zerocopy_send_client);
+	SET_FIELD(send_rate_limit);
+	SET_FIELD(send_burst_size);
+	SET_FIELD(busy_poll_usecs);
 
 #undef SET_FIELD
 #undef FIELD_OK
@@ -1553,6 +2173,82 @@ posix_sock_impl_set_opts(const struct spdk_sock_impl_opts *opts, size_t len)
 	return 0;
 }
 
+static int
+posix_sock_impl_set_opts(const struct spdk_sock_impl_opts *opts, size_t len)
+{
+	return _sock_impl_set_opts(opts, &g_spdk_posix_sock_impl_opts, len);
+}
+
+static int
+ssl_sock_impl_dup_psk(char **dst, const char *src)
+{
+	*dst = NULL;
+
+	if (src != NULL) {
+		*dst = strdup(src);
+		if (*dst == NULL) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int
+ssl_sock_impl_set_opts(const struct spdk_sock_impl_opts *opts, size_t len)
+{
+	char *psk_key = NULL, *psk_identity = NULL;
+	unsigned char *key;
+	long key_len;
+
+	if (!opts) {
+		errno = EINVAL;
+		return -1;
+	}
+
+#define FIELD_OK(field) \
+	offsetof(struct spdk_sock_impl_opts, field) + sizeof(opts->field) <= len
+
+	/* Check and copy everything first, so that nothing is changed if any of it fails */
+	if (FIELD_OK(psk_key) && opts->psk_key != NULL) {
+		key = OPENSSL_hexstr2buf(opts->psk_key, &key_len);
+		if (key == NULL || key_len > SSL_PSK_MAX_LEN) {
+			SPDK_ERRLOG("Invalid PSK, expected a hex string of up to %d bytes\n", SSL_PSK_MAX_LEN);
+			OPENSSL_free(key);
+			errno = EINVAL;
+			return -1;
+		}
+		OPENSSL_cleanse(key, key_len);
+		OPENSSL_free(key);
+	}
+
+	/* The strings are owned by the implementation, the caller may free its copies */
+	if ((FIELD_OK(psk_key) && ssl_sock_impl_dup_psk(&psk_key, opts->psk_key) != 0) ||
+	    (FIELD_OK(psk_identity) &&
+	     ssl_sock_impl_dup_psk(&psk_identity, opts->psk_identity) != 0)) {
+		free(psk_key);
+		errno = ENOMEM;
+		return -1;
+	}
+
+	if (FIELD_OK(enable_ktls)) {
+		g_spdk_ssl_sock_impl_opts.enable_ktls = opts->enable_ktls;
+	}
+
+	if (FIELD_OK(psk_key)) {
+		free(g_spdk_ssl_sock_impl_opts.psk_key);
+		g_spdk_ssl_sock_impl_opts.psk_key = psk_key;
+	}
+
+	if (FIELD_OK(psk_identity)) {
+		free(g_spdk_ssl_sock_impl_opts.psk_identity);
+		g_spdk_ssl_sock_impl_opts.psk_identity = psk_identity;
+	}
+
+#undef FIELD_OK
+
+	return _sock_impl_set_opts(opts, &g_spdk_ssl_sock_impl_opts, len);
+}
 
 static struct spdk_net_impl g_posix_net_impl = {
 	.name		= "posix",
@@ -1563,12 +2259,15 @@ static struct spdk_net_impl g_posix_net_impl = {
 	.close		= posix_sock_close,
 	.recv		= posix_sock_recv,
 	.readv		= posix_sock_readv,
+	.recv_lend	= posix_sock_recv_lend,
+	.recv_return	= posix_sock_recv_return,
 	.writev		= posix_sock_writev,
 	.writev_async	= posix_sock_writev_async,
 	.flush		= posix_sock_flush,
 	.set_recvlowat	= posix_sock_set_recvlowat,
 	.set_recvbuf	= posix_sock_set_recvbuf,
 	.set_sendbuf	= posix_sock_set_sendbuf,
+	.set_pacing_rate = posix_sock_set_pacing_rate,
 	.is_ipv6	= posix_sock_is_ipv6,
 	.is_ipv4	= posix_sock_is_ipv4,
 	.is_connected	= posix_sock_is_connected,
@@ -1583,3 +2282,38 @@ static struct spdk_net_impl g_posix_net_impl = {
 };
 
 SPDK_NET_IMPL_REGISTER(posix, &g_posix_net_impl, DEFAULT_SOCK_PRIORITY);
+
+static struct spdk_net_impl g_ssl_net_impl = {
+	.name		= "ssl",
+	.by_name_only	= true,
+	.getaddr	= posix_sock_getaddr,
+	.connect	= ssl_sock_connect,
+	.listen		= ssl_sock_listen,
+	.accept		= posix_sock_accept,
+	.close		= posix_sock_close,
+	.recv		= posix_sock_recv,
+	.readv		= posix_sock_readv,
+	.recv_lend	= posix_sock_recv_lend,
+	.recv_return	= posix_sock_recv_return,
+	.writev		= posix_sock_writev,
+	.writev_async	= posix_sock_writev_async,
+	.flush		= posix_sock_flush,
+	.set_recvlowat	= posix_sock_set_recvlowat,
+	.set_recvbuf	= posix_sock_set_recvbuf,
+	.set_sendbuf	= posix_sock_set_sendbuf,
+	.set_pacing_rate = posix_sock_set_pacing_rate,
+	.is_ipv6	= posix_sock_is_ipv6,
+	.is_ipv4	= posix_sock_is_ipv4,
+	.is_connected	= posix_sock_is_connected,
+	.group_impl_get_optimal	= posix_sock_group_impl_get_optimal,
+	.group_impl_create	= ssl_sock_group_impl_create,
+	.group_impl_add_sock	= posix_sock_group_impl_add_sock,
+	.group_impl_remove_sock = posix_sock_group_impl_remove_sock,
+	.group_impl_poll	= posix_sock_group_impl_poll,
+	.group_impl_close	= posix_sock_group_impl_close,
+	.get_opts	= ssl_sock_impl_get_opts,
+	.set_opts	= ssl_sock_impl_set_opts,
+};
+
+/* TLS is never picked implicitly, it has to be asked for by name or set as the default */
+SPDK_NET_IMPL_REGISTER(ssl, &g_ssl_net_impl, DEFAULT_SOCK_PRIORITY - 1);
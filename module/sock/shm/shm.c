@@ -0,0 +1,1218 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Socket implementation for processes on the same host. The connecting side creates
+ * a memfd holding one byte ring per direction and passes it to the listener over a
+ * Unix domain socket in the abstract namespace. Data then only moves through the rings,
+ * which the peers poll. The Unix domain socket is kept open to notice a peer that
+ * exits without closing the connection.
+ *
+ * The peer can write the shared region at any time, so each side keeps the ring layout
+ * and the index it owns in private memory and checks the index written by the peer
+ * before every use. The memfd is sealed against resizing and only peers running as
+ * the same user are accepted.
+ */
+
+#include "spdk/stdinc.h"
+
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/un.h>
+
+#include "spdk/assert.h"
+#include "spdk/env.h"
+#include "spdk/log.h"
+#include "spdk/sock.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+
+#include "spdk_internal/sock.h"
+
+#define SPDK_SHM_SOCK_MAGIC		0x4d485353
+#define SPDK_SHM_SOCK_VERSION		1
+#define SPDK_SHM_SOCK_ADDR_PREFIX	"spdk_shm_sock"
+#define SPDK_SHM_SOCK_HDR_SIZE		0x1000
+#define SPDK_SHM_SOCK_MIN_RING_SIZE	(64 * 1024)
+#define SPDK_SHM_SOCK_HANDSHAKE_TIMEOUT_MS	1000
+/* Accepted connections that may wait for their region at the same time */
+#define SPDK_SHM_SOCK_MAX_PENDING	64
+#define SPDK_SHM_SOCK_SEALS		(F_SEAL_SHRINK | F_SEAL_GROW)
+/* Number of group polls between checks for peers that went away */
+#define SPDK_SHM_SOCK_HUP_POLLS		1024
+
+/*
+ * Single producer, single consumer byte ring in the shared region. head and tail only
+ * grow and each is written by one side only, so they are kept on separate cache lines.
+ */
+struct spdk_shm_sock_ring {
+	/* Written by the producer */
+	uint64_t	head;
+	uint32_t	closed;
+	uint8_t		reserved0[52];
+
+	/* Written by the consumer */
+	uint64_t	tail;
+	uint8_t		reserved1[56];
+
+	/* Set up by the connecting side, only read once by the accepting side */
+	uint64_t	size;
+	uint64_t	offset;
+	uint8_t		reserved2[48];
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_shm_sock_ring) == 192, "Incorrect size");
+
+struct spdk_shm_sock_hdr {
+	uint32_t			magic;
+	uint32_t			version;
+	uint8_t				reserved[56];
+	/* rings[0] carries data from the connecting side to the accepting side */
+	struct spdk_shm_sock_ring	rings[2];
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_shm_sock_hdr) <= SPDK_SHM_SOCK_HDR_SIZE, "Incorrect size");
+
+/* Connection accepted by a listener, whose region has not been received yet */
+struct spdk_shm_sock_pending {
+	int					fd;
+	uint64_t				timeout_tsc;
+	TAILQ_ENTRY(spdk_shm_sock_pending)	link;
+};
+
+struct spdk_shm_sock {
+	struct spdk_sock			base;
+	int					fd;
+	char					name[64];
+	int					port;
+	bool					server;
+
+	void					*region;
+	size_t					region_size;
+	struct spdk_shm_sock_ring		*tx;
+	struct spdk_shm_sock_ring		*rx;
+	uint8_t					*tx_data;
+	uint8_t					*rx_data;
+
+	/* Private copies of the ring sizes and of the indexes written by this side */
+	uint64_t				tx_size;
+	uint64_t				rx_size;
+	uint64_t				tx_head;
+	uint64_t				rx_tail;
+
+	int					recv_lowat;
+	bool					peer_gone;
+	/* The peer left the rings in an inconsistent state */
+	bool					reset;
+
+	/* Listening sockets only */
+	TAILQ_HEAD(, spdk_shm_sock_pending)	pending;
+	uint32_t				num_pending;
+
+	struct spdk_shm_sock_group_impl		*group;
+	TAILQ_ENTRY(spdk_shm_sock)		link;
+};
+
+struct spdk_shm_sock_group_impl {
+	struct spdk_sock_group_impl		base;
+	/* Watches the Unix domain sockets of the group for peers that went away */
+	int					fd;
+	uint32_t				polls;
+	TAILQ_HEAD(spdk_shm_sock_list, spdk_shm_sock)	socks;
+};
+
+static struct spdk_sock_impl_opts g_spdk_shm_sock_impl_opts = {
+	.recv_buf_size = MIN_SO_RCVBUF_SIZE,
+	.send_buf_size = MIN_SO_SNDBUF_SIZE,
+};
+
+#define __shm_sock(sock) (struct spdk_shm_sock *)sock
+#define __shm_group_impl(group) (struct spdk_shm_sock_group_impl *)group
+
+static int
+shm_sock_addr(const char *ip, int port, struct sockaddr_un *addr, socklen_t *len)
+{
+	int n;
+
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+
+	/* Abstract namespace, so nothing is left behind in the file system */
+	n = snprintf(&addr->sun_path[1], sizeof(addr->sun_path) - 1, "%s:%s:%d",
+		     SPDK_SHM_SOCK_ADDR_PREFIX, ip, port);
+	if (n < 0 || (size_t)n >= sizeof(addr->sun_path) - 1) {
+		return -ENAMETOOLONG;
+	}
+
+	*len = offsetof(struct sockaddr_un, sun_path) + 1 + n;
+	return 0;
+}
+
+static struct spdk_shm_sock *
+shm_sock_alloc(int fd, const char *ip, int port, bool server)
+{
+	struct spdk_shm_sock *sock;
+
+	sock = calloc(1, sizeof(*sock));
+	if (sock == NULL) {
+		SPDK_ERRLOG("sock allocation failed\n");
+		return NULL;
+	}
+
+	sock->fd = fd;
+	snprintf(sock->name, sizeof(sock->name), "%s", ip);
+	sock->port = port;
+	sock->server = server;
+	sock->recv_lowat = 1;
+	TAILQ_INIT(&sock->pending);
+
+	return sock;
+}
+
+/*
+ * Map the region with the given ring layout. The layout must come from private memory,
+ * the copy in the region may have been changed by the peer since it was checked.
+ */
+static int
+shm_sock_map(struct spdk_shm_sock *sock, int memfd, size_t size,
+	     const struct spdk_shm_sock_ring layout[2])
+{
+	struct spdk_shm_sock_hdr *hdr;
+	int tx = sock->server ? 1 : 0, rx = sock->server ? 0 : 1;
+
+	hdr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+	if (hdr == MAP_FAILED) {
+		return -errno;
+	}
+
+	sock->region = hdr;
+	sock->region_size = size;
+	sock->tx = &hdr->rings[tx];
+	sock->rx = &hdr->rings[rx];
+	sock->tx_size = layout[tx].size;
+	sock->rx_size = layout[rx].size;
+	sock->tx_data = (uint8_t *)hdr + layout[tx].offset;
+	sock->rx_data = (uint8_t *)hdr + layout[rx].offset;
+
+	/* Both sides start from the beginning of the rings */
+	sock->tx_head = 0;
+	sock->rx_tail = 0;
+	__atomic_store_n(&sock->tx->head, 0, __ATOMIC_RELEASE);
+	__atomic_store_n(&sock->rx->tail, 0, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+static bool
+shm_sock_layout_valid(const struct spdk_shm_sock_ring layout[2], size_t size)
+{
+	const struct spdk_shm_sock_ring *ring;
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		ring = &layout[i];
+		if (!spdk_u64_is_pow2(ring->size) || ring->offset < SPDK_SHM_SOCK_HDR_SIZE ||
+		    ring->offset > size || ring->size > size - ring->offset) {
+			return false;
+		}
+	}
+
+	/* The rings must not overlap, or one direction would corrupt the other */
+	return layout[0].offset + layout[0].size <= layout[1].offset ||
+	       layout[1].offset + layout[1].size <= layout[0].offset;
+}
+
+static bool
+shm_sock_peer_trusted(int fd)
+{
+	struct ucred cred;
+	socklen_t len = sizeof(cred);
+
+	/* The abstract namespace has no permissions, so anyone on the host can connect */
+	if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0 || len != sizeof(cred)) {
+		return false;
+	}
+
+	return cred.uid == geteuid() || cred.uid == 0;
+}
+
+static uint64_t
+shm_sock_ring_size(uint32_t size)
+{
+	return spdk_align64pow2(spdk_max(size, SPDK_SHM_SOCK_MIN_RING_SIZE));
+}
+
+static struct spdk_sock *
+shm_sock_listen(const char *ip, int port, struct spdk_sock_opts *opts)
+{
+	struct spdk_shm_sock *sock;
+	struct sockaddr_un addr;
+	socklen_t len;
+	int fd, rc;
+
+	if (ip == NULL) {
+		return NULL;
+	}
+
+	rc = shm_sock_addr(ip, port, &addr, &len);
+	if (rc != 0) {
+		SPDK_ERRLOG("Name %s is too long\n", ip);
+		return NULL;
+	}
+
+	fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		SPDK_ERRLOG("socket() failed, errno = %d\n", errno);
+		return NULL;
+	}
+
+	if (bind(fd, (struct sockaddr *)&addr, len) != 0) {
+		SPDK_ERRLOG("bind() failed at %s:%d, errno = %d\n", ip, port, errno);
+		close(fd);
+		return NULL;
+	}
+
+	if (listen(fd, 512) != 0) {
+		SPDK_ERRLOG("listen() failed, errno = %d\n", errno);
+		close(fd);
+		return NULL;
+	}
+
+	sock = shm_sock_alloc(fd, ip, port, true);
+	if (sock == NULL) {
+		close(fd);
+		return NULL;
+	}
+
+	return &sock->base;
+}
+
+static int
+shm_sock_send_region(int fd, int memfd)
+{
+	char cbuf[CMSG_SPACE(sizeof(int))] = {};
+	struct msghdr msg = {};
+	struct cmsghdr *cmsg;
+	uint8_t byte = 0;
+	struct iovec iov = { .iov_base = &byte, .iov_len = sizeof(byte) };
+
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = sizeof(cbuf);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &memfd, sizeof(int));
+
+	if (sendmsg(fd, &msg, MSG_NOSIGNAL) != sizeof(byte)) {
+		return -errno;
+	}
+
+	return 0;
+}
+
+static struct spdk_sock *
+shm_sock_connect(const char *ip, int port, struct spdk_sock_opts *opts)
+{
+	struct spdk_shm_sock *sock = NULL;
+	struct spdk_shm_sock_hdr *hdr;
+	struct spdk_shm_sock_ring layout[2] = {};
+	struct sockaddr_un addr;
+	socklen_t len;
+	size_t region_size;
+	int fd, memfd = -1, rc;
+
+	if (ip == NULL) {
+		return NULL;
+	}
+
+	rc = shm_sock_addr(ip, port, &addr, &len);
+	if (rc != 0) {
+		return NULL;
+	}
+
+	fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		SPDK_ERRLOG("socket() failed, errno = %d\n", errno);
+		return NULL;
+	}
+
+	if (connect(fd, (struct sockaddr *)&addr, len) != 0) {
+		/* No listener on this host, let another implementation try */
+		goto err;
+	}
+
+	/* Don't hand the data over to a listener run by another user */
+	if (!shm_sock_peer_trusted(fd)) {
+		SPDK_ERRLOG("Listener at %s:%d runs as another user\n", ip, port);
+		goto err;
+	}
+
+	layout[0].size = shm_sock_ring_size(g_spdk_shm_sock_impl_opts.send_buf_size);
+	layout[0].offset = SPDK_SHM_SOCK_HDR_SIZE;
+	layout[1].size = shm_sock_ring_size(g_spdk_shm_sock_impl_opts.recv_buf_size);
+	layout[1].offset = SPDK_SHM_SOCK_HDR_SIZE + layout[0].size;
+	region_size = SPDK_SHM_SOCK_HDR_SIZE + layout[0].size + layout[1].size;
+
+	/* The accepting side refuses a region that could be resized under its mapping */
+	memfd = memfd_create(SPDK_SHM_SOCK_ADDR_PREFIX, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (memfd < 0 || ftruncate(memfd, region_size) != 0 ||
+	    fcntl(memfd, F_ADD_SEALS, SPDK_SHM_SOCK_SEALS | F_SEAL_SEAL) != 0) {
+		SPDK_ERRLOG("Failed to create the shared region, errno = %d\n", errno);
+		goto err;
+	}
+
+	/* The rings are set up before mapping, the accepting side reads them at accept */
+	hdr = mmap(NULL, SPDK_SHM_SOCK_HDR_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+	if (hdr == MAP_FAILED) {
+		goto err;
+	}
+	hdr->magic = SPDK_SHM_SOCK_MAGIC;
+	hdr->version = SPDK_SHM_SOCK_VERSION;
+	hdr->rings[0].size = layout[0].size;
+	hdr->rings[0].offset = layout[0].offset;
+	hdr->rings[1].size = layout[1].size;
+	hdr->rings[1].offset = layout[1].offset;
+	munmap(hdr, SPDK_SHM_SOCK_HDR_SIZE);
+
+	sock = shm_sock_alloc(fd, ip, port, false);
+	if (sock == NULL) {
+		goto err;
+	}
+
+	rc = shm_sock_map(sock, memfd, region_size, layout);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to map the shared region, rc = %d\n", rc);
+		goto err;
+	}
+
+	rc = shm_sock_send_region(fd, memfd);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to pass the shared region to %s:%d, rc = %d\n", ip, port, rc);
+		goto err;
+	}
+
+	/* The mapping keeps the region alive */
+	close(memfd);
+	memfd = -1;
+
+	if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0) {
+		goto err;
+	}
+
+	return &sock->base;
+err:
+	if (sock != NULL) {
+		if (sock->region != NULL) {
+			munmap(sock->region, sock->region_size);
+		}
+		free(sock);
+	}
+	if (memfd >= 0) {
+		close(memfd);
+	}
+	close(fd);
+	return NULL;
+}
+
+static int
+shm_sock_recv_region(int fd)
+{
+	char cbuf[CMSG_SPACE(sizeof(int))] = {};
+	struct msghdr msg = {};
+	struct cmsghdr *cmsg;
+	uint8_t byte;
+	struct iovec iov = { .iov_base = &byte, .iov_len = sizeof(byte) };
+	ssize_t rc;
+	int memfd;
+
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = sizeof(cbuf);
+
+	rc = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+	if (rc < 0) {
+		return -errno;
+	} else if (rc != sizeof(byte)) {
+		return -EPROTO;
+	}
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS ||
+	    cmsg->cmsg_len != CMSG_LEN(sizeof(int))) {
+		return -EPROTO;
+	}
+
+	memcpy(&memfd, CMSG_DATA(cmsg), sizeof(int));
+	return memfd;
+}
+
+/*
+ * Set up the socket of an accepted connection once its region arrived. Returns -EAGAIN
+ * if it didn't yet. The connection's fd is only owned by the new socket on success.
+ */
+static int
+shm_sock_accept_region(struct spdk_shm_sock *listen_sock, int fd, struct spdk_shm_sock **_sock)
+{
+	struct spdk_shm_sock *sock = NULL;
+	struct spdk_shm_sock_hdr *hdr;
+	struct spdk_shm_sock_ring layout[2] = {};
+	struct stat st;
+	uint32_t magic, version;
+	int memfd, seals, i, rc;
+
+	memfd = shm_sock_recv_region(fd);
+	if (memfd < 0) {
+		return memfd;
+	}
+
+	rc = -EPROTO;
+	seals = fcntl(memfd, F_GET_SEALS);
+	if (seals < 0 || (seals & SPDK_SHM_SOCK_SEALS) != SPDK_SHM_SOCK_SEALS) {
+		SPDK_ERRLOG("The shared region from the connecting side is not sealed\n");
+		goto err;
+	}
+
+	if (fstat(memfd, &st) != 0 || (size_t)st.st_size < SPDK_SHM_SOCK_HDR_SIZE) {
+		goto err;
+	}
+
+	/* Copy the layout out of the region before checking it, so it can't change after */
+	hdr = mmap(NULL, SPDK_SHM_SOCK_HDR_SIZE, PROT_READ, MAP_SHARED, memfd, 0);
+	if (hdr == MAP_FAILED) {
+		rc = -errno;
+		goto err;
+	}
+	magic = hdr->magic;
+	version = hdr->version;
+	for (i = 0; i < 2; i++) {
+		layout[i].size = hdr->rings[i].size;
+		layout[i].offset = hdr->rings[i].offset;
+	}
+	munmap(hdr, SPDK_SHM_SOCK_HDR_SIZE);
+
+	if (magic != SPDK_SHM_SOCK_MAGIC || version != SPDK_SHM_SOCK_VERSION ||
+	    !shm_sock_layout_valid(layout, st.st_size)) {
+		SPDK_ERRLOG("Invalid shared region from the connecting side\n");
+		goto err;
+	}
+
+	sock = shm_sock_alloc(fd, listen_sock->name, listen_sock->port, true);
+	if (sock == NULL) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	rc = shm_sock_map(sock, memfd, st.st_size, layout);
+	if (rc != 0) {
+		free(sock);
+		goto err;
+	}
+
+	close(memfd);
+	*_sock = sock;
+	return 0;
+err:
+	close(memfd);
+	return rc;
+}
+
+static void
+shm_sock_pending_free(struct spdk_shm_sock *listen_sock, struct spdk_shm_sock_pending *pending)
+{
+	TAILQ_REMOVE(&listen_sock->pending, pending, link);
+	listen_sock->num_pending--;
+	close(pending->fd);
+	free(pending);
+}
+
+static struct spdk_sock *
+shm_sock_accept(struct spdk_sock *_sock)
+{
+	struct spdk_shm_sock *listen_sock = __shm_sock(_sock);
+	struct spdk_shm_sock *sock;
+	struct spdk_shm_sock_pending *pending, *tmp;
+	uint64_t now = spdk_get_ticks();
+	int fd, rc;
+
+	/* Connections whose region didn't arrive yet are checked again, without waiting */
+	TAILQ_FOREACH_SAFE(pending, &listen_sock->pending, link, tmp) {
+		rc = shm_sock_accept_region(listen_sock, pending->fd, &sock);
+		if (rc == 0) {
+			TAILQ_REMOVE(&listen_sock->pending, pending, link);
+			listen_sock->num_pending--;
+			free(pending);
+			return &sock->base;
+		}
+
+		if (rc != -EAGAIN || now >= pending->timeout_tsc) {
+			SPDK_ERRLOG("Failed to receive the shared region, rc = %d\n", rc);
+			shm_sock_pending_free(listen_sock, pending);
+		}
+	}
+
+	while (true) {
+		fd = accept4(listen_sock->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0) {
+			return NULL;
+		}
+
+		if (!shm_sock_peer_trusted(fd)) {
+			SPDK_ERRLOG("Refused a connection to %s:%d from another user\n",
+				    listen_sock->name, listen_sock->port);
+			close(fd);
+			continue;
+		}
+
+		rc = shm_sock_accept_region(listen_sock, fd, &sock);
+		if (rc == 0) {
+			return &sock->base;
+		}
+
+		if (rc == -EAGAIN && listen_sock->num_pending < SPDK_SHM_SOCK_MAX_PENDING) {
+			pending = calloc(1, sizeof(*pending));
+			if (pending != NULL) {
+				pending->fd = fd;
+				pending->timeout_tsc = now + SPDK_SHM_SOCK_HANDSHAKE_TIMEOUT_MS *
+						       spdk_get_ticks_hz() / 1000;
+				TAILQ_INSERT_TAIL(&listen_sock->pending, pending, link);
+				listen_sock->num_pending++;
+				continue;
+			}
+		}
+
+		SPDK_ERRLOG("Failed to receive the shared region, rc = %d\n", rc);
+		close(fd);
+	}
+}
+
+static int
+shm_sock_close(struct spdk_sock *_sock)
+{
+	struct spdk_shm_sock *sock = __shm_sock(_sock);
+
+	assert(TAILQ_EMPTY(&_sock->pending_reqs));
+
+	if (sock->region != NULL) {
+		/* Let the peer read what is left, then see the end of the stream */
+		__atomic_store_n(&sock->tx->closed, 1, __ATOMIC_RELEASE);
+		munmap(sock->region, sock->region_size);
+	}
+
+	while (!TAILQ_EMPTY(&sock->pending)) {
+		shm_sock_pending_free(sock, TAILQ_FIRST(&sock->pending));
+	}
+
+	close(sock->fd);
+	free(sock);
+
+	return 0;
+}
+
+static int
+shm_sock_getaddr(struct spdk_sock *_sock, char *saddr, int slen, uint16_t *sport,
+		 char *caddr, int clen, uint16_t *cport)
+{
+	struct spdk_shm_sock *sock = __shm_sock(_sock);
+
+	/* Both ends are on this host and are known by the listener's name and port */
+	if (saddr != NULL) {
+		snprintf(saddr, slen, "%s", sock->name);
+	}
+	if (sport != NULL) {
+		*sport = sock->port;
+	}
+	if (caddr != NULL) {
+		snprintf(caddr, clen, "%s", sock->name);
+	}
+	if (cport != NULL) {
+		*cport = 0;
+	}
+
+	return 0;
+}
+
+static void
+shm_sock_reset(struct spdk_shm_sock *sock)
+{
+	if (!sock->reset) {
+		SPDK_ERRLOG("Inconsistent ring indexes from the peer on %s:%d, resetting\n",
+			    sock->name, sock->port);
+		sock->reset = true;
+	}
+}
+
+static inline uint64_t
+shm_sock_rx_bytes(struct spdk_shm_sock *sock)
+{
+	uint64_t avail;
+
+	if (spdk_unlikely(sock->reset)) {
+		return 0;
+	}
+
+	avail = __atomic_load_n(&sock->rx->head, __ATOMIC_ACQUIRE) - sock->rx_tail;
+	if (spdk_unlikely(avail > sock->rx_size)) {
+		shm_sock_reset(sock);
+		return 0;
+	}
+
+	return avail;
+}
+
+static inline bool
+shm_sock_rx_closed(struct spdk_shm_sock *sock)
+{
+	return sock->reset || sock->peer_gone ||
+	       __atomic_load_n(&sock->rx->closed, __ATOMIC_ACQUIRE);
+}
+
+/* Returns the number of bytes that can be read, 0 at the end of the stream or -1 with errno */
+static ssize_t
+shm_sock_rx_avail(struct spdk_shm_sock *sock)
+{
+	uint64_t avail;
+
+	avail = shm_sock_rx_bytes(sock);
+	if (avail != 0) {
+		return avail;
+	}
+
+	if (!shm_sock_rx_closed(sock)) {
+		errno = EAGAIN;
+		return -1;
+	}
+
+	/* Data written before the close is still delivered */
+	avail = shm_sock_rx_bytes(sock);
+	if (avail != 0) {
+		return avail;
+	}
+
+	if (sock->reset) {
+		errno = ECONNRESET;
+		return -1;
+	}
+
+	return 0;
+}
+
+static ssize_t
+shm_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
+{
+	struct spdk_shm_sock *sock = __shm_sock(_sock);
+	uint64_t tail = sock->rx_tail, mask = sock->rx_size - 1;
+	size_t total = 0, len, off, chunk;
+	ssize_t avail;
+	int i;
+
+	avail = shm_sock_rx_avail(sock);
+	if (avail <= 0) {
+		return avail;
+	}
+
+	for (i = 0; i < iovcnt && total < (size_t)avail; i++) {
+		len = spdk_min(iov[i].iov_len, avail - total);
+		off = (tail + total) & mask;
+		chunk = spdk_min(len, sock->rx_size - off);
+		memcpy(iov[i].iov_base, sock->rx_data + off, chunk);
+		memcpy((uint8_t *)iov[i].iov_base + chunk, sock->rx_data, len - chunk);
+		total += len;
+	}
+
+	/* The copies must complete before the producer may reuse the space */
+	sock->rx_tail = tail + total;
+	__atomic_store_n(&sock->rx->tail, sock->rx_tail, __ATOMIC_RELEASE);
+
+	return total;
+}
+
+static ssize_t
+shm_sock_recv(struct spdk_sock *sock, void *buf, size_t len)
+{
+	struct iovec iov[1];
+
+	iov[0].iov_base = buf;
+	iov[0].iov_len = len;
+
+	return shm_sock_readv(sock, iov, 1);
+}
+
+static ssize_t
+shm_sock_recv_lend(struct spdk_sock *_sock, void **buf)
+{
+	struct spdk_shm_sock *sock = __shm_sock(_sock);
+	uint64_t off;
+	ssize_t avail;
+
+	avail = shm_sock_rx_avail(sock);
+	if (avail <= 0) {
+		return avail;
+	}
+
+	/* Lend the data in place, up to the end of the ring */
+	off = sock->rx_tail & (sock->rx_size - 1);
+	*buf = sock->rx_data + off;
+
+	return spdk_min((uint64_t)avail, sock->rx_size - off);
+}
+
+static int
+shm_sock_recv_return(struct spdk_sock *_sock, size_t len)
+{
+	struct spdk_shm_sock *sock = __shm_sock(_sock);
+	uint64_t off = sock->rx_tail & (sock->rx_size - 1);
+
+	if (len > shm_sock_rx_bytes(sock) || len > sock->rx_size - off) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	sock->rx_tail += len;
+	__atomic_store_n(&sock->rx->tail, sock->rx_tail, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+static ssize_t
+shm_sock_writev(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
+{
+	struct spdk_shm_sock *sock = __shm_sock(_sock);
+	uint64_t used, space, head = sock->tx_head, mask = sock->tx_size - 1;
+	size_t total = 0, len, off, chunk;
+	int i;
+
+	if (spdk_unlikely(sock->reset)) {
+		errno = ECONNRESET;
+		return -1;
+	}
+
+	/* The peer stops reading once it has closed its side */
+	if (sock->peer_gone || __atomic_load_n(&sock->rx->closed, __ATOMIC_ACQUIRE)) {
+		errno = EPIPE;
+		return -1;
+	}
+
+	used = head - __atomic_load_n(&sock->tx->tail, __ATOMIC_ACQUIRE);
+	if (spdk_unlikely(used > sock->tx_size)) {
+		shm_sock_reset(sock);
+		errno = ECONNRESET;
+		return -1;
+	}
+
+	space = sock->tx_size - used;
+	if (space == 0) {
+		errno = EAGAIN;
+		return -1;
+	}
+
+	for (i = 0; i < iovcnt && total < space; i++) {
+		len = spdk_min(iov[i].iov_len, space - total);
+		off = (head + total) & mask;
+		chunk = spdk_min(len, sock->tx_size - off);
+		memcpy(sock->tx_data + off, iov[i].iov_base, chunk);
+		memcpy(sock->tx_data, (uint8_t *)iov[i].iov_base + chunk, len - chunk);
+		total += len;
+	}
+
+	/* Publish the data before the new head */
+	sock->tx_head = head + total;
+	__atomic_store_n(&sock->tx->head, sock->tx_head, __ATOMIC_RELEASE);
+
+	return total;
+}
+
+static int
+_sock_flush(struct spdk_sock *sock)
+{
+	struct iovec iovs[IOV_BATCH_SIZE];
+	struct spdk_sock_request *req;
+	unsigned int offset;
+	ssize_t rc;
+	size_t len;
+	int iovcnt, i, retval;
+
+	/* Can't flush from within a callback or we end up with recursive calls */
+	if (sock->cb_cnt > 0) {
+		return 0;
+	}
+
+	iovcnt = spdk_sock_prep_reqs(sock, iovs, 0, NULL);
+	if (iovcnt == 0) {
+		return 0;
+	}
+
+	rc = shm_sock_writev(sock, iovs, iovcnt);
+	if (rc < 0) {
+		return errno == EAGAIN ? 0 : rc;
+	}
+
+	spdk_sock_send_charge(sock, rc);
+
+	/* Consume the requests that were actually written */
+	req = TAILQ_FIRST(&sock->queued_reqs);
+	while (req) {
+		offset = req->internal.offset;
+
+		for (i = 0; i < req->iovcnt; i++) {
+			/* Advance by the offset first */
+			if (offset >= SPDK_SOCK_REQUEST_IOV(req, i)->iov_len) {
+				offset -= SPDK_SOCK_REQUEST_IOV(req, i)->iov_len;
+				continue;
+			}
+
+			/* Calculate the remaining length of this element */
+			len = SPDK_SOCK_REQUEST_IOV(req, i)->iov_len - offset;
+
+			if (len > (size_t)rc) {
+				/* This element was partially sent. */
+				req->internal.offset += rc;
+				return 0;
+			}
+
+			offset = 0;
+			req->internal.offset += len;
+			rc -= len;
+		}
+
+		/* Handled a full request. The data is in the ring, so it is done. */
+		spdk_sock_request_pend(sock, req);
+		retval = spdk_sock_request_put(sock, req, 0);
+		if (retval) {
+			break;
+		}
+
+		if (rc == 0) {
+			break;
+		}
+
+		req = TAILQ_FIRST(&sock->queued_reqs);
+	}
+
+	return 0;
+}
+
+static void
+shm_sock_writev_async(struct spdk_sock *sock, struct spdk_sock_request *req)
+{
+	int rc;
+
+	spdk_sock_request_queue(sock, req);
+
+	/* If there are a sufficient number queued, just flush them out immediately. */
+	if (sock->queued_iovcnt >= IOV_BATCH_SIZE) {
+		rc = _sock_flush(sock);
+		if (rc) {
+			spdk_sock_abort_requests(sock);
+		}
+	}
+}
+
+static int
+shm_sock_flush(struct spdk_sock *sock)
+{
+	return _sock_flush(sock);
+}
+
+static int
+shm_sock_set_recvlowat(struct spdk_sock *_sock, int nbytes)
+{
+	struct spdk_shm_sock *sock = __shm_sock(_sock);
+
+	sock->recv_lowat = spdk_max(nbytes, 1);
+	return 0;
+}
+
+static int
+shm_sock_set_recvbuf(struct spdk_sock *_sock, int sz)
+{
+	/* The rings are sized when the connection is made */
+	return 0;
+}
+
+static int
+shm_sock_set_sendbuf(struct spdk_sock *_sock, int sz)
+{
+	/* The rings are sized when the connection is made */
+	return 0;
+}
+
+static bool
+shm_sock_is_ipv6(struct spdk_sock *_sock)
+{
+	return false;
+}
+
+static bool
+shm_sock_is_ipv4(struct spdk_sock *_sock)
+{
+	return false;
+}
+
+static bool
+shm_sock_is_connected(struct spdk_sock *_sock)
+{
+	struct spdk_shm_sock *sock = __shm_sock(_sock);
+
+	return sock->region != NULL && !shm_sock_rx_closed(sock);
+}
+
+static struct spdk_sock_group_impl *
+shm_sock_group_impl_get_optimal(struct spdk_sock *_sock, struct spdk_sock_group_impl *hint)
+{
+	return NULL;
+}
+
+static struct spdk_sock_group_impl *
+shm_sock_group_impl_create(void)
+{
+	struct spdk_shm_sock_group_impl *group_impl;
+	int fd;
+
+	fd = epoll_create1(EPOLL_CLOEXEC);
+	if (fd == -1) {
+		return NULL;
+	}
+
+	group_impl = calloc(1, sizeof(*group_impl));
+	if (group_impl == NULL) {
+		SPDK_ERRLOG("group_impl allocation failed\n");
+		close(fd);
+		return NULL;
+	}
+
+	group_impl->fd = fd;
+	TAILQ_INIT(&group_impl->socks);
+
+	return &group_impl->base;
+}
+
+static int
+shm_sock_group_impl_add_sock(struct spdk_sock_group_impl *_group, struct spdk_sock *_sock)
+{
+	struct spdk_shm_sock_group_impl *group = __shm_group_impl(_group);
+	struct spdk_shm_sock *sock = __shm_sock(_sock);
+	struct epoll_event event = {};
+	int rc;
+
+	/* Only a hang up is of interest, data goes through the rings */
+	event.events = EPOLLRDHUP;
+	event.data.ptr = sock;
+
+	rc = epoll_ctl(group->fd, EPOLL_CTL_ADD, sock->fd, &event);
+	if (rc != 0) {
+		return rc;
+	}
+
+	sock->group = group;
+	TAILQ_INSERT_TAIL(&group->socks, sock, link);
+
+	return 0;
+}
+
+static int
+shm_sock_group_impl_remove_sock(struct spdk_sock_group_impl *_group, struct spdk_sock *_sock)
+{
+	struct spdk_shm_sock_group_impl *group = __shm_group_impl(_group);
+	struct spdk_shm_sock *sock = __shm_sock(_sock);
+	struct epoll_event event = {};
+
+	assert(sock->group == group);
+	TAILQ_REMOVE(&group->socks, sock, link);
+	sock->group = NULL;
+
+	/* Event parameter is ignored but some old kernel version still require it. */
+	return epoll_ctl(group->fd, EPOLL_CTL_DEL, sock->fd, &event);
+}
+
+static void
+shm_sock_group_check_hup(struct spdk_shm_sock_group_impl *group)
+{
+	struct epoll_event events[MAX_EVENTS_PER_POLL];
+	struct spdk_shm_sock *sock;
+	int num_events, i;
+
+	num_events = epoll_wait(group->fd, events, MAX_EVENTS_PER_POLL, 0);
+	for (i = 0; i < num_events; i++) {
+		sock = events[i].data.ptr;
+		sock->peer_gone = true;
+	}
+}
+
+static int
+shm_sock_group_impl_poll(struct spdk_sock_group_impl *_group, int max_events,
+			 struct spdk_sock **socks)
+{
+	struct spdk_shm_sock_group_impl *group = __shm_group_impl(_group);
+	struct spdk_shm_sock *sock, *tmp, *last;
+	int num_events = 0, rc;
+
+	/* Peers that close the connection mark the ring. Only peers that exit without
+	 * closing have to be found through the Unix domain sockets. */
+	if (++group->polls == SPDK_SHM_SOCK_HUP_POLLS) {
+		group->polls = 0;
+		shm_sock_group_check_hup(group);
+	}
+
+	TAILQ_FOREACH_SAFE(sock, &group->socks, link, tmp) {
+		rc = _sock_flush(&sock->base);
+		if (rc) {
+			spdk_sock_abort_requests(&sock->base);
+		}
+	}
+
+	last = TAILQ_LAST(&group->socks, spdk_shm_sock_list);
+	TAILQ_FOREACH_SAFE(sock, &group->socks, link, tmp) {
+		if (num_events == max_events) {
+			break;
+		}
+
+		if (shm_sock_rx_bytes(sock) >= (uint64_t)sock->recv_lowat || shm_sock_rx_closed(sock)) {
+			socks[num_events++] = &sock->base;
+			/* Serve the other sockets first next time */
+			TAILQ_REMOVE(&group->socks, sock, link);
+			TAILQ_INSERT_TAIL(&group->socks, sock, link);
+		}
+
+		if (sock == last) {
+			break;
+		}
+	}
+
+	return num_events;
+}
+
+static int
+shm_sock_group_impl_close(struct spdk_sock_group_impl *_group)
+{
+	struct spdk_shm_sock_group_impl *group = __shm_group_impl(_group);
+	int rc;
+
+	assert(TAILQ_EMPTY(&group->socks));
+
+	rc = close(group->fd);
+	free(group);
+	return rc;
+}
+
+static int
+shm_sock_impl_get_opts(struct spdk_sock_impl_opts *opts, size_t *len)
+{
+	if (!opts || !len) {
+		errno = EINVAL;
+		return -1;
+	}
+	memset(opts, 0, *len);
+
+#define FIELD_OK(field) \
+	offsetof(struct spdk_sock_impl_opts, field) + sizeof(opts->field) <= *len
+
+#define GET_FIELD(field) \
+	if (FIELD_OK(field)) { \
+		opts->field = g_spdk_shm_sock_impl_opts.field; \
+	}
+
+	GET_FIELD(recv_buf_size);
+	GET_FIELD(send_buf_size);
+	GET_FIELD(send_rate_limit);
+	GET_FIELD(send_burst_size);
+
+#undef GET_FIELD
+#undef FIELD_OK
+
+	*len = spdk_min(*len, sizeof(g_spdk_shm_sock_impl_opts));
+	return 0;
+}
+
+static int
+shm_sock_impl_set_opts(const struct spdk_sock_impl_opts *opts, size_t len)
+{
+	if (!opts) {
+		errno = EINVAL;
+		return -1;
+	}
+
+#define FIELD_OK(field) \
+	offsetof(struct spdk_sock_impl_opts, field) + sizeof(opts->field) <= len
+
+#define SET_FIELD(field) \
+	if (FIELD_OK(field)) { \
+		g_spdk_shm_sock_impl_opts.field = opts->field; \
+	}
+
+	SET_FIELD(recv_buf_size);
+	SET_FIELD(send_buf_size);
+	SET_FIELD(send_rate_limit);
+	SET_FIELD(send_burst_size);
+
+#undef SET_FIELD
+#undef FIELD_OK
+
+	return 0;
+}
+
+static struct spdk_net_impl g_shm_net_impl = {
+	.name		= "shm",
+	.by_name_only	= true,
+	.getaddr	= shm_sock_getaddr,
+	.connect	= shm_sock_connect,
+	.listen		= shm_sock_listen,
+	.accept		= shm_sock_accept,
+	.close		= shm_sock_close,
+	.recv		= shm_sock_recv,
+	.readv		= shm_sock_readv,
+	.writev		= shm_sock_writev,
+	.recv_lend	= shm_sock_recv_lend,
+	.recv_return	= shm_sock_recv_return,
+	.writev_async	= shm_sock_writev_async,
+	.flush		= shm_sock_flush,
+	.set_recvlowat	= shm_sock_set_recvlowat,
+	.set_recvbuf	= shm_sock_set_recvbuf,
+	.set_sendbuf	= shm_sock_set_sendbuf,
+	.is_ipv6	= shm_sock_is_ipv6,
+	.is_ipv4	= shm_sock_is_ipv4,
+	.is_connected	= shm_sock_is_connected,
+	.group_impl_get_optimal	= shm_sock_group_impl_get_optimal,
+	.group_impl_create	= shm_sock_group_impl_create,
+	.group_impl_add_sock	= shm_sock_group_impl_add_sock,
+	.group_impl_remove_sock = shm_sock_group_impl_remove_sock,
+	.group_impl_poll	= shm_sock_group_impl_poll,
+	.group_impl_close	= shm_sock_group_impl_close,
+	.get_opts	= shm_sock_impl_get_opts,
+	.set_opts	= shm_sock_impl_set_opts,
+};
+
+/* Never chosen implicitly, it must be requested by name or set as the default */
+SPDK_NET_IMPL_REGISTER(shm, &g_shm_net_impl, DEFAULT_SOCK_PRIORITY - 2);
@@ -60,12 +60,33 @@ enum spdk_sock_task_type {
 	SPDK_SOCK_TASK_RECV,
 	SPDK_SOCK_TASK_WRITE,
 	SPDK_SOCK_TASK_CANCEL,
+	SPDK_SOCK_TASK_READ,
 };
 
 #if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
 #define SPDK_ZEROCOPY
 #endif
 
+#if defined(IORING_CQE_F_BUFFER) && defined(IORING_RECV_MULTISHOT)
+#define SPDK_URING_RECV_BUF_RING
+#endif
+
+/* Default size of the provided buffer ring shared by all sockets of a group, see the
+ * recv_ring_buf_count and recv_ring_buf_size options. */
+#define SPDK_URING_RECV_BUF_COUNT	1024
+#define SPDK_URING_RECV_BUF_SIZE	4096
+/* The number of buffers must be a power of 2 and is limited by the kernel */
+#define SPDK_URING_RECV_BUF_COUNT_MIN	8
+#define SPDK_URING_RECV_BUF_COUNT_MAX	32768
+#define SPDK_URING_RECV_BUF_GROUP_ID	0
+
+#ifdef IORING_RSRC_REGISTER_SPARSE
+#define SPDK_URING_FIXED_FILES
+#endif
+
+/* Upper bound of the registered file table of a group, further limited by RLIMIT_NOFILE */
+#define SPDK_URING_FIXED_FILES_MAX	4096
+
 enum spdk_uring_sock_task_status {
 	SPDK_URING_SOCK_TASK_NOT_IN_USE = 0,
 	SPDK_URING_SOCK_TASK_IN_PROCESS,
@@ -82,6 +103,14 @@ struct spdk_uring_task {
 	STAILQ_ENTRY(spdk_uring_task)		link;
 };
 
+/* Group-owned receive buffer holding data of a single socket */
+struct spdk_uring_recv_buf {
+	uint16_t				bid;
+	uint32_t				len;
+	uint32_t				offset;
+	STAILQ_ENTRY(spdk_uring_recv_buf)	link;
+};
+
 struct spdk_uring_sock {
 	struct spdk_sock			base;
 	int					fd;
@@ -91,9 +120,20 @@ struct spdk_uring_sock {
 	struct spdk_uring_task			recv_task;
 	struct spdk_uring_task			pollin_task;
 	struct spdk_uring_task			cancel_task;
+	struct spdk_uring_task			read_task;
 	struct spdk_pipe			*recv_pipe;
 	void					*recv_buf;
 	int					recv_buf_sz;
+	/* Buffers filled by the multishot receive, not yet read by the user */
+	STAILQ_HEAD(, spdk_uring_recv_buf)	recv_queue;
+	uint32_t				recv_bufs_held;
+	/* Status of a terminated multishot receive, 0 if the peer closed the connection */
+	int					recv_status;
+	bool					recv_closed;
+	bool					recv_multishot;
+	/* The socket is referenced through fixed_idx in the group's registered file table */
+	bool					fixed_file;
+	uint32_t				fixed_idx;
 	bool					zcopy;
 	bool					pending_recv;
 	int					zcopy_send_flags;
@@ -112,6 +152,20 @@ struct spdk_uring_sock_group_impl {
 	uint32_t				io_queued;
 	uint32_t				io_avail;
 	struct pending_recv_list		pending_recv;
+#ifdef SPDK_URING_RECV_BUF_RING
+	struct io_uring_buf_ring		*buf_ring;
+	uint8_t					*recv_bufs;
+	struct spdk_uring_recv_buf		*recv_buf_descs;
+	uint32_t				recv_buf_count;
+	uint32_t				recv_buf_size;
+	uint32_t				recv_bufs_avail;
+#endif
+#ifdef SPDK_URING_FIXED_FILES
+	/* Stack of unused slots of the registered file table */
+	uint32_t				*fixed_free;
+	uint32_t				fixed_free_count;
+	uint32_t				fixed_count;
+#endif
 };
 
 static struct spdk_sock_impl_opts g_spdk_uring_sock_impl_opts = {
@@ -122,6 +176,8 @@ static struct spdk_sock_impl_opts g_spdk_uring_sock_impl_opts = {
 	.enable_placement_id = PLACEMENT_NONE,
 	.enable_zerocopy_send_server = false,
 	.enable_zerocopy_send_client = false,
+	.recv_ring_buf_count = SPDK_URING_RECV_BUF_COUNT,
+	.recv_ring_buf_size = SPDK_URING_RECV_BUF_SIZE,
 };
 
 static struct spdk_sock_map g_map = {
@@ -226,7 +282,7 @@ uring_sock_alloc_pipe(struct spdk_uring_sock *sock, int sz)
 	int sbytes;
 	ssize_t bytes;
 
-	if (sock->recv_buf_sz == sz) {
+	if (sock->recv_pipe != NULL && sock->recv_buf_sz == sz) {
 		return 0;
 	}
 
@@ -236,6 +292,7 @@ uring_sock_alloc_pipe(struct spdk_uring_sock *sock, int sz)
 		free(sock->recv_buf);
 		sock->recv_pipe = NULL;
 		sock->recv_buf = NULL;
+		sock->recv_buf_sz = 0;
 		return 0;
 	} else if (sz < MIN_SOCK_PIPE_SIZE) {
 		SPDK_ERRLOG("The size of the pipe must be larger than %d\n", MIN_SOCK_PIPE_SIZE);
@@ -292,10 +349,19 @@ uring_sock_set_recvbuf(struct spdk_sock *_sock, int sz)
 	assert(sock != NULL);
 
 	if (g_spdk_uring_sock_impl_opts.enable_recv_pipe) {
-		rc = uring_sock_alloc_pipe(sock, sz);
-		if (rc) {
-			SPDK_ERRLOG("unable to allocate sufficient recvbuf with sz=%d on sock=%p\n", sz, _sock);
-			return rc;
+		if (sock->recv_pipe != NULL) {
+			rc = uring_sock_alloc_pipe(sock, sz);
+			if (rc) {
+				SPDK_ERRLOG("unable to allocate sufficient recvbuf with sz=%d on sock=%p\n", sz, _sock);
+				return rc;
+			}
+		} else if (sz != 0 && sz < MIN_SOCK_PIPE_SIZE) {
+			SPDK_ERRLOG("The size of the pipe must be larger than %d\n", MIN_SOCK_PIPE_SIZE);
+			return -1;
+		} else {
+			/* Sockets receiving into the group's buffer ring never need the pipe, the
+			 * others allocate it on their first read */
+			sock->recv_buf_sz = sz;
 		}
 	}
 
@@ -331,6 +397,23 @@ uring_sock_set_sendbuf(struct spdk_sock *_sock, int sz)
 	return 0;
 }
 
+static int
+uring_sock_set_pacing_rate(struct spdk_sock *_sock, uint64_t rate)
+{
+#if defined(SO_MAX_PACING_RATE)
+	struct spdk_uring_sock *sock = __uring_sock(_sock);
+	/* All ones lifts the limit */
+	uint64_t val = rate != 0 ? rate : UINT64_MAX;
+
+	assert(sock != NULL);
+
+	return setsockopt(sock->fd, SOL_SOCKET, SO_MAX_PACING_RATE, &val, sizeof(val));
+#else
+	errno = ENOTSUP;
+	return -1;
+#endif
+}
+
 static struct spdk_uring_sock *
 uring_sock_alloc(int fd, bool enable_zero_copy)
 {
@@ -347,6 +430,7 @@ uring_sock_alloc(int fd, bool enable_zero_copy)
 	}
 
 	sock->fd = fd;
+	STAILQ_INIT(&sock->recv_queue);
 
 #if defined(__linux__)
 	flag = 1;
@@ -634,6 +718,7 @@ uring_sock_close(struct spdk_sock *_sock)
 
 	assert(TAILQ_EMPTY(&_sock->pending_reqs));
 	assert(sock->group == NULL);
+	assert(STAILQ_EMPTY(&sock->recv_queue));
 
 	/* If the socket fails to close, the best choice is to
 	 * leak the fd but continue to free the rest of the sock
@@ -647,13 +732,34 @@ uring_sock_close(struct spdk_sock *_sock)
 	return 0;
 }
 
+static inline bool
+uring_sock_has_recv_data(struct spdk_uring_sock *sock)
+{
+	return (sock->recv_pipe != NULL && spdk_pipe_reader_bytes_available(sock->recv_pipe) > 0) ||
+	       !STAILQ_EMPTY(&sock->recv_queue) || sock->recv_closed;
+}
+
+static void
+uring_sock_pipe_consume(struct spdk_uring_sock *sock, size_t bytes)
+{
+	struct spdk_uring_sock_group_impl *group;
+
+	spdk_pipe_reader_advance(sock->recv_pipe, bytes);
+
+	/* If we drained the pipe, take it off the level-triggered list */
+	if (sock->base.group_impl && sock->pending_recv && !uring_sock_has_recv_data(sock)) {
+		group = __uring_group_impl(sock->base.group_impl);
+		TAILQ_REMOVE(&group->pending_recv, sock, link);
+		sock->pending_recv = false;
+	}
+}
+
 static ssize_t
 uring_sock_recv_from_pipe(struct spdk_uring_sock *sock, struct iovec *diov, int diovcnt)
 {
 	struct iovec siov[2];
 	int sbytes;
 	ssize_t bytes;
-	struct spdk_uring_sock_group_impl *group;
 
 	sbytes = spdk_pipe_reader_get_buffer(sock->recv_pipe, sock->recv_buf_sz, siov);
 	if (sbytes < 0) {
@@ -672,14 +778,7 @@ uring_sock_recv_from_pipe(struct spdk_uring_sock *sock, struct iovec *diov, int
 		return -1;
 	}
 
-	spdk_pipe_reader_advance(sock->recv_pipe, bytes);
-
-	/* If we drained the pipe, take it off the level-triggered list */
-	if (sock->base.group_impl && spdk_pipe_reader_bytes_available(sock->recv_pipe) == 0) {
-		group = __uring_group_impl(sock->base.group_impl);
-		TAILQ_REMOVE(&group->pending_recv, sock, link);
-		sock->pending_recv = false;
-	}
+	uring_sock_pipe_consume(sock, bytes);
 
 	return bytes;
 }
@@ -708,6 +807,124 @@ uring_sock_read(struct spdk_uring_sock *sock)
 	return bytes;
 }
 
+#ifdef SPDK_URING_RECV_BUF_RING
+static inline uint8_t *
+uring_sock_recv_buf_addr(struct spdk_uring_sock_group_impl *group, uint16_t bid)
+{
+	return group->recv_bufs + (size_t)bid * group->recv_buf_size;
+}
+
+/* Buffers of the ring a single socket may hold, so that a socket whose data isn't read
+ * doesn't starve the rest of the group. Its receive is stopped at the limit and started
+ * again once it's back to half of it. */
+static inline uint32_t
+uring_sock_recv_buf_sock_max(struct spdk_uring_sock_group_impl *group)
+{
+	return group->recv_buf_count / 8;
+}
+
+static void
+uring_sock_recycle_recv_buf(struct spdk_uring_sock *sock, struct spdk_uring_recv_buf *buf)
+{
+	struct spdk_uring_sock_group_impl *group = sock->group;
+
+	assert(sock->recv_bufs_held > 0);
+	sock->recv_bufs_held--;
+	io_uring_buf_ring_add(group->buf_ring, uring_sock_recv_buf_addr(group, buf->bid),
+			      group->recv_buf_size, buf->bid,
+			      io_uring_buf_ring_mask(group->recv_buf_count), 0);
+	io_uring_buf_ring_advance(group->buf_ring, 1);
+	group->recv_bufs_avail++;
+}
+
+static void
+uring_sock_bufs_consume(struct spdk_uring_sock *sock, size_t bytes)
+{
+	struct spdk_uring_sock_group_impl *group = sock->group;
+	struct spdk_uring_recv_buf *buf;
+	size_t len;
+
+	while (bytes > 0) {
+		buf = STAILQ_FIRST(&sock->recv_queue);
+		assert(buf != NULL);
+		len = spdk_min(buf->len - buf->offset, bytes);
+		buf->offset += len;
+		bytes -= len;
+		if (buf->offset == buf->len) {
+			STAILQ_REMOVE_HEAD(&sock->recv_queue, link);
+			uring_sock_recycle_recv_buf(sock, buf);
+		}
+	}
+
+	/* If we drained the buffers, take it off the level-triggered list */
+	if (sock->pending_recv && !uring_sock_has_recv_data(sock)) {
+		TAILQ_REMOVE(&group->pending_recv, sock, link);
+		sock->pending_recv = false;
+	}
+}
+
+static ssize_t
+uring_sock_recv_closed(struct spdk_uring_sock *sock)
+{
+	if (!sock->recv_closed) {
+		errno = EAGAIN;
+		return -1;
+	} else if (sock->recv_status != 0) {
+		errno = -sock->recv_status;
+		return -1;
+	}
+
+	return 0;
+}
+
+static ssize_t
+uring_sock_recv_from_bufs(struct spdk_uring_sock *sock, struct iovec *diov, int diovcnt)
+{
+	struct spdk_uring_sock_group_impl *group = sock->group;
+	struct spdk_uring_recv_buf *buf;
+	struct iovec siov[IOV_BATCH_SIZE];
+	int sbufs = 0;
+	size_t bytes;
+
+	STAILQ_FOREACH(buf, &sock->recv_queue, link) {
+		if (sbufs == IOV_BATCH_SIZE) {
+			break;
+		}
+		siov[sbufs].iov_base = uring_sock_recv_buf_addr(group, buf->bid) + buf->offset;
+		siov[sbufs].iov_len = buf->len - buf->offset;
+		sbufs++;
+	}
+
+	if (sbufs == 0) {
+		return uring_sock_recv_closed(sock);
+	}
+
+	bytes = spdk_iovcpy(siov, sbufs, diov, diovcnt);
+	if (bytes == 0) {
+		/* The only way this happens is if diov is 0 length */
+		errno = EINVAL;
+		return -1;
+	}
+
+	uring_sock_bufs_consume(sock, bytes);
+
+	return bytes;
+}
+#endif
+
+/* Allocate the pipe of a socket that reads from its descriptor, on its first read */
+static inline void
+uring_sock_get_pipe(struct spdk_uring_sock *sock)
+{
+	if (spdk_unlikely(sock->recv_pipe == NULL && sock->recv_buf_sz != 0)) {
+		/* Without the pipe the socket reads straight into the user's buffers, don't
+		 * retry the allocation on every read */
+		if (uring_sock_alloc_pipe(sock, sock->recv_buf_sz) != 0) {
+			sock->recv_buf_sz = 0;
+		}
+	}
+}
+
 static ssize_t
 uring_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 {
@@ -715,6 +932,19 @@ uring_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 	int rc, i;
 	size_t len;
 
+#ifdef SPDK_URING_RECV_BUF_RING
+	/* The socket is read by the multishot receive, so data must not be taken from the fd
+	 * directly. Data buffered before the socket was added to the group comes first. */
+	if (sock->recv_multishot) {
+		if (sock->recv_pipe != NULL && spdk_pipe_reader_bytes_available(sock->recv_pipe) > 0) {
+			return uring_sock_recv_from_pipe(sock, iov, iovcnt);
+		}
+
+		return uring_sock_recv_from_bufs(sock, iov, iovcnt);
+	}
+#endif
+
+	uring_sock_get_pipe(sock);
 	if (sock->recv_pipe == NULL) {
 		return readv(sock->fd, iov, iovcnt);
 	}
@@ -741,6 +971,88 @@ uring_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 	return uring_sock_recv_from_pipe(sock, iov, iovcnt);
 }
 
+static ssize_t
+uring_sock_recv_lend(struct spdk_sock *_sock, void **buf)
+{
+	struct spdk_uring_sock *sock = __uring_sock(_sock);
+	struct iovec siov[2];
+	int rc;
+
+	if (sock->recv_pipe != NULL && spdk_pipe_reader_bytes_available(sock->recv_pipe) > 0) {
+		goto lend_pipe;
+	}
+
+#ifdef SPDK_URING_RECV_BUF_RING
+	if (sock->recv_multishot) {
+		struct spdk_uring_recv_buf *rbuf = STAILQ_FIRST(&sock->recv_queue);
+
+		if (rbuf == NULL) {
+			return uring_sock_recv_closed(sock);
+		}
+
+		*buf = uring_sock_recv_buf_addr(sock->group, rbuf->bid) + rbuf->offset;
+		return rbuf->len - rbuf->offset;
+	}
+#endif
+
+	uring_sock_get_pipe(sock);
+	if (sock->recv_pipe == NULL) {
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	rc = uring_sock_read(sock);
+	if (rc <= 0) {
+		return rc;
+	}
+
+lend_pipe:
+	spdk_pipe_reader_get_buffer(sock->recv_pipe, sock->recv_buf_sz, siov);
+
+	/* Only the part up to the end of the pipe's buffer is contiguous */
+	*buf = siov[0].iov_base;
+
+	return siov[0].iov_len;
+}
+
+static int
+uring_sock_recv_return(struct spdk_sock *_sock, size_t len)
+{
+	struct spdk_uring_sock *sock = __uring_sock(_sock);
+
+	/* Data buffered in the pipe is always lent before the group's buffers */
+	if (sock->recv_pipe != NULL && spdk_pipe_reader_bytes_available(sock->recv_pipe) > 0) {
+		if (len > spdk_pipe_reader_bytes_available(sock->recv_pipe)) {
+			errno = EINVAL;
+			return -1;
+		}
+
+		uring_sock_pipe_consume(sock, len);
+		return 0;
+	}
+
+#ifdef SPDK_URING_RECV_BUF_RING
+	if (sock->recv_multishot && !STAILQ_EMPTY(&sock->recv_queue)) {
+		struct spdk_uring_recv_buf *rbuf = STAILQ_FIRST(&sock->recv_queue);
+
+		if (len > rbuf->len - rbuf->offset) {
+			errno = EINVAL;
+			return -1;
+		}
+
+		uring_sock_bufs_consume(sock, len);
+		return 0;
+	}
+#endif
+
+	if (len > 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	return 0;
+}
+
 static ssize_t
 uring_sock_recv(struct spdk_sock *sock, void *buf, size_t len)
 {
@@ -774,6 +1086,8 @@ sock_complete_reqs(struct spdk_sock *_sock, ssize_t rc)
 	unsigned int offset;
 	size_t len;
 
+	spdk_sock_send_charge(_sock, rc);
+
 	if (sock->zcopy) {
 		/* Handling overflow case, because we use psock->sendmsg_idx - 1 for the
 		 * req->internal.offset, so sendmsg_idx should not be zero */
@@ -835,6 +1149,18 @@ sock_complete_reqs(struct spdk_sock *_sock, ssize_t rc)
 	return 0;
 }
 
+static inline void
+_sock_sqe_set_file(struct io_uring_sqe *sqe, struct spdk_uring_sock *sock)
+{
+#ifdef SPDK_URING_FIXED_FILES
+	/* Spare the kernel the file descriptor lookup on every request */
+	if (sock->fixed_file) {
+		sqe->fd = sock->fixed_idx;
+		sqe->flags |= IOSQE_FIXED_FILE;
+	}
+#endif
+}
+
 #ifdef SPDK_ZEROCOPY
 static int
 _sock_check_zcopy(struct spdk_sock *_sock, int status)
@@ -913,6 +1239,7 @@ _sock_prep_recv(struct spdk_sock *_sock)
 
 	sqe = io_uring_get_sqe(&sock->group->uring);
 	io_uring_prep_recvmsg(sqe, sock->fd, &task->msg, MSG_ERRQUEUE);
+	_sock_sqe_set_file(sqe, sock);
 	io_uring_sqe_set_data(sqe, task);
 	task->status = SPDK_URING_SOCK_TASK_IN_PROCESS;
 }
@@ -946,6 +1273,7 @@ _sock_flush(struct spdk_sock *_sock)
 
 	sqe = io_uring_get_sqe(&sock->group->uring);
 	io_uring_prep_sendmsg(sqe, sock->fd, &sock->write_task.msg, flags);
+	_sock_sqe_set_file(sqe, sock);
 	io_uring_sqe_set_data(sqe, task);
 	task->status = SPDK_URING_SOCK_TASK_IN_PROCESS;
 }
@@ -967,6 +1295,7 @@ _sock_prep_pollin(struct spdk_sock *_sock)
 
 	sqe = io_uring_get_sqe(&sock->group->uring);
 	io_uring_prep_poll_add(sqe, sock->fd, POLLIN | POLLERR);
+	_sock_sqe_set_file(sqe, sock);
 	io_uring_sqe_set_data(sqe, task);
 	task->status = SPDK_URING_SOCK_TASK_IN_PROCESS;
 }
@@ -991,6 +1320,123 @@ _sock_prep_cancel_task(struct spdk_sock *_sock, void *user_data)
 	task->status = SPDK_URING_SOCK_TASK_IN_PROCESS;
 }
 
+#ifdef SPDK_URING_RECV_BUF_RING
+static void
+_sock_prep_read(struct spdk_sock *_sock)
+{
+	struct spdk_uring_sock *sock = __uring_sock(_sock);
+	struct spdk_uring_task *task = &sock->read_task;
+	struct io_uring_sqe *sqe;
+
+	assert(sock->group != NULL);
+
+	/* Do not re-arm the receive until buffers are returned to the ring */
+	if (task->status == SPDK_URING_SOCK_TASK_IN_PROCESS || sock->recv_closed ||
+	    sock->group->recv_bufs_avail == 0 ||
+	    sock->recv_bufs_held > uring_sock_recv_buf_sock_max(sock->group) / 2) {
+		return;
+	}
+
+	sock->group->io_queued++;
+
+	sqe = io_uring_get_sqe(&sock->group->uring);
+	io_uring_prep_recv_multishot(sqe, sock->fd, NULL, 0, 0);
+	_sock_sqe_set_file(sqe, sock);
+	sqe->flags |= IOSQE_BUFFER_SELECT;
+	sqe->buf_group = SPDK_URING_RECV_BUF_GROUP_ID;
+	io_uring_sqe_set_data(sqe, task);
+	task->status = SPDK_URING_SOCK_TASK_IN_PROCESS;
+}
+
+static void
+_sock_read_complete(struct spdk_uring_sock *sock, int status, uint32_t cqe_flags)
+{
+	struct spdk_uring_sock_group_impl *group = sock->group;
+	struct spdk_uring_recv_buf *buf;
+
+	if (spdk_likely(status > 0)) {
+		assert(cqe_flags & IORING_CQE_F_BUFFER);
+		buf = &group->recv_buf_descs[cqe_flags >> IORING_CQE_BUFFER_SHIFT];
+		buf->len = status;
+		buf->offset = 0;
+		STAILQ_INSERT_TAIL(&sock->recv_queue, buf, link);
+		group->recv_bufs_avail--;
+		sock->recv_bufs_held++;
+
+		/* The receive is still armed, stop it until the user catches up */
+		if (spdk_unlikely(sock->recv_bufs_held >= uring_sock_recv_buf_sock_max(sock->group)) &&
+		    sock->read_task.status == SPDK_URING_SOCK_TASK_IN_PROCESS) {
+			_sock_prep_cancel_task(&sock->base, &sock->read_task);
+		}
+	} else if (status == -ENOBUFS || status == -ECANCELED) {
+		/* The receive is re-armed once buffers are available, or was cancelled
+		 * because the socket holds too many buffers or is being removed from the
+		 * group. */
+		return;
+	} else if (status == -EINVAL) {
+		/* The kernel does not support multishot receive, poll the socket instead */
+		sock->recv_multishot = false;
+		return;
+	} else {
+		sock->recv_status = status;
+		sock->recv_closed = true;
+	}
+
+	if (sock->base.cb_fn != NULL && sock->pending_recv == false) {
+		sock->pending_recv = true;
+		TAILQ_INSERT_TAIL(&group->pending_recv, sock, link);
+	}
+}
+
+/* Move the data received into the group's buffers to the socket's pipe, so that
+ * the buffers can be returned when the socket leaves the group. */
+static void
+_sock_drain_recv_bufs(struct spdk_uring_sock *sock)
+{
+	struct spdk_uring_sock_group_impl *group = sock->group;
+	struct spdk_uring_recv_buf *buf;
+	struct iovec siov, diov[2];
+	int queued = 0, sz;
+	ssize_t bytes;
+	bool drop = false;
+
+	if (STAILQ_EMPTY(&sock->recv_queue)) {
+		return;
+	}
+
+	STAILQ_FOREACH(buf, &sock->recv_queue, link) {
+		queued += buf->len - buf->offset;
+	}
+
+	sz = queued;
+	if (sock->recv_pipe != NULL) {
+		sz += spdk_pipe_reader_bytes_available(sock->recv_pipe);
+	}
+	sz = spdk_max(sz, spdk_max(sock->recv_buf_sz, MIN_SOCK_PIPE_SIZE));
+
+	if (uring_sock_alloc_pipe(sock, sz) != 0) {
+		SPDK_ERRLOG("Dropping %d bytes received on sock %p\n", queued, sock);
+		sock->recv_status = -ENOMEM;
+		sock->recv_closed = true;
+		drop = true;
+	}
+
+	while ((buf = STAILQ_FIRST(&sock->recv_queue)) != NULL) {
+		if (!drop) {
+			siov.iov_base = uring_sock_recv_buf_addr(group, buf->bid) + buf->offset;
+			siov.iov_len = buf->len - buf->offset;
+			spdk_pipe_writer_get_buffer(sock->recv_pipe, siov.iov_len, diov);
+			bytes = spdk_iovcpy(&siov, 1, diov, 2);
+			assert(bytes == (ssize_t)siov.iov_len);
+			spdk_pipe_writer_advance(sock->recv_pipe, bytes);
+		}
+
+		STAILQ_REMOVE_HEAD(&sock->recv_queue, link);
+		uring_sock_recycle_recv_buf(sock, buf);
+	}
+}
+#endif
+
 static int
 sock_uring_group_reap(struct spdk_uring_sock_group_impl *group, int max, int max_read_events,
 		      struct spdk_sock **socks)
@@ -1000,6 +1446,9 @@ sock_uring_group_reap(struct spdk_uring_sock_group_impl *group, int max, int max
 	struct spdk_uring_sock *sock, *tmp;
 	struct spdk_uring_task *task;
 	int status;
+#ifdef SPDK_URING_RECV_BUF_RING
+	uint32_t cqe_flags;
+#endif
 
 	for (i = 0; i < max; i++) {
 		ret = io_uring_peek_cqe(&group->uring, &cqe);
@@ -1017,15 +1466,32 @@ sock_uring_group_reap(struct spdk_uring_sock_group_impl *group, int max, int max
 		assert(sock != NULL);
 		assert(sock->group != NULL);
 		assert(sock->group == group);
-		sock->group->io_inflight--;
-		sock->group->io_avail++;
 		status = cqe->res;
+#ifdef SPDK_URING_RECV_BUF_RING
+		cqe_flags = cqe->flags;
+#endif
 		io_uring_cqe_seen(&group->uring, cqe);
 
+#ifdef SPDK_URING_RECV_BUF_RING
+		/* A multishot receive stays in flight until a completion without F_MORE */
+		if (cqe_flags & IORING_CQE_F_MORE) {
+			assert(task->type == SPDK_SOCK_TASK_READ);
+			_sock_read_complete(sock, status, cqe_flags);
+			continue;
+		}
+#endif
+
+		sock->group->io_inflight--;
+		sock->group->io_avail++;
 		task->status = SPDK_URING_SOCK_TASK_NOT_IN_USE;
 
 		if (spdk_unlikely(status <= 0)) {
 			if (status == -EAGAIN || status == -EWOULDBLOCK || (status == -ENOBUFS && sock->zcopy)) {
+				if (task->type == SPDK_SOCK_TASK_WRITE) {
+					/* Gather again from the queue head on the next flush */
+					task->last_req = NULL;
+					task->iov_cnt = 0;
+				}
 				continue;
 			}
 		}
@@ -1068,6 +1534,11 @@ sock_uring_group_reap(struct spdk_uring_sock_group_impl *group, int max, int max
 		case SPDK_SOCK_TASK_CANCEL:
 			/* Do nothing */
 			break;
+#ifdef SPDK_URING_RECV_BUF_RING
+		case SPDK_SOCK_TASK_READ:
+			_sock_read_complete(sock, status, cqe_flags);
+			break;
+#endif
 		default:
 			SPDK_UNREACHABLE();
 		}
@@ -1082,8 +1553,7 @@ sock_uring_group_reap(struct spdk_uring_sock_group_impl *group, int max, int max
 			break;
 		}
 
-		if (spdk_unlikely(sock->base.cb_fn == NULL) ||
-		    (sock->recv_pipe == NULL || spdk_pipe_reader_bytes_available(sock->recv_pipe) == 0)) {
+		if (spdk_unlikely(sock->base.cb_fn == NULL) || !uring_sock_has_recv_data(sock)) {
 			sock->pending_recv = false;
 			TAILQ_REMOVE(&group->pending_recv, sock, link);
 			if (spdk_unlikely(sock->base.cb_fn == NULL)) {
@@ -1313,6 +1783,173 @@ uring_sock_group_impl_get_optimal(struct spdk_sock *_sock, struct spdk_sock_grou
 	return NULL;
 }
 
+#ifdef SPDK_URING_RECV_BUF_RING
+static void
+uring_sock_group_free_buf_ring(struct spdk_uring_sock_group_impl *group)
+{
+	free(group->buf_ring);
+	free(group->recv_bufs);
+	free(group->recv_buf_descs);
+	group->buf_ring = NULL;
+	group->recv_bufs = NULL;
+	group->recv_buf_descs = NULL;
+}
+
+static int
+uring_sock_group_init_buf_ring(struct spdk_uring_sock_group_impl *group)
+{
+	struct io_uring_buf_reg reg = {};
+	uint32_t i, count, size;
+	int rc;
+
+	count = g_spdk_uring_sock_impl_opts.recv_ring_buf_count;
+	size = g_spdk_uring_sock_impl_opts.recv_ring_buf_size;
+	assert(spdk_u32_is_pow2(count));
+
+	if (posix_memalign((void **)&group->buf_ring, 0x1000,
+			   count * sizeof(struct io_uring_buf)) != 0 ||
+	    posix_memalign((void **)&group->recv_bufs, 0x1000, (size_t)count * size) != 0) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	group->recv_buf_descs = calloc(count, sizeof(*group->recv_buf_descs));
+	if (group->recv_buf_descs == NULL) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	reg.ring_addr = (uintptr_t)group->buf_ring;
+	reg.ring_entries = count;
+	reg.bgid = SPDK_URING_RECV_BUF_GROUP_ID;
+
+	/* Fails on kernels without provided buffer rings */
+	rc = io_uring_register_buf_ring(&group->uring, &reg, 0);
+	if (rc != 0) {
+		goto err;
+	}
+
+	group->recv_buf_count = count;
+	group->recv_buf_size = size;
+	io_uring_buf_ring_init(group->buf_ring);
+	for (i = 0; i < count; i++) {
+		group->recv_buf_descs[i].bid = i;
+		io_uring_buf_ring_add(group->buf_ring, uring_sock_recv_buf_addr(group, i), size, i,
+				      io_uring_buf_ring_mask(count), i);
+	}
+	io_uring_buf_ring_advance(group->buf_ring, count);
+	group->recv_bufs_avail = count;
+
+	return 0;
+err:
+	uring_sock_group_free_buf_ring(group);
+	return rc;
+}
+#endif
+
+#ifdef SPDK_URING_FIXED_FILES
+static int
+uring_sock_group_init_fixed_files(struct spdk_uring_sock_group_impl *group)
+{
+	struct rlimit rlim;
+	uint32_t count = SPDK_URING_FIXED_FILES_MAX;
+	uint32_t i;
+	int rc;
+
+	/* The kernel refuses tables larger than the open files limit */
+	if (getrlimit(RLIMIT_NOFILE, &rlim) == 0 && rlim.rlim_cur < count) {
+		count = rlim.rlim_cur;
+	}
+
+	if (count == 0) {
+		return -ENOSPC;
+	}
+
+	group->fixed_free = calloc(count, sizeof(*group->fixed_free));
+	if (group->fixed_free == NULL) {
+		return -ENOMEM;
+	}
+
+	/* Fails on kernels without sparse file tables */
+	rc = io_uring_register_files_sparse(&group->uring, count);
+	if (rc != 0) {
+		free(group->fixed_free);
+		group->fixed_free = NULL;
+		return rc;
+	}
+
+	/* Hand out the lowest slots first */
+	for (i = 0; i < count; i++) {
+		group->fixed_free[i] = count - i - 1;
+	}
+	group->fixed_free_count = count;
+	group->fixed_count = count;
+
+	return 0;
+}
+
+static void
+uring_sock_group_fini_fixed_files(struct spdk_uring_sock_group_impl *group)
+{
+	if (group->fixed_free == NULL) {
+		return;
+	}
+
+	assert(group->fixed_free_count == group->fixed_count);
+	io_uring_unregister_files(&group->uring);
+	free(group->fixed_free);
+	group->fixed_free = NULL;
+	group->fixed_free_count = 0;
+	group->fixed_count = 0;
+}
+
+static void
+uring_sock_add_fixed_file(struct spdk_uring_sock_group_impl *group, struct spdk_uring_sock *sock)
+{
+	uint32_t idx;
+	int rc;
+
+	assert(!sock->fixed_file);
+	if (group->fixed_free_count == 0) {
+		/* Table is full or unavailable, keep using the plain descriptor */
+		return;
+	}
+
+	idx = group->fixed_free[group->fixed_free_count - 1];
+	rc = io_uring_register_files_update(&group->uring, idx, &sock->fd, 1);
+	if (rc != 1) {
+		SPDK_WARNLOG("Failed to register fd %d as fixed file: %d\n", sock->fd, rc);
+		return;
+	}
+
+	group->fixed_free_count--;
+	sock->fixed_idx = idx;
+	sock->fixed_file = true;
+}
+
+static void
+uring_sock_remove_fixed_file(struct spdk_uring_sock_group_impl *group, struct spdk_uring_sock *sock)
+{
+	int fd = -1;
+	int rc;
+
+	if (!sock->fixed_file) {
+		return;
+	}
+
+	/* The table holds its own reference to the file, so drop it before the socket is
+	 * closed or moved to another group */
+	rc = io_uring_register_files_update(&group->uring, sock->fixed_idx, &fd, 1);
+	if (rc != 1) {
+		SPDK_ERRLOG("Failed to unregister fixed file %u: %d\n", sock->fixed_idx, rc);
+	}
+
+	assert(group->fixed_free_count < group->fixed_count);
+	group->fixed_free[group->fixed_free_count++] = sock->fixed_idx;
+	sock->fixed_file = false;
+}
+#endif
+
 static struct spdk_sock_group_impl *
 uring_sock_group_impl_create(void)
 {
@@ -1334,6 +1971,20 @@ uring_sock_group_impl_create(void)
 
 	TAILQ_INIT(&group_impl->pending_recv);
 
+#ifdef SPDK_URING_RECV_BUF_RING
+	if (g_spdk_uring_sock_impl_opts.recv_ring_buf_count != 0 &&
+	    uring_sock_group_init_buf_ring(group_impl) != 0) {
+		SPDK_NOTICELOG("Provided buffer ring unavailable, sockets of the group will be polled\n");
+	}
+#endif
+
+#ifdef SPDK_URING_FIXED_FILES
+	if (uring_sock_group_init_fixed_files(group_impl) != 0) {
+		SPDK_NOTICELOG("Registered file table unavailable, sockets of the group will be "
+			       "referenced by descriptor\n");
+	}
+#endif
+
 	if (g_spdk_uring_sock_impl_opts.enable_placement_id == PLACEMENT_CPU) {
 		spdk_sock_map_insert(&g_map, spdk_env_get_current_core(), &group_impl->base);
 	}
@@ -1364,6 +2015,21 @@ uring_sock_group_impl_add_sock(struct spdk_sock_group_impl *_group,
 	sock->cancel_task.sock = sock;
 	sock->cancel_task.type = SPDK_SOCK_TASK_CANCEL;
 
+	sock->read_task.sock = sock;
+	sock->read_task.type = SPDK_SOCK_TASK_READ;
+
+#ifdef SPDK_URING_RECV_BUF_RING
+	/* Receive straight into the group's buffers instead of polling for POLLIN and
+	 * then reading into the socket's pipe. Zero-copy sockets keep polling, since
+	 * the poll also reports their error queue notifications. */
+	sock->recv_multishot = group->buf_ring != NULL && !sock->zcopy &&
+			       g_spdk_uring_sock_impl_opts.enable_recv_pipe;
+#endif
+
+#ifdef SPDK_URING_FIXED_FILES
+	uring_sock_add_fixed_file(group, sock);
+#endif
+
 	/* switched from another polling group due to scheduling */
 	if (spdk_unlikely(sock->recv_pipe != NULL &&
 			  (spdk_pipe_reader_bytes_available(sock->recv_pipe) > 0))) {
@@ -1400,6 +2066,12 @@ uring_sock_group_impl_poll(struct spdk_sock_group_impl *_group, int max_events,
 				continue;
 			}
 			_sock_flush(_sock);
+#ifdef SPDK_URING_RECV_BUF_RING
+			if (sock->recv_multishot) {
+				_sock_prep_read(_sock);
+				continue;
+			}
+#endif
 			_sock_prep_pollin(_sock);
 		}
 	}
@@ -1421,6 +2093,12 @@ uring_sock_group_impl_poll(struct spdk_sock_group_impl *_group, int max_events,
 
 	count = 0;
 	to_complete = group->io_inflight;
+#ifdef SPDK_URING_RECV_BUF_RING
+	/* A multishot receive may post several completions */
+	if (to_complete > 0 && group->buf_ring != NULL) {
+		to_complete = SPDK_SOCK_GROUP_QUEUE_DEPTH;
+	}
+#endif
 	if (to_complete > 0 || !TAILQ_EMPTY(&group->pending_recv)) {
 		count = sock_uring_group_reap(group, to_complete, max_events, socks);
 	}
@@ -1435,6 +2113,11 @@ uring_sock_group_impl_remove_sock(struct spdk_sock_group_impl *_group,
 	struct spdk_uring_sock *sock = __uring_sock(_sock);
 	struct spdk_uring_sock_group_impl *group = __uring_group_impl(_group);
 
+	/* The receive may be being stopped, only one cancel can be in flight */
+	while (sock->cancel_task.status != SPDK_URING_SOCK_TASK_NOT_IN_USE) {
+		uring_sock_group_impl_poll(_group, 32, NULL);
+	}
+
 	if (sock->write_task.status != SPDK_URING_SOCK_TASK_NOT_IN_USE) {
 		_sock_prep_cancel_task(_sock, &sock->write_task);
 		/* Since spdk_sock_group_remove_sock is not asynchronous interface, so
@@ -1465,10 +2148,31 @@ uring_sock_group_impl_remove_sock(struct spdk_sock_group_impl *_group,
 		}
 	}
 
+	if (sock->read_task.status != SPDK_URING_SOCK_TASK_NOT_IN_USE) {
+		_sock_prep_cancel_task(_sock, &sock->read_task);
+		/* Since spdk_sock_group_remove_sock is not asynchronous interface, so
+		 * currently can use a while loop here. */
+		while ((sock->read_task.status != SPDK_URING_SOCK_TASK_NOT_IN_USE) ||
+		       (sock->cancel_task.status != SPDK_URING_SOCK_TASK_NOT_IN_USE)) {
+			uring_sock_group_impl_poll(_group, 32, NULL);
+		}
+	}
+
 	/* Make sure the cancelling the tasks above didn't cause sending new requests */
 	assert(sock->write_task.status == SPDK_URING_SOCK_TASK_NOT_IN_USE);
 	assert(sock->pollin_task.status == SPDK_URING_SOCK_TASK_NOT_IN_USE);
 	assert(sock->recv_task.status == SPDK_URING_SOCK_TASK_NOT_IN_USE);
+	assert(sock->read_task.status == SPDK_URING_SOCK_TASK_NOT_IN_USE);
+
+#ifdef SPDK_URING_RECV_BUF_RING
+	_sock_drain_recv_bufs(sock);
+	sock->recv_multishot = false;
+#endif
+
+#ifdef SPDK_URING_FIXED_FILES
+	/* No request references the slot anymore */
+	uring_sock_remove_fixed_file(group, sock);
+#endif
 
 	if (sock->pending_recv) {
 		TAILQ_REMOVE(&group->pending_recv, sock, link);
@@ -1496,6 +2200,18 @@ uring_sock_group_impl_close(struct spdk_sock_group_impl *_group)
 	assert(group->io_inflight == 0);
 	assert(group->io_avail == SPDK_SOCK_GROUP_QUEUE_DEPTH);
 
+#ifdef SPDK_URING_RECV_BUF_RING
+	if (group->buf_ring != NULL) {
+		assert(group->recv_bufs_avail == group->recv_buf_count);
+		io_uring_unregister_buf_ring(&group->uring, SPDK_URING_RECV_BUF_GROUP_ID);
+		uring_sock_group_free_buf_ring(group);
+	}
+#endif
+
+#ifdef SPDK_URING_FIXED_FILES
+	uring_sock_group_fini_fixed_files(group);
+#endif
+
 	io_uring_queue_exit(&group->uring);
 
 	if (g_spdk_uring_sock_impl_opts.enable_placement_id == PLACEMENT_CPU) {
@@ -1530,6 +2246,10 @@ uring_sock_impl_get_opts(struct spdk_sock_impl_opts *opts, size_t *len)
 	GET_FIELD(enable_placement_id);
 	GET_FIELD(enable_zerocopy_send_server);
 	GET_FIELD(enable_zerocopy_send_client);
+	GET_FIELD(send_rate_limit);
+	GET_FIELD(send_burst_size);
+	GET_FIELD(recv_ring_buf_count);
+	GET_FIELD(recv_ring_buf_size);
 
 #undef GET_FIELD
 #undef FIELD_OK
@@ -1554,6 +2274,22 @@ uring_sock_impl_set_opts(const struct spdk_sock_impl_opts *opts, size_t len)
 		g_spdk_uring_sock_impl_opts.field = opts->field; \
 	}
 
+	if (FIELD_OK(recv_ring_buf_count) && opts->recv_ring_buf_count != 0 &&
+	    (!spdk_u32_is_pow2(opts->recv_ring_buf_count) ||
+	     opts->recv_ring_buf_count < SPDK_URING_RECV_BUF_COUNT_MIN ||
+	     opts->recv_ring_buf_count > SPDK_URING_RECV_BUF_COUNT_MAX)) {
+		SPDK_ERRLOG("recv_ring_buf_count must be 0 or a power of 2 between %d and %d\n",
+			    SPDK_URING_RECV_BUF_COUNT_MIN, SPDK_URING_RECV_BUF_COUNT_MAX);
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (FIELD_OK(recv_ring_buf_size) && opts->recv_ring_buf_size == 0) {
+		SPDK_ERRLOG("recv_ring_buf_size must not be 0\n");
+		errno = EINVAL;
+		return -1;
+	}
+
 	SET_FIELD(recv_buf_size);
 	SET_FIELD(send_buf_size);
 	SET_FIELD(enable_recv_pipe);
@@ -1561,6 +2297,10 @@ uring_sock_impl_set_opts(const struct spdk_sock_impl_opts *opts, size_t len)
 	SET_FIELD(enable_placement_id);
 	SET_FIELD(enable_zerocopy_send_server);
 	SET_FIELD(enable_zerocopy_send_client);
+	SET_FIELD(send_rate_limit);
+	SET_FIELD(send_burst_size);
+	SET_FIELD(recv_ring_buf_count);
+	SET_FIELD(recv_ring_buf_size);
 
 #undef SET_FIELD
 #undef FIELD_OK
@@ -1589,12 +2329,15 @@ static struct spdk_net_impl g_uring_net_impl = {
 	.close		= uring_sock_close,
 	.recv		= uring_sock_recv,
 	.readv		= uring_sock_readv,
+	.recv_lend	= uring_sock_recv_lend,
+	.recv_return	= uring_sock_recv_return,
 	.writev		= uring_sock_writev,
 	.writev_async	= uring_sock_writev_async,
 	.flush          = uring_sock_flush,
 	.set_recvlowat	= uring_sock_set_recvlowat,
 	.set_recvbuf	= uring_sock_set_recvbuf,
 	.set_sendbuf	= uring_sock_set_sendbuf,
+	.set_pacing_rate = uring_sock_set_pacing_rate,
 	.is_ipv6	= uring_sock_is_ipv6,
 	.is_ipv4	= uring_sock_is_ipv4,
 	.is_connected   = uring_sock_is_connected,
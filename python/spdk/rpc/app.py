@@ -28,6 +28,39 @@ def framework_monitor_context_switch(client, enabled=None):
     return client.call('framework_monitor_context_switch', params)
 
 
+def framework_work_stealing(client, enabled=None):
+    """Query or set state of work stealing between reactors.
+
+    Args:
+        enabled: True to enable work stealing; False to disable it; None to query (optional)
+
+    Returns:
+        Current work stealing state (after applying enabled flag).
+    """
+    params = {}
+    if enabled is not None:
+        params['enabled'] = enabled
+    return client.call('framework_work_stealing', params)
+
+
+def framework_hybrid_mode(client, idle_threshold=None, wakeup_threshold=None):
+    """Query or configure automatic switching of reactors between poll and interrupt mode.
+
+    Args:
+        idle_threshold: Idle time in microseconds before a reactor switches to interrupt mode, 0 to disable (optional)
+        wakeup_threshold: Number of wakeups within idle_threshold to switch back to poll mode (optional)
+
+    Returns:
+        Current hybrid mode configuration.
+    """
+    params = {}
+    if idle_threshold is not None:
+        params['idle_threshold'] = idle_threshold
+    if wakeup_threshold is not None:
+        params['wakeup_threshold'] = wakeup_threshold
+    return client.call('framework_hybrid_mode', params)
+
+
 def framework_get_reactors(client):
     """Query list of all reactors.
 
@@ -37,13 +70,43 @@ def framework_get_reactors(client):
     return client.call('framework_get_reactors')
 
 
+def framework_msg_latency_tracking(client, enabled=None):
+    """Query or set state of message and event queueing latency tracking.
+
+    Args:
+        enabled: True to enable (and reset) tracking; False to disable it; None to query (optional)
+
+    Returns:
+        Current tracking state (after applying enabled flag).
+    """
+    params = {}
+    if enabled is not None:
+        params['enabled'] = enabled
+    return client.call('framework_msg_latency_tracking', params)
+
+
+def framework_get_event_latency(client):
+    """Query queueing latency of events received by each reactor.
+
+    Returns:
+        Event latency statistics of all reactors.
+    """
+    return client.call('framework_get_event_latency')
+
+
 def framework_set_scheduler(client, name, period=None, load_limit=None, core_limit=None,
-                            core_busy=None):
+                            core_busy=None, ewma_weight=None, hysteresis=None, cooldown=None,
+                            power_aware=None, latency_slo=None):
     """Select threads scheduler that will be activated and its period.
 
     Args:
         name: Name of a scheduler
         period: Scheduler period in microseconds
+        ewma_weight: Weight in % of the last period in the predicted thread load (dynamic only)
+        hysteresis: Width in % of the band around load_limit (dynamic only)
+        cooldown: Number of periods a thread is not moved after a migration (dynamic only)
+        power_aware: Lower the frequency of unused cores and boost the busy ones (dynamic only)
+        latency_slo: Maximum idle state exit latency in microseconds for cores running threads (dynamic only)
     Returns:
         True or False
     """
@@ -56,6 +119,16 @@ def framework_set_scheduler(client, name, period=None, load_limit=None, core_lim
         params['core_limit'] = core_limit
     if core_busy is not None:
         params['core_busy'] = core_busy
+    if ewma_weight is not None:
+        params['ewma_weight'] = ewma_weight
+    if hysteresis is not None:
+        params['hysteresis'] = hysteresis
+    if cooldown is not None:
+        params['cooldown'] = cooldown
+    if power_aware is not None:
+        params['power_aware'] = power_aware
+    if latency_slo is not None:
+        params['latency_slo'] = latency_slo
     return client.call('framework_set_scheduler', params)
 
 
@@ -120,3 +193,12 @@ def thread_get_io_channels(client):
         Current IO channels.
     """
     return client.call('thread_get_io_channels')
+
+
+def thread_get_msg_latency(client):
+    """Query queueing latency of messages received by each thread.
+
+    Returns:
+        Message latency statistics of all threads.
+    """
+    return client.call('thread_get_msg_latency')
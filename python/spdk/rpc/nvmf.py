@@ -122,6 +122,8 @@ def nvmf_create_transport(client, **params):
         disable_mappable_bar0: disable client mmap() of BAR0 - VFIO-USER specific (optional)
         disable_adaptive_irq: Disable adaptive interrupt feature - VFIO-USER specific (optional)
         disable_shadow_doorbells: disable shadow doorbell support - VFIO-USER specific (optional)
+        disable_lazy_mem_register: register guest memory in full when it is mapped - VFIO-USER specific (optional)
+        cmb_size: size of the emulated controller memory buffer in bytes - VFIO-USER specific (optional)
         acceptor_poll_rate: Acceptor poll period in microseconds (optional)
     Returns:
         True or False
@@ -248,6 +250,7 @@ def nvmf_subsystem_add_listener(client, **params):
         trsvcid: Transport service ID (required for RDMA or TCP).
         tgt_name: name of the parent NVMe-oF target (optional).
         adrfam: Address family ("IPv4", "IPv6", "IB", or "FC").
+        secure_channel: Require a TLS secure channel, TCP only (optional).
 
     Returns:
         True or False
@@ -484,6 +487,83 @@ def nvmf_subsystem_allow_any_host(client, nqn, disable, tgt_name=None):
     return client.call('nvmf_subsystem_allow_any_host', params)
 
 
+def nvmf_subsystem_set_qos_limits(client, nqn, host=None, nsid=None, rw_ios_per_sec=None,
+                                  rw_mbytes_per_sec=None, max_queue_depth=None, tgt_name=None):
+    """Set, replace or remove a QoS policy on a subsystem.
+
+    Args:
+        nqn: Subsystem NQN.
+        host: Host NQN the policy applies to (optional; default: any host).
+        nsid: Namespace ID the policy applies to (optional; default: all namespaces).
+        rw_ios_per_sec: Read/write I/Os per second limit, 0 for unlimited (optional).
+        rw_mbytes_per_sec: Read/write megabytes per second limit, 0 for unlimited (optional).
+        max_queue_depth: Maximum outstanding I/Os, 0 for unlimited (optional).
+        tgt_name: name of the parent NVMe-oF target (optional).
+
+    Returns:
+        True or False
+    """
+    params = {'nqn': nqn}
+
+    if host:
+        params['host'] = host
+    if nsid:
+        params['nsid'] = nsid
+    if rw_ios_per_sec is not None:
+        params['rw_ios_per_sec'] = rw_ios_per_sec
+    if rw_mbytes_per_sec is not None:
+        params['rw_mbytes_per_sec'] = rw_mbytes_per_sec
+    if max_queue_depth is not None:
+        params['max_queue_depth'] = max_queue_depth
+    if tgt_name:
+        params['tgt_name'] = tgt_name
+
+    return client.call('nvmf_subsystem_set_qos_limits', params)
+
+
+def nvmf_subsystem_enable_histogram(client, nqn, enable, tgt_name=None):
+    """Enable or disable I/O latency histograms on a subsystem.
+
+    Args:
+        nqn: Subsystem NQN.
+        enable: Enable (true) or disable (false) the histograms.
+        tgt_name: name of the parent NVMe-oF target (optional).
+
+    Returns:
+        True or False
+    """
+    params = {'nqn': nqn, 'enable': enable}
+
+    if tgt_name:
+        params['tgt_name'] = tgt_name
+
+    return client.call('nvmf_subsystem_enable_histogram', params)
+
+
+def nvmf_subsystem_get_histogram(client, nqn, cntlid=None, qid=None, tgt_name=None):
+    """Get I/O latency histograms of a subsystem, controller or queue pair.
+
+    Args:
+        nqn: Subsystem NQN.
+        cntlid: Controller ID to aggregate (optional; default: all controllers).
+        qid: Queue pair ID of the controller to aggregate (optional; default: all queue pairs).
+        tgt_name: name of the parent NVMe-oF target (optional).
+
+    Returns:
+        Queue, backend, response and total latency histograms.
+    """
+    params = {'nqn': nqn}
+
+    if cntlid is not None:
+        params['cntlid'] = cntlid
+    if qid is not None:
+        params['qid'] = qid
+    if tgt_name:
+        params['tgt_name'] = tgt_name
+
+    return client.call('nvmf_subsystem_get_histogram', params)
+
+
 @deprecated_alias('delete_nvmf_subsystem')
 def nvmf_delete_subsystem(client, nqn, tgt_name=None):
     """Delete an existing NVMe-oF subsystem.
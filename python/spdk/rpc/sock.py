@@ -19,7 +19,15 @@ def sock_impl_set_options(client,
                           enable_quickack=None,
                           enable_placement_id=None,
                           enable_zerocopy_send_server=None,
-                          enable_zerocopy_send_client=None):
+                          enable_zerocopy_send_client=None,
+                          enable_ktls=None,
+                          psk_key=None,
+                          psk_identity=None,
+                          send_rate_limit=None,
+                          send_burst_size=None,
+                          busy_poll_usecs=None,
+                          recv_ring_buf_count=None,
+                          recv_ring_buf_size=None):
     """Set parameters for the socket layer implementation.
 
     Args:
@@ -31,6 +39,14 @@ def sock_impl_set_options(client,
         enable_placement_id: option for placement_id. 0:disable,1:incoming_napi,2:incoming_cpu (optional)
         enable_zerocopy_send_server: enable or disable zerocopy on send for server sockets(optional)
         enable_zerocopy_send_client: enable or disable zerocopy on send for client sockets(optional)
+        enable_ktls: enable or disable Kernel TLS offload after the handshake, ssl only (optional)
+        psk_key: TLS pre-shared key as a hex string, ssl only (optional)
+        psk_identity: TLS pre-shared key identity, ssl only (optional)
+        send_rate_limit: maximum send rate of each socket in bytes per second, 0 for unlimited (optional)
+        send_burst_size: bytes a rate limited socket may send back to back, 0 for 10 ms worth (optional)
+        busy_poll_usecs: time in microseconds a sock group busy polls its NAPI context, 0 to disable (optional)
+        recv_ring_buf_count: number of buffers in the receive buffer ring of each sock group, 0 to disable, uring only (optional)
+        recv_ring_buf_size: size of each buffer in the receive buffer ring, uring only (optional)
     """
     params = {}
 
@@ -49,6 +65,22 @@ def sock_impl_set_options(client,
         params['enable_zerocopy_send_server'] = enable_zerocopy_send_server
     if enable_zerocopy_send_client is not None:
         params['enable_zerocopy_send_client'] = enable_zerocopy_send_client
+    if enable_ktls is not None:
+        params['enable_ktls'] = enable_ktls
+    if psk_key is not None:
+        params['psk_key'] = psk_key
+    if psk_identity is not None:
+        params['psk_identity'] = psk_identity
+    if send_rate_limit is not None:
+        params['send_rate_limit'] = send_rate_limit
+    if send_burst_size is not None:
+        params['send_burst_size'] = send_burst_size
+    if busy_poll_usecs is not None:
+        params['busy_poll_usecs'] = busy_poll_usecs
+    if recv_ring_buf_count is not None:
+        params['recv_ring_buf_count'] = recv_ring_buf_count
+    if recv_ring_buf_size is not None:
+        params['recv_ring_buf_size'] = recv_ring_buf_size
 
     return client.call('sock_impl_set_options', params)
 
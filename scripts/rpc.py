@@ -153,6 +153,33 @@ if __name__ == "__main__":
     p.add_argument('-d', '--disable', action='store_true', help='Disable context switch monitoring')
     p.set_defaults(func=framework_monitor_context_switch)
 
+    def framework_work_stealing(args):
+        enabled = None
+        if args.enable:
+            enabled = True
+        if args.disable:
+            enabled = False
+        print_dict(rpc.app.framework_work_stealing(args.client, enabled=enabled))
+
+    p = subparsers.add_parser('framework_work_stealing',
+                              help='Control whether idle reactors may run threads of busy reactors')
+    p.add_argument('-e', '--enable', action='store_true', help='Enable work stealing')
+    p.add_argument('-d', '--disable', action='store_true', help='Disable work stealing')
+    p.set_defaults(func=framework_work_stealing)
+
+    def framework_hybrid_mode(args):
+        print_dict(rpc.app.framework_hybrid_mode(args.client,
+                                                 idle_threshold=args.idle_threshold,
+                                                 wakeup_threshold=args.wakeup_threshold))
+
+    p = subparsers.add_parser('framework_hybrid_mode',
+                              help='Query or configure automatic switching of reactors between poll and interrupt mode')
+    p.add_argument('-i', '--idle-threshold', type=int,
+                   help='Idle time in microseconds before a reactor switches to interrupt mode, 0 disables hybrid mode')
+    p.add_argument('-w', '--wakeup-threshold', type=int,
+                   help='Number of wakeups within the idle threshold to switch back to poll mode')
+    p.set_defaults(func=framework_hybrid_mode)
+
     def framework_get_reactors(args):
         print_dict(rpc.app.framework_get_reactors(args.client))
 
@@ -160,13 +187,39 @@ if __name__ == "__main__":
         'framework_get_reactors', help='Display list of all reactors')
     p.set_defaults(func=framework_get_reactors)
 
+    def framework_msg_latency_tracking(args):
+        enabled = None
+        if args.enable:
+            enabled = True
+        if args.disable:
+            enabled = False
+        print_dict(rpc.app.framework_msg_latency_tracking(args.client, enabled=enabled))
+
+    p = subparsers.add_parser('framework_msg_latency_tracking',
+                              help='Control tracking of the time messages and events wait in queues')
+    p.add_argument('-e', '--enable', action='store_true', help='Enable tracking and reset the statistics')
+    p.add_argument('-d', '--disable', action='store_true', help='Disable tracking')
+    p.set_defaults(func=framework_msg_latency_tracking)
+
+    def framework_get_event_latency(args):
+        print_dict(rpc.app.framework_get_event_latency(args.client))
+
+    p = subparsers.add_parser(
+        'framework_get_event_latency', help='Display queueing latency of events received by each reactor')
+    p.set_defaults(func=framework_get_event_latency)
+
     def framework_set_scheduler(args):
         rpc.app.framework_set_scheduler(args.client,
                                         name=args.name,
                                         period=args.period,
                                         load_limit=args.load_limit,
                                         core_limit=args.core_limit,
-                                        core_busy=args.core_busy)
+                                        core_busy=args.core_busy,
+                                        ewma_weight=args.ewma_weight,
+                                        hysteresis=args.hysteresis,
+                                        cooldown=args.cooldown,
+                                        power_aware=args.power_aware,
+                                        latency_slo=args.latency_slo)
 
     p = subparsers.add_parser(
         'framework_set_scheduler', help='Select thread scheduler that will be activated and its period (experimental)')
@@ -175,6 +228,16 @@ if __name__ == "__main__":
     p.add_argument('--load-limit', help="Scheduler load limit. Reserved for dynamic scheduler", type=int, required=False)
     p.add_argument('--core-limit', help="Scheduler core limit. Reserved for dynamic scheduler", type=int, required=False)
     p.add_argument('--core-busy', help="Scheduler core busy limit. Reserved for dynamic schedler", type=int, required=False)
+    p.add_argument('--ewma-weight', help="Weight in %% of the last period in the predicted thread load. Reserved for dynamic scheduler",
+                   type=int, required=False)
+    p.add_argument('--hysteresis', help="Width in %% of the band around the load limit. Reserved for dynamic scheduler",
+                   type=int, required=False)
+    p.add_argument('--cooldown', help="Periods a thread is not moved after a migration. Reserved for dynamic scheduler",
+                   type=int, required=False)
+    p.add_argument('--power-aware', help="Lower the frequency of unused cores and boost the busy ones. Reserved for dynamic scheduler",
+                   action='store_true', default=None)
+    p.add_argument('--latency-slo', help="Maximum idle state exit latency in microseconds for cores running threads. Reserved for dynamic scheduler",
+                   type=int, required=False)
     p.set_defaults(func=framework_set_scheduler)
 
     def framework_get_scheduler(args):
@@ -2149,6 +2212,10 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     Relevant only for VFIO-USER transport""")
     p.add_argument('-S', '--disable-shadow-doorbells', action='store_true', help="""Disable shadow doorbell support.
     Relevant only for VFIO-USER transport""")
+    p.add_argument('--disable-lazy-mem-register', action='store_true', help="""Register guest memory in full when
+    it is mapped instead of on first use. Relevant only for VFIO-USER transport""")
+    p.add_argument('--cmb-size', help="""Size of the emulated controller memory buffer in bytes.
+    Relevant only for VFIO-USER transport""", type=int)
     p.add_argument('--acceptor-poll-rate', help='Polling interval of the acceptor for incoming connections (usec)', type=int)
     p.set_defaults(func=nvmf_create_transport)
 
@@ -2222,7 +2289,9 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-p', '--tgt-name', help='The name of the parent NVMe-oF target (optional)', type=str)
     p.add_argument('-f', '--adrfam', help='NVMe-oF transport adrfam: e.g., ipv4, ipv6, ib, fc, intra_host')
     p.add_argument('-s', '--trsvcid', help='NVMe-oF transport service id: e.g., a port number (required for RDMA or TCP)')
-    p.set_defaults(func=nvmf_subsystem_add_listener)
+    p.add_argument('--secure-channel', help='Require a TLS secure channel, uses the ssl socket implementation (TCP only)',
+                   action='store_true')
+    p.set_defaults(func=nvmf_subsystem_add_listener, secure_channel=None)
 
     def nvmf_subsystem_remove_listener(args):
         rpc.nvmf.nvmf_subsystem_remove_listener(args.client,
@@ -2337,6 +2406,57 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-t', '--tgt-name', help='The name of the parent NVMe-oF target (optional)', type=str)
     p.set_defaults(func=nvmf_subsystem_allow_any_host)
 
+    def nvmf_subsystem_set_qos_limits(args):
+        rpc.nvmf.nvmf_subsystem_set_qos_limits(args.client,
+                                               nqn=args.nqn,
+                                               host=args.host,
+                                               nsid=args.nsid,
+                                               rw_ios_per_sec=args.rw_ios_per_sec,
+                                               rw_mbytes_per_sec=args.rw_mbytes_per_sec,
+                                               max_queue_depth=args.max_queue_depth,
+                                               tgt_name=args.tgt_name)
+
+    p = subparsers.add_parser('nvmf_subsystem_set_qos_limits',
+                              help="""Set QoS limits for a host and/or namespace of a subsystem.
+    All limits set to 0 remove the policy.""")
+    p.add_argument('nqn', help='NVMe-oF subsystem NQN')
+    p.add_argument('-H', '--host', help='Host NQN the limits apply to (default: any host)')
+    p.add_argument('-n', '--nsid', help='Namespace ID the limits apply to (default: all namespaces)', type=int)
+    p.add_argument('--rw-ios-per-sec', help='R/W IOs per second limit (0 for unlimited)', type=int)
+    p.add_argument('--rw-mbytes-per-sec', help='R/W megabytes per second limit (0 for unlimited)', type=int)
+    p.add_argument('--max-queue-depth', help='Maximum outstanding I/Os (0 for unlimited)', type=int)
+    p.add_argument('-t', '--tgt-name', help='The name of the parent NVMe-oF target (optional)', type=str)
+    p.set_defaults(func=nvmf_subsystem_set_qos_limits)
+
+    def nvmf_subsystem_enable_histogram(args):
+        rpc.nvmf.nvmf_subsystem_enable_histogram(args.client,
+                                                 nqn=args.nqn,
+                                                 enable=args.enable,
+                                                 tgt_name=args.tgt_name)
+
+    p = subparsers.add_parser('nvmf_subsystem_enable_histogram',
+                              help='Enable or disable I/O latency histograms on a subsystem')
+    p.add_argument('nqn', help='NVMe-oF subsystem NQN')
+    p.add_argument('-e', '--enable', default=True, dest='enable', action='store_true', help='Enable histograms')
+    p.add_argument('-d', '--disable', dest='enable', action='store_false', help='Disable histograms')
+    p.add_argument('-t', '--tgt-name', help='The name of the parent NVMe-oF target (optional)', type=str)
+    p.set_defaults(func=nvmf_subsystem_enable_histogram)
+
+    def nvmf_subsystem_get_histogram(args):
+        print_dict(rpc.nvmf.nvmf_subsystem_get_histogram(args.client,
+                                                         nqn=args.nqn,
+                                                         cntlid=args.cntlid,
+                                                         qid=args.qid,
+                                                         tgt_name=args.tgt_name))
+
+    p = subparsers.add_parser('nvmf_subsystem_get_histogram',
+                              help='Get I/O latency histograms of a subsystem, controller or queue pair')
+    p.add_argument('nqn', help='NVMe-oF subsystem NQN')
+    p.add_argument('-c', '--cntlid', help='Controller ID (default: all controllers)', type=int)
+    p.add_argument('-q', '--qid', help='Queue pair ID of the controller (default: all queue pairs)', type=int)
+    p.add_argument('-t', '--tgt-name', help='The name of the parent NVMe-oF target (optional)', type=str)
+    p.set_defaults(func=nvmf_subsystem_get_histogram)
+
     def nvmf_subsystem_get_controllers(args):
         print_dict(rpc.nvmf.nvmf_subsystem_get_controllers(args.client,
                                                            nqn=args.nqn,
@@ -2775,6 +2895,13 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
         'thread_get_io_channels', help='Display current IO channels of all the threads')
     p.set_defaults(func=thread_get_io_channels)
 
+    def thread_get_msg_latency(args):
+        print_dict(rpc.app.thread_get_msg_latency(args.client))
+
+    p = subparsers.add_parser(
+        'thread_get_msg_latency', help='Display queueing latency of messages received by each thread')
+    p.set_defaults(func=thread_get_msg_latency)
+
     def env_dpdk_get_mem_stats(args):
         print_dict(rpc.env_dpdk.env_dpdk_get_mem_stats(args.client))
 
@@ -2838,7 +2965,15 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                        enable_quickack=args.enable_quickack,
                                        enable_placement_id=args.enable_placement_id,
                                        enable_zerocopy_send_server=args.enable_zerocopy_send_server,
-                                       enable_zerocopy_send_client=args.enable_zerocopy_send_client)
+                                       enable_zerocopy_send_client=args.enable_zerocopy_send_client,
+                                       enable_ktls=args.enable_ktls,
+                                       psk_key=args.psk_key,
+                                       psk_identity=args.psk_identity,
+                                       send_rate_limit=args.send_rate_limit,
+                                       send_burst_size=args.send_burst_size,
+                                       busy_poll_usecs=args.busy_poll_usecs,
+                                       recv_ring_buf_count=args.recv_ring_buf_count,
+                                       recv_ring_buf_size=args.recv_ring_buf_size)
 
     p = subparsers.add_parser('sock_impl_set_options', help="""Set options of socket layer implementation""")
     p.add_argument('-i', '--impl', help='Socket implementation name, e.g. posix', required=True)
@@ -2861,8 +2996,25 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                    action='store_true', dest='enable_zerocopy_send_client')
     p.add_argument('--disable-zerocopy-send-client', help='Disable zerocopy on send for client sockets',
                    action='store_false', dest='enable_zerocopy_send_client')
+    p.add_argument('--enable-ktls', help='Enable Kernel TLS offload after the handshake (ssl only)',
+                   action='store_true', dest='enable_ktls')
+    p.add_argument('--disable-ktls', help='Disable Kernel TLS offload (ssl only)',
+                   action='store_false', dest='enable_ktls')
+    p.add_argument('--psk-key', help='TLS pre-shared key as a hex string (ssl only)')
+    p.add_argument('--psk-identity', help='TLS pre-shared key identity (ssl only)')
+    p.add_argument('--send-rate-limit', help='Maximum send rate of each socket in bytes per second, 0 for unlimited',
+                   type=int)
+    p.add_argument('--send-burst-size', help='Bytes a rate limited socket may send back to back, 0 for 10 ms worth',
+                   type=int)
+    p.add_argument('--busy-poll-usecs', help='Time in microseconds a sock group busy polls its NAPI context, 0 to disable',
+                   type=int)
+    p.add_argument('--recv-ring-buf-count', help='Number of buffers in the receive buffer ring of each sock group, 0 to disable (uring only)',
+                   type=int)
+    p.add_argument('--recv-ring-buf-size', help='Size of each buffer in the receive buffer ring (uring only)',
+                   type=int)
     p.set_defaults(func=sock_impl_set_options, enable_recv_pipe=None, enable_quickack=None,
-                   enable_placement_id=None, enable_zerocopy_send_server=None, enable_zerocopy_send_client=None)
+                   enable_placement_id=None, enable_zerocopy_send_server=None, enable_zerocopy_send_client=None,
+                   enable_ktls=None)
 
     def sock_set_default_impl(args):
         print_json(rpc.sock.sock_set_default_impl(args.client,
@@ -54,6 +54,7 @@ DEFINE_STUB(spdk_pci_ioat_get_driver, struct spdk_pci_driver *, (void), NULL)
 DEFINE_STUB(spdk_pci_virtio_get_driver, struct spdk_pci_driver *, (void), NULL)
 DEFINE_STUB(spdk_env_thread_launch_pinned, int, (uint32_t core, thread_start_fn fn, void *arg), 0);
 DEFINE_STUB_V(spdk_env_thread_wait_all, (void));
+DEFINE_STUB_V(spdk_pause, (void));
 DEFINE_STUB_V(spdk_env_opts_init, (struct spdk_env_opts *opts));
 DEFINE_STUB(spdk_env_init, int, (const struct spdk_env_opts *opts), 0);
 DEFINE_STUB_V(spdk_env_fini, (void));
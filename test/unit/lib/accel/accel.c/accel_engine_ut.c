@@ -788,6 +788,895 @@ test_spdk_accel_submit_copy_crc32c(void)
 	CU_ASSERT(expected_accel_task == &task);
 }
 
+static void
+test_spdk_accel_submit_xor(void)
+{
+	const uint64_t nbytes = TEST_SUBMIT_SIZE;
+	uint8_t dst[TEST_SUBMIT_SIZE] = {0};
+	uint8_t src1[TEST_SUBMIT_SIZE], src2[TEST_SUBMIT_SIZE], src3[TEST_SUBMIT_SIZE];
+	void *sources[] = { src1, src2, src3 };
+	void *cb_arg = NULL;
+	int rc, i;
+	struct spdk_accel_task task;
+	struct spdk_accel_task *expected_accel_task = NULL;
+
+	TAILQ_INIT(&g_accel_ch->task_pool);
+
+	/* Fail with a single source */
+	rc = spdk_accel_submit_xor(g_ch, dst, sources, 1, nbytes, dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* Fail with no tasks on _get_task() */
+	rc = spdk_accel_submit_xor(g_ch, dst, sources, 3, nbytes, dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -ENOMEM);
+
+	task.cb_fn = dummy_submit_cb_fn;
+	task.cb_arg = cb_arg;
+	task.accel_ch = g_accel_ch;
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+
+	g_accel_ch->engine = &g_accel_engine;
+	g_opc_mask = _accel_op_to_bit(ACCEL_OPC_XOR);
+	g_accel_ch->engine->submit_tasks = dummy_submit_tasks;
+
+	/* HW accel submission OK. */
+	rc = spdk_accel_submit_xor(g_ch, dst, sources, 3, nbytes, dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.dst == dst);
+	CU_ASSERT(task.nsrcs.srcs == sources);
+	CU_ASSERT(task.nsrcs.cnt == 3);
+	CU_ASSERT(task.nbytes == nbytes);
+	CU_ASSERT(task.op_code == ACCEL_OPC_XOR);
+	CU_ASSERT(g_dummy_submit_called == true);
+
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	g_dummy_submit_called = false;
+	g_opc_mask = 0;
+	task.op_code = 0xff;
+	memset(src1, 0x11, TEST_SUBMIT_SIZE);
+	memset(src2, 0x22, TEST_SUBMIT_SIZE);
+	for (i = 0; i < TEST_SUBMIT_SIZE; i++) {
+		src3[i] = i;
+	}
+
+	/* SW engine does the XOR. */
+	rc = spdk_accel_submit_xor(g_ch, dst, sources, 3, nbytes, dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.op_code == ACCEL_OPC_XOR);
+	CU_ASSERT(g_dummy_submit_called == false);
+	for (i = 0; i < TEST_SUBMIT_SIZE; i++) {
+		CU_ASSERT(dst[i] == (0x33 ^ i));
+	}
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+	CU_ASSERT(task.status == 0);
+}
+
+static void
+test_spdk_accel_submit_ec(void)
+{
+	const uint64_t nbytes = TEST_SUBMIT_SIZE;
+	uint8_t d0[TEST_SUBMIT_SIZE], d1[TEST_SUBMIT_SIZE], d2[TEST_SUBMIT_SIZE];
+	uint8_t p0[TEST_SUBMIT_SIZE], p1[TEST_SUBMIT_SIZE], orig[TEST_SUBMIT_SIZE];
+	void *data[] = { d0, d1, d2 }, *parity[] = { p0, p1 };
+	uint32_t erased[] = { 1, 3 };
+	void *cb_arg = NULL;
+	int rc;
+	struct spdk_accel_task task;
+	struct spdk_accel_task *expected_accel_task = NULL;
+
+	TAILQ_INIT(&g_accel_ch->task_pool);
+
+	/* Invalid stripes */
+	rc = spdk_accel_submit_ec_encode(g_ch, data, 3, parity, 0, nbytes, dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_accel_submit_ec_encode(g_ch, data, SPDK_EC_MAX_DATA_BUFS + 1, parity, 2, nbytes,
+					 dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_accel_submit_ec_decode(g_ch, data, 3, parity, 2, erased, 3, nbytes,
+					 dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* Fail with no tasks on _get_task() */
+	rc = spdk_accel_submit_ec_encode(g_ch, data, 3, parity, 2, nbytes, dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -ENOMEM);
+
+	task.cb_fn = dummy_submit_cb_fn;
+	task.cb_arg = cb_arg;
+	task.accel_ch = g_accel_ch;
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+
+	g_accel_ch->engine = &g_accel_engine;
+	g_opc_mask = _accel_op_to_bit(ACCEL_OPC_EC_ENCODE);
+	g_accel_ch->engine->submit_tasks = dummy_submit_tasks;
+
+	/* HW accel submission OK. */
+	rc = spdk_accel_submit_ec_encode(g_ch, data, 3, parity, 2, nbytes, dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.ec.data == data);
+	CU_ASSERT(task.ec.ndata == 3);
+	CU_ASSERT(task.ec.parity == parity);
+	CU_ASSERT(task.ec.nparity == 2);
+	CU_ASSERT(task.ec.nerased == 0);
+	CU_ASSERT(task.nbytes == nbytes);
+	CU_ASSERT(task.op_code == ACCEL_OPC_EC_ENCODE);
+	CU_ASSERT(g_dummy_submit_called == true);
+
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	g_dummy_submit_called = false;
+	g_opc_mask = 0;
+	memset(d0, 0x5A, TEST_SUBMIT_SIZE);
+	memset(d1, 0xA5, TEST_SUBMIT_SIZE);
+	memset(d2, 0x3C, TEST_SUBMIT_SIZE);
+
+	/* SW engine encodes. */
+	rc = spdk_accel_submit_ec_encode(g_ch, data, 3, parity, 2, nbytes, dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_dummy_submit_called == false);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+	CU_ASSERT(task.status == 0);
+
+	/* SW engine reconstructs a lost data and a lost parity buffer. */
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	memcpy(orig, p0, TEST_SUBMIT_SIZE);
+	memset(d1, 0, TEST_SUBMIT_SIZE);
+	memset(p0, 0, TEST_SUBMIT_SIZE);
+	rc = spdk_accel_submit_ec_decode(g_ch, data, 3, parity, 2, erased, 2, nbytes,
+					 dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.op_code == ACCEL_OPC_EC_DECODE);
+	CU_ASSERT(task.ec.erased == erased);
+	CU_ASSERT(task.ec.nerased == 2);
+	CU_ASSERT(memcmp(p0, orig, TEST_SUBMIT_SIZE) == 0);
+	memset(orig, 0xA5, TEST_SUBMIT_SIZE);
+	CU_ASSERT(memcmp(d1, orig, TEST_SUBMIT_SIZE) == 0);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+	CU_ASSERT(task.status == 0);
+}
+
+static void
+test_spdk_accel_submit_compress(void)
+{
+	uint8_t src[TEST_SUBMIT_SIZE * 4], dst[TEST_SUBMIT_SIZE * 4];
+	struct iovec src_iovs[2], dst_iovs[2];
+	uint32_t output_size = 0;
+	void *cb_arg = NULL;
+	int rc;
+	struct spdk_accel_task task;
+	struct spdk_accel_task *expected_accel_task = NULL;
+
+	TAILQ_INIT(&g_accel_ch->task_pool);
+
+	src_iovs[0].iov_base = src;
+	src_iovs[0].iov_len = TEST_SUBMIT_SIZE;
+	src_iovs[1].iov_base = src + TEST_SUBMIT_SIZE;
+	src_iovs[1].iov_len = sizeof(src) - TEST_SUBMIT_SIZE;
+	dst_iovs[0].iov_base = dst;
+	dst_iovs[0].iov_len = TEST_SUBMIT_SIZE;
+	dst_iovs[1].iov_base = dst + TEST_SUBMIT_SIZE;
+	dst_iovs[1].iov_len = sizeof(dst) - TEST_SUBMIT_SIZE;
+
+	/* Missing buffers */
+	rc = spdk_accel_submit_compress(g_ch, dst_iovs, 0, src_iovs, 2, &output_size,
+					dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_accel_submit_compress(g_ch, dst_iovs, 2, src_iovs, 2, NULL,
+					dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_accel_submit_decompress(g_ch, dst_iovs, 2, NULL, 0, &output_size,
+					  dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -EINVAL);
+
+	g_accel_ch->engine = &g_accel_engine;
+	g_opc_mask = _accel_op_to_bit(ACCEL_OPC_COMPRESS) | _accel_op_to_bit(ACCEL_OPC_DECOMPRESS);
+	g_accel_ch->engine->submit_tasks = dummy_submit_tasks;
+
+	/* Fail with no tasks on _get_task() */
+	rc = spdk_accel_submit_compress(g_ch, dst_iovs, 2, src_iovs, 2, &output_size,
+					dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -ENOMEM);
+
+	task.cb_fn = dummy_submit_cb_fn;
+	task.cb_arg = cb_arg;
+	task.accel_ch = g_accel_ch;
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+
+	/* HW accel submission OK. */
+	rc = spdk_accel_submit_compress(g_ch, dst_iovs, 2, src_iovs, 2, &output_size,
+					dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.v.iovs == src_iovs);
+	CU_ASSERT(task.v.iovcnt == 2);
+	CU_ASSERT(task.d.iovs == dst_iovs);
+	CU_ASSERT(task.d.iovcnt == 2);
+	CU_ASSERT(task.output_size == &output_size);
+	CU_ASSERT(task.op_code == ACCEL_OPC_COMPRESS);
+	CU_ASSERT(g_dummy_submit_called == true);
+
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	g_dummy_submit_called = false;
+	rc = spdk_accel_submit_decompress(g_ch, dst_iovs, 1, src_iovs, 2, NULL,
+					  dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.d.iovcnt == 1);
+	CU_ASSERT(task.output_size == NULL);
+	CU_ASSERT(task.op_code == ACCEL_OPC_DECOMPRESS);
+	CU_ASSERT(g_dummy_submit_called == true);
+
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	g_dummy_submit_called = false;
+	g_opc_mask = 0;
+
+#ifdef SPDK_CONFIG_ISAL
+	memset(src, 0x5A, sizeof(src));
+	memset(src + 40, 0xA5, 100);
+
+	/* SW engine compresses across multiple buffers. */
+	rc = spdk_accel_submit_compress(g_ch, dst_iovs, 2, src_iovs, 2, &output_size,
+					dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_dummy_submit_called == false);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+	CU_ASSERT(task.status == 0);
+	CU_ASSERT(output_size > 0 && output_size < sizeof(src));
+
+	/* SW engine decompresses the result back into split buffers. */
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	memcpy(src + TEST_SUBMIT_SIZE * 2, dst, output_size);
+	src_iovs[0].iov_base = src + TEST_SUBMIT_SIZE * 2;
+	src_iovs[0].iov_len = 1;
+	src_iovs[1].iov_base = src + TEST_SUBMIT_SIZE * 2 + 1;
+	src_iovs[1].iov_len = output_size - 1;
+	memset(dst, 0, sizeof(dst));
+	rc = spdk_accel_submit_decompress(g_ch, dst_iovs, 2, src_iovs, 2, &output_size,
+					  dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == 0);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+	CU_ASSERT(task.status == 0);
+	CU_ASSERT(output_size == sizeof(dst));
+	CU_ASSERT(dst[0] == 0x5A && dst[40] == 0xA5 && dst[139] == 0xA5 && dst[140] == 0x5A);
+
+	/* Output that does not fit is reported to the callback. */
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	rc = spdk_accel_submit_decompress(g_ch, dst_iovs, 1, src_iovs, 2, NULL,
+					  dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == 0);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+	CU_ASSERT(task.status == -ENOSPC);
+
+	/* A truncated stream fails instead of returning what was decompressed. */
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	src_iovs[1].iov_len /= 2;
+	rc = spdk_accel_submit_decompress(g_ch, dst_iovs, 2, src_iovs, 2, NULL,
+					  dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == 0);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+	CU_ASSERT(task.status == -EIO);
+
+	/* The streams are reused, but not the buffers of the previous operations. */
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	src_iovs[0].iov_base = src;
+	src_iovs[0].iov_len = TEST_SUBMIT_SIZE;
+	src_iovs[1].iov_base = src + TEST_SUBMIT_SIZE;
+	src_iovs[1].iov_len = TEST_SUBMIT_SIZE;
+	rc = spdk_accel_submit_compress(g_ch, dst_iovs, 2, src_iovs, 2, &output_size,
+					dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == 0);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+	CU_ASSERT(task.status == 0);
+
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	memcpy(src + TEST_SUBMIT_SIZE * 2, dst, output_size);
+	src_iovs[0].iov_base = src + TEST_SUBMIT_SIZE * 2;
+	src_iovs[0].iov_len = output_size;
+	memset(dst, 0, sizeof(dst));
+	rc = spdk_accel_submit_decompress(g_ch, dst_iovs, 2, src_iovs, 1, &output_size,
+					  dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == 0);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+	CU_ASSERT(task.status == 0);
+	CU_ASSERT(output_size == TEST_SUBMIT_SIZE * 2);
+	CU_ASSERT(memcmp(dst, src, TEST_SUBMIT_SIZE * 2) == 0);
+	free(g_sw_ch->comp_ctx);
+	g_sw_ch->comp_ctx = NULL;
+#else
+	/* Without ISA-L there is no SW fallback. */
+	rc = spdk_accel_submit_compress(g_ch, dst_iovs, 2, src_iovs, 2, &output_size,
+					dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -ENOTSUP);
+	rc = spdk_accel_submit_decompress(g_ch, dst_iovs, 2, src_iovs, 2, &output_size,
+					  dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -ENOTSUP);
+	expected_accel_task = TAILQ_FIRST(&g_accel_ch->task_pool);
+	CU_ASSERT(expected_accel_task == &task);
+	TAILQ_REMOVE(&g_accel_ch->task_pool, &task, link);
+	CU_ASSERT(TAILQ_EMPTY(&g_sw_ch->tasks_to_complete));
+#endif
+}
+
+static void
+test_spdk_accel_submit_crypto(void)
+{
+	uint8_t key1[SPDK_ACCEL_AES_XTS_128_KEY_SIZE], key2[SPDK_ACCEL_AES_XTS_128_KEY_SIZE];
+	uint8_t src[TEST_SUBMIT_SIZE * 2], dst[TEST_SUBMIT_SIZE * 2];
+	struct iovec src_iovs[2], dst_iovs[2];
+	struct spdk_accel_crypto_key *key = NULL;
+	void *cb_arg = NULL;
+	int rc;
+	struct spdk_accel_task task;
+	struct spdk_accel_task *expected_accel_task = NULL;
+
+	TAILQ_INIT(&g_accel_ch->task_pool);
+
+	memset(key1, 0x11, sizeof(key1));
+	memset(key2, 0x22, sizeof(key2));
+
+	/* Invalid keys */
+	rc = spdk_accel_crypto_key_create(key1, key2, 24, &key);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_accel_crypto_key_create(key1, key1, sizeof(key1), &key);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(key == NULL);
+
+	rc = spdk_accel_crypto_key_create(key1, key2, sizeof(key1), &key);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(key != NULL);
+	CU_ASSERT(memcmp(key->key, key1, sizeof(key1)) == 0);
+	CU_ASSERT(memcmp(key->key2, key2, sizeof(key2)) == 0);
+	CU_ASSERT(key->key_size == sizeof(key1));
+
+	src_iovs[0].iov_base = src;
+	src_iovs[0].iov_len = 48;
+	src_iovs[1].iov_base = src + 48;
+	src_iovs[1].iov_len = sizeof(src) - 48;
+	dst_iovs[0].iov_base = dst;
+	dst_iovs[0].iov_len = 80;
+	dst_iovs[1].iov_base = dst + 80;
+	dst_iovs[1].iov_len = sizeof(dst) - 80;
+
+	/* Invalid data unit size and buffers */
+	rc = spdk_accel_submit_encrypt(g_ch, key, dst_iovs, 2, src_iovs, 2, 0, 24,
+				       dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_accel_submit_encrypt(g_ch, key, dst_iovs, 2, src_iovs, 2, 0, 96,
+				       dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_accel_submit_decrypt(g_ch, key, dst_iovs, 1, src_iovs, 2, 0, 32,
+				       dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -EINVAL);
+	src_iovs[0].iov_len = 40;
+	rc = spdk_accel_submit_encrypt(g_ch, key, dst_iovs, 2, src_iovs, 1, 0, 40,
+				       dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -EINVAL);
+	src_iovs[0].iov_len = 48;
+	rc = spdk_accel_submit_encrypt(g_ch, NULL, dst_iovs, 2, src_iovs, 2, 0, 32,
+				       dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -EINVAL);
+
+	g_accel_ch->engine = &g_accel_engine;
+	g_opc_mask = _accel_op_to_bit(ACCEL_OPC_ENCRYPT) | _accel_op_to_bit(ACCEL_OPC_DECRYPT);
+	g_accel_ch->engine->submit_tasks = dummy_submit_tasks;
+
+	/* Fail with no tasks on _get_task() */
+	rc = spdk_accel_submit_encrypt(g_ch, key, dst_iovs, 2, src_iovs, 2, 0, 32,
+				       dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -ENOMEM);
+
+	task.cb_fn = dummy_submit_cb_fn;
+	task.cb_arg = cb_arg;
+	task.accel_ch = g_accel_ch;
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+
+	/* HW accel submission OK. */
+	rc = spdk_accel_submit_encrypt(g_ch, key, dst_iovs, 2, src_iovs, 2, 0x1234, 32,
+				       dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.v.iovs == src_iovs);
+	CU_ASSERT(task.v.iovcnt == 2);
+	CU_ASSERT(task.d.iovs == dst_iovs);
+	CU_ASSERT(task.d.iovcnt == 2);
+	CU_ASSERT(task.crypto.key == key);
+	CU_ASSERT(task.crypto.iv == 0x1234);
+	CU_ASSERT(task.crypto.block_size == 32);
+	CU_ASSERT(task.op_code == ACCEL_OPC_ENCRYPT);
+	CU_ASSERT(g_dummy_submit_called == true);
+
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	g_dummy_submit_called = false;
+	rc = spdk_accel_submit_decrypt(g_ch, key, dst_iovs, 2, src_iovs, 2, 0x1234, 32,
+				       dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.op_code == ACCEL_OPC_DECRYPT);
+	CU_ASSERT(g_dummy_submit_called == true);
+
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	g_dummy_submit_called = false;
+	g_opc_mask = 0;
+
+#ifdef SPDK_CONFIG_IPSEC_MB
+	{
+		/* IEEE 1619 XTS-AES-128 test vector 2 */
+		const uint8_t expected[32] = {
+			0xc4, 0x54, 0x18, 0x5e, 0x6a, 0x16, 0x93, 0x6e,
+			0x39, 0x33, 0x40, 0x38, 0xac, 0xef, 0x83, 0x8b,
+			0xfb, 0x18, 0x6f, 0xff, 0x74, 0x80, 0xad, 0xc4,
+			0x28, 0x93, 0x82, 0xec, 0xd6, 0xd3, 0x94, 0xf0
+		};
+		uint8_t orig[TEST_SUBMIT_SIZE * 2];
+		size_t i;
+
+		/* SW engine encrypts a single data unit. */
+		memset(src, 0x44, sizeof(src));
+		rc = spdk_accel_submit_encrypt(g_ch, key, dst_iovs, 1, src_iovs, 1, 0x3333333333ULL, 32,
+					       dummy_submit_cb_fn, cb_arg);
+		CU_ASSERT(rc == -EINVAL);
+		src_iovs[0].iov_len = 32;
+		rc = spdk_accel_submit_encrypt(g_ch, key, dst_iovs, 1, src_iovs, 1, 0x3333333333ULL, 32,
+					       dummy_submit_cb_fn, cb_arg);
+		CU_ASSERT(rc == 0);
+		CU_ASSERT(g_dummy_submit_called == false);
+		expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+		TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+		CU_ASSERT(expected_accel_task == &task);
+		CU_ASSERT(task.status == 0);
+		CU_ASSERT(memcmp(dst, expected, sizeof(expected)) == 0);
+
+		/* SW engine round trips several data units split differently across buffers. */
+		TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+		src_iovs[0].iov_len = 48;
+		for (i = 0; i < sizeof(src); i++) {
+			src[i] = i;
+		}
+		memcpy(orig, src, sizeof(src));
+		rc = spdk_accel_submit_encrypt(g_ch, key, dst_iovs, 2, src_iovs, 2, 7, 32,
+					       dummy_submit_cb_fn, cb_arg);
+		CU_ASSERT(rc == 0);
+		expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+		TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+		CU_ASSERT(task.status == 0);
+		CU_ASSERT(memcmp(dst, orig, sizeof(dst)) != 0);
+
+		/* Decrypt in place. */
+		TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+		rc = spdk_accel_submit_decrypt(g_ch, key, dst_iovs, 2, dst_iovs, 2, 7, 32,
+					       dummy_submit_cb_fn, cb_arg);
+		CU_ASSERT(rc == 0);
+		expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+		TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+		CU_ASSERT(task.status == 0);
+		CU_ASSERT(memcmp(dst, orig, sizeof(dst)) == 0);
+
+		_sw_accel_free_crypto_ctx(g_sw_ch->crypto_ctx);
+		g_sw_ch->crypto_ctx = NULL;
+	}
+#else
+	/* Without ipsec-mb there is no SW fallback. */
+	rc = spdk_accel_submit_encrypt(g_ch, key, dst_iovs, 2, src_iovs, 2, 0, 32,
+				       dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -ENOTSUP);
+	rc = spdk_accel_submit_decrypt(g_ch, key, dst_iovs, 2, src_iovs, 2, 0, 32,
+				       dummy_submit_cb_fn, cb_arg);
+	CU_ASSERT(rc == -ENOTSUP);
+	expected_accel_task = TAILQ_FIRST(&g_accel_ch->task_pool);
+	CU_ASSERT(expected_accel_task == &task);
+	TAILQ_REMOVE(&g_accel_ch->task_pool, &task, link);
+	CU_ASSERT(TAILQ_EMPTY(&g_sw_ch->tasks_to_complete));
+#endif
+
+	spdk_accel_crypto_key_destroy(key);
+}
+
+#define TEST_SEQ_TASKS 8
+static struct spdk_accel_task g_seq_tasks[TEST_SEQ_TASKS];
+static struct spdk_accel_sequence g_seqs[2];
+static struct spdk_accel_task *g_seq_submitted;
+static int g_seq_steps;
+static int g_seq_status;
+static bool g_seq_done;
+
+static void
+_seq_init_pools(void)
+{
+	int i;
+
+	TAILQ_INIT(&g_accel_ch->task_pool);
+	TAILQ_INIT(&g_accel_ch->seq_pool);
+	for (i = 0; i < TEST_SEQ_TASKS; i++) {
+		TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &g_seq_tasks[i], link);
+	}
+	for (i = 0; i < (int)SPDK_COUNTOF(g_seqs); i++) {
+		TAILQ_INSERT_TAIL(&g_accel_ch->seq_pool, &g_seqs[i], link);
+	}
+
+	g_accel_ch->engine = &g_accel_engine;
+	g_seq_submitted = NULL;
+	g_seq_steps = 0;
+	g_seq_status = 1;
+	g_seq_done = false;
+}
+
+static void
+_seq_check_pools(void)
+{
+	struct spdk_accel_task *task;
+	struct spdk_accel_sequence *seq;
+	int count = 0;
+
+	TAILQ_FOREACH(task, &g_accel_ch->task_pool, link) {
+		count++;
+	}
+	CU_ASSERT(count == TEST_SEQ_TASKS);
+
+	count = 0;
+	TAILQ_FOREACH(seq, &g_accel_ch->seq_pool, link) {
+		count++;
+	}
+	CU_ASSERT(count == SPDK_COUNTOF(g_seqs));
+}
+
+static void
+_seq_step_cb(void *cb_arg)
+{
+	/* Steps are released in order */
+	CU_ASSERT((intptr_t)cb_arg == g_seq_steps);
+	g_seq_steps++;
+}
+
+static void
+_seq_done_cb(void *cb_arg, int status)
+{
+	g_seq_status = status;
+	g_seq_done = true;
+}
+
+static int
+_seq_submit_tasks(struct spdk_io_channel *ch, struct spdk_accel_task *first_task)
+{
+	CU_ASSERT(g_seq_submitted == NULL);
+	CU_ASSERT(TAILQ_NEXT(first_task, link) == NULL);
+	g_seq_submitted = first_task;
+	return 0;
+}
+
+static void
+test_sequence_sw(void)
+{
+	struct spdk_accel_sequence *seq = NULL;
+	uint8_t src[TEST_SUBMIT_SIZE], dst[TEST_SUBMIT_SIZE], buf[TEST_SUBMIT_SIZE];
+	struct iovec iov = { .iov_base = dst, .iov_len = TEST_SUBMIT_SIZE };
+	uint32_t crc = 0, crcv = 0;
+	int rc;
+
+	_seq_init_pools();
+	g_opc_mask = 0;
+	memset(src, 0, sizeof(src));
+	memset(dst, 0, sizeof(dst));
+	memset(buf, 0x5A, sizeof(buf));
+
+	/* fill -> copy -> crc of the copy (fused into the copy) -> crc over an iov -> compare */
+	rc = spdk_accel_append_fill(&seq, g_ch, src, 0x5A, TEST_SUBMIT_SIZE, 0, _seq_step_cb,
+				    (void *)0);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(seq != NULL);
+	rc = spdk_accel_append_copy(&seq, g_ch, dst, src, TEST_SUBMIT_SIZE, 0, _seq_step_cb,
+				    (void *)1);
+	CU_ASSERT(rc == 0);
+	rc = spdk_accel_append_crc32c(&seq, g_ch, &crc, dst, 0, TEST_SUBMIT_SIZE, _seq_step_cb,
+				      (void *)2);
+	CU_ASSERT(rc == 0);
+	rc = spdk_accel_append_crc32cv(&seq, g_ch, &crcv, &iov, 1, 0, _seq_step_cb, (void *)3);
+	CU_ASSERT(rc == 0);
+	rc = spdk_accel_append_compare(&seq, g_ch, dst, buf, TEST_SUBMIT_SIZE, _seq_step_cb,
+				       (void *)4);
+	CU_ASSERT(rc == 0);
+
+	/* Nothing runs before the sequence is finished */
+	CU_ASSERT(src[0] == 0);
+	CU_ASSERT(g_seq_steps == 0);
+
+	rc = spdk_accel_sequence_finish(seq, _seq_done_cb, NULL);
+	CU_ASSERT(rc == 0);
+	/* The tasks are taken from the pool in order, the third one is the CRC-32C */
+	CU_ASSERT(g_seq_tasks[2].fused == true);
+	CU_ASSERT(g_seq_tasks[3].fused == false);
+
+	/* All but the last step ran right away, the completion comes from the poller */
+	CU_ASSERT(g_seq_steps == 4);
+	CU_ASSERT(g_seq_done == false);
+	accel_comp_poll(g_sw_ch);
+	CU_ASSERT(g_seq_steps == 5);
+	CU_ASSERT(g_seq_done == true);
+	CU_ASSERT(g_seq_status == 0);
+	CU_ASSERT(memcmp(dst, buf, TEST_SUBMIT_SIZE) == 0);
+	CU_ASSERT(crc == spdk_crc32c_update(buf, TEST_SUBMIT_SIZE, ~0u));
+	CU_ASSERT(crcv == crc);
+	_seq_check_pools();
+
+	/* A miscompare stops the sequence, the remaining steps are still released */
+	seq = NULL;
+	g_seq_steps = 0;
+	g_seq_done = false;
+	buf[0] = 0;
+	rc = spdk_accel_append_compare(&seq, g_ch, dst, buf, TEST_SUBMIT_SIZE, _seq_step_cb,
+				       (void *)0);
+	CU_ASSERT(rc == 0);
+	rc = spdk_accel_append_fill(&seq, g_ch, dst, 0, TEST_SUBMIT_SIZE, 0, _seq_step_cb,
+				    (void *)1);
+	CU_ASSERT(rc == 0);
+	rc = spdk_accel_sequence_finish(seq, _seq_done_cb, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_seq_done == false);
+	accel_comp_poll(g_sw_ch);
+	CU_ASSERT(g_seq_done == true);
+	CU_ASSERT(g_seq_status == -EILSEQ);
+	CU_ASSERT(g_seq_steps == 2);
+	CU_ASSERT(dst[1] == 0x5A);
+	_seq_check_pools();
+}
+
+static void
+test_sequence_hw(void)
+{
+	struct spdk_accel_sequence *seq = NULL;
+	uint8_t src[TEST_SUBMIT_SIZE], dst[TEST_SUBMIT_SIZE];
+	uint32_t crc = 0;
+	struct spdk_accel_task *task;
+	int rc;
+
+	_seq_init_pools();
+	g_accel_ch->engine->submit_tasks = _seq_submit_tasks;
+	g_opc_mask = _accel_op_to_bit(ACCEL_OPC_COPY) | _accel_op_to_bit(ACCEL_OPC_CRC32C) |
+		     _accel_op_to_bit(ACCEL_OPC_COPY_CRC32C);
+	memset(src, 0xA5, sizeof(src));
+
+	/* crc -> copy of the same source (fused) -> compare in software */
+	rc = spdk_accel_append_crc32c(&seq, g_ch, &crc, src, 0, TEST_SUBMIT_SIZE, _seq_step_cb,
+				      (void *)0);
+	CU_ASSERT(rc == 0);
+	rc = spdk_accel_append_copy(&seq, g_ch, dst, src, TEST_SUBMIT_SIZE, 0, _seq_step_cb,
+				    (void *)1);
+	CU_ASSERT(rc == 0);
+	rc = spdk_accel_append_compare(&seq, g_ch, dst, src, TEST_SUBMIT_SIZE, _seq_step_cb,
+				       (void *)2);
+	CU_ASSERT(rc == 0);
+
+	rc = spdk_accel_sequence_finish(seq, _seq_done_cb, NULL);
+	CU_ASSERT(rc == 0);
+	task = g_seq_submitted;
+	SPDK_CU_ASSERT_FATAL(task != NULL);
+	CU_ASSERT(task->op_code == ACCEL_OPC_COPY_CRC32C);
+	CU_ASSERT(task->src == src);
+	CU_ASSERT(task->dst == dst);
+	CU_ASSERT(task->crc_dst == &crc);
+	CU_ASSERT(TAILQ_NEXT(task, seq_link)->fused == true);
+
+	/* The engine completes the fused step, the next one is executed in software */
+	memcpy(dst, src, TEST_SUBMIT_SIZE);
+	g_seq_submitted = NULL;
+	spdk_accel_task_complete(task, 0);
+	CU_ASSERT(g_seq_steps == 2);
+	CU_ASSERT(g_seq_submitted == NULL);
+	CU_ASSERT(g_seq_done == false);
+	accel_comp_poll(g_sw_ch);
+	CU_ASSERT(g_seq_steps == 3);
+	CU_ASSERT(g_seq_done == true);
+	CU_ASSERT(g_seq_status == 0);
+	_seq_check_pools();
+
+	/* Steps are not fused when the engine can only do them separately */
+	seq = NULL;
+	g_seq_steps = 0;
+	g_seq_done = false;
+	g_opc_mask = _accel_op_to_bit(ACCEL_OPC_COPY) | _accel_op_to_bit(ACCEL_OPC_CRC32C);
+	rc = spdk_accel_append_copy(&seq, g_ch, dst, src, TEST_SUBMIT_SIZE, 0, _seq_step_cb,
+				    (void *)0);
+	CU_ASSERT(rc == 0);
+	rc = spdk_accel_append_crc32c(&seq, g_ch, &crc, dst, 0, TEST_SUBMIT_SIZE, _seq_step_cb,
+				      (void *)1);
+	CU_ASSERT(rc == 0);
+	rc = spdk_accel_sequence_finish(seq, _seq_done_cb, NULL);
+	CU_ASSERT(rc == 0);
+	task = g_seq_submitted;
+	SPDK_CU_ASSERT_FATAL(task != NULL);
+	CU_ASSERT(task->op_code == ACCEL_OPC_COPY);
+	g_seq_submitted = NULL;
+	spdk_accel_task_complete(task, 0);
+	task = g_seq_submitted;
+	SPDK_CU_ASSERT_FATAL(task != NULL);
+	CU_ASSERT(task->op_code == ACCEL_OPC_CRC32C);
+
+	/* A failed step completes the sequence right away */
+	spdk_accel_task_complete(task, -EIO);
+	CU_ASSERT(g_seq_steps == 2);
+	CU_ASSERT(g_seq_done == true);
+	CU_ASSERT(g_seq_status == -EIO);
+	_seq_check_pools();
+
+	g_opc_mask = 0;
+}
+
+static void
+test_sequence_crypto(void)
+{
+	struct spdk_accel_sequence *seq = NULL;
+	uint8_t key1[SPDK_ACCEL_AES_XTS_128_KEY_SIZE], key2[SPDK_ACCEL_AES_XTS_128_KEY_SIZE];
+	uint8_t buf[TEST_SUBMIT_SIZE], dst[TEST_SUBMIT_SIZE];
+	struct iovec iov = { .iov_base = buf, .iov_len = sizeof(buf) };
+	struct iovec dst_iov = { .iov_base = dst, .iov_len = sizeof(dst) };
+	struct spdk_accel_crypto_key *key = NULL;
+	uint32_t crc = 0, output_size = 0;
+	struct spdk_accel_task *task;
+	int rc;
+
+	memset(key1, 0x11, sizeof(key1));
+	memset(key2, 0x22, sizeof(key2));
+	rc = spdk_accel_crypto_key_create(key1, key2, sizeof(key1), &key);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+
+	_seq_init_pools();
+	g_accel_ch->engine->submit_tasks = _seq_submit_tasks;
+	g_opc_mask = 0;
+
+	/* Steps no engine can execute are rejected up front */
+#ifndef SPDK_CONFIG_IPSEC_MB
+	rc = spdk_accel_append_decrypt(&seq, g_ch, key, &iov, 1, &iov, 1, 0, 32, NULL, NULL);
+	CU_ASSERT(rc == -ENOTSUP);
+	CU_ASSERT(seq == NULL);
+#endif
+#ifndef SPDK_CONFIG_ISAL
+	rc = spdk_accel_append_decompress(&seq, g_ch, &dst_iov, 1, &iov, 1, NULL, NULL, NULL);
+	CU_ASSERT(rc == -ENOTSUP);
+	CU_ASSERT(seq == NULL);
+#endif
+	rc = spdk_accel_append_decrypt(&seq, g_ch, key, &iov, 1, &iov, 1, 0, 24, NULL, NULL);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_accel_append_compress(&seq, g_ch, &dst_iov, 1, &iov, 1, NULL, NULL, NULL);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(seq == NULL);
+	_seq_check_pools();
+
+	/* decrypt in place by the engine -> verify CRC-32C -> copy out, both in software */
+	g_opc_mask = _accel_op_to_bit(ACCEL_OPC_DECRYPT);
+	memset(buf, 0x5A, sizeof(buf));
+	rc = spdk_accel_append_decrypt(&seq, g_ch, key, &iov, 1, &iov, 1, 10, 32, _seq_step_cb,
+				       (void *)0);
+	CU_ASSERT(rc == 0);
+	rc = spdk_accel_append_crc32cv(&seq, g_ch, &crc, &iov, 1, 0, _seq_step_cb, (void *)1);
+	CU_ASSERT(rc == 0);
+	rc = spdk_accel_append_copy(&seq, g_ch, dst, buf, sizeof(buf), 0, _seq_step_cb, (void *)2);
+	CU_ASSERT(rc == 0);
+
+	rc = spdk_accel_sequence_finish(seq, _seq_done_cb, NULL);
+	CU_ASSERT(rc == 0);
+	task = g_seq_submitted;
+	SPDK_CU_ASSERT_FATAL(task != NULL);
+	CU_ASSERT(task->op_code == ACCEL_OPC_DECRYPT);
+	CU_ASSERT(task->crypto.key == key);
+	CU_ASSERT(task->crypto.iv == 10);
+	CU_ASSERT(task->crypto.block_size == 32);
+	CU_ASSERT(task->v.iovs == &iov);
+	CU_ASSERT(task->d.iovs == &iov);
+
+	g_seq_submitted = NULL;
+	spdk_accel_task_complete(task, 0);
+	CU_ASSERT(g_seq_steps == 2);
+	CU_ASSERT(g_seq_done == false);
+	accel_comp_poll(g_sw_ch);
+	CU_ASSERT(g_seq_steps == 3);
+	CU_ASSERT(g_seq_done == true);
+	CU_ASSERT(g_seq_status == 0);
+	CU_ASSERT(crc == spdk_crc32c_update(buf, sizeof(buf), ~0u));
+	CU_ASSERT(memcmp(dst, buf, sizeof(buf)) == 0);
+	_seq_check_pools();
+
+	/* A compression executed by the engine */
+	seq = NULL;
+	g_seq_steps = 0;
+	g_seq_done = false;
+	g_opc_mask = _accel_op_to_bit(ACCEL_OPC_COMPRESS);
+	rc = spdk_accel_append_compress(&seq, g_ch, &dst_iov, 1, &iov, 1, &output_size,
+					_seq_step_cb, (void *)0);
+	CU_ASSERT(rc == 0);
+	rc = spdk_accel_sequence_finish(seq, _seq_done_cb, NULL);
+	CU_ASSERT(rc == 0);
+	task = g_seq_submitted;
+	SPDK_CU_ASSERT_FATAL(task != NULL);
+	CU_ASSERT(task->op_code == ACCEL_OPC_COMPRESS);
+	CU_ASSERT(task->output_size == &output_size);
+	CU_ASSERT(task->d.iovs == &dst_iov);
+	g_seq_submitted = NULL;
+	spdk_accel_task_complete(task, 0);
+	CU_ASSERT(g_seq_steps == 1);
+	CU_ASSERT(g_seq_done == true);
+	CU_ASSERT(g_seq_status == 0);
+	_seq_check_pools();
+
+#ifdef SPDK_CONFIG_IPSEC_MB
+	/* encrypt -> decrypt in software gives back the original data */
+	seq = NULL;
+	g_seq_steps = 0;
+	g_seq_done = false;
+	g_opc_mask = 0;
+	memset(dst, 0, sizeof(dst));
+	rc = spdk_accel_append_encrypt(&seq, g_ch, key, &dst_iov, 1, &iov, 1, 3, 32, _seq_step_cb,
+				       (void *)0);
+	CU_ASSERT(rc == 0);
+	rc = spdk_accel_append_decrypt(&seq, g_ch, key, &dst_iov, 1, &dst_iov, 1, 3, 32,
+				       _seq_step_cb, (void *)1);
+	CU_ASSERT(rc == 0);
+	rc = spdk_accel_sequence_finish(seq, _seq_done_cb, NULL);
+	CU_ASSERT(rc == 0);
+	accel_comp_poll(g_sw_ch);
+	CU_ASSERT(g_seq_steps == 2);
+	CU_ASSERT(g_seq_done == true);
+	CU_ASSERT(g_seq_status == 0);
+	CU_ASSERT(memcmp(dst, buf, sizeof(buf)) == 0);
+	_seq_check_pools();
+
+	_sw_accel_free_crypto_ctx(g_sw_ch->crypto_ctx);
+	g_sw_ch->crypto_ctx = NULL;
+#endif
+
+	g_opc_mask = 0;
+	spdk_accel_crypto_key_destroy(key);
+}
+
+static void
+test_sequence_abort(void)
+{
+	struct spdk_accel_sequence *seq = NULL, *seq2 = NULL, *seq3 = NULL;
+	uint8_t dst[TEST_SUBMIT_SIZE];
+	int rc, i;
+
+	_seq_init_pools();
+	g_opc_mask = 0;
+
+	rc = spdk_accel_append_fill(&seq, g_ch, dst, 0, TEST_SUBMIT_SIZE, 0, _seq_step_cb, (void *)0);
+	CU_ASSERT(rc == 0);
+	rc = spdk_accel_append_fill(&seq, g_ch, dst, 1, TEST_SUBMIT_SIZE, 0, _seq_step_cb, (void *)1);
+	CU_ASSERT(rc == 0);
+	rc = spdk_accel_append_fill(&seq2, g_ch, dst, 0, TEST_SUBMIT_SIZE, 0, NULL, NULL);
+	CU_ASSERT(rc == 0);
+
+	/* Out of sequences */
+	rc = spdk_accel_append_fill(&seq3, g_ch, dst, 0, TEST_SUBMIT_SIZE, 0, NULL, NULL);
+	CU_ASSERT(rc == -ENOMEM);
+	CU_ASSERT(seq3 == NULL);
+
+	/* Out of tasks, the sequence is left as it was */
+	for (i = 3; i < TEST_SEQ_TASKS; i++) {
+		rc = spdk_accel_append_fill(&seq2, g_ch, dst, 0, TEST_SUBMIT_SIZE, 0, NULL, NULL);
+		CU_ASSERT(rc == 0);
+	}
+	rc = spdk_accel_append_fill(&seq2, g_ch, dst, 0, TEST_SUBMIT_SIZE, 0, NULL, NULL);
+	CU_ASSERT(rc == -ENOMEM);
+
+	spdk_accel_sequence_abort(seq);
+	CU_ASSERT(g_seq_steps == 2);
+	spdk_accel_sequence_abort(seq2);
+	spdk_accel_sequence_abort(NULL);
+	CU_ASSERT(g_seq_done == false);
+	CU_ASSERT(TAILQ_EMPTY(&g_sw_ch->tasks_to_complete));
+	_seq_check_pools();
+}
+
 int main(int argc, char **argv)
 {
 	CU_pSuite	suite = NULL;
@@ -812,6 +1701,14 @@ int main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_spdk_accel_submit_crc32c_hw_engine_unsupported);
 	CU_ADD_TEST(suite, test_spdk_accel_submit_crc32cv);
 	CU_ADD_TEST(suite, test_spdk_accel_submit_copy_crc32c);
+	CU_ADD_TEST(suite, test_spdk_accel_submit_xor);
+	CU_ADD_TEST(suite, test_spdk_accel_submit_ec);
+	CU_ADD_TEST(suite, test_spdk_accel_submit_compress);
+	CU_ADD_TEST(suite, test_spdk_accel_submit_crypto);
+	CU_ADD_TEST(suite, test_sequence_sw);
+	CU_ADD_TEST(suite, test_sequence_hw);
+	CU_ADD_TEST(suite, test_sequence_crypto);
+	CU_ADD_TEST(suite, test_sequence_abort);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
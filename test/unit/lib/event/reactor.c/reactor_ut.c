@@ -750,7 +750,225 @@ test_scheduler(void)
 	free_cores();
 }
 
+static void
+test_scheduler_numa(void)
+{
+	struct spdk_cpuset cpuset = {};
+	struct spdk_scheduler_thread_info thread_info = {};
+	struct spdk_thread *thread;
+	struct spdk_reactor *reactor;
+	int i;
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	allocate_cores(4);
+
+	CU_ASSERT(spdk_reactors_init(SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+
+	/* Re-initialize the scheduler, so that it picks up the new core count. */
+	spdk_scheduler_set(NULL);
+	spdk_scheduler_set("dynamic");
+	CU_ASSERT(g_main_lcore == 0);
+
+	for (i = 0; i < 4; i++) {
+		spdk_cpuset_set_cpu(&g_reactor_core_mask, i, true);
+		spdk_cpuset_set_cpu(&cpuset, i, true);
+	}
+	g_next_core = 0;
+
+	thread = spdk_thread_create(NULL, &cpuset);
+	SPDK_CU_ASSERT_FATAL(thread != NULL);
+
+	/* Cores 0-1 are on node 0, cores 2-3 on node 1 */
+	for (i = 0; i < 4; i++) {
+		g_cores[i].numa_id = i / 2;
+	}
+
+	thread_info.thread_id = spdk_thread_get_id(thread);
+	thread_info.current_stats.busy_tsc = 40;
+	thread_info.current_stats.idle_tsc = 60;
+
+	/* Thread without device affinity on core 3 is consolidated on the idle main core. */
+	for (i = 0; i < 4; i++) {
+		g_cores[i].busy = 0;
+		g_cores[i].idle = 100;
+		g_cores[i].thread_count = 0;
+	}
+	g_cores[3].busy = 40;
+	g_cores[3].idle = 60;
+	g_cores[3].thread_count = 1;
+	thread_info.lcore = 3;
+	thread_info.numa_id = SPDK_ENV_SOCKET_ID_ANY;
+	CU_ASSERT(_find_optimal_core(&thread_info) == 0);
+
+	/* Thread with node 1 affinity stays on its node instead, on the lowest core there. */
+	thread_info.numa_id = 1;
+	CU_ASSERT(_find_optimal_core(&thread_info) == 2);
+
+	/* Thread with node 1 affinity running on the main core is brought back to node 1. */
+	g_cores[3].busy = 0;
+	g_cores[3].idle = 100;
+	g_cores[3].thread_count = 0;
+	g_cores[0].busy = 40;
+	g_cores[0].idle = 60;
+	g_cores[0].thread_count = 1;
+	thread_info.lcore = 0;
+	CU_ASSERT(_find_optimal_core(&thread_info) == 2);
+
+	/* Only when node 1 is saturated the thread can spill over to node 0. */
+	for (i = 0; i < 4; i++) {
+		g_cores[i].busy = 100;
+		g_cores[i].idle = 0;
+		g_cores[i].thread_count = 1;
+	}
+	g_cores[1].busy = 0;
+	g_cores[1].idle = 100;
+	g_cores[1].thread_count = 0;
+	g_cores[3].busy = 90;
+	g_cores[3].idle = 10;
+	g_cores[3].thread_count = 2;
+	thread_info.lcore = 3;
+	CU_ASSERT(_find_optimal_core(&thread_info) == 1);
+
+	/* Without an overloaded core there is no reason to leave node 1. */
+	g_cores[3].busy = 40;
+	g_cores[3].idle = 60;
+	CU_ASSERT(_find_optimal_core(&thread_info) == 3);
+
+	/* Destroy the thread */
+	for (i = 0; i < 4; i++) {
+		reactor = spdk_reactor_get(i);
+		CU_ASSERT(reactor != NULL);
+		MOCK_SET(spdk_env_get_current_core, i);
+		event_queue_run_batch(reactor);
+		reactor_run(reactor);
+	}
+
+	spdk_set_thread(NULL);
+
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	spdk_reactors_fini();
+
+	free_cores();
+}
+
+static void
+test_scheduler_load_model(void)
+{
+	struct spdk_scheduler_thread_info thread_info = {};
+	struct thread_load *load;
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	allocate_cores(2);
+
+	CU_ASSERT(spdk_reactors_init(SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+
+	spdk_scheduler_set(NULL);
+	spdk_scheduler_set("dynamic");
+
+	g_scheduler_ewma_weight = 50;
+	g_scheduler_hysteresis = 10;
+	g_scheduler_cooldown = 2;
+
+	/* First period, prediction equals the sample */
+	g_period++;
+	thread_info.thread_id = 1;
+	thread_info.lcore = 1;
+	thread_info.current_stats.busy_tsc = 100;
+	thread_info.current_stats.idle_tsc = 0;
+	g_cores[1].busy = 100;
+	g_cores[1].idle = 0;
+	g_cores[1].thread_count = 1;
+	_predict_thread_load(&thread_info);
+	load = _get_thread_load_history(1);
+	SPDK_CU_ASSERT_FATAL(load != NULL);
+	CU_ASSERT(load->busy == 100);
+	CU_ASSERT(thread_info.current_stats.busy_tsc == 100);
+	CU_ASSERT(_is_thread_active(&thread_info));
+
+	/* Thread goes idle, the load decays and the core stats follow the prediction */
+	g_period++;
+	thread_info.current_stats.busy_tsc = 0;
+	thread_info.current_stats.idle_tsc = 100;
+	g_cores[1].busy = 0;
+	g_cores[1].idle = 100;
+	_predict_thread_load(&thread_info);
+	CU_ASSERT(thread_info.current_stats.busy_tsc == 50);
+	CU_ASSERT(thread_info.current_stats.idle_tsc == 50);
+	CU_ASSERT(g_cores[1].busy == 50);
+	CU_ASSERT(g_cores[1].idle == 50);
+
+	g_period++;
+	thread_info.current_stats.busy_tsc = 0;
+	thread_info.current_stats.idle_tsc = 100;
+	_predict_thread_load(&thread_info);
+	CU_ASSERT(thread_info.current_stats.busy_tsc == 25);
+
+	/* 12% is below the load limit, but within the hysteresis band off the main core... */
+	g_period++;
+	thread_info.current_stats.busy_tsc = 0;
+	thread_info.current_stats.idle_tsc = 100;
+	_predict_thread_load(&thread_info);
+	CU_ASSERT(thread_info.current_stats.busy_tsc == 12);
+	CU_ASSERT(_is_thread_active(&thread_info));
+
+	/* ...while on the main core a thread needs 30% to be active */
+	thread_info.lcore = 0;
+	CU_ASSERT(!_is_thread_active(&thread_info));
+	thread_info.current_stats.busy_tsc = 25;
+	thread_info.current_stats.idle_tsc = 75;
+	CU_ASSERT(!_is_thread_active(&thread_info));
+	thread_info.current_stats.busy_tsc = 30;
+	thread_info.current_stats.idle_tsc = 70;
+	CU_ASSERT(_is_thread_active(&thread_info));
+
+	/* Moving the thread starts the cooldown */
+	CU_ASSERT(!_is_thread_cooling_down(&thread_info));
+	g_cores[0].busy = 30;
+	g_cores[0].idle = 70;
+	g_cores[0].thread_count = 1;
+	_record_thread_move(&thread_info);
+	CU_ASSERT(load->moved == true);
+	CU_ASSERT(load->lcore == 0);
+	CU_ASSERT(_is_thread_cooling_down(&thread_info));
+	g_period += 2;
+	CU_ASSERT(_is_thread_cooling_down(&thread_info));
+
+	/* Unless its core is overloaded */
+	g_cores[0].busy = 90;
+	g_cores[0].idle = 10;
+	g_cores[0].thread_count = 2;
+	CU_ASSERT(!_is_thread_cooling_down(&thread_info));
+	g_cores[0].busy = 30;
+	g_cores[0].idle = 70;
+	g_cores[0].thread_count = 1;
+
+	g_period++;
+	CU_ASSERT(!_is_thread_cooling_down(&thread_info));
+
+	/* Threads that were not seen in a period are forgotten */
+	_prune_thread_loads();
+	CU_ASSERT(RB_EMPTY(&g_thread_loads));
+
+	g_scheduler_ewma_weight = 100;
+	g_scheduler_hysteresis = 0;
+	g_scheduler_cooldown = 0;
+
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	spdk_reactors_fini();
+
+	free_cores();
+}
+
 uint8_t g_curr_freq;
+uint32_t g_core_freq_min_calls[3];
+uint32_t g_core_freq_max_calls[3];
+uint32_t g_core_idle_latency[3];
+uint32_t g_core_idle_latency_calls;
+int g_core_idle_latency_rc;
 
 static int
 core_freq_up(uint32_t lcore)
@@ -776,11 +994,34 @@ static int
 core_freq_max(uint32_t lcore)
 {
 	g_curr_freq = UINT8_MAX;
+	if (lcore < SPDK_COUNTOF(g_core_freq_max_calls)) {
+		g_core_freq_max_calls[lcore]++;
+	}
+
+	return 0;
+}
+
+static int
+core_freq_min(uint32_t lcore)
+{
+	if (lcore < SPDK_COUNTOF(g_core_freq_min_calls)) {
+		g_core_freq_min_calls[lcore]++;
+	}
 
 	return 0;
 }
 
-DEFINE_STUB(core_freq_min, int, (uint32_t lcore_id), 0);
+static int
+core_idle_latency(uint32_t lcore, uint32_t latency_us)
+{
+	if (lcore < SPDK_COUNTOF(g_core_idle_latency)) {
+		g_core_idle_latency[lcore] = latency_us;
+	}
+	g_core_idle_latency_calls++;
+
+	return g_core_idle_latency_rc;
+}
+
 DEFINE_STUB(core_caps, int,
 	    (uint32_t lcore_id, struct spdk_governor_capabilities *capabilities), 0);
 DEFINE_STUB(governor_init, int, (void), 0);
@@ -794,10 +1035,297 @@ static struct spdk_governor governor = {
 	.set_core_freq_max = core_freq_max,
 	.set_core_freq_min = core_freq_min,
 	.get_core_capabilities = core_caps,
+	.set_core_idle_latency = core_idle_latency,
 	.init = governor_init,
 	.deinit = governor_deinit,
 };
 
+static int
+poller_count_busy(void *ctx)
+{
+	uint32_t *count = ctx;
+
+	(*count)++;
+
+	return 1;
+}
+
+static void
+work_stealing_done(void *cb_arg)
+{
+	bool *done = cb_arg;
+
+	*done = true;
+}
+
+static void
+run_reactor_events(uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++) {
+		MOCK_SET(spdk_env_get_current_core, i);
+		event_queue_run_batch(spdk_reactor_get(i));
+	}
+	MOCK_SET(spdk_env_get_current_core, 0);
+}
+
+static void
+test_work_stealing(void)
+{
+	struct spdk_cpuset cpuset = {};
+	struct spdk_thread *thread[3];
+	struct spdk_lw_thread *lw_thread[3];
+	struct spdk_poller *poller[3];
+	struct spdk_reactor *reactor0, *reactor1;
+	uint32_t count[3] = {};
+	bool done = false;
+	int i;
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	allocate_cores(2);
+
+	CU_ASSERT(spdk_reactors_init(SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+
+	reactor0 = spdk_reactor_get(0);
+	SPDK_CU_ASSERT_FATAL(reactor0 != NULL);
+	reactor1 = spdk_reactor_get(1);
+	SPDK_CU_ASSERT_FATAL(reactor1 != NULL);
+
+	/* Create three busy threads on core 0 */
+	spdk_cpuset_set_cpu(&cpuset, 0, true);
+	for (i = 0; i < 3; i++) {
+		thread[i] = spdk_thread_create(NULL, &cpuset);
+		SPDK_CU_ASSERT_FATAL(thread[i] != NULL);
+		lw_thread[i] = spdk_thread_get_ctx(thread[i]);
+		spdk_set_thread(thread[i]);
+		poller[i] = spdk_poller_register(poller_count_busy, &count[i], 0);
+		CU_ASSERT(poller[i] != NULL);
+	}
+	spdk_set_thread(NULL);
+
+	g_reactor_state = SPDK_REACTOR_STATE_RUNNING;
+
+	/* Work stealing is disabled by default, nothing is offered. */
+	CU_ASSERT(spdk_framework_work_stealing_enabled() == false);
+	_reactor_run(reactor0);
+	CU_ASSERT(reactor0->thread_count == 3);
+	CU_ASSERT(reactor0->steal_slot == NULL);
+	CU_ASSERT(count[0] == 1 && count[1] == 1 && count[2] == 1);
+
+	/* Without work stealing, threads are polled without being acquired. */
+	lw_thread[1]->running = true;
+	_reactor_run(reactor0);
+	CU_ASSERT(count[0] == 2 && count[1] == 2 && count[2] == 2);
+	CU_ASSERT(lw_thread[1]->running == true);
+	lw_thread[1]->running = false;
+
+	/* Switching is only allowed from the app thread. */
+	CU_ASSERT(spdk_framework_enable_work_stealing(true, work_stealing_done, &done) == -EPERM);
+
+	spdk_set_thread(thread[0]);
+	CU_ASSERT(spdk_framework_enable_work_stealing(true, work_stealing_done, &done) == 0);
+	CU_ASSERT(spdk_framework_enable_work_stealing(true, work_stealing_done, &done) == -EBUSY);
+	spdk_set_thread(NULL);
+	CU_ASSERT(spdk_framework_work_stealing_enabled() == true);
+	while (!done) {
+		run_reactor_events(2);
+	}
+	CU_ASSERT(reactor0->work_stealing == true && reactor0->lw_thread_shared == true);
+	CU_ASSERT(reactor1->work_stealing == true && reactor1->lw_thread_shared == true);
+	CU_ASSERT(count[0] == 2 && count[1] == 2 && count[2] == 2);
+
+	/* Threads pinned to core 0 are never offered. */
+	_reactor_run(reactor0);
+	CU_ASSERT(reactor0->steal_slot == NULL);
+
+	/* Allow the last two threads on core 1. The first thread runs events,
+	 * so the last busy thread is offered. */
+	for (i = 1; i < 3; i++) {
+		spdk_cpuset_set_cpu(spdk_thread_get_cpumask(thread[i]), 1, true);
+	}
+	_reactor_run(reactor0);
+	CU_ASSERT(reactor0->steal_slot == lw_thread[2]);
+	CU_ASSERT(lw_thread[2]->offered == true);
+	CU_ASSERT(count[0] == 4 && count[1] == 4 && count[2] == 4);
+
+	/* Idle reactor 1 takes the offer and polls the thread once */
+	MOCK_SET(spdk_env_get_current_core, 1);
+	_reactor_run(reactor1);
+	CU_ASSERT(reactor0->steal_slot == NULL);
+	CU_ASSERT(lw_thread[2]->offered == false);
+	CU_ASSERT(lw_thread[2]->running == false);
+	CU_ASSERT(count[0] == 4 && count[1] == 4 && count[2] == 5);
+	CU_ASSERT(reactor1->busy_tsc > 0 || reactor1->idle_tsc > 0);
+
+	/* The thread still belongs to reactor 0 */
+	CU_ASSERT(lw_thread[2]->lcore == 0);
+	CU_ASSERT(reactor0->thread_count == 3);
+	CU_ASSERT(TAILQ_EMPTY(&reactor1->threads));
+
+	/* A thread that is being run elsewhere is skipped by its home reactor */
+	MOCK_SET(spdk_env_get_current_core, 0);
+	lw_thread[1]->running = true;
+	_reactor_run(reactor0);
+	CU_ASSERT(count[0] == 5 && count[1] == 4 && count[2] == 6);
+	lw_thread[1]->running = false;
+	CU_ASSERT(reactor0->steal_slot == lw_thread[2]);
+
+	/* An offer whose cpumask no longer allows core 1 is dropped */
+	spdk_cpuset_set_cpu(spdk_thread_get_cpumask(thread[2]), 1, false);
+	MOCK_SET(spdk_env_get_current_core, 1);
+	_reactor_run(reactor1);
+	CU_ASSERT(reactor0->steal_slot == NULL);
+	CU_ASSERT(lw_thread[2]->offered == false);
+	CU_ASSERT(count[2] == 6);
+
+	/* An exiting thread offered in the slot is withdrawn before being destroyed */
+	MOCK_SET(spdk_env_get_current_core, 0);
+	_reactor_run(reactor0);
+	CU_ASSERT(reactor0->steal_slot == lw_thread[1]);
+	spdk_set_thread(thread[1]);
+	spdk_poller_unregister(&poller[1]);
+	spdk_thread_exit(thread[1]);
+	spdk_set_thread(NULL);
+	_reactor_run(reactor0);
+	CU_ASSERT(reactor0->steal_slot == NULL);
+	CU_ASSERT(reactor0->thread_count == 2);
+
+	/* A pending offer is withdrawn when disabling */
+	spdk_cpuset_set_cpu(spdk_thread_get_cpumask(thread[2]), 1, true);
+	_reactor_run(reactor0);
+	CU_ASSERT(reactor0->steal_slot == lw_thread[2]);
+
+	done = false;
+	spdk_set_thread(thread[0]);
+	CU_ASSERT(spdk_framework_enable_work_stealing(false, work_stealing_done, &done) == 0);
+	spdk_set_thread(NULL);
+	CU_ASSERT(spdk_framework_work_stealing_enabled() == false);
+
+	/* Reactors keep acquiring their threads until none of them can be stealing anymore */
+	run_reactor_events(2);
+	CU_ASSERT(reactor0->work_stealing == false && reactor0->lw_thread_shared == true);
+	CU_ASSERT(reactor1->work_stealing == false && reactor1->lw_thread_shared == true);
+	CU_ASSERT(reactor0->steal_slot == NULL);
+	CU_ASSERT(lw_thread[2]->offered == false);
+	while (!done) {
+		run_reactor_events(2);
+	}
+	CU_ASSERT(reactor0->lw_thread_shared == false && reactor1->lw_thread_shared == false);
+	CU_ASSERT(lw_thread[0]->running == false);
+
+	for (i = 0; i < 3; i++) {
+		if (i == 1) {
+			continue;
+		}
+		spdk_set_thread(thread[i]);
+		spdk_poller_unregister(&poller[i]);
+	}
+
+	g_reactor_state = SPDK_REACTOR_STATE_INITIALIZED;
+
+	reactor_run(reactor0);
+	CU_ASSERT(TAILQ_EMPTY(&reactor0->threads));
+
+	spdk_set_thread(NULL);
+
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	spdk_reactors_fini();
+
+	free_cores();
+}
+
+static int
+ut_create_ch(void *io_device, void *ctx_buf)
+{
+	return 0;
+}
+
+static void
+ut_destroy_ch(void *io_device, void *ctx_buf)
+{
+}
+
+static void
+test_gather_metrics_numa(void)
+{
+	struct spdk_cpuset cpuset = {};
+	struct spdk_thread *thread;
+	struct spdk_lw_thread *lw_thread;
+	struct spdk_reactor *reactor;
+	struct spdk_io_channel *ch;
+	int io_device;
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	allocate_cores(1);
+
+	CU_ASSERT(spdk_reactors_init(SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+
+	reactor = spdk_reactor_get(0);
+	SPDK_CU_ASSERT_FATAL(reactor != NULL);
+
+	spdk_cpuset_set_cpu(&cpuset, 0, true);
+	thread = spdk_thread_create(NULL, &cpuset);
+	SPDK_CU_ASSERT_FATAL(thread != NULL);
+	lw_thread = spdk_thread_get_ctx(thread);
+	CU_ASSERT(lw_thread->numa_id == SPDK_ENV_SOCKET_ID_ANY);
+
+	spdk_set_thread(thread);
+	spdk_io_device_register(&io_device, ut_create_ch, ut_destroy_ch, 0, NULL);
+	CU_ASSERT(spdk_io_device_set_numa_id(&io_device, 1) == 0);
+	ch = spdk_get_io_channel(&io_device);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+	spdk_set_thread(NULL);
+
+	_reactor_run(reactor);
+	CU_ASSERT(reactor->thread_count == 1);
+
+	/* The I/O channels of a thread run by another reactor are not looked at */
+	reactor->lw_thread_shared = true;
+	lw_thread->running = true;
+	_reactors_scheduler_gather_metrics(NULL, NULL);
+	SPDK_CU_ASSERT_FATAL(g_core_infos[0].thread_infos != NULL);
+	CU_ASSERT(g_core_infos[0].thread_infos[0].numa_id == SPDK_ENV_SOCKET_ID_ANY);
+	lw_thread->running = false;
+	/* The scheduler is not running, so the round is cancelled */
+	_run_events_till_completion(1);
+	CU_ASSERT(g_core_infos[0].thread_infos == NULL);
+
+	/* Once back home, the node is updated and kept while the thread is away again */
+	MOCK_SET(spdk_env_get_current_core, 0);
+	_reactors_scheduler_gather_metrics(NULL, NULL);
+	CU_ASSERT(g_core_infos[0].thread_infos[0].numa_id == 1);
+	CU_ASSERT(lw_thread->numa_id == 1);
+	_run_events_till_completion(1);
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+	lw_thread->running = true;
+	_reactors_scheduler_gather_metrics(NULL, NULL);
+	CU_ASSERT(g_core_infos[0].thread_infos[0].numa_id == 1);
+	lw_thread->running = false;
+	_run_events_till_completion(1);
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+	spdk_set_thread(thread);
+	spdk_put_io_channel(ch);
+	spdk_io_device_unregister(&io_device, NULL);
+	spdk_set_thread(NULL);
+
+	reactor_run(reactor);
+	CU_ASSERT(TAILQ_EMPTY(&reactor->threads));
+
+	spdk_set_thread(NULL);
+
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	spdk_reactors_fini();
+
+	free_cores();
+}
+
 static void
 test_governor(void)
 {
@@ -963,6 +1491,167 @@ test_governor(void)
 	free_cores();
 }
 
+static void
+test_hybrid_mode(void)
+{
+	struct spdk_reactor reactor = {};
+	uint32_t idle_us, wakeups;
+
+	/* Hybrid mode needs interrupt mode to be enabled */
+	CU_ASSERT(spdk_framework_set_hybrid_mode(100, 0) == -EINVAL);
+	CU_ASSERT(spdk_framework_set_hybrid_mode(100, 2) == -ENOTSUP);
+	CU_ASSERT(spdk_framework_set_hybrid_mode(0, 0) == 0);
+	spdk_framework_get_hybrid_mode(&idle_us, &wakeups);
+	CU_ASSERT(idle_us == 0);
+	CU_ASSERT(wakeups == 0);
+
+	g_framework_hybrid_idle_tsc = 100;
+	g_framework_hybrid_wakeups = 3;
+
+	/* Polling reactor switches after being idle for longer than the threshold */
+	CU_ASSERT(!_reactor_hybrid_check(&reactor, 1000, true));
+	CU_ASSERT(!_reactor_hybrid_check(&reactor, 1050, false));
+	CU_ASSERT(!_reactor_hybrid_check(&reactor, 1100, true));
+	CU_ASSERT(!_reactor_hybrid_check(&reactor, 1200, false));
+	CU_ASSERT(_reactor_hybrid_check(&reactor, 1201, false));
+
+	/* Nothing is decided while a switch is pending */
+	reactor.hybrid_switch_pending = true;
+	CU_ASSERT(!_reactor_hybrid_check(&reactor, 1300, false));
+	reactor.hybrid_switch_pending = false;
+
+	/* In interrupt mode, three wakeups within the threshold switch back */
+	reactor.in_interrupt = true;
+	CU_ASSERT(!_reactor_hybrid_check(&reactor, 2000, false));
+	CU_ASSERT(reactor.hybrid_in_interrupt == true);
+	CU_ASSERT(!_reactor_hybrid_check(&reactor, 2010, true));
+	CU_ASSERT(!_reactor_hybrid_check(&reactor, 2050, true));
+	/* Window expired, counting starts over */
+	CU_ASSERT(!_reactor_hybrid_check(&reactor, 2200, true));
+	CU_ASSERT(!_reactor_hybrid_check(&reactor, 2250, true));
+	CU_ASSERT(_reactor_hybrid_check(&reactor, 2290, true));
+
+	/* Back in poll mode the idle streak starts from the switch */
+	reactor.in_interrupt = false;
+	CU_ASSERT(!_reactor_hybrid_check(&reactor, 3000, false));
+	CU_ASSERT(!_reactor_hybrid_check(&reactor, 3100, false));
+	CU_ASSERT(_reactor_hybrid_check(&reactor, 3101, false));
+
+	g_framework_hybrid_idle_tsc = 0;
+	g_framework_hybrid_wakeups = 0;
+}
+
+static void
+test_scheduler_power(void)
+{
+	uint32_t i;
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	allocate_cores(3);
+
+	CU_ASSERT(spdk_reactors_init(SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+
+	spdk_scheduler_set(NULL);
+	spdk_scheduler_set("dynamic");
+
+	memset(g_core_freq_min_calls, 0, sizeof(g_core_freq_min_calls));
+	memset(g_core_freq_max_calls, 0, sizeof(g_core_freq_max_calls));
+	g_core_idle_latency_calls = 0;
+
+	/* Power awareness disabled, nothing is changed */
+	g_cores[0].thread_count = 2;
+	g_cores[1].thread_count = 1;
+	g_cores[2].thread_count = 0;
+	_balance_power(&governor);
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT(g_core_freq_min_calls[i] == 0);
+		CU_ASSERT(g_core_freq_max_calls[i] == 0);
+	}
+	CU_ASSERT(g_core_idle_latency_calls == 0);
+
+	/* Core with threads is boosted and kept out of deep idle states,
+	 * unused core is slowed down. Main core is left to balance(). */
+	g_scheduler_power_aware = true;
+	g_scheduler_latency_slo = 10;
+	_balance_power(&governor);
+	CU_ASSERT(g_core_freq_min_calls[0] == 0);
+	CU_ASSERT(g_core_freq_max_calls[0] == 0);
+	CU_ASSERT(g_core_freq_min_calls[1] == 0);
+	CU_ASSERT(g_core_freq_max_calls[1] == 1);
+	CU_ASSERT(g_core_freq_min_calls[2] == 1);
+	CU_ASSERT(g_core_freq_max_calls[2] == 0);
+	CU_ASSERT(g_core_idle_latency[0] == 10);
+	CU_ASSERT(g_core_idle_latency[1] == 10);
+	/* Core 2 already allows all idle states */
+	CU_ASSERT(g_core_idle_latency_calls == 2);
+
+	/* Nothing changed, no calls to the governor */
+	_balance_power(&governor);
+	CU_ASSERT(g_core_freq_max_calls[1] == 1);
+	CU_ASSERT(g_core_freq_min_calls[2] == 1);
+	CU_ASSERT(g_core_idle_latency_calls == 2);
+
+	/* Threads move from core 1 to core 2 */
+	g_cores[1].thread_count = 0;
+	g_cores[2].thread_count = 1;
+	_balance_power(&governor);
+	CU_ASSERT(g_core_freq_min_calls[1] == 1);
+	CU_ASSERT(g_core_freq_max_calls[2] == 1);
+	CU_ASSERT(g_core_idle_latency[1] == UINT32_MAX);
+	CU_ASSERT(g_core_idle_latency[2] == 10);
+	CU_ASSERT(g_core_idle_latency_calls == 4);
+
+	/* Disabling power awareness restores the default frequency */
+	g_scheduler_power_aware = false;
+	_balance_power(&governor);
+	CU_ASSERT(g_core_freq_max_calls[1] == 2);
+	CU_ASSERT(g_core_freq_max_calls[2] == 2);
+
+	/* Clearing the SLO allows all idle states again */
+	g_scheduler_latency_slo = 0;
+	_balance_power(&governor);
+	CU_ASSERT(g_core_idle_latency[0] == UINT32_MAX);
+	CU_ASSERT(g_core_idle_latency[2] == UINT32_MAX);
+	CU_ASSERT(g_core_idle_latency_calls == 6);
+
+	/* Failed calls are retried after a growing number of periods */
+	g_scheduler_latency_slo = 10;
+	g_core_idle_latency_rc = -ENOTSUP;
+	_balance_power(&governor);
+	CU_ASSERT(g_core_idle_latency_calls == 8);
+	CU_ASSERT(g_cores[0].idle_latency == UINT32_MAX);
+	_balance_power(&governor);
+	CU_ASSERT(g_core_idle_latency_calls == 8);
+	g_period += 2;
+	_balance_power(&governor);
+	CU_ASSERT(g_core_idle_latency_calls == 10);
+	g_period += 2;
+	_balance_power(&governor);
+	CU_ASSERT(g_core_idle_latency_calls == 10);
+	g_core_idle_latency_rc = 0;
+	g_period += 2;
+	_balance_power(&governor);
+	CU_ASSERT(g_core_idle_latency_calls == 12);
+	CU_ASSERT(g_core_idle_latency[0] == 10);
+	CU_ASSERT(g_core_idle_latency[2] == 10);
+	CU_ASSERT(g_cores[0].idle_retry.failures == 0);
+
+	/* Removing the scheduler restores the idle states it limited */
+	spdk_scheduler_set(NULL);
+	CU_ASSERT(g_core_idle_latency[0] == UINT32_MAX);
+	CU_ASSERT(g_core_idle_latency[2] == UINT32_MAX);
+	CU_ASSERT(g_core_idle_latency_calls == 14);
+
+	g_scheduler_latency_slo = 0;
+
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	spdk_reactors_fini();
+
+	free_cores();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -982,7 +1671,13 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_for_each_reactor);
 	CU_ADD_TEST(suite, test_reactor_stats);
 	CU_ADD_TEST(suite, test_scheduler);
+	CU_ADD_TEST(suite, test_scheduler_numa);
+	CU_ADD_TEST(suite, test_gather_metrics_numa);
+	CU_ADD_TEST(suite, test_scheduler_load_model);
+	CU_ADD_TEST(suite, test_work_stealing);
 	CU_ADD_TEST(suite, test_governor);
+	CU_ADD_TEST(suite, test_scheduler_power);
+	CU_ADD_TEST(suite, test_hybrid_mode);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
@@ -2765,6 +2765,186 @@ test_nvmf_property_set(void)
 	CU_ASSERT(req.rsp->prop_get_rsp.value.u64 == 0xDDADBEEF);
 }
 
+static void
+test_nvmf_qos_admit(void)
+{
+	struct spdk_nvmf_ctrlr ctrlr = {};
+	struct spdk_nvme_cmd cmd = {};
+	struct spdk_nvmf_request req[3] = {};
+	struct spdk_nvmf_qos_policy *host_policy, *any_host_policy;
+	struct nvmf_ctrlr_qos *qos;
+	int i;
+
+	/* 2 I/Os per 1 ms timeslice for the host on namespace 1 */
+	host_policy = calloc(1, sizeof(*host_policy));
+	SPDK_CU_ASSERT_FATAL(host_policy != NULL);
+	host_policy->nsid = 1;
+	host_policy->limits.rw_ios_per_sec = 2000;
+	host_policy->quota_per_timeslice[NVMF_QOS_RW_IOPS_RATE_LIMIT] = 2;
+	host_policy->remaining_this_timeslice[NVMF_QOS_RW_IOPS_RATE_LIMIT] = 2;
+	host_policy->timeslice_ticks = 1000;
+	host_policy->timeslice = spdk_get_ticks() / host_policy->timeslice_ticks;
+	host_policy->ref = 1;
+
+	/* At most 2 outstanding I/Os for any host on any namespace */
+	any_host_policy = calloc(1, sizeof(*any_host_policy));
+	SPDK_CU_ASSERT_FATAL(any_host_policy != NULL);
+	any_host_policy->limits.max_queue_depth = 2;
+	any_host_policy->timeslice_ticks = 1000;
+	any_host_policy->timeslice = spdk_get_ticks() / any_host_policy->timeslice_ticks;
+	any_host_policy->ref = 1;
+
+	qos = calloc(1, sizeof(*qos) + sizeof(qos->ns[0]));
+	SPDK_CU_ASSERT_FATAL(qos != NULL);
+	qos->any_host_default = any_host_policy;
+	qos->num_ns = 1;
+	qos->ns[0].host = host_policy;
+	qos->ns[0].any_host = any_host_policy;
+
+	cmd.opc = SPDK_NVME_OPC_READ;
+	cmd.nsid = 1;
+	for (i = 0; i < 3; i++) {
+		req[i].cmd = (union nvmf_h2c_msg *)&cmd;
+		req[i].length = 4096;
+	}
+
+	/* No policies at all */
+	CU_ASSERT(nvmf_qos_admit(&ctrlr, &req[0]) == true);
+	CU_ASSERT(req[0].qos_policy[0] == NULL);
+	CU_ASSERT(req[0].qos_policy[1] == NULL);
+
+	ctrlr.qos = qos;
+
+	/* Charged against both the host and the any host policy */
+	CU_ASSERT(nvmf_qos_admit(&ctrlr, &req[0]) == true);
+	CU_ASSERT(req[0].qos_policy[0] == host_policy);
+	CU_ASSERT(req[0].qos_policy[1] == any_host_policy);
+	CU_ASSERT(host_policy->ref == 2);
+	CU_ASSERT(host_policy->remaining_this_timeslice[NVMF_QOS_RW_IOPS_RATE_LIMIT] == 1);
+	CU_ASSERT(any_host_policy->ref == 2);
+
+	CU_ASSERT(nvmf_qos_admit(&ctrlr, &req[1]) == true);
+	CU_ASSERT(host_policy->remaining_this_timeslice[NVMF_QOS_RW_IOPS_RATE_LIMIT] == 0);
+	CU_ASSERT(any_host_policy->ref == 3);
+
+	/* Queue depth of the any host policy reached */
+	CU_ASSERT(nvmf_qos_admit(&ctrlr, &req[2]) == false);
+	CU_ASSERT(req[2].qos_policy[0] == NULL);
+	CU_ASSERT(req[2].qos_policy[1] == NULL);
+
+	nvmf_qos_release(&req[0]);
+	CU_ASSERT(req[0].qos_policy[0] == NULL);
+	CU_ASSERT(req[0].qos_policy[1] == NULL);
+	CU_ASSERT(host_policy->ref == 2);
+	CU_ASSERT(any_host_policy->ref == 2);
+
+	/* Out of I/O quota for this timeslice */
+	CU_ASSERT(nvmf_qos_admit(&ctrlr, &req[2]) == false);
+
+	/* Quota is refilled on the next timeslice */
+	spdk_delay_us(1000);
+	CU_ASSERT(nvmf_qos_admit(&ctrlr, &req[2]) == true);
+	CU_ASSERT(host_policy->remaining_this_timeslice[NVMF_QOS_RW_IOPS_RATE_LIMIT] == 1);
+
+	/* Namespaces outside of the table use the default policies */
+	nvmf_qos_release(&req[1]);
+	cmd.nsid = 2;
+	CU_ASSERT(nvmf_qos_admit(&ctrlr, &req[1]) == true);
+	CU_ASSERT(req[1].qos_policy[0] == NULL);
+	CU_ASSERT(req[1].qos_policy[1] == any_host_policy);
+
+	/* Fused commands are accounted for, but never held back */
+	cmd.fuse = SPDK_NVME_CMD_FUSE_FIRST;
+	CU_ASSERT(nvmf_qos_admit(&ctrlr, &req[0]) == true);
+	CU_ASSERT(any_host_policy->ref == 4);
+
+	for (i = 0; i < 3; i++) {
+		nvmf_qos_release(&req[i]);
+	}
+	CU_ASSERT(host_policy->ref == 1);
+	CU_ASSERT(any_host_policy->ref == 1);
+
+	nvmf_qos_policy_put(host_policy);
+	nvmf_qos_policy_put(any_host_policy);
+	free(qos);
+}
+
+static bool
+ut_histogram_is(struct spdk_histogram_data *histogram, uint64_t datapoint)
+{
+	struct spdk_histogram_data *expected;
+	bool rc;
+
+	expected = spdk_histogram_data_alloc();
+	SPDK_CU_ASSERT_FATAL(expected != NULL);
+	spdk_histogram_data_tally(expected, datapoint);
+	rc = memcmp(expected->bucket, histogram->bucket,
+		    SPDK_HISTOGRAM_NUM_BUCKETS(expected) * sizeof(uint64_t)) == 0;
+	spdk_histogram_data_free(expected);
+
+	return rc;
+}
+
+static void
+test_nvmf_request_latency(void)
+{
+	struct spdk_nvmf_qpair qpair = {};
+	struct spdk_nvmf_request req = {};
+	struct spdk_nvme_cmd cmd = {};
+	union nvmf_c2h_msg rsp = {};
+	struct spdk_nvmf_latency_histograms *histograms;
+
+	TAILQ_INIT(&qpair.outstanding);
+	qpair.qid = 1;
+	qpair.state = SPDK_NVMF_QPAIR_ACTIVE;
+
+	cmd.opc = SPDK_NVME_OPC_READ;
+	cmd.nsid = 1;
+	req.qpair = &qpair;
+	req.cmd = (union nvmf_h2c_msg *)&cmd;
+	req.rsp = &rsp;
+
+	/* The histograms of the qpair are allocated on its first I/O */
+	nvmf_qpair_latency_recv(&qpair, &req);
+	histograms = qpair.histograms;
+	SPDK_CU_ASSERT_FATAL(histograms != NULL);
+	CU_ASSERT(req.recv_tsc == spdk_get_ticks());
+
+	/* Requests resubmitted after being queued keep their arrival time */
+	spdk_delay_us(10);
+	nvmf_qpair_latency_recv(&qpair, &req);
+	CU_ASSERT(req.recv_tsc == spdk_get_ticks() - 10);
+
+	req.submit_tsc = spdk_get_ticks();
+	spdk_delay_us(20);
+
+	TAILQ_INSERT_TAIL(&qpair.outstanding, &req, link);
+	_nvmf_request_complete(&req);
+	CU_ASSERT(req.recv_tsc == 0);
+	CU_ASSERT(req.submit_tsc == 0);
+	CU_ASSERT(ut_histogram_is(histograms->data[SPDK_NVMF_LATENCY_QUEUE], 10));
+	CU_ASSERT(ut_histogram_is(histograms->data[SPDK_NVMF_LATENCY_BACKEND], 20));
+	CU_ASSERT(ut_histogram_is(histograms->data[SPDK_NVMF_LATENCY_RESPONSE], 0));
+	CU_ASSERT(ut_histogram_is(histograms->data[SPDK_NVMF_LATENCY_TOTAL], 30));
+
+	/* zcopy requests are not tracked, even if the transport set their arrival time */
+	req.recv_tsc = spdk_get_ticks();
+	req.zcopy_phase = NVMF_ZCOPY_PHASE_INIT;
+	nvmf_qpair_latency_recv(&qpair, &req);
+	CU_ASSERT(req.recv_tsc == 0);
+
+	/* Nothing is recorded once the histograms are disabled */
+	req.zcopy_phase = NVMF_ZCOPY_PHASE_NONE;
+	req.recv_tsc = spdk_get_ticks();
+	qpair.histograms = NULL;
+	TAILQ_INSERT_TAIL(&qpair.outstanding, &req, link);
+	_nvmf_request_complete(&req);
+	CU_ASSERT(req.recv_tsc == 0);
+	CU_ASSERT(ut_histogram_is(histograms->data[SPDK_NVMF_LATENCY_TOTAL], 30));
+
+	nvmf_latency_histograms_free(histograms);
+}
+
 int main(int argc, char **argv)
 {
 	CU_pSuite	suite = NULL;
@@ -2800,6 +2980,8 @@ int main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_zcopy_read);
 	CU_ADD_TEST(suite, test_zcopy_write);
 	CU_ADD_TEST(suite, test_nvmf_property_set);
+	CU_ADD_TEST(suite, test_nvmf_qos_admit);
+	CU_ADD_TEST(suite, test_nvmf_request_latency);
 
 	allocate_threads(1);
 	set_thread(0);
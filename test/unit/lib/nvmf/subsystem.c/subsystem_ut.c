@@ -1522,6 +1522,135 @@ test_spdk_nvmf_subsystem_add_host(void)
 	free(tgt.subsystems);
 }
 
+static int
+ut_tgt_channel_create(void *io_device, void *ctx_buf)
+{
+	return 0;
+}
+
+static void
+ut_tgt_channel_destroy(void *io_device, void *ctx_buf)
+{
+}
+
+static void
+test_spdk_nvmf_subsystem_set_qos_limits(void)
+{
+	struct spdk_nvmf_tgt tgt = {};
+	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_ctrlr ctrlr1 = {}, ctrlr2 = {};
+	struct spdk_nvmf_qos_limits limits = {}, out = {};
+	struct spdk_nvmf_qos_policy *any_host_policy, *host_policy;
+	const char host1[] = "nqn.2016-06.io.spdk:host1";
+	const char host2[] = "nqn.2016-06.io.spdk:host2";
+	int rc;
+
+	tgt.max_subsystems = 1024;
+	tgt.subsystems = calloc(tgt.max_subsystems, sizeof(struct spdk_nvmf_subsystem *));
+	SPDK_CU_ASSERT_FATAL(tgt.subsystems != NULL);
+	spdk_io_device_register(&tgt, ut_tgt_channel_create, ut_tgt_channel_destroy, 0, "tgt");
+
+	subsystem = spdk_nvmf_subsystem_create(&tgt, "nqn.2016-06.io.spdk:subsystem1",
+					       SPDK_NVMF_SUBTYPE_NVME, 4);
+	SPDK_CU_ASSERT_FATAL(subsystem != NULL);
+
+	/* Any host, all namespaces */
+	limits.rw_ios_per_sec = 10000;
+	rc = spdk_nvmf_subsystem_set_qos_limits(subsystem, NULL, 0, &limits);
+	CU_ASSERT(rc == 0);
+	any_host_policy = spdk_nvmf_subsystem_get_first_qos_policy(subsystem);
+	SPDK_CU_ASSERT_FATAL(any_host_policy != NULL);
+	CU_ASSERT(spdk_nvmf_qos_policy_get_hostnqn(any_host_policy) == NULL);
+	CU_ASSERT(spdk_nvmf_qos_policy_get_nsid(any_host_policy) == 0);
+	CU_ASSERT(any_host_policy->quota_per_timeslice[NVMF_QOS_RW_IOPS_RATE_LIMIT] == 10);
+	CU_ASSERT(any_host_policy->quota_per_timeslice[NVMF_QOS_RW_BPS_RATE_LIMIT] == 0);
+
+	/* host1, namespace 2 */
+	limits.rw_ios_per_sec = 0;
+	limits.max_queue_depth = 8;
+	rc = spdk_nvmf_subsystem_set_qos_limits(subsystem, host1, 2, &limits);
+	CU_ASSERT(rc == 0);
+	host_policy = spdk_nvmf_subsystem_get_next_qos_policy(subsystem, any_host_policy);
+	SPDK_CU_ASSERT_FATAL(host_policy != NULL);
+	CU_ASSERT(strcmp(spdk_nvmf_qos_policy_get_hostnqn(host_policy), host1) == 0);
+	CU_ASSERT(spdk_nvmf_qos_policy_get_nsid(host_policy) == 2);
+	spdk_nvmf_qos_policy_get_limits(host_policy, &out);
+	CU_ASSERT(out.max_queue_depth == 8);
+	CU_ASSERT(spdk_nvmf_subsystem_get_next_qos_policy(subsystem, host_policy) == NULL);
+
+	/* Invalid host NQN and NSID */
+	rc = spdk_nvmf_subsystem_set_qos_limits(subsystem, "nqn.host", 0, &limits);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_nvmf_subsystem_set_qos_limits(subsystem, host1, 5, &limits);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* Controllers resolve the policies of their host */
+	ctrlr1.subsys = subsystem;
+	ctrlr1.dynamic_ctrlr = true;
+	snprintf(ctrlr1.hostnqn, sizeof(ctrlr1.hostnqn), "%s", host1);
+	rc = nvmf_subsystem_add_ctrlr(subsystem, &ctrlr1);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(ctrlr1.qos != NULL);
+	CU_ASSERT(ctrlr1.qos->host_default == NULL);
+	CU_ASSERT(ctrlr1.qos->any_host_default == any_host_policy);
+	CU_ASSERT(ctrlr1.qos->num_ns == 2);
+	CU_ASSERT(ctrlr1.qos->ns[0].host == NULL);
+	CU_ASSERT(ctrlr1.qos->ns[0].any_host == any_host_policy);
+	CU_ASSERT(ctrlr1.qos->ns[1].host == host_policy);
+	CU_ASSERT(ctrlr1.qos->ns[1].any_host == any_host_policy);
+
+	ctrlr2.subsys = subsystem;
+	ctrlr2.dynamic_ctrlr = true;
+	snprintf(ctrlr2.hostnqn, sizeof(ctrlr2.hostnqn), "%s", host2);
+	rc = nvmf_subsystem_add_ctrlr(subsystem, &ctrlr2);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(ctrlr2.qos != NULL);
+	CU_ASSERT(ctrlr2.qos->host_default == NULL);
+	CU_ASSERT(ctrlr2.qos->any_host_default == any_host_policy);
+	CU_ASSERT(ctrlr2.qos->num_ns == 0);
+
+	/* Replacing a policy keeps its position and updates the controllers */
+	limits.rw_ios_per_sec = 0;
+	limits.rw_mbytes_per_sec = 100;
+	limits.max_queue_depth = 0;
+	rc = spdk_nvmf_subsystem_set_qos_limits(subsystem, NULL, 0, &limits);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	any_host_policy = spdk_nvmf_subsystem_get_first_qos_policy(subsystem);
+	SPDK_CU_ASSERT_FATAL(any_host_policy != NULL);
+	CU_ASSERT(spdk_nvmf_qos_policy_get_hostnqn(any_host_policy) == NULL);
+	CU_ASSERT(any_host_policy->quota_per_timeslice[NVMF_QOS_RW_BPS_RATE_LIMIT] == 104857);
+	CU_ASSERT(spdk_nvmf_subsystem_get_next_qos_policy(subsystem, any_host_policy) == host_policy);
+	CU_ASSERT(ctrlr1.qos->any_host_default == any_host_policy);
+	CU_ASSERT(ctrlr1.qos->ns[1].host == host_policy);
+	CU_ASSERT(ctrlr2.qos->any_host_default == any_host_policy);
+
+	/* Setting all limits to 0 removes the policy */
+	memset(&limits, 0, sizeof(limits));
+	rc = spdk_nvmf_subsystem_set_qos_limits(subsystem, host1, 2, &limits);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	CU_ASSERT(spdk_nvmf_subsystem_get_first_qos_policy(subsystem) == any_host_policy);
+	CU_ASSERT(spdk_nvmf_subsystem_get_next_qos_policy(subsystem, any_host_policy) == NULL);
+	SPDK_CU_ASSERT_FATAL(ctrlr1.qos != NULL);
+	CU_ASSERT(ctrlr1.qos->num_ns == 0);
+
+	rc = spdk_nvmf_subsystem_set_qos_limits(subsystem, NULL, 0, &limits);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	CU_ASSERT(spdk_nvmf_subsystem_get_first_qos_policy(subsystem) == NULL);
+	CU_ASSERT(ctrlr1.qos == NULL);
+	CU_ASSERT(ctrlr2.qos == NULL);
+
+	nvmf_subsystem_remove_ctrlr(subsystem, &ctrlr1);
+	nvmf_subsystem_remove_ctrlr(subsystem, &ctrlr2);
+	rc = spdk_nvmf_subsystem_destroy(subsystem, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	spdk_io_device_unregister(&tgt, NULL);
+	poll_threads();
+	free(tgt.subsystems);
+}
+
 static void
 test_nvmf_ns_reservation_report(void)
 {
@@ -1745,6 +1874,7 @@ int main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvmf_ns_reservation_add_remove_registrant);
 	CU_ADD_TEST(suite, test_nvmf_subsystem_add_ctrlr);
 	CU_ADD_TEST(suite, test_spdk_nvmf_subsystem_add_host);
+	CU_ADD_TEST(suite, test_spdk_nvmf_subsystem_set_qos_limits);
 	CU_ADD_TEST(suite, test_nvmf_ns_reservation_report);
 	CU_ADD_TEST(suite, test_nvmf_valid_nqn);
 	CU_ADD_TEST(suite, test_nvmf_ns_reservation_restore);
@@ -38,8 +38,6 @@
 
 DEFINE_STUB(spdk_nvmf_ctrlr_get_regs, const struct spdk_nvmf_registers *,
 	    (struct spdk_nvmf_ctrlr *ctrlr), NULL);
-DEFINE_STUB(spdk_mem_register, int, (void *vaddr, size_t len), 0);
-DEFINE_STUB(spdk_mem_unregister, int, (void *vaddr, size_t len), 0);
 DEFINE_STUB_V(spdk_nvmf_request_exec, (struct spdk_nvmf_request *req));
 DEFINE_STUB_V(spdk_nvmf_request_exec_fabrics, (struct spdk_nvmf_request *req));
 DEFINE_STUB(spdk_nvmf_request_complete, int, (struct spdk_nvmf_request *req), 0);
@@ -72,6 +70,35 @@ DEFINE_STUB(nvmf_ctrlr_restore_migr_data, int, (struct spdk_nvmf_ctrlr *ctrlr,
 		struct nvmf_ctrlr_migr_data *data), 0);
 DEFINE_STUB_V(nvmf_ctrlr_set_fatal_status, (struct spdk_nvmf_ctrlr *ctrlr));
 
+static int g_mem_register_cnt;
+static void *g_mem_register_vaddr;
+static size_t g_mem_register_len;
+
+DEFINE_RETURN_MOCK(spdk_mem_register, int);
+int
+spdk_mem_register(void *vaddr, size_t len)
+{
+	g_mem_register_cnt++;
+	g_mem_register_vaddr = vaddr;
+	g_mem_register_len = len;
+
+	HANDLE_RETURN_MOCK(spdk_mem_register);
+
+	return 0;
+}
+
+static int g_mem_unregister_cnt;
+static size_t g_mem_unregister_len;
+
+int
+spdk_mem_unregister(void *vaddr, size_t len)
+{
+	g_mem_unregister_cnt++;
+	g_mem_unregister_len += len;
+
+	return 0;
+}
+
 static void *
 gpa_to_vva(void *prv, uint64_t addr, uint64_t len, int prot)
 {
@@ -268,6 +295,7 @@ test_nvmf_vfio_user_create_destroy(void)
 					transport);
 	/* Allocate a endpoint for destroy */
 	endpoint = calloc(1, sizeof(*endpoint));
+	endpoint->cmb_fd = -1;
 	pthread_mutex_init(&endpoint->lock, NULL);
 	TAILQ_INSERT_TAIL(&vu_transport->endpoints, endpoint, link);
 	done = 0;
@@ -277,6 +305,311 @@ test_nvmf_vfio_user_create_destroy(void)
 	CU_ASSERT(done == 1);
 }
 
+static void
+test_vfio_user_mem_lazy_register(void)
+{
+	struct nvmf_vfio_user_transport vu_transport = {};
+	struct nvmf_vfio_user_endpoint endpoint = {};
+	struct nvmf_vfio_user_ctrlr ctrlr = {};
+	struct spdk_nvmf_request req = {};
+	struct nvmf_vfio_user_mem_region *region;
+	const size_t chunk = NVMF_VFIO_USER_MEM_REGISTER_CHUNK_SIZE;
+	/* Never dereferenced, only used to find regions and chunks */
+	uint8_t *vaddr = (uint8_t *)0x200000000000;
+	size_t len = 2 * chunk + 0x1000;
+
+	endpoint.transport = &vu_transport;
+	TAILQ_INIT(&vu_transport.endpoints);
+	TAILQ_INSERT_TAIL(&vu_transport.endpoints, &endpoint, link);
+	pthread_mutex_init(&vu_transport.lock, NULL);
+	pthread_mutex_init(&vu_transport.mem_thread_lock, NULL);
+	pthread_cond_init(&vu_transport.mem_thread_cond, NULL);
+	TAILQ_INIT(&endpoint.mem_regions);
+	pthread_mutex_init(&endpoint.mem_lock, NULL);
+	ctrlr.transport = &vu_transport;
+	ctrlr.endpoint = &endpoint;
+	req.iovcnt = 1;
+	g_mem_register_cnt = 0;
+	g_mem_unregister_cnt = 0;
+	g_mem_unregister_len = 0;
+
+	/* Mapping a region only tracks it */
+	vfio_user_mem_region_add(&endpoint, vaddr, len);
+	region = TAILQ_FIRST(&endpoint.mem_regions);
+	SPDK_CU_ASSERT_FATAL(region != NULL);
+	CU_ASSERT(region->chunks != NULL);
+	CU_ASSERT(g_mem_register_cnt == 0);
+
+	/* Buffers that are already in the memory maps don't take the lock */
+	req.iov[0].iov_base = vaddr + 0x100;
+	req.iov[0].iov_len = 0x1000;
+	pthread_mutex_lock(&endpoint.mem_lock);
+	CU_ASSERT(vfio_user_req_mem_ready(&ctrlr, &req));
+	pthread_mutex_unlock(&endpoint.mem_lock);
+	CU_ASSERT(!vu_transport.mem_register_pending);
+
+	/* The first use of a chunk hands it to the registration thread */
+	MOCK_SET(spdk_vtophys, SPDK_VTOPHYS_ERROR);
+	req.iov[0].iov_base = vaddr + chunk + 0x100;
+	CU_ASSERT(!vfio_user_req_mem_ready(&ctrlr, &req));
+	CU_ASSERT(vu_transport.mem_register_pending);
+	CU_ASSERT(g_mem_register_cnt == 0);
+	CU_ASSERT(region->chunks[0] == VFIO_USER_MEM_CHUNK_UNREGISTERED);
+	CU_ASSERT(region->chunks[1] == VFIO_USER_MEM_CHUNK_PENDING);
+
+	/* Later users of a pending chunk keep waiting for it */
+	vu_transport.mem_register_pending = false;
+	req.iov[0].iov_base = vaddr + chunk + 0x2000;
+	CU_ASSERT(!vfio_user_req_mem_ready(&ctrlr, &req));
+	CU_ASSERT(!vu_transport.mem_register_pending);
+
+	/* The poll group doesn't wait for the lock held by the registration thread */
+	pthread_mutex_lock(&endpoint.mem_lock);
+	req.iov[0].iov_base = vaddr + 0x100;
+	CU_ASSERT(!vfio_user_req_mem_ready(&ctrlr, &req));
+	pthread_mutex_unlock(&endpoint.mem_lock);
+	CU_ASSERT(region->chunks[0] == VFIO_USER_MEM_CHUNK_UNREGISTERED);
+
+	/* A buffer across two chunks waits for the second one, the last chunk is short */
+	req.iov[0].iov_base = vaddr + 2 * chunk - 0x10;
+	req.iov[0].iov_len = 0x20;
+	CU_ASSERT(!vfio_user_req_mem_ready(&ctrlr, &req));
+	CU_ASSERT(region->chunks[2] == VFIO_USER_MEM_CHUNK_PENDING);
+
+	/* The registration thread registers all pending chunks in one pass */
+	vfio_user_mem_register_pending(&endpoint);
+	CU_ASSERT(g_mem_register_cnt == 2);
+	CU_ASSERT(g_mem_register_vaddr == vaddr + 2 * chunk);
+	CU_ASSERT(g_mem_register_len == 0x1000);
+	CU_ASSERT(region->chunks[0] == VFIO_USER_MEM_CHUNK_UNREGISTERED);
+	CU_ASSERT(region->chunks[1] == VFIO_USER_MEM_CHUNK_REGISTERED);
+	CU_ASSERT(region->chunks[2] == VFIO_USER_MEM_CHUNK_REGISTERED);
+	CU_ASSERT(vfio_user_req_mem_ready(&ctrlr, &req));
+
+	/* Memory outside of any region is left alone */
+	req.iov[0].iov_base = vaddr + len;
+	CU_ASSERT(vfio_user_req_mem_ready(&ctrlr, &req));
+
+	/* A failed registration isn't retried */
+	MOCK_SET(spdk_mem_register, -ENOMEM);
+	req.iov[0].iov_base = vaddr;
+	CU_ASSERT(!vfio_user_req_mem_ready(&ctrlr, &req));
+	vfio_user_mem_register_pending(&endpoint);
+	CU_ASSERT(g_mem_register_cnt == 3);
+	CU_ASSERT(region->chunks[0] == VFIO_USER_MEM_CHUNK_FAILED);
+	CU_ASSERT(vfio_user_req_mem_ready(&ctrlr, &req));
+	vfio_user_mem_register_pending(&endpoint);
+	CU_ASSERT(g_mem_register_cnt == 3);
+	MOCK_CLEAR(spdk_mem_register);
+
+	/* A buffer spanning two adjacent regions waits for a chunk in each */
+	vfio_user_mem_region_add(&endpoint, vaddr + len, chunk);
+	req.iov[0].iov_base = vaddr + len - 0x10;
+	CU_ASSERT(!vfio_user_req_mem_ready(&ctrlr, &req));
+	region = vfio_user_find_mem_region(&endpoint, vaddr + len);
+	SPDK_CU_ASSERT_FATAL(region != NULL);
+	CU_ASSERT(region->vaddr == vaddr + len);
+	CU_ASSERT(region->chunks[0] == VFIO_USER_MEM_CHUNK_PENDING);
+
+	/* The registration thread finds pending chunks through the endpoint list */
+	CU_ASSERT(vu_transport.mem_register_pending);
+	pthread_create(&vu_transport.mem_tid, NULL, vfio_user_mem_register_thread, &vu_transport);
+	while (g_mem_register_cnt != 4) {
+		sched_yield();
+	}
+	pthread_mutex_lock(&vu_transport.mem_thread_lock);
+	vu_transport.mem_thread_exit = true;
+	pthread_cond_signal(&vu_transport.mem_thread_cond);
+	pthread_mutex_unlock(&vu_transport.mem_thread_lock);
+	pthread_join(vu_transport.mem_tid, NULL);
+	CU_ASSERT(!vu_transport.mem_register_pending);
+	CU_ASSERT(g_mem_register_vaddr == vaddr + len);
+	CU_ASSERT(g_mem_register_len == chunk);
+	CU_ASSERT(region->chunks[0] == VFIO_USER_MEM_CHUNK_REGISTERED);
+	CU_ASSERT(vfio_user_req_mem_ready(&ctrlr, &req));
+
+	/* Unmapping unregisters only the registered chunks */
+	vfio_user_mem_region_remove(&endpoint, vaddr, len);
+	CU_ASSERT(g_mem_unregister_cnt == 2);
+	CU_ASSERT(g_mem_unregister_len == chunk + 0x1000);
+	CU_ASSERT(vfio_user_find_mem_region(&endpoint, vaddr) == NULL);
+
+	vfio_user_mem_region_remove(&endpoint, vaddr + len, chunk);
+	CU_ASSERT(g_mem_unregister_cnt == 3);
+	CU_ASSERT(TAILQ_EMPTY(&endpoint.mem_regions));
+
+	/* Unknown regions are ignored */
+	vfio_user_mem_region_remove(&endpoint, vaddr, len);
+	CU_ASSERT(g_mem_unregister_cnt == 3);
+	MOCK_CLEAR(spdk_vtophys);
+
+	/* With lazy registration disabled, regions are registered when mapped */
+	vu_transport.transport_opts.disable_lazy_mem_register = true;
+	g_mem_register_cnt = 0;
+	g_mem_unregister_cnt = 0;
+	g_mem_unregister_len = 0;
+
+	vfio_user_mem_region_add(&endpoint, vaddr, len);
+	CU_ASSERT(g_mem_register_cnt == 1);
+	CU_ASSERT(g_mem_register_vaddr == vaddr);
+	CU_ASSERT(g_mem_register_len == len);
+	region = TAILQ_FIRST(&endpoint.mem_regions);
+	SPDK_CU_ASSERT_FATAL(region != NULL);
+	CU_ASSERT(region->chunks == NULL);
+
+	MOCK_SET(spdk_vtophys, SPDK_VTOPHYS_ERROR);
+	req.iov[0].iov_base = vaddr + chunk;
+	req.iov[0].iov_len = 0x1000;
+	CU_ASSERT(vfio_user_req_mem_ready(&ctrlr, &req));
+	CU_ASSERT(g_mem_register_cnt == 1);
+	MOCK_CLEAR(spdk_vtophys);
+
+	vfio_user_mem_region_remove(&endpoint, vaddr, len);
+	CU_ASSERT(g_mem_unregister_cnt == 1);
+	CU_ASSERT(g_mem_unregister_len == len);
+	CU_ASSERT(TAILQ_EMPTY(&endpoint.mem_regions));
+
+	pthread_mutex_destroy(&endpoint.mem_lock);
+	pthread_cond_destroy(&vu_transport.mem_thread_cond);
+	pthread_mutex_destroy(&vu_transport.mem_thread_lock);
+	pthread_mutex_destroy(&vu_transport.lock);
+}
+
+static void
+test_vfio_user_cmb_map_one(void)
+{
+	struct nvmf_vfio_user_endpoint endpoint = {};
+	uint8_t cmb[0x4000];
+
+	endpoint.cmb = cmb;
+	endpoint.cmb_size = sizeof(cmb);
+
+	/* Memory space disabled: nothing is in the CMB */
+	endpoint.cmbmsc.bits.cre = 1;
+	endpoint.cmbmsc.bits.cba = 0x100;
+	CU_ASSERT(cmb_map_one(&endpoint, 0x100000, 8) == NULL);
+
+	endpoint.cmbmsc.bits.cmse = 1;
+	CU_ASSERT(cmb_map_one(&endpoint, 0x100000, 8) == cmb);
+	CU_ASSERT(cmb_map_one(&endpoint, 0x101000, 0x3000) == cmb + 0x1000);
+
+	/* Below, past the end of and straddling the end of the CMB */
+	CU_ASSERT(cmb_map_one(&endpoint, 0xff000, 8) == NULL);
+	CU_ASSERT(cmb_map_one(&endpoint, 0x104000, 8) == NULL);
+	CU_ASSERT(cmb_map_one(&endpoint, 0x103ff8, 16) == NULL);
+	CU_ASSERT(cmb_map_one(&endpoint, 0x100000, UINT64_MAX) == NULL);
+}
+
+static void
+test_vfio_user_cmb_map_data(void)
+{
+	struct nvmf_vfio_user_endpoint endpoint = {};
+	struct nvmf_vfio_user_ctrlr ctrlr = {};
+	struct nvmf_vfio_user_sq sq = {};
+	struct nvmf_vfio_user_req *vu_req;
+	uint8_t cmb[0x4000];
+
+	endpoint.cmb = cmb;
+	endpoint.cmb_size = sizeof(cmb);
+	endpoint.cmbmsc.bits.cre = 1;
+	endpoint.cmbmsc.bits.cmse = 1;
+	endpoint.cmbmsc.bits.cba = 0x100;
+	ctrlr.endpoint = &endpoint;
+	sq.ctrlr = &ctrlr;
+
+	vu_req = calloc(1, sizeof(*vu_req));
+	SPDK_CU_ASSERT_FATAL(vu_req != NULL);
+	vu_req->req.qpair = &sq.qpair;
+	vu_req->req.rsp = (union nvmf_c2h_msg *)&vu_req->rsp;
+
+	/* PRP lists can always be read from the CMB */
+	CU_ASSERT(_map_one(&vu_req->req, 0x101000, 0x1000, PROT_READ) == cmb + 0x1000);
+	CU_ASSERT(vu_req->iovcnt == 0);
+	CU_ASSERT(vu_req->rsp.status.sc == SPDK_NVME_SC_SUCCESS);
+
+	/* Data may only be placed in the CMB when RDS/WDS are advertised */
+	CU_ASSERT(_map_one(&vu_req->req, 0x102000, 0x1000, PROT_READ | PROT_WRITE) == NULL);
+	CU_ASSERT(vu_req->iovcnt == 0);
+	CU_ASSERT(vu_req->rsp.status.sct == SPDK_NVME_SCT_GENERIC);
+	CU_ASSERT(vu_req->rsp.status.sc == SPDK_NVME_SC_INVALID_CONTROLLER_MEM_BUF);
+
+	memset(&vu_req->rsp, 0, sizeof(vu_req->rsp));
+	endpoint.cmb_data_supported = true;
+	CU_ASSERT(_map_one(&vu_req->req, 0x102000, 0x1000,
+			   PROT_READ | PROT_WRITE) == cmb + 0x2000);
+	CU_ASSERT(vu_req->iovcnt == 0);
+	CU_ASSERT(vu_req->rsp.status.sc == SPDK_NVME_SC_SUCCESS);
+
+	free(vu_req);
+}
+
+static void
+test_vfio_user_migr_cmb(void)
+{
+	struct nvmf_vfio_user_endpoint src = {}, dst = {};
+	struct vfio_user_nvme_migr_header header = {};
+	size_t cmb_size = 0x4000;
+	int rc;
+
+	src.cmb = malloc(cmb_size);
+	SPDK_CU_ASSERT_FATAL(src.cmb != NULL);
+	src.cmb_size = cmb_size;
+	memset(src.cmb, 0xa5, cmb_size);
+	src.cmbmsc.bits.cre = 1;
+	src.cmbmsc.bits.cmse = 1;
+	src.cmbmsc.bits.cba = 0x100;
+	src.migr_data = calloc(1, vfio_user_migr_data_len(&src));
+	SPDK_CU_ASSERT_FATAL(src.migr_data != NULL);
+	CU_ASSERT(vfio_user_migr_data_len(&src) == vfio_user_migr_cmb_offset() + cmb_size);
+
+	/* Contents and CMBMSC are saved after the device state */
+	vfio_user_migr_save_cmb(&src, &header);
+	CU_ASSERT(header.bar_offset[VFU_PCI_DEV_BAR2_REGION_IDX] == vfio_user_migr_cmb_offset());
+	CU_ASSERT(header.bar_len[VFU_PCI_DEV_BAR2_REGION_IDX] == cmb_size);
+	CU_ASSERT(header.cmbmsc == src.cmbmsc.raw);
+
+	/* The destination gets the same contents and mapping */
+	dst.cmb = calloc(1, cmb_size);
+	SPDK_CU_ASSERT_FATAL(dst.cmb != NULL);
+	dst.cmb_size = cmb_size;
+	dst.migr_data = src.migr_data;
+	rc = vfio_user_migr_restore_cmb(&dst, &header);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(memcmp(dst.cmb, src.cmb, cmb_size) == 0);
+	CU_ASSERT(dst.cmbmsc.raw == src.cmbmsc.raw);
+	CU_ASSERT(cmb_map_one(&dst, 0x100000 + 0x200, 64) == (uint8_t *)dst.cmb + 0x200);
+
+	/* A disabled CMB can't have its memory space enabled */
+	dst.cmbmsc.raw = 0;
+	header.cmbmsc = 0;
+	((union spdk_nvme_cmbmsc_register *)&header.cmbmsc)->bits.cmse = 1;
+	rc = vfio_user_migr_restore_cmb(&dst, &header);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(dst.cmbmsc.raw == 0);
+
+	/* Different CMB sizes can't be migrated */
+	dst.cmb_size = cmb_size / 2;
+	rc = vfio_user_migr_restore_cmb(&dst, &header);
+	CU_ASSERT(rc == -EINVAL);
+	dst.cmb_size = cmb_size;
+
+	/* Neither can a CMB to a destination without one */
+	free(dst.cmb);
+	dst.cmb = NULL;
+	dst.cmb_size = 0;
+	rc = vfio_user_migr_restore_cmb(&dst, &header);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* A source without a CMB leaves it disabled */
+	memset(&header, 0, sizeof(header));
+	rc = vfio_user_migr_restore_cmb(&dst, &header);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(dst.cmbmsc.raw == 0);
+
+	free(src.migr_data);
+	free(src.cmb);
+}
+
 int main(int argc, char **argv)
 {
 	CU_pSuite	suite = NULL;
@@ -290,6 +623,10 @@ int main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_cmd_map_prps);
 	CU_ADD_TEST(suite, test_nvme_cmd_map_sgls);
 	CU_ADD_TEST(suite, test_nvmf_vfio_user_create_destroy);
+	CU_ADD_TEST(suite, test_vfio_user_mem_lazy_register);
+	CU_ADD_TEST(suite, test_vfio_user_cmb_map_one);
+	CU_ADD_TEST(suite, test_vfio_user_cmb_map_data);
+	CU_ADD_TEST(suite, test_vfio_user_migr_cmb);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
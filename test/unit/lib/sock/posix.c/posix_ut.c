@@ -51,6 +51,7 @@ DEFINE_STUB_V(spdk_sock_map_cleanup, (struct spdk_sock_map *map));
 
 DEFINE_STUB_V(spdk_net_impl_register, (struct spdk_net_impl *impl, int priority));
 DEFINE_STUB(spdk_sock_close, int, (struct spdk_sock **s), 0);
+DEFINE_STUB(spdk_sock_send_budget, uint64_t, (struct spdk_sock *sock), 0);
 
 static void
 _req_cb(void *cb_arg, int len)
@@ -159,18 +160,192 @@ flush(void)
 	free(req2);
 }
 
+#define UT_SSL_PSK_KEY		"1234567890ABCDEF1234567890ABCDEF"
+#define UT_SSL_PSK_IDENTITY	"NVMe0R01 nqn.2016-06.io.spdk:host nqn.2016-06.io.spdk:cnode1"
+#define UT_SSL_PORT		53260
+
+static struct spdk_sock *
+ut_ssl_accept(struct spdk_sock *listen_sock, struct spdk_sock **client)
+{
+	struct spdk_sock_opts opts = { .opts_size = sizeof(opts) };
+	struct spdk_sock *server = NULL;
+	int i;
+
+	/* Neither side waits for the handshake, it is driven by the reads and writes */
+	*client = ssl_sock_connect("127.0.0.1", UT_SSL_PORT, &opts);
+	SPDK_CU_ASSERT_FATAL(*client != NULL);
+
+	for (i = 0; i < 1000 && server == NULL; i++) {
+		server = posix_sock_accept(listen_sock);
+		if (server == NULL) {
+			usleep(1000);
+		}
+	}
+
+	return server;
+}
+
+static void
+ut_ssl_drain(struct spdk_sock *listen_sock)
+{
+	struct spdk_sock *server;
+
+	/* Connections the client side gave up on may still be waiting to be accepted */
+	server = posix_sock_accept(listen_sock);
+	if (server != NULL) {
+		posix_sock_close(server);
+	}
+}
+
+static void
+ssl_loopback(void)
+{
+	struct spdk_sock_opts opts = { .opts_size = sizeof(opts) };
+	struct spdk_sock_impl_opts impl_opts;
+	struct spdk_sock *listen_sock, *server, *client;
+	struct spdk_posix_sock *psock;
+	char wbuf[8192], rbuf[8192];
+	struct iovec iov[2];
+	size_t len;
+	ssize_t total, rc;
+	bool written = false;
+	int i;
+
+	/* Earlier tests leave sendmsg() mocked */
+	MOCK_CLEAR(sendmsg);
+
+	len = sizeof(impl_opts);
+	CU_ASSERT(ssl_sock_impl_get_opts(&impl_opts, &len) == 0);
+	CU_ASSERT(impl_opts.enable_ktls == true);
+	impl_opts.psk_key = UT_SSL_PSK_KEY;
+	impl_opts.psk_identity = UT_SSL_PSK_IDENTITY;
+	CU_ASSERT(ssl_sock_impl_set_opts(&impl_opts, len) == 0);
+	/* The implementation keeps its own copies */
+	CU_ASSERT(g_spdk_ssl_sock_impl_opts.psk_key != impl_opts.psk_key);
+	CU_ASSERT(strcmp(g_spdk_ssl_sock_impl_opts.psk_key, UT_SSL_PSK_KEY) == 0);
+
+	/* Nothing is changed if any of the options is invalid */
+	impl_opts.psk_key = "not a key";
+	impl_opts.psk_identity = "other";
+	impl_opts.enable_ktls = false;
+	CU_ASSERT(ssl_sock_impl_set_opts(&impl_opts, len) != 0);
+	CU_ASSERT(strcmp(g_spdk_ssl_sock_impl_opts.psk_key, UT_SSL_PSK_KEY) == 0);
+	CU_ASSERT(strcmp(g_spdk_ssl_sock_impl_opts.psk_identity, UT_SSL_PSK_IDENTITY) == 0);
+	CU_ASSERT(g_spdk_ssl_sock_impl_opts.enable_ktls == true);
+	impl_opts.psk_key = UT_SSL_PSK_KEY;
+	impl_opts.psk_identity = UT_SSL_PSK_IDENTITY;
+	impl_opts.enable_ktls = true;
+
+	/* Only used when asked for by name */
+	CU_ASSERT(g_ssl_net_impl.by_name_only);
+	CU_ASSERT(!g_posix_net_impl.by_name_only);
+
+	listen_sock = ssl_sock_listen("127.0.0.1", UT_SSL_PORT, &opts);
+	SPDK_CU_ASSERT_FATAL(listen_sock != NULL);
+	psock = __posix_sock(listen_sock);
+	CU_ASSERT(psock->ctx != NULL);
+	CU_ASSERT(psock->ssl == NULL);
+
+	server = ut_ssl_accept(listen_sock, &client);
+	SPDK_CU_ASSERT_FATAL(server != NULL);
+	psock = __posix_sock(server);
+	CU_ASSERT(psock->ssl != NULL);
+	CU_ASSERT(!psock->ssl_ready);
+	psock = __posix_sock(client);
+	SPDK_CU_ASSERT_FATAL(psock->ssl != NULL);
+	CU_ASSERT(!psock->ssl_ready);
+
+	for (i = 0; i < (int)sizeof(wbuf); i++) {
+		wbuf[i] = (char)i;
+	}
+
+	/*
+	 * Data written through the client comes out of the server in clear text. The
+	 * handshake is driven by the reads and writes, which return EAGAIN until it's done.
+	 */
+	iov[0].iov_base = wbuf;
+	iov[0].iov_len = 100;
+	iov[1].iov_base = wbuf + 100;
+	iov[1].iov_len = sizeof(wbuf) - 100;
+
+	total = 0;
+	for (i = 0; i < 1000 && total < (ssize_t)sizeof(rbuf); i++) {
+		if (!written) {
+			rc = posix_sock_writev(client, iov, 2);
+			if (rc > 0) {
+				CU_ASSERT(rc == sizeof(wbuf));
+				written = true;
+			} else {
+				CU_ASSERT(rc < 0 && errno == EAGAIN);
+			}
+		}
+
+		rc = posix_sock_recv(server, rbuf + total, sizeof(rbuf) - total);
+		if (rc > 0) {
+			total += rc;
+		} else {
+			CU_ASSERT(rc < 0 && errno == EAGAIN);
+			usleep(1000);
+		}
+	}
+	CU_ASSERT(written);
+	CU_ASSERT(total == sizeof(rbuf));
+	CU_ASSERT(memcmp(wbuf, rbuf, sizeof(rbuf)) == 0);
+	CU_ASSERT(psock->ssl_ready);
+	CU_ASSERT(SSL_version(psock->ssl) == TLS1_3_VERSION);
+
+	/* A closed connection reads as EOF */
+	posix_sock_close(client);
+	for (i = 0; i < 1000; i++) {
+		rc = posix_sock_recv(server, rbuf, sizeof(rbuf));
+		if (rc >= 0 || errno != EAGAIN) {
+			break;
+		}
+		usleep(1000);
+	}
+	CU_ASSERT(rc == 0);
+	posix_sock_close(server);
+
+	/* A handshake that doesn't complete in time fails the connection */
+	client = ssl_sock_connect("127.0.0.1", UT_SSL_PORT, &opts);
+	SPDK_CU_ASSERT_FATAL(client != NULL);
+	rc = posix_sock_writev(client, iov, 2);
+	CU_ASSERT(rc < 0 && errno == EAGAIN);
+	spdk_delay_us(SSL_HANDSHAKE_TIMEOUT_MS * 1000);
+	rc = posix_sock_writev(client, iov, 2);
+	CU_ASSERT(rc < 0 && errno == ETIMEDOUT);
+	posix_sock_close(client);
+	ut_ssl_drain(listen_sock);
+
+	/* Without a PSK there is nothing to authenticate with, so the handshake fails */
+	impl_opts.psk_key = NULL;
+	impl_opts.psk_identity = NULL;
+	CU_ASSERT(ssl_sock_impl_set_opts(&impl_opts, len) == 0);
+	CU_ASSERT(g_spdk_ssl_sock_impl_opts.psk_key == NULL);
+	CU_ASSERT(g_spdk_ssl_sock_impl_opts.psk_identity == NULL);
+	client = ssl_sock_connect("127.0.0.1", UT_SSL_PORT, &opts);
+	CU_ASSERT(client == NULL);
+	ut_ssl_drain(listen_sock);
+
+	posix_sock_close(listen_sock);
+}
+
 int
 main(int argc, char **argv)
 {
 	CU_pSuite	suite = NULL;
 	unsigned int	num_failures;
 
+	/* Like applications do, the TLS tests write to connections closed by the peer */
+	signal(SIGPIPE, SIG_IGN);
+
 	CU_set_error_action(CUEA_ABORT);
 	CU_initialize_registry();
 
 	suite = CU_add_suite("posix", NULL, NULL);
 
 	CU_ADD_TEST(suite, flush);
+	CU_ADD_TEST(suite, ssl_loopback);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 
@@ -0,0 +1,489 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "spdk/stdinc.h"
+#include "spdk/util.h"
+
+#include "spdk_internal/mock.h"
+
+#include "spdk_cunit.h"
+
+#include "common/lib/test_env.c"
+#include "sock/shm/shm.c"
+
+#define UT_IP	"ut_shm"
+#define UT_PORT	7890
+
+DEFINE_STUB(spdk_sock_map_insert, int, (struct spdk_sock_map *map, int placement_id,
+					struct spdk_sock_group_impl *group), 0);
+DEFINE_STUB_V(spdk_sock_map_release, (struct spdk_sock_map *map, int placement_id));
+DEFINE_STUB(spdk_sock_map_lookup, int, (struct spdk_sock_map *map, int placement_id,
+					struct spdk_sock_group_impl **group, struct spdk_sock_group_impl *hint), 0);
+DEFINE_STUB(spdk_sock_map_find_free, int, (struct spdk_sock_map *map), -1);
+DEFINE_STUB_V(spdk_sock_map_cleanup, (struct spdk_sock_map *map));
+
+DEFINE_STUB_V(spdk_net_impl_register, (struct spdk_net_impl *impl, int priority));
+DEFINE_STUB(spdk_sock_close, int, (struct spdk_sock **s), 0);
+DEFINE_STUB(spdk_sock_send_budget, uint64_t, (struct spdk_sock *sock), UINT64_MAX);
+
+static void
+_connect(struct spdk_sock **listen_sock, struct spdk_sock **client, struct spdk_sock **server)
+{
+	*listen_sock = shm_sock_listen(UT_IP, UT_PORT, NULL);
+	SPDK_CU_ASSERT_FATAL(*listen_sock != NULL);
+
+	/* The connecting side passes the region right away, so accept does not wait */
+	*client = shm_sock_connect(UT_IP, UT_PORT, NULL);
+	SPDK_CU_ASSERT_FATAL(*client != NULL);
+
+	*server = shm_sock_accept(*listen_sock);
+	SPDK_CU_ASSERT_FATAL(*server != NULL);
+}
+
+static void
+loopback(void)
+{
+	struct spdk_sock *listen_sock, *client, *server, *other;
+	char saddr[64], caddr[64];
+	uint16_t sport, cport;
+	char buf[64] = {};
+	ssize_t rc;
+
+	/* Nobody listens on this port, so another implementation has to be used */
+	other = shm_sock_connect(UT_IP, UT_PORT + 1, NULL);
+	CU_ASSERT(other == NULL);
+
+	_connect(&listen_sock, &client, &server);
+
+	/* A second listener on the same name is refused */
+	other = shm_sock_listen(UT_IP, UT_PORT, NULL);
+	CU_ASSERT(other == NULL);
+
+	rc = shm_sock_getaddr(server, saddr, sizeof(saddr), &sport, caddr, sizeof(caddr), &cport);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(strcmp(saddr, UT_IP) == 0);
+	CU_ASSERT(sport == UT_PORT);
+	CU_ASSERT(shm_sock_is_connected(client));
+	CU_ASSERT(shm_sock_is_connected(server));
+	CU_ASSERT(!shm_sock_is_ipv4(client));
+	CU_ASSERT(!shm_sock_is_ipv6(client));
+
+	/* Nothing was written yet */
+	rc = shm_sock_recv(server, buf, sizeof(buf));
+	CU_ASSERT(rc == -1);
+	CU_ASSERT(errno == EAGAIN);
+
+	/* Both directions */
+	rc = shm_sock_writev(client, &(struct iovec) { .iov_base = "ping", .iov_len = 4 }, 1);
+	CU_ASSERT(rc == 4);
+	rc = shm_sock_recv(server, buf, sizeof(buf));
+	CU_ASSERT(rc == 4);
+	CU_ASSERT(memcmp(buf, "ping", 4) == 0);
+
+	rc = shm_sock_writev(server, &(struct iovec) { .iov_base = "pong", .iov_len = 4 }, 1);
+	CU_ASSERT(rc == 4);
+	rc = shm_sock_recv(client, buf, 2);
+	CU_ASSERT(rc == 2);
+	CU_ASSERT(memcmp(buf, "po", 2) == 0);
+	rc = shm_sock_recv(client, buf, sizeof(buf));
+	CU_ASSERT(rc == 2);
+	CU_ASSERT(memcmp(buf, "ng", 2) == 0);
+
+	/* Data written before the close is still received, then the end of the stream */
+	rc = shm_sock_writev(client, &(struct iovec) { .iov_base = "bye", .iov_len = 3 }, 1);
+	CU_ASSERT(rc == 3);
+	shm_sock_close(client);
+
+	CU_ASSERT(!shm_sock_is_connected(server));
+	rc = shm_sock_writev(server, &(struct iovec) { .iov_base = "late", .iov_len = 4 }, 1);
+	CU_ASSERT(rc == -1);
+	CU_ASSERT(errno == EPIPE);
+	rc = shm_sock_recv(server, buf, sizeof(buf));
+	CU_ASSERT(rc == 3);
+	CU_ASSERT(memcmp(buf, "bye", 3) == 0);
+	rc = shm_sock_recv(server, buf, sizeof(buf));
+	CU_ASSERT(rc == 0);
+
+	shm_sock_close(server);
+	shm_sock_close(listen_sock);
+}
+
+static void
+ring_wrap(void)
+{
+	struct spdk_sock_impl_opts opts, saved;
+	size_t len = sizeof(opts);
+	struct spdk_sock *listen_sock, *client, *server;
+	struct spdk_shm_sock *sclient;
+	struct iovec iov[2];
+	uint8_t *wbuf, *rbuf;
+	void *lent;
+	size_t chunk, i;
+	ssize_t rc;
+
+	shm_sock_impl_get_opts(&saved, &len);
+	opts = saved;
+	opts.send_buf_size = 1;
+	shm_sock_impl_set_opts(&opts, sizeof(opts));
+
+	_connect(&listen_sock, &client, &server);
+	sclient = __shm_sock(client);
+	CU_ASSERT(sclient->tx_size == SPDK_SHM_SOCK_MIN_RING_SIZE);
+
+	shm_sock_impl_set_opts(&saved, sizeof(saved));
+
+	chunk = SPDK_SHM_SOCK_MIN_RING_SIZE * 3 / 4;
+	wbuf = malloc(SPDK_SHM_SOCK_MIN_RING_SIZE * 2);
+	rbuf = malloc(SPDK_SHM_SOCK_MIN_RING_SIZE * 2);
+	SPDK_CU_ASSERT_FATAL(wbuf != NULL && rbuf != NULL);
+	for (i = 0; i < SPDK_SHM_SOCK_MIN_RING_SIZE * 2; i++) {
+		wbuf[i] = i % 251;
+	}
+
+	/* The ring only takes as much as fits */
+	iov[0].iov_base = wbuf;
+	iov[0].iov_len = SPDK_SHM_SOCK_MIN_RING_SIZE * 2;
+	rc = shm_sock_writev(client, iov, 1);
+	CU_ASSERT(rc == SPDK_SHM_SOCK_MIN_RING_SIZE);
+	rc = shm_sock_writev(client, &(struct iovec) { .iov_base = wbuf, .iov_len = 1 }, 1);
+	CU_ASSERT(rc == -1);
+	CU_ASSERT(errno == EAGAIN);
+	rc = shm_sock_recv(server, rbuf, SPDK_SHM_SOCK_MIN_RING_SIZE * 2);
+	CU_ASSERT(rc == SPDK_SHM_SOCK_MIN_RING_SIZE);
+	CU_ASSERT(memcmp(wbuf, rbuf, SPDK_SHM_SOCK_MIN_RING_SIZE) == 0);
+
+	/* Move the ring position, then write across the end of the ring */
+	rc = shm_sock_writev(client, &(struct iovec) { .iov_base = wbuf, .iov_len = chunk }, 1);
+	CU_ASSERT(rc == (ssize_t)chunk);
+	rc = shm_sock_recv(server, rbuf, chunk);
+	CU_ASSERT(rc == (ssize_t)chunk);
+
+	iov[0].iov_base = wbuf;
+	iov[0].iov_len = chunk / 2;
+	iov[1].iov_base = wbuf + chunk / 2;
+	iov[1].iov_len = chunk / 2;
+	rc = shm_sock_writev(client, iov, 2);
+	CU_ASSERT(rc == (ssize_t)chunk);
+
+	/* Lending stops at the end of the ring */
+	rc = shm_sock_recv_lend(server, &lent);
+	CU_ASSERT(rc == SPDK_SHM_SOCK_MIN_RING_SIZE - (ssize_t)chunk);
+	CU_ASSERT(memcmp(lent, wbuf, rc) == 0);
+	CU_ASSERT(shm_sock_recv_return(server, rc + 1) == -1);
+	CU_ASSERT(shm_sock_recv_return(server, rc) == 0);
+
+	memset(rbuf, 0, chunk);
+	iov[0].iov_base = rbuf;
+	iov[0].iov_len = 100;
+	iov[1].iov_base = rbuf + 100;
+	iov[1].iov_len = chunk;
+	rc = shm_sock_readv(server, iov, 2);
+	CU_ASSERT(rc == 2 * (ssize_t)chunk - SPDK_SHM_SOCK_MIN_RING_SIZE);
+	CU_ASSERT(memcmp(rbuf, wbuf + SPDK_SHM_SOCK_MIN_RING_SIZE - chunk, rc) == 0);
+
+	free(wbuf);
+	free(rbuf);
+	shm_sock_close(client);
+	shm_sock_close(server);
+	shm_sock_close(listen_sock);
+}
+
+static int
+_raw_connect(void)
+{
+	struct sockaddr_un addr;
+	socklen_t len;
+	int fd;
+
+	SPDK_CU_ASSERT_FATAL(shm_sock_addr(UT_IP, UT_PORT, &addr, &len) == 0);
+	fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	SPDK_CU_ASSERT_FATAL(fd >= 0);
+	SPDK_CU_ASSERT_FATAL(connect(fd, (struct sockaddr *)&addr, len) == 0);
+
+	return fd;
+}
+
+static int
+_raw_region(bool seal, uint64_t rx_offset)
+{
+	struct spdk_shm_sock_hdr *hdr;
+	size_t size = SPDK_SHM_SOCK_HDR_SIZE + 2 * SPDK_SHM_SOCK_MIN_RING_SIZE;
+	int memfd;
+
+	memfd = memfd_create("ut_shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	SPDK_CU_ASSERT_FATAL(memfd >= 0);
+	SPDK_CU_ASSERT_FATAL(ftruncate(memfd, size) == 0);
+
+	hdr = mmap(NULL, SPDK_SHM_SOCK_HDR_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+	SPDK_CU_ASSERT_FATAL(hdr != MAP_FAILED);
+	hdr->magic = SPDK_SHM_SOCK_MAGIC;
+	hdr->version = SPDK_SHM_SOCK_VERSION;
+	hdr->rings[0].size = SPDK_SHM_SOCK_MIN_RING_SIZE;
+	hdr->rings[0].offset = SPDK_SHM_SOCK_HDR_SIZE;
+	hdr->rings[1].size = SPDK_SHM_SOCK_MIN_RING_SIZE;
+	hdr->rings[1].offset = rx_offset;
+	munmap(hdr, SPDK_SHM_SOCK_HDR_SIZE);
+
+	if (seal) {
+		SPDK_CU_ASSERT_FATAL(fcntl(memfd, F_ADD_SEALS, SPDK_SHM_SOCK_SEALS) == 0);
+	}
+
+	return memfd;
+}
+
+static void
+accept_handoff(void)
+{
+	struct spdk_sock *listen_sock, *server;
+	struct spdk_shm_sock *slisten, *sserver;
+	uint64_t rx_offset = SPDK_SHM_SOCK_HDR_SIZE + SPDK_SHM_SOCK_MIN_RING_SIZE;
+	int fd, memfd;
+
+	listen_sock = shm_sock_listen(UT_IP, UT_PORT, NULL);
+	SPDK_CU_ASSERT_FATAL(listen_sock != NULL);
+	slisten = __shm_sock(listen_sock);
+
+	/* Accept doesn't wait for the region, the connection is kept aside until it comes */
+	fd = _raw_connect();
+	server = shm_sock_accept(listen_sock);
+	CU_ASSERT(server == NULL);
+	CU_ASSERT(slisten->num_pending == 1);
+
+	memfd = _raw_region(true, rx_offset);
+	CU_ASSERT(shm_sock_send_region(fd, memfd) == 0);
+	server = shm_sock_accept(listen_sock);
+	SPDK_CU_ASSERT_FATAL(server != NULL);
+	CU_ASSERT(slisten->num_pending == 0);
+	sserver = __shm_sock(server);
+	CU_ASSERT(sserver->rx_size == SPDK_SHM_SOCK_MIN_RING_SIZE);
+	shm_sock_close(server);
+	close(memfd);
+	close(fd);
+
+	/* A region that can be resized is refused */
+	fd = _raw_connect();
+	memfd = _raw_region(false, rx_offset);
+	CU_ASSERT(shm_sock_send_region(fd, memfd) == 0);
+	server = shm_sock_accept(listen_sock);
+	CU_ASSERT(server == NULL);
+	CU_ASSERT(slisten->num_pending == 0);
+	close(memfd);
+	close(fd);
+
+	/* So are overlapping rings */
+	fd = _raw_connect();
+	memfd = _raw_region(true, SPDK_SHM_SOCK_HDR_SIZE);
+	CU_ASSERT(shm_sock_send_region(fd, memfd) == 0);
+	server = shm_sock_accept(listen_sock);
+	CU_ASSERT(server == NULL);
+	close(memfd);
+	close(fd);
+
+	/* A connection whose region never comes is dropped after the timeout */
+	fd = _raw_connect();
+	server = shm_sock_accept(listen_sock);
+	CU_ASSERT(server == NULL);
+	CU_ASSERT(slisten->num_pending == 1);
+	spdk_delay_us(SPDK_SHM_SOCK_HANDSHAKE_TIMEOUT_MS * 1000);
+	server = shm_sock_accept(listen_sock);
+	CU_ASSERT(server == NULL);
+	CU_ASSERT(slisten->num_pending == 0);
+	close(fd);
+
+	/* Pending connections go away with the listener */
+	fd = _raw_connect();
+	server = shm_sock_accept(listen_sock);
+	CU_ASSERT(server == NULL);
+	CU_ASSERT(slisten->num_pending == 1);
+	shm_sock_close(listen_sock);
+	close(fd);
+}
+
+static void
+peer_corruption(void)
+{
+	struct spdk_sock *listen_sock, *client, *server;
+	struct spdk_shm_sock *sclient, *sserver;
+	char buf[16];
+	void *lent;
+	ssize_t rc;
+
+	_connect(&listen_sock, &client, &server);
+	sclient = __shm_sock(client);
+	sserver = __shm_sock(server);
+
+	/* The layout in the region isn't used after the connection is made */
+	sserver->rx->size = 1ULL << 40;
+	sserver->tx->offset = 0;
+	rc = shm_sock_writev(client, &(struct iovec) { .iov_base = "ping", .iov_len = 4 }, 1);
+	CU_ASSERT(rc == 4);
+	rc = shm_sock_recv(server, buf, sizeof(buf));
+	CU_ASSERT(rc == 4);
+	CU_ASSERT(memcmp(buf, "ping", 4) == 0);
+	rc = shm_sock_writev(server, &(struct iovec) { .iov_base = "pong", .iov_len = 4 }, 1);
+	CU_ASSERT(rc == 4);
+	rc = shm_sock_recv(client, buf, sizeof(buf));
+	CU_ASSERT(rc == 4);
+	CU_ASSERT(memcmp(buf, "pong", 4) == 0);
+
+	/* A consumer index ahead of the data written resets the connection */
+	sclient->rx->tail = sserver->tx_head + 1;
+	rc = shm_sock_writev(server, &(struct iovec) { .iov_base = "late", .iov_len = 4 }, 1);
+	CU_ASSERT(rc == -1);
+	CU_ASSERT(errno == ECONNRESET);
+	CU_ASSERT(sserver->reset);
+	CU_ASSERT(!shm_sock_is_connected(server));
+	rc = shm_sock_recv(server, buf, sizeof(buf));
+	CU_ASSERT(rc == -1);
+	CU_ASSERT(errno == ECONNRESET);
+	shm_sock_close(server);
+
+	/* So does a producer index claiming more data than the ring holds */
+	sclient->rx->head = sclient->rx_tail + sclient->rx_size + 1;
+	CU_ASSERT(shm_sock_recv_lend(client, &lent) == -1);
+	CU_ASSERT(errno == ECONNRESET);
+	CU_ASSERT(sclient->reset);
+
+	shm_sock_close(client);
+	shm_sock_close(listen_sock);
+}
+
+static void
+_req_cb(void *cb_arg, int len)
+{
+	*(bool *)cb_arg = true;
+	CU_ASSERT(len == 0);
+}
+
+static void
+group_poll(void)
+{
+	struct spdk_sock_group_impl *group;
+	struct spdk_sock *listen_sock, *client, *server, *socks[4];
+	struct spdk_shm_sock *sclient, *sserver;
+	struct spdk_sock_request *req;
+	char buf[16];
+	bool cb_arg = false;
+	int rc;
+
+	_connect(&listen_sock, &client, &server);
+	TAILQ_INIT(&client->queued_reqs);
+	TAILQ_INIT(&client->pending_reqs);
+
+	group = shm_sock_group_impl_create();
+	SPDK_CU_ASSERT_FATAL(group != NULL);
+	CU_ASSERT(shm_sock_group_impl_add_sock(group, client) == 0);
+	CU_ASSERT(shm_sock_group_impl_add_sock(group, server) == 0);
+	client->group_impl = group;
+
+	rc = shm_sock_group_impl_poll(group, 4, socks);
+	CU_ASSERT(rc == 0);
+
+	/* Queued requests are written out and completed by the poll */
+	req = calloc(1, sizeof(struct spdk_sock_request) + sizeof(struct iovec));
+	SPDK_CU_ASSERT_FATAL(req != NULL);
+	SPDK_SOCK_REQUEST_IOV(req, 0)->iov_base = "hello";
+	SPDK_SOCK_REQUEST_IOV(req, 0)->iov_len = 5;
+	req->iovcnt = 1;
+	req->cb_fn = _req_cb;
+	req->cb_arg = &cb_arg;
+	shm_sock_writev_async(client, req);
+	CU_ASSERT(cb_arg == false);
+
+	rc = shm_sock_group_impl_poll(group, 4, socks);
+	CU_ASSERT(cb_arg == true);
+	CU_ASSERT(rc == 1);
+	CU_ASSERT(socks[0] == server);
+	CU_ASSERT(shm_sock_recv(server, buf, sizeof(buf)) == 5);
+
+	/* The receive low watermark holds the socket back */
+	shm_sock_set_recvlowat(server, 8);
+	rc = shm_sock_writev(client, &(struct iovec) { .iov_base = "abcd", .iov_len = 4 }, 1);
+	CU_ASSERT(rc == 4);
+	rc = shm_sock_group_impl_poll(group, 4, socks);
+	CU_ASSERT(rc == 0);
+	rc = shm_sock_writev(client, &(struct iovec) { .iov_base = "efgh", .iov_len = 4 }, 1);
+	CU_ASSERT(rc == 4);
+	rc = shm_sock_group_impl_poll(group, 4, socks);
+	CU_ASSERT(rc == 1);
+	CU_ASSERT(shm_sock_recv(server, buf, sizeof(buf)) == 8);
+
+	/* A peer that exits without closing is found through the Unix domain socket */
+	CU_ASSERT(shm_sock_group_impl_remove_sock(group, client) == 0);
+	sclient = __shm_sock(client);
+	sserver = __shm_sock(server);
+	close(sclient->fd);
+	sclient->fd = -1;
+	shm_sock_group_check_hup(__shm_group_impl(group));
+	CU_ASSERT(sserver->peer_gone);
+	rc = shm_sock_group_impl_poll(group, 4, socks);
+	CU_ASSERT(rc == 1);
+	CU_ASSERT(socks[0] == server);
+	CU_ASSERT(shm_sock_recv(server, buf, sizeof(buf)) == 0);
+
+	CU_ASSERT(shm_sock_group_impl_remove_sock(group, server) == 0);
+	CU_ASSERT(shm_sock_group_impl_close(group) == 0);
+
+	free(req);
+	shm_sock_close(client);
+	shm_sock_close(server);
+	shm_sock_close(listen_sock);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_set_error_action(CUEA_ABORT);
+	CU_initialize_registry();
+
+	suite = CU_add_suite("shm", NULL, NULL);
+
+	CU_ADD_TEST(suite, loopback);
+	CU_ADD_TEST(suite, ring_wrap);
+	CU_ADD_TEST(suite, accept_handoff);
+	CU_ADD_TEST(suite, peer_corruption);
+	CU_ADD_TEST(suite, group_poll);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+
+	CU_basic_run_tests();
+
+	num_failures = CU_get_number_of_failures();
+	CU_cleanup_registry();
+
+	return num_failures;
+}
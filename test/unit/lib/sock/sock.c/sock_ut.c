@@ -464,6 +464,103 @@ ut_sock(void)
 	_sock(UT_IP, UT_PORT, "ut");
 }
 
+static void
+sock_impl_by_name_only(void)
+{
+	struct spdk_sock *listen_sock, *client_sock;
+
+	/* Skipped when falling back through all implementations */
+	g_ut_net_impl.by_name_only = true;
+	listen_sock = spdk_sock_listen(UT_IP, UT_PORT, NULL);
+	CU_ASSERT(listen_sock == NULL);
+	client_sock = spdk_sock_connect(UT_IP, UT_PORT, NULL);
+	CU_ASSERT(client_sock == NULL);
+
+	/* But still used when asked for by name */
+	listen_sock = spdk_sock_listen(UT_IP, UT_PORT, "ut");
+	SPDK_CU_ASSERT_FATAL(listen_sock != NULL);
+	CU_ASSERT(spdk_sock_close(&listen_sock) == 0);
+
+	g_ut_net_impl.by_name_only = false;
+	listen_sock = spdk_sock_listen(UT_IP, UT_PORT, NULL);
+	SPDK_CU_ASSERT_FATAL(listen_sock != NULL);
+	CU_ASSERT(spdk_sock_close(&listen_sock) == 0);
+}
+
+static void
+sock_recv_lend(void)
+{
+	struct spdk_sock *listen_sock, *server_sock, *client_sock;
+	char *test_string = "abcdef";
+	struct iovec iov;
+	void *buf;
+	ssize_t rc;
+
+	listen_sock = spdk_sock_listen("127.0.0.1", UT_PORT, "posix");
+	SPDK_CU_ASSERT_FATAL(listen_sock != NULL);
+	client_sock = spdk_sock_connect("127.0.0.1", UT_PORT, "posix");
+	SPDK_CU_ASSERT_FATAL(client_sock != NULL);
+	usleep(1000);
+	server_sock = spdk_sock_accept(listen_sock);
+	SPDK_CU_ASSERT_FATAL(server_sock != NULL);
+
+	/* Lending requires the socket to buffer received data */
+	rc = spdk_sock_recv_lend(server_sock, &buf);
+	CU_ASSERT(rc == -1);
+	CU_ASSERT(errno == ENOTSUP);
+	rc = spdk_sock_set_recvbuf(server_sock, MIN_SOCK_PIPE_SIZE);
+	CU_ASSERT(rc == 0);
+
+	rc = spdk_sock_recv_lend(server_sock, &buf);
+	CU_ASSERT(rc == -1);
+	CU_ASSERT(errno == EAGAIN || errno == EWOULDBLOCK);
+
+	iov.iov_base = test_string;
+	iov.iov_len = 7;
+	rc = spdk_sock_writev(client_sock, &iov, 1);
+	CU_ASSERT(rc == 7);
+	usleep(1000);
+
+	/* The data is lent in place and stays there until it is consumed */
+	rc = spdk_sock_recv_lend(server_sock, &buf);
+	CU_ASSERT(rc == 7);
+	CU_ASSERT(memcmp(buf, test_string, 7) == 0);
+	CU_ASSERT(spdk_sock_recv_return(server_sock, 2) == 0);
+
+	rc = spdk_sock_recv_lend(server_sock, &buf);
+	CU_ASSERT(rc == 5);
+	CU_ASSERT(memcmp(buf, test_string + 2, 5) == 0);
+
+	/* More than was lent cannot be consumed */
+	CU_ASSERT(spdk_sock_recv_return(server_sock, 6) == -1);
+	CU_ASSERT(errno == EINVAL);
+	CU_ASSERT(spdk_sock_recv_return(server_sock, 5) == 0);
+
+	/* A closed connection is reported as 0 bytes */
+	spdk_sock_close(&client_sock);
+	usleep(1000);
+	rc = spdk_sock_recv_lend(server_sock, &buf);
+	CU_ASSERT(rc == 0);
+
+	CU_ASSERT(spdk_sock_close(&server_sock) == 0);
+	CU_ASSERT(spdk_sock_close(&listen_sock) == 0);
+
+	/* Implementations without lending report ENOTSUP */
+	listen_sock = spdk_sock_listen(UT_IP, UT_PORT, "ut");
+	SPDK_CU_ASSERT_FATAL(listen_sock != NULL);
+	client_sock = spdk_sock_connect(UT_IP, UT_PORT, "ut");
+	SPDK_CU_ASSERT_FATAL(client_sock != NULL);
+	server_sock = spdk_sock_accept(listen_sock);
+	SPDK_CU_ASSERT_FATAL(server_sock != NULL);
+	rc = spdk_sock_recv_lend(server_sock, &buf);
+	CU_ASSERT(rc == -1);
+	CU_ASSERT(errno == ENOTSUP);
+	CU_ASSERT(spdk_sock_recv_return(server_sock, 0) == -1);
+	CU_ASSERT(spdk_sock_close(&client_sock) == 0);
+	CU_ASSERT(spdk_sock_close(&server_sock) == 0);
+	CU_ASSERT(spdk_sock_close(&listen_sock) == 0);
+}
+
 static void
 read_data(void *cb_arg, struct spdk_sock_group *group, struct spdk_sock *sock)
 {
@@ -578,6 +675,36 @@ posix_sock_group(void)
 	_sock_group("127.0.0.1", UT_PORT, "posix");
 }
 
+static void
+posix_sock_group_busy_poll(void)
+{
+	struct spdk_sock_impl_opts opts, saved_opts;
+	size_t len;
+	int rc;
+
+	len = sizeof(saved_opts);
+	rc = spdk_sock_impl_get_opts("posix", &saved_opts, &len);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(saved_opts.busy_poll_usecs == 0);
+
+	opts = saved_opts;
+	opts.busy_poll_usecs = 50;
+	rc = spdk_sock_impl_set_opts("posix", &opts, sizeof(opts));
+	CU_ASSERT(rc == 0);
+	memset(&opts, 0, sizeof(opts));
+	len = sizeof(opts);
+	rc = spdk_sock_impl_get_opts("posix", &opts, &len);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(opts.busy_poll_usecs == 50);
+
+	/* Busy polling is best effort, the group works the same whether or not the
+	 * kernel accepts it */
+	_sock_group("127.0.0.1", UT_PORT, "posix");
+
+	rc = spdk_sock_impl_set_opts("posix", &saved_opts, sizeof(saved_opts));
+	CU_ASSERT(rc == 0);
+}
+
 static void
 ut_sock_group(void)
 {
@@ -956,6 +1083,192 @@ posix_sock_impl_get_set_opts(void)
 	CU_ASSERT(opts.recv_buf_size == 5);
 }
 
+static void
+_send_rate_cb(void *cb_arg, int err)
+{
+	CU_ASSERT(err == 0);
+	*(bool *)cb_arg = true;
+}
+
+static ssize_t
+_send_rate_recv_all(struct spdk_sock *sock, char *buf, size_t len)
+{
+	ssize_t rc, total = 0;
+
+	while ((rc = spdk_sock_recv(sock, buf + total, len - total)) > 0) {
+		total += rc;
+	}
+
+	return total;
+}
+
+static void
+sock_send_rate(void)
+{
+	struct spdk_sock *listen_sock, *server_sock, *client_sock;
+	struct spdk_sock_impl_opts impl_opts, saved_opts;
+	uint8_t req_buf[sizeof(struct spdk_sock_request) + 2 * sizeof(struct iovec)];
+	struct spdk_sock_request *req = (struct spdk_sock_request *)req_buf;
+	struct iovec iovs[IOV_BATCH_SIZE];
+	char data[2000], buf[2000];
+	size_t len;
+	bool done = false;
+	ssize_t rc;
+
+	/* Sockets pick up the rate limit of their implementation */
+	len = sizeof(saved_opts);
+	rc = spdk_sock_impl_get_opts("posix", &saved_opts, &len);
+	CU_ASSERT(rc == 0);
+	impl_opts = saved_opts;
+	impl_opts.send_rate_limit = 100000;
+	impl_opts.send_burst_size = 1500;
+	rc = spdk_sock_impl_set_opts("posix", &impl_opts, sizeof(impl_opts));
+	CU_ASSERT(rc == 0);
+
+	listen_sock = spdk_sock_listen("127.0.0.1", UT_PORT, "posix");
+	SPDK_CU_ASSERT_FATAL(listen_sock != NULL);
+	client_sock = spdk_sock_connect("127.0.0.1", UT_PORT, "posix");
+	SPDK_CU_ASSERT_FATAL(client_sock != NULL);
+	usleep(1000);
+	server_sock = spdk_sock_accept(listen_sock);
+	SPDK_CU_ASSERT_FATAL(server_sock != NULL);
+	CU_ASSERT(client_sock->send_limit.rate == 100000);
+	CU_ASSERT(client_sock->send_limit.burst == 1500);
+	CU_ASSERT(server_sock->send_limit.rate == 100000);
+
+	rc = spdk_sock_impl_set_opts("posix", &saved_opts, sizeof(saved_opts));
+	CU_ASSERT(rc == 0);
+
+	memset(data, 0xa5, sizeof(data));
+	memset(req_buf, 0, sizeof(req_buf));
+	req->cb_fn = _send_rate_cb;
+	req->cb_arg = &done;
+	req->iovcnt = 2;
+	SPDK_SOCK_REQUEST_IOV(req, 0)->iov_base = data;
+	SPDK_SOCK_REQUEST_IOV(req, 0)->iov_len = 1000;
+	SPDK_SOCK_REQUEST_IOV(req, 1)->iov_base = data + 1000;
+	SPDK_SOCK_REQUEST_IOV(req, 1)->iov_len = 1000;
+
+	/* The gathered iovs stop at the budget. Queue the request directly, as
+	 * spdk_sock_writev_async() would send it right away. */
+	spdk_sock_request_queue(client_sock, req);
+	rc = spdk_sock_prep_reqs(client_sock, iovs, 0, NULL);
+	CU_ASSERT(rc == 2);
+	CU_ASSERT(iovs[0].iov_len == 1000);
+	CU_ASSERT(iovs[1].iov_len == 500);
+
+	/* Only the burst is sent at once */
+	rc = spdk_sock_flush(client_sock);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(done == false);
+	CU_ASSERT(client_sock->send_limit.tokens == 0);
+	usleep(1000);
+	rc = _send_rate_recv_all(server_sock, buf, sizeof(buf));
+	CU_ASSERT(rc == 1500);
+
+	/* Nothing more until the bucket refills, 5 ms earn 500 bytes */
+	CU_ASSERT(spdk_sock_prep_reqs(client_sock, iovs, 0, NULL) == 0);
+	spdk_delay_us(5000);
+	rc = spdk_sock_flush(client_sock);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(done == true);
+	usleep(1000);
+	rc = _send_rate_recv_all(server_sock, buf, sizeof(buf));
+	CU_ASSERT(rc == 500);
+
+	/* An idle bucket refills up to the burst only */
+	spdk_delay_us(1000000);
+	CU_ASSERT(spdk_sock_send_budget(client_sock) == 1500);
+
+	/* The default burst is 10 ms worth of the rate */
+	rc = spdk_sock_set_send_rate(client_sock, 100000, 0);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(client_sock->send_limit.burst == 1000);
+
+	/* Without a limit everything is gathered again */
+	rc = spdk_sock_set_send_rate(client_sock, 0, 0);
+	CU_ASSERT(rc == 0);
+	done = false;
+	spdk_sock_writev_async(client_sock, req);
+	rc = spdk_sock_prep_reqs(client_sock, iovs, 0, NULL);
+	CU_ASSERT(rc == 2);
+	CU_ASSERT(iovs[1].iov_len == 1000);
+	rc = spdk_sock_flush(client_sock);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(done == true);
+
+	rc = spdk_sock_close(&client_sock);
+	CU_ASSERT(rc == 0);
+	rc = spdk_sock_close(&server_sock);
+	CU_ASSERT(rc == 0);
+	rc = spdk_sock_close(&listen_sock);
+	CU_ASSERT(rc == 0);
+}
+
+static void
+sock_send_rate_writev(void)
+{
+	struct spdk_sock *listen_sock, *server_sock, *client_sock;
+	uint8_t req_buf[3][sizeof(struct spdk_sock_request) + sizeof(struct iovec)];
+	struct spdk_sock_request *req[3];
+	char data[2000], buf[2000];
+	bool done[3] = {};
+	ssize_t rc;
+	int i;
+
+	listen_sock = spdk_sock_listen("127.0.0.1", UT_PORT, "posix");
+	SPDK_CU_ASSERT_FATAL(listen_sock != NULL);
+	client_sock = spdk_sock_connect("127.0.0.1", UT_PORT, "posix");
+	SPDK_CU_ASSERT_FATAL(client_sock != NULL);
+	usleep(1000);
+	server_sock = spdk_sock_accept(listen_sock);
+	SPDK_CU_ASSERT_FATAL(server_sock != NULL);
+
+	rc = spdk_sock_set_send_rate(client_sock, 100000, 1000);
+	CU_ASSERT(rc == 0);
+
+	memset(data, 0xa5, sizeof(data));
+	for (i = 0; i < 3; i++) {
+		memset(req_buf[i], 0, sizeof(req_buf[i]));
+		req[i] = (struct spdk_sock_request *)req_buf[i];
+		req[i]->cb_fn = _send_rate_cb;
+		req[i]->cb_arg = &done[i];
+		req[i]->iovcnt = 1;
+		SPDK_SOCK_REQUEST_IOV(req[i], 0)->iov_base = data;
+		SPDK_SOCK_REQUEST_IOV(req[i], 0)->iov_len = i == 0 ? 1500 : 250;
+	}
+
+	/* The first burst goes out with the first request */
+	spdk_sock_writev_async(client_sock, req[0]);
+	CU_ASSERT(done[0] == false);
+	CU_ASSERT(client_sock->send_limit.tokens == 0);
+	usleep(1000);
+	rc = _send_rate_recv_all(server_sock, buf, sizeof(buf));
+	CU_ASSERT(rc == 1000);
+
+	/* Queuing another request before the bucket refilled sends nothing */
+	spdk_sock_writev_async(client_sock, req[1]);
+	CU_ASSERT(done[0] == false);
+	CU_ASSERT(done[1] == false);
+
+	/* Once it refilled, the next request also sends the data held back */
+	spdk_delay_us(10000);
+	spdk_sock_writev_async(client_sock, req[2]);
+	CU_ASSERT(done[0] == true);
+	CU_ASSERT(done[1] == true);
+	CU_ASSERT(done[2] == true);
+	usleep(1000);
+	rc = _send_rate_recv_all(server_sock, buf, sizeof(buf));
+	CU_ASSERT(rc == 1000);
+
+	rc = spdk_sock_close(&client_sock);
+	CU_ASSERT(rc == 0);
+	rc = spdk_sock_close(&server_sock);
+	CU_ASSERT(rc == 0);
+	rc = spdk_sock_close(&listen_sock);
+	CU_ASSERT(rc == 0);
+}
+
 static void
 ut_sock_map(void)
 {
@@ -1129,7 +1442,10 @@ main(int argc, char **argv)
 
 	CU_ADD_TEST(suite, posix_sock);
 	CU_ADD_TEST(suite, ut_sock);
+	CU_ADD_TEST(suite, sock_impl_by_name_only);
+	CU_ADD_TEST(suite, sock_recv_lend);
 	CU_ADD_TEST(suite, posix_sock_group);
+	CU_ADD_TEST(suite, posix_sock_group_busy_poll);
 	CU_ADD_TEST(suite, ut_sock_group);
 	CU_ADD_TEST(suite, posix_sock_group_fairness);
 	CU_ADD_TEST(suite, _posix_sock_close);
@@ -1137,6 +1453,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, ut_sock_impl_get_set_opts);
 	CU_ADD_TEST(suite, posix_sock_impl_get_set_opts);
 	CU_ADD_TEST(suite, ut_sock_map);
+	CU_ADD_TEST(suite, sock_send_rate);
+	CU_ADD_TEST(suite, sock_send_rate_writev);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 
@@ -51,6 +51,7 @@ DEFINE_STUB_V(spdk_sock_map_cleanup, (struct spdk_sock_map *map));
 
 DEFINE_STUB_V(spdk_net_impl_register, (struct spdk_net_impl *impl, int priority));
 DEFINE_STUB(spdk_sock_close, int, (struct spdk_sock **s), 0);
+DEFINE_STUB(spdk_sock_send_budget, uint64_t, (struct spdk_sock *sock), 0);
 DEFINE_STUB(__io_uring_get_cqe, int, (struct io_uring *ring, struct io_uring_cqe **cqe_ptr,
 				      unsigned submit,
 				      unsigned wait_nr, sigset_t *sigmask), 0);
@@ -58,6 +59,17 @@ DEFINE_STUB(io_uring_submit, int, (struct io_uring *ring), 0);
 DEFINE_STUB(io_uring_get_sqe, struct io_uring_sqe *, (struct io_uring *ring), 0);
 DEFINE_STUB(io_uring_queue_init, int, (unsigned entries, struct io_uring *ring, unsigned flags), 0);
 DEFINE_STUB_V(io_uring_queue_exit, (struct io_uring *ring));
+#ifdef SPDK_URING_RECV_BUF_RING
+DEFINE_STUB(io_uring_register_buf_ring, int, (struct io_uring *ring, struct io_uring_buf_reg *reg,
+		unsigned int flags), 0);
+DEFINE_STUB(io_uring_unregister_buf_ring, int, (struct io_uring *ring, int bgid), 0);
+#endif
+#ifdef SPDK_URING_FIXED_FILES
+DEFINE_STUB(io_uring_register_files_sparse, int, (struct io_uring *ring, unsigned nr), 0);
+DEFINE_STUB(io_uring_register_files_update, int, (struct io_uring *ring, unsigned off,
+		const int *files, unsigned nr_files), 1);
+DEFINE_STUB(io_uring_unregister_files, int, (struct io_uring *ring), 0);
+#endif
 
 static void
 _req_cb(void *cb_arg, int len)
@@ -255,6 +267,359 @@ flush_server(void)
 	free(req2);
 }
 
+static void
+recv_pipe_lazy(void)
+{
+	struct spdk_uring_sock usock = {};
+	struct spdk_sock *sock = &usock.base;
+	struct iovec iov;
+	char buf[16];
+	int fds[2];
+	int rc;
+
+	rc = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	usock.fd = fds[0];
+	STAILQ_INIT(&usock.recv_queue);
+
+	/* Setting the receive buffer size only records it */
+	rc = uring_sock_set_recvbuf(sock, MIN_SOCK_PIPE_SIZE);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(usock.recv_buf_sz == MIN_SOCK_PIPE_SIZE);
+	CU_ASSERT(usock.recv_pipe == NULL);
+
+	rc = uring_sock_set_recvbuf(sock, MIN_SOCK_PIPE_SIZE - 1);
+	CU_ASSERT(rc == -1);
+	CU_ASSERT(usock.recv_buf_sz == MIN_SOCK_PIPE_SIZE);
+
+	/* The first read from the descriptor allocates the pipe and reads ahead into it */
+	CU_ASSERT(write(fds[1], "hello", 5) == 5);
+	iov.iov_base = buf;
+	iov.iov_len = 2;
+	rc = uring_sock_readv(sock, &iov, 1);
+	CU_ASSERT(rc == 2);
+	CU_ASSERT(memcmp(buf, "he", 2) == 0);
+	SPDK_CU_ASSERT_FATAL(usock.recv_pipe != NULL);
+	CU_ASSERT(spdk_pipe_reader_bytes_available(usock.recv_pipe) == 3);
+
+	/* Once allocated, the pipe follows the receive buffer size */
+	rc = uring_sock_set_recvbuf(sock, 2 * MIN_SOCK_PIPE_SIZE);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(usock.recv_buf_sz == 2 * MIN_SOCK_PIPE_SIZE);
+	iov.iov_len = sizeof(buf);
+	rc = uring_sock_readv(sock, &iov, 1);
+	CU_ASSERT(rc == 3);
+	CU_ASSERT(memcmp(buf, "llo", 3) == 0);
+
+	rc = uring_sock_set_recvbuf(sock, 0);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(usock.recv_pipe == NULL);
+	CU_ASSERT(usock.recv_buf_sz == 0);
+
+	close(fds[0]);
+	close(fds[1]);
+}
+
+static void
+recv_ring_opts(void)
+{
+	struct spdk_sock_impl_opts opts, saved;
+	size_t len = sizeof(opts);
+	int rc;
+
+	rc = uring_sock_impl_get_opts(&saved, &len);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(saved.recv_ring_buf_count == SPDK_URING_RECV_BUF_COUNT);
+	CU_ASSERT(saved.recv_ring_buf_size == SPDK_URING_RECV_BUF_SIZE);
+
+	opts = saved;
+	opts.recv_ring_buf_count = 256;
+	opts.recv_ring_buf_size = 8192;
+	rc = uring_sock_impl_set_opts(&opts, sizeof(opts));
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_spdk_uring_sock_impl_opts.recv_ring_buf_count == 256);
+	CU_ASSERT(g_spdk_uring_sock_impl_opts.recv_ring_buf_size == 8192);
+
+	/* 0 disables the ring */
+	opts.recv_ring_buf_count = 0;
+	rc = uring_sock_impl_set_opts(&opts, sizeof(opts));
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_spdk_uring_sock_impl_opts.recv_ring_buf_count == 0);
+
+	/* Invalid sizes are rejected without changing anything */
+	opts.recv_ring_buf_count = 1000;
+	rc = uring_sock_impl_set_opts(&opts, sizeof(opts));
+	CU_ASSERT(rc == -1);
+	CU_ASSERT(errno == EINVAL);
+	opts.recv_ring_buf_count = 4;
+	rc = uring_sock_impl_set_opts(&opts, sizeof(opts));
+	CU_ASSERT(rc == -1);
+	opts.recv_ring_buf_count = 65536;
+	rc = uring_sock_impl_set_opts(&opts, sizeof(opts));
+	CU_ASSERT(rc == -1);
+	opts.recv_ring_buf_count = 256;
+	opts.recv_ring_buf_size = 0;
+	rc = uring_sock_impl_set_opts(&opts, sizeof(opts));
+	CU_ASSERT(rc == -1);
+	CU_ASSERT(g_spdk_uring_sock_impl_opts.recv_ring_buf_count == 0);
+	CU_ASSERT(g_spdk_uring_sock_impl_opts.recv_ring_buf_size == 8192);
+
+	rc = uring_sock_impl_set_opts(&saved, sizeof(saved));
+	CU_ASSERT(rc == 0);
+}
+
+#ifdef SPDK_URING_RECV_BUF_RING
+static void
+recv_buf_ring(void)
+{
+	struct spdk_uring_sock_group_impl group = {};
+	struct spdk_uring_sock usock = {};
+	struct spdk_sock *sock = &usock.base;
+	uint32_t flags = IORING_CQE_F_BUFFER | IORING_CQE_F_MORE;
+	char buf[64];
+	void *lent;
+	ssize_t rc;
+	int rc2;
+
+	rc2 = uring_sock_group_init_buf_ring(&group);
+	SPDK_CU_ASSERT_FATAL(rc2 == 0);
+	CU_ASSERT(group.recv_buf_count == SPDK_URING_RECV_BUF_COUNT);
+	CU_ASSERT(group.recv_bufs_avail == group.recv_buf_count);
+	TAILQ_INIT(&group.pending_recv);
+
+	STAILQ_INIT(&usock.recv_queue);
+	usock.group = &group;
+	usock.recv_multishot = true;
+	sock->group_impl = &group.base;
+	sock->cb_fn = (spdk_sock_cb)0xDEADBEEF;
+
+	/* Nothing received yet */
+	rc = uring_sock_recv(sock, buf, sizeof(buf));
+	CU_ASSERT(rc == -1);
+	CU_ASSERT(errno == EAGAIN);
+
+	/* Two completions land in buffers 3 and 7 */
+	memcpy(uring_sock_recv_buf_addr(&group, 3), "hello ", 6);
+	_sock_read_complete(&usock, 6, flags | (3 << IORING_CQE_BUFFER_SHIFT));
+	memcpy(uring_sock_recv_buf_addr(&group, 7), "world", 5);
+	_sock_read_complete(&usock, 5, flags | (7 << IORING_CQE_BUFFER_SHIFT));
+	CU_ASSERT(group.recv_bufs_avail == group.recv_buf_count - 2);
+	CU_ASSERT(usock.pending_recv == true);
+	CU_ASSERT(TAILQ_FIRST(&group.pending_recv) == &usock);
+
+	/* A short read consumes part of the first buffer */
+	rc = uring_sock_recv(sock, buf, 3);
+	CU_ASSERT(rc == 3);
+	CU_ASSERT(memcmp(buf, "hel", 3) == 0);
+	CU_ASSERT(group.recv_bufs_avail == group.recv_buf_count - 2);
+
+	/* The rest spans both buffers, which are returned to the ring */
+	rc = uring_sock_recv(sock, buf, sizeof(buf));
+	CU_ASSERT(rc == 8);
+	CU_ASSERT(memcmp(buf, "lo world", 8) == 0);
+	CU_ASSERT(group.recv_bufs_avail == group.recv_buf_count);
+	CU_ASSERT(STAILQ_EMPTY(&usock.recv_queue));
+	CU_ASSERT(usock.pending_recv == false);
+	CU_ASSERT(TAILQ_EMPTY(&group.pending_recv));
+
+	/* Received data can be lent in place instead of being copied */
+	memcpy(uring_sock_recv_buf_addr(&group, 5), "lend", 4);
+	_sock_read_complete(&usock, 4, flags | (5 << IORING_CQE_BUFFER_SHIFT));
+	rc = uring_sock_recv_lend(sock, &lent);
+	CU_ASSERT(rc == 4);
+	CU_ASSERT(lent == uring_sock_recv_buf_addr(&group, 5));
+	CU_ASSERT(uring_sock_recv_return(sock, 2) == 0);
+	rc = uring_sock_recv_lend(sock, &lent);
+	CU_ASSERT(rc == 2);
+	CU_ASSERT(memcmp(lent, "nd", 2) == 0);
+	CU_ASSERT(uring_sock_recv_return(sock, 3) == -1);
+	CU_ASSERT(uring_sock_recv_return(sock, 2) == 0);
+	CU_ASSERT(group.recv_bufs_avail == group.recv_buf_count);
+	CU_ASSERT(usock.pending_recv == false);
+	rc = uring_sock_recv_lend(sock, &lent);
+	CU_ASSERT(rc == -1);
+	CU_ASSERT(errno == EAGAIN);
+
+	/* Running out of buffers does not close the socket */
+	_sock_read_complete(&usock, -ENOBUFS, 0);
+	CU_ASSERT(usock.recv_closed == false);
+	CU_ASSERT(usock.pending_recv == false);
+
+	/* Data left when the socket leaves the group is moved to its pipe */
+	memcpy(uring_sock_recv_buf_addr(&group, 1), "pipe", 4);
+	_sock_read_complete(&usock, 4, flags | (1 << IORING_CQE_BUFFER_SHIFT));
+	_sock_drain_recv_bufs(&usock);
+	CU_ASSERT(STAILQ_EMPTY(&usock.recv_queue));
+	CU_ASSERT(group.recv_bufs_avail == group.recv_buf_count);
+	SPDK_CU_ASSERT_FATAL(usock.recv_pipe != NULL);
+	CU_ASSERT(spdk_pipe_reader_bytes_available(usock.recv_pipe) == 4);
+	rc = uring_sock_recv(sock, buf, sizeof(buf));
+	CU_ASSERT(rc == 4);
+	CU_ASSERT(memcmp(buf, "pipe", 4) == 0);
+
+	/* End of stream is reported once the queued data is read */
+	_sock_read_complete(&usock, 0, 0);
+	CU_ASSERT(usock.recv_closed == true);
+	rc = uring_sock_recv(sock, buf, sizeof(buf));
+	CU_ASSERT(rc == 0);
+
+	TAILQ_REMOVE(&group.pending_recv, &usock, link);
+	spdk_pipe_destroy(usock.recv_pipe);
+	free(usock.recv_buf);
+	uring_sock_group_free_buf_ring(&group);
+}
+
+/* Each buffer is an iovec, a single receive only takes IOV_BATCH_SIZE of them */
+static size_t
+ut_uring_recv_all(struct spdk_sock *sock, char *buf, size_t len)
+{
+	size_t done = 0;
+	ssize_t rc;
+
+	while (done < len) {
+		rc = uring_sock_recv(sock, buf, len - done);
+		if (rc <= 0) {
+			break;
+		}
+		done += rc;
+	}
+
+	return done;
+}
+
+static void
+recv_buf_sock_limit(void)
+{
+	struct spdk_uring_sock_group_impl group = {};
+	struct spdk_uring_sock usock = {};
+	struct spdk_sock *sock = &usock.base;
+	struct io_uring_sqe sqe = {};
+	uint32_t flags = IORING_CQE_F_BUFFER | IORING_CQE_F_MORE;
+	char buf[SPDK_URING_RECV_BUF_COUNT];
+	uint32_t i, max;
+	int rc;
+
+	rc = uring_sock_group_init_buf_ring(&group);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	max = uring_sock_recv_buf_sock_max(&group);
+	CU_ASSERT(max == SPDK_URING_RECV_BUF_COUNT / 8);
+	TAILQ_INIT(&group.pending_recv);
+
+	STAILQ_INIT(&usock.recv_queue);
+	usock.group = &group;
+	usock.recv_multishot = true;
+	usock.read_task.sock = &usock;
+	usock.read_task.type = SPDK_SOCK_TASK_READ;
+	usock.cancel_task.sock = &usock;
+	usock.cancel_task.type = SPDK_SOCK_TASK_CANCEL;
+	sock->group_impl = &group.base;
+	sock->cb_fn = (spdk_sock_cb)0xDEADBEEF;
+	MOCK_SET(io_uring_get_sqe, &sqe);
+
+	/* The receive is armed and fills buffers while the user doesn't read */
+	_sock_prep_read(sock);
+	CU_ASSERT(usock.read_task.status == SPDK_URING_SOCK_TASK_IN_PROCESS);
+	CU_ASSERT(group.io_queued == 1);
+
+	for (i = 0; i < max - 1; i++) {
+		_sock_read_complete(&usock, 1, flags | (i << IORING_CQE_BUFFER_SHIFT));
+	}
+	CU_ASSERT(usock.recv_bufs_held == max - 1);
+	CU_ASSERT(usock.cancel_task.status == SPDK_URING_SOCK_TASK_NOT_IN_USE);
+
+	/* At the limit the receive is cancelled */
+	_sock_read_complete(&usock, 1, flags | (i << IORING_CQE_BUFFER_SHIFT));
+	CU_ASSERT(usock.recv_bufs_held == max);
+	CU_ASSERT(usock.cancel_task.status == SPDK_URING_SOCK_TASK_IN_PROCESS);
+	CU_ASSERT(sqe.user_data == (uintptr_t)&usock.cancel_task);
+	CU_ASSERT(group.io_queued == 2);
+	CU_ASSERT(group.recv_bufs_avail == group.recv_buf_count - max);
+
+	/* The cancelled receive ends without closing the socket */
+	usock.read_task.status = SPDK_URING_SOCK_TASK_NOT_IN_USE;
+	usock.cancel_task.status = SPDK_URING_SOCK_TASK_NOT_IN_USE;
+	_sock_read_complete(&usock, -ECANCELED, 0);
+	CU_ASSERT(usock.recv_closed == false);
+
+	/* It isn't re-armed until the socket is back to half of the limit */
+	_sock_prep_read(sock);
+	CU_ASSERT(usock.read_task.status == SPDK_URING_SOCK_TASK_NOT_IN_USE);
+
+	CU_ASSERT(ut_uring_recv_all(sock, buf, max / 2 - 1) == max / 2 - 1);
+	_sock_prep_read(sock);
+	CU_ASSERT(usock.read_task.status == SPDK_URING_SOCK_TASK_NOT_IN_USE);
+
+	CU_ASSERT(ut_uring_recv_all(sock, buf, 1) == 1);
+	CU_ASSERT(usock.recv_bufs_held == max / 2);
+	_sock_prep_read(sock);
+	CU_ASSERT(usock.read_task.status == SPDK_URING_SOCK_TASK_IN_PROCESS);
+	CU_ASSERT(group.io_queued == 3);
+
+	CU_ASSERT(ut_uring_recv_all(sock, buf, sizeof(buf)) == max / 2);
+	CU_ASSERT(usock.recv_bufs_held == 0);
+	CU_ASSERT(group.recv_bufs_avail == group.recv_buf_count);
+
+	MOCK_CLEAR_P(io_uring_get_sqe);
+	uring_sock_group_free_buf_ring(&group);
+}
+#endif
+
+#ifdef SPDK_URING_FIXED_FILES
+static void
+fixed_files(void)
+{
+	struct spdk_uring_sock_group_impl group = {};
+	struct spdk_uring_sock usock1 = {}, usock2 = {};
+	uint32_t count;
+	int rc;
+
+	rc = uring_sock_group_init_fixed_files(&group);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	count = group.fixed_count;
+	CU_ASSERT(count > 1);
+	CU_ASSERT(group.fixed_free_count == count);
+
+	/* Sockets take the lowest free slots */
+	usock1.fd = 10;
+	usock2.fd = 11;
+	uring_sock_add_fixed_file(&group, &usock1);
+	uring_sock_add_fixed_file(&group, &usock2);
+	CU_ASSERT(usock1.fixed_file == true);
+	CU_ASSERT(usock1.fixed_idx == 0);
+	CU_ASSERT(usock2.fixed_file == true);
+	CU_ASSERT(usock2.fixed_idx == 1);
+	CU_ASSERT(group.fixed_free_count == count - 2);
+
+	/* A released slot is reused */
+	uring_sock_remove_fixed_file(&group, &usock1);
+	CU_ASSERT(usock1.fixed_file == false);
+	CU_ASSERT(group.fixed_free_count == count - 1);
+	uring_sock_add_fixed_file(&group, &usock1);
+	CU_ASSERT(usock1.fixed_idx == 0);
+
+	/* A failed registration leaves the socket on its descriptor */
+	uring_sock_remove_fixed_file(&group, &usock1);
+	MOCK_SET(io_uring_register_files_update, -EBADF);
+	uring_sock_add_fixed_file(&group, &usock1);
+	CU_ASSERT(usock1.fixed_file == false);
+	CU_ASSERT(group.fixed_free_count == count - 1);
+	MOCK_CLEAR(io_uring_register_files_update);
+
+	/* Without a table every socket uses its descriptor */
+	uring_sock_remove_fixed_file(&group, &usock2);
+	uring_sock_group_fini_fixed_files(&group);
+	CU_ASSERT(group.fixed_free == NULL);
+	uring_sock_add_fixed_file(&group, &usock1);
+	CU_ASSERT(usock1.fixed_file == false);
+
+	MOCK_SET(io_uring_register_files_sparse, -EINVAL);
+	rc = uring_sock_group_init_fixed_files(&group);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(group.fixed_free == NULL);
+	MOCK_CLEAR(io_uring_register_files_sparse);
+}
+#endif
+
 int
 main(int argc, char **argv)
 {
@@ -269,6 +634,15 @@ main(int argc, char **argv)
 
 	CU_ADD_TEST(suite, flush_client);
 	CU_ADD_TEST(suite, flush_server);
+	CU_ADD_TEST(suite, recv_pipe_lazy);
+	CU_ADD_TEST(suite, recv_ring_opts);
+#ifdef SPDK_URING_RECV_BUF_RING
+	CU_ADD_TEST(suite, recv_buf_ring);
+	CU_ADD_TEST(suite, recv_buf_sock_limit);
+#endif
+#ifdef SPDK_URING_FIXED_FILES
+	CU_ADD_TEST(suite, fixed_files);
+#endif
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 
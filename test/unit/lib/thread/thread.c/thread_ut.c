@@ -173,6 +173,51 @@ thread_send_msg(void)
 	free_threads();
 }
 
+static void
+send_msg_batch_cb(void *ctx)
+{
+	uint32_t *order = ctx;
+	static uint32_t seq;
+
+	*order = ++seq;
+}
+
+static void
+thread_send_msg_batch(void)
+{
+	struct spdk_thread *thread0;
+	uint32_t order[SPDK_THREAD_MSG_BATCH_MAX] = {};
+	void *ctxs[SPDK_THREAD_MSG_BATCH_MAX + 1];
+	uint32_t i;
+
+	allocate_threads(2);
+	set_thread(0);
+	thread0 = spdk_get_thread();
+
+	for (i = 0; i < SPDK_THREAD_MSG_BATCH_MAX; i++) {
+		ctxs[i] = &order[i];
+	}
+
+	set_thread(1);
+	CU_ASSERT(spdk_thread_send_msg_batch(thread0, send_msg_batch_cb, ctxs, 0) == 0);
+	CU_ASSERT(spdk_thread_send_msg_batch(thread0, send_msg_batch_cb, ctxs,
+					     SPDK_THREAD_MSG_BATCH_MAX + 1) == -EINVAL);
+	CU_ASSERT(spdk_thread_send_msg_batch(thread0, send_msg_batch_cb, ctxs,
+					     SPDK_THREAD_MSG_BATCH_MAX) == 0);
+
+	poll_thread(1);
+	CU_ASSERT(order[0] == 0);
+
+	/* All messages are executed on thread 0, in order. */
+	poll_thread(0);
+	for (i = 1; i < SPDK_THREAD_MSG_BATCH_MAX; i++) {
+		CU_ASSERT(order[i] != 0);
+		CU_ASSERT(order[i] == order[i - 1] + 1);
+	}
+
+	free_threads();
+}
+
 static int
 poller_run_done(void *ctx)
 {
@@ -1429,24 +1474,22 @@ cache_closest_timed_poller(void)
 
 	poll_threads();
 
-	/* When multiple timed pollers are inserted, the cache should
-	 * have the closest timed poller.
+	/* When multiple timed pollers are inserted, the next expiration
+	 * should be the one of the closest timed poller.
 	 */
-	CU_ASSERT(thread->first_timed_poller == poller1);
-	CU_ASSERT(RB_MIN(timed_pollers_tree, &thread->timed_pollers) == poller1);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == poller1->next_run_tick);
 
 	spdk_delay_us(1000);
 	poll_threads();
 
-	CU_ASSERT(thread->first_timed_poller == poller2);
-	CU_ASSERT(RB_MIN(timed_pollers_tree, &thread->timed_pollers) == poller2);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == poller2->next_run_tick);
 
 	/* If we unregister a timed poller by spdk_poller_unregister()
 	 * when it is waiting, it is marked as being unregistered and
 	 * is actually unregistered when it is expired.
 	 *
 	 * Hence if we unregister the closest timed poller when it is waiting,
-	 * the cache is not updated to the next timed poller until it is expired.
+	 * the next expiration does not change until it is expired.
 	 */
 	tmp = poller2;
 
@@ -1456,37 +1499,33 @@ cache_closest_timed_poller(void)
 	spdk_delay_us(499);
 	poll_threads();
 
-	CU_ASSERT(thread->first_timed_poller == tmp);
-	CU_ASSERT(RB_MIN(timed_pollers_tree, &thread->timed_pollers) == tmp);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == tmp->next_run_tick);
 
 	spdk_delay_us(1);
 	poll_threads();
 
-	CU_ASSERT(thread->first_timed_poller == poller3);
-	CU_ASSERT(RB_MIN(timed_pollers_tree, &thread->timed_pollers) == poller3);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == poller3->next_run_tick);
 
 	/* If we pause a timed poller by spdk_poller_pause() when it is waiting,
 	 * it is marked as being paused and is actually paused when it is expired.
 	 *
-	 * Hence if we pause the closest timed poller when it is waiting, the cache
-	 * is not updated to the next timed poller until it is expired.
+	 * Hence if we pause the closest timed poller when it is waiting, the next
+	 * expiration does not change until it is expired.
 	 */
 	spdk_poller_pause(poller3);
 
 	spdk_delay_us(299);
 	poll_threads();
 
-	CU_ASSERT(thread->first_timed_poller == poller3);
-	CU_ASSERT(RB_MIN(timed_pollers_tree, &thread->timed_pollers) == poller3);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == poller3->next_run_tick);
 
 	spdk_delay_us(1);
 	poll_threads();
 
-	CU_ASSERT(thread->first_timed_poller == poller1);
-	CU_ASSERT(RB_MIN(timed_pollers_tree, &thread->timed_pollers) == poller1);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == poller1->next_run_tick);
 
-	/* After unregistering all timed pollers, the cache should
-	 * be NULL.
+	/* After unregistering all timed pollers, there should be
+	 * no expiration.
 	 */
 	spdk_poller_unregister(&poller1);
 	spdk_poller_unregister(&poller3);
@@ -1494,8 +1533,8 @@ cache_closest_timed_poller(void)
 	spdk_delay_us(200);
 	poll_threads();
 
-	CU_ASSERT(thread->first_timed_poller == NULL);
-	CU_ASSERT(RB_EMPTY(&thread->timed_pollers));
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == 0);
+	CU_ASSERT(spdk_thread_get_first_timed_poller(thread) == NULL);
 
 	free_threads();
 }
@@ -1530,10 +1569,8 @@ multi_timed_pollers_have_same_expiration(void)
 	poller4 = spdk_poller_register(dummy_poller, NULL, 1500);
 	SPDK_CU_ASSERT_FATAL(poller4 != NULL);
 
-	/* poller1 and poller2 have the same next_run_tick but cache has poller1
-	 * because poller1 is registered earlier than poller2.
-	 */
-	CU_ASSERT(thread->first_timed_poller == poller1);
+	/* poller1 and poller2 have the same next_run_tick. */
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == poller1->next_run_tick);
 	CU_ASSERT(poller1->next_run_tick == start_ticks + 500);
 	CU_ASSERT(poller2->next_run_tick == start_ticks + 500);
 	CU_ASSERT(poller3->next_run_tick == start_ticks + 1000);
@@ -1544,10 +1581,8 @@ multi_timed_pollers_have_same_expiration(void)
 	CU_ASSERT(spdk_get_ticks() == start_ticks + 500);
 	poll_threads();
 
-	/* poller1, poller2, and poller3 have the same next_run_tick but cache
-	 * has poller3 because poller3 is not expired yet.
-	 */
-	CU_ASSERT(thread->first_timed_poller == poller3);
+	/* poller1 and poller2 were re-armed and now expire with poller3. */
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == poller3->next_run_tick);
 	CU_ASSERT(poller1->next_run_tick == start_ticks + 1000);
 	CU_ASSERT(poller2->next_run_tick == start_ticks + 1000);
 	CU_ASSERT(poller3->next_run_tick == start_ticks + 1000);
@@ -1558,10 +1593,8 @@ multi_timed_pollers_have_same_expiration(void)
 	CU_ASSERT(spdk_get_ticks() == start_ticks + 1000);
 	poll_threads();
 
-	/* poller1, poller2, and poller4 have the same next_run_tick but cache
-	 * has poller4 because poller4 is not expired yet.
-	 */
-	CU_ASSERT(thread->first_timed_poller == poller4);
+	/* poller1 and poller2 were re-armed and now expire with poller4. */
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == poller4->next_run_tick);
 	CU_ASSERT(poller1->next_run_tick == start_ticks + 1500);
 	CU_ASSERT(poller2->next_run_tick == start_ticks + 1500);
 	CU_ASSERT(poller3->next_run_tick == start_ticks + 2000);
@@ -1572,10 +1605,8 @@ multi_timed_pollers_have_same_expiration(void)
 	CU_ASSERT(spdk_get_ticks() == start_ticks + 1500);
 	poll_threads();
 
-	/* poller1, poller2, and poller3 have the same next_run_tick but cache
-	 * has poller3 because poller3 is updated earlier than poller1 and poller2.
-	 */
-	CU_ASSERT(thread->first_timed_poller == poller3);
+	/* poller1, poller2, and poller3 have the same next_run_tick. */
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == poller3->next_run_tick);
 	CU_ASSERT(poller1->next_run_tick == start_ticks + 2000);
 	CU_ASSERT(poller2->next_run_tick == start_ticks + 2000);
 	CU_ASSERT(poller3->next_run_tick == start_ticks + 2000);
@@ -1590,8 +1621,8 @@ multi_timed_pollers_have_same_expiration(void)
 	CU_ASSERT(spdk_get_ticks() == start_ticks + 3000);
 	poll_threads();
 
-	CU_ASSERT(thread->first_timed_poller == NULL);
-	CU_ASSERT(RB_EMPTY(&thread->timed_pollers));
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == 0);
+	CU_ASSERT(spdk_thread_get_first_timed_poller(thread) == NULL);
 
 	/*
 	 * case 2: unregister timed pollers while multiple timed pollers are registered.
@@ -1601,7 +1632,7 @@ multi_timed_pollers_have_same_expiration(void)
 	poller1 = spdk_poller_register(dummy_poller, NULL, 500);
 	SPDK_CU_ASSERT_FATAL(poller1 != NULL);
 
-	CU_ASSERT(thread->first_timed_poller == poller1);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == poller1->next_run_tick);
 	CU_ASSERT(poller1->next_run_tick == start_ticks + 500);
 
 	/* after 250 usec, register poller2 and poller3. */
@@ -1614,7 +1645,7 @@ multi_timed_pollers_have_same_expiration(void)
 	poller3 = spdk_poller_register(dummy_poller, NULL, 750);
 	SPDK_CU_ASSERT_FATAL(poller3 != NULL);
 
-	CU_ASSERT(thread->first_timed_poller == poller1);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == poller1->next_run_tick);
 	CU_ASSERT(poller1->next_run_tick == start_ticks + 500);
 	CU_ASSERT(poller2->next_run_tick == start_ticks + 750);
 	CU_ASSERT(poller3->next_run_tick == start_ticks + 1000);
@@ -1629,7 +1660,7 @@ multi_timed_pollers_have_same_expiration(void)
 	poll_threads();
 
 	/* poller2 is not unregistered yet because it is not expired. */
-	CU_ASSERT(thread->first_timed_poller == tmp);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == tmp->next_run_tick);
 	CU_ASSERT(poller1->next_run_tick == start_ticks + 1000);
 	CU_ASSERT(tmp->next_run_tick == start_ticks + 750);
 	CU_ASSERT(poller3->next_run_tick == start_ticks + 1000);
@@ -1638,7 +1669,7 @@ multi_timed_pollers_have_same_expiration(void)
 	CU_ASSERT(spdk_get_ticks() == start_ticks + 750);
 	poll_threads();
 
-	CU_ASSERT(thread->first_timed_poller == poller3);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == poller3->next_run_tick);
 	CU_ASSERT(poller1->next_run_tick == start_ticks + 1000);
 	CU_ASSERT(poller3->next_run_tick == start_ticks + 1000);
 
@@ -1648,7 +1679,7 @@ multi_timed_pollers_have_same_expiration(void)
 	CU_ASSERT(spdk_get_ticks() == start_ticks + 1000);
 	poll_threads();
 
-	CU_ASSERT(thread->first_timed_poller == poller1);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == poller1->next_run_tick);
 	CU_ASSERT(poller1->next_run_tick == start_ticks + 1500);
 
 	spdk_poller_unregister(&poller1);
@@ -1657,8 +1688,8 @@ multi_timed_pollers_have_same_expiration(void)
 	CU_ASSERT(spdk_get_ticks() == start_ticks + 1500);
 	poll_threads();
 
-	CU_ASSERT(thread->first_timed_poller == NULL);
-	CU_ASSERT(RB_EMPTY(&thread->timed_pollers));
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == 0);
+	CU_ASSERT(spdk_thread_get_first_timed_poller(thread) == NULL);
 
 	free_threads();
 }
@@ -1674,6 +1705,160 @@ dummy_destroy_cb(void *io_device, void *ctx_buf)
 {
 }
 
+static int
+count_poller(void *arg)
+{
+	uint32_t *count = arg;
+
+	(*count)++;
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+delay_us_64(uint64_t us)
+{
+	while (us > UINT32_MAX) {
+		spdk_delay_us(UINT32_MAX);
+		us -= UINT32_MAX;
+	}
+	spdk_delay_us(us);
+}
+
+static void
+timed_pollers_long_periods(void)
+{
+	struct spdk_thread *thread;
+	struct spdk_poller *poller[4], *tmp;
+	uint64_t periods[4] = { 10, 5000, 300000, 1ULL << 37 };
+	uint32_t count[4] = {};
+	uint64_t start_ticks;
+	int i, num_pollers;
+
+	allocate_threads(1);
+	set_thread(0);
+
+	thread = spdk_get_thread();
+	SPDK_CU_ASSERT_FATAL(thread != NULL);
+
+	start_ticks = spdk_get_ticks();
+
+	/* The pollers are spread over the levels of the timer wheel and beyond */
+	for (i = 0; i < 4; i++) {
+		poller[i] = spdk_poller_register(count_poller, &count[i], periods[i]);
+		SPDK_CU_ASSERT_FATAL(poller[i] != NULL);
+	}
+
+	num_pollers = 0;
+	for (tmp = spdk_thread_get_first_timed_poller(thread); tmp != NULL;
+	     tmp = spdk_thread_get_next_timed_poller(tmp)) {
+		num_pollers++;
+	}
+	CU_ASSERT(num_pollers == 4);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == start_ticks + 10);
+
+	/* Pollers of the upper levels are moved down the wheel and expire on time */
+	for (i = 0; i < 1000; i++) {
+		spdk_delay_us(10);
+		poll_threads();
+	}
+	CU_ASSERT(spdk_get_ticks() == start_ticks + 10000);
+	CU_ASSERT(count[0] == 1000);
+	CU_ASSERT(count[1] == 2);
+	CU_ASSERT(count[2] == 0);
+	CU_ASSERT(count[3] == 0);
+
+	/* A long gap between two polls neither runs pollers early nor skips them */
+	spdk_delay_us(289999);
+	poll_threads();
+	CU_ASSERT(count[0] == 1001);
+	CU_ASSERT(count[1] == 3);
+	CU_ASSERT(count[2] == 0);
+
+	spdk_delay_us(1);
+	poll_threads();
+	CU_ASSERT(count[2] == 1);
+	CU_ASSERT(poller[2]->next_run_tick == start_ticks + 600000);
+
+	delay_us_64(periods[3] - 300001);
+	poll_threads();
+	CU_ASSERT(count[3] == 0);
+
+	spdk_delay_us(1);
+	poll_threads();
+	CU_ASSERT(count[3] == 1);
+
+	for (i = 0; i < 4; i++) {
+		spdk_poller_unregister(&poller[i]);
+	}
+
+	delay_us_64(periods[3]);
+	poll_threads();
+
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == 0);
+	CU_ASSERT(spdk_thread_get_first_timed_poller(thread) == NULL);
+
+	free_threads();
+}
+
+static void
+timed_pollers_mixed_levels(void)
+{
+	struct spdk_thread *thread;
+	struct spdk_poller *poller1, *poller2, *poller3;
+	uint32_t count1 = 0, count2 = 0, count3 = 0;
+	uint64_t start_ticks;
+
+	allocate_threads(1);
+	set_thread(0);
+
+	thread = spdk_get_thread();
+	SPDK_CU_ASSERT_FATAL(thread != NULL);
+
+	/* Start at the beginning of a level 0 rotation so that nothing gets cascaded below */
+	spdk_delay_us(64 - (spdk_get_ticks() & 63));
+	poll_threads();
+	start_ticks = spdk_get_ticks();
+
+	/* poller1 lands in level 1, poller2 registered later in level 0 expires after it */
+	poller1 = spdk_poller_register(count_poller, &count1, 64);
+	SPDK_CU_ASSERT_FATAL(poller1 != NULL);
+	spdk_delay_us(30);
+	poll_threads();
+	poller2 = spdk_poller_register(count_poller, &count2, 63);
+	SPDK_CU_ASSERT_FATAL(poller2 != NULL);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == start_ticks + 64);
+
+	/* A poller further up the wheel does not hide closer ones either */
+	poller3 = spdk_poller_register(count_poller, &count3, 5000);
+	SPDK_CU_ASSERT_FATAL(poller3 != NULL);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == start_ticks + 64);
+
+	spdk_delay_us(34);
+	poll_threads();
+	CU_ASSERT(count1 == 1);
+	CU_ASSERT(count2 == 0);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == start_ticks + 93);
+
+	spdk_delay_us(29);
+	poll_threads();
+	CU_ASSERT(count2 == 1);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == start_ticks + 128);
+
+	spdk_delay_us(35);
+	poll_threads();
+	CU_ASSERT(count1 == 2);
+	CU_ASSERT(count2 == 1);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == start_ticks + 156);
+
+	spdk_poller_unregister(&poller1);
+	spdk_poller_unregister(&poller2);
+	spdk_poller_unregister(&poller3);
+	poll_threads();
+
+	free_threads();
+}
+
 /* We had a bug that the compare function for the io_device tree
  * did not work as expected because subtraction caused overflow
  * when the difference between two keys was more than 32 bits.
@@ -1803,6 +1988,309 @@ io_device_lookup(void)
 	free_threads();
 }
 
+static void
+thread_numa_id(void)
+{
+	struct spdk_io_channel *ch1, *ch2, *ch3, *ch4;
+	struct spdk_thread *thread;
+
+	allocate_threads(1);
+	set_thread(0);
+	thread = spdk_get_thread();
+
+	spdk_io_device_register((void *)0x1, dummy_create_cb, dummy_destroy_cb, 0, NULL);
+	spdk_io_device_register((void *)0x2, dummy_create_cb, dummy_destroy_cb, 0, NULL);
+	spdk_io_device_register((void *)0x3, dummy_create_cb, dummy_destroy_cb, 0, NULL);
+	spdk_io_device_register((void *)0x4, dummy_create_cb, dummy_destroy_cb, 0, NULL);
+
+	CU_ASSERT(spdk_io_device_set_numa_id((void *)0x5, 1) == -ENODEV);
+	CU_ASSERT(spdk_io_device_set_numa_id((void *)0x2, 1) == 0);
+	CU_ASSERT(spdk_io_device_set_numa_id((void *)0x3, 0) == 0);
+	CU_ASSERT(spdk_io_device_set_numa_id((void *)0x4, 1) == 0);
+
+	/* No channels, no affinity */
+	CU_ASSERT(spdk_thread_get_numa_id(thread) == SPDK_ENV_SOCKET_ID_ANY);
+
+	/* Channels to devices without a node don't count */
+	ch1 = spdk_get_io_channel((void *)0x1);
+	SPDK_CU_ASSERT_FATAL(ch1 != NULL);
+	CU_ASSERT(spdk_thread_get_numa_id(thread) == SPDK_ENV_SOCKET_ID_ANY);
+
+	ch2 = spdk_get_io_channel((void *)0x2);
+	SPDK_CU_ASSERT_FATAL(ch2 != NULL);
+	CU_ASSERT(spdk_thread_get_numa_id(thread) == 1);
+
+	/* A tie means no clear affinity */
+	ch3 = spdk_get_io_channel((void *)0x3);
+	SPDK_CU_ASSERT_FATAL(ch3 != NULL);
+	CU_ASSERT(spdk_thread_get_numa_id(thread) == SPDK_ENV_SOCKET_ID_ANY);
+
+	ch4 = spdk_get_io_channel((void *)0x4);
+	SPDK_CU_ASSERT_FATAL(ch4 != NULL);
+	CU_ASSERT(spdk_thread_get_numa_id(thread) == 1);
+
+	spdk_put_io_channel(ch2);
+	spdk_put_io_channel(ch4);
+	poll_threads();
+	CU_ASSERT(spdk_thread_get_numa_id(thread) == 0);
+
+	spdk_put_io_channel(ch1);
+	spdk_put_io_channel(ch3);
+	poll_threads();
+
+	spdk_io_device_unregister((void *)0x1, NULL);
+	spdk_io_device_unregister((void *)0x2, NULL);
+	spdk_io_device_unregister((void *)0x3, NULL);
+	spdk_io_device_unregister((void *)0x4, NULL);
+	poll_threads();
+
+	CU_ASSERT(RB_EMPTY(&g_io_devices));
+
+	free_threads();
+}
+
+static void
+thread_numa_id_plurality(void)
+{
+	/* Nodes of the devices, none of them has a majority of the channels */
+	int32_t numa_ids[] = { 0, 0, 0, 1, 1, 2, 2 };
+	struct spdk_io_channel *ch[SPDK_COUNTOF(numa_ids)];
+	struct spdk_thread *thread;
+	uintptr_t i;
+
+	allocate_threads(1);
+	set_thread(0);
+	thread = spdk_get_thread();
+
+	CU_ASSERT(spdk_io_device_set_numa_id((void *)0x1, SPDK_THREAD_MAX_NUMA_NODES) == -EINVAL);
+	CU_ASSERT(spdk_io_device_set_numa_id((void *)0x1, -2) == -EINVAL);
+
+	for (i = 0; i < SPDK_COUNTOF(numa_ids); i++) {
+		spdk_io_device_register((void *)(i + 1), dummy_create_cb, dummy_destroy_cb, 0, NULL);
+		CU_ASSERT(spdk_io_device_set_numa_id((void *)(i + 1), numa_ids[i]) == 0);
+		ch[i] = spdk_get_io_channel((void *)(i + 1));
+		SPDK_CU_ASSERT_FATAL(ch[i] != NULL);
+	}
+
+	/* No node has a majority, the one with the most channels still wins */
+	CU_ASSERT(spdk_thread_get_numa_id(thread) == 0);
+
+	/* Two nodes with the most channels mean no clear affinity */
+	spdk_put_io_channel(ch[0]);
+	poll_threads();
+	CU_ASSERT(spdk_thread_get_numa_id(thread) == SPDK_ENV_SOCKET_ID_ANY);
+
+	for (i = 1; i < SPDK_COUNTOF(numa_ids); i++) {
+		spdk_put_io_channel(ch[i]);
+	}
+	poll_threads();
+
+	for (i = 0; i < SPDK_COUNTOF(numa_ids); i++) {
+		spdk_io_device_unregister((void *)(i + 1), NULL);
+	}
+	poll_threads();
+
+	CU_ASSERT(RB_EMPTY(&g_io_devices));
+
+	free_threads();
+}
+
+static void
+io_channel_cache(void)
+{
+	struct spdk_io_channel *ch1, *ch2;
+	struct io_channel_cache_entry *entry;
+	struct spdk_thread *thread;
+
+	allocate_threads(1);
+	set_thread(0);
+	thread = spdk_get_thread();
+
+	spdk_io_device_register(&g_device1, create_cb_1, destroy_cb_1, sizeof(g_ctx1), NULL);
+	entry = io_channel_cache_entry(thread, &g_device1);
+	CU_ASSERT(entry->ch == NULL);
+
+	/* A new channel is added to the cache */
+	ch1 = spdk_get_io_channel(&g_device1);
+	SPDK_CU_ASSERT_FATAL(ch1 != NULL);
+	CU_ASSERT(entry->io_device == &g_device1);
+	CU_ASSERT(entry->ch == ch1);
+
+	/* Cache hit takes a reference without the device lookup */
+	CU_ASSERT(pthread_mutex_trylock(&g_devlist_mutex) == 0);
+	ch2 = spdk_get_io_channel(&g_device1);
+	CU_ASSERT(pthread_mutex_unlock(&g_devlist_mutex) == 0);
+	CU_ASSERT(ch2 == ch1);
+	CU_ASSERT(ch1->ref == 2);
+	spdk_put_io_channel(ch2);
+	poll_threads();
+
+	/* An entry evicted by another channel is refilled from the slow path */
+	entry->io_device = NULL;
+	entry->ch = NULL;
+	ch2 = spdk_get_io_channel(&g_device1);
+	CU_ASSERT(ch2 == ch1);
+	CU_ASSERT(entry->ch == ch1);
+	spdk_put_io_channel(ch2);
+	poll_threads();
+
+	/* Channels of unregistered devices are not returned */
+	spdk_io_device_unregister(&g_device1, NULL);
+	poll_threads();
+	CU_ASSERT(spdk_get_io_channel(&g_device1) == NULL);
+
+	/* Destroying the channel removes it from the cache */
+	spdk_put_io_channel(ch1);
+	poll_threads();
+	CU_ASSERT(entry->ch == NULL);
+	CU_ASSERT(RB_EMPTY(&g_io_devices));
+
+	free_threads();
+}
+
+static void
+msg_latency_tracking(void)
+{
+	struct spdk_thread *thread0, *thread1;
+	const struct spdk_msg_latency_table *table;
+	struct spdk_msg_latency_table *fake_table = NULL;
+	const struct spdk_msg_latency_stats *entry = NULL;
+	bool done = false;
+	uintptr_t fn;
+	uint32_t i;
+
+	allocate_threads(2);
+	set_thread(0);
+	thread0 = spdk_get_thread();
+	set_thread(1);
+	thread1 = spdk_get_thread();
+
+	/* Nothing is recorded while tracking is disabled */
+	CU_ASSERT(!spdk_msg_latency_tracking_is_enabled());
+	spdk_thread_send_msg(thread0, send_msg_cb, &done);
+	spdk_delay_us(10);
+	poll_thread(0);
+	CU_ASSERT(done);
+	CU_ASSERT(spdk_thread_get_msg_latency(thread0) == NULL);
+
+	/* Wait times are aggregated per source thread and function */
+	spdk_msg_latency_tracking_enable(true);
+	done = false;
+	spdk_thread_send_msg(thread0, send_msg_cb, &done);
+	spdk_delay_us(10);
+	poll_thread(0);
+	CU_ASSERT(done);
+	spdk_thread_send_msg(thread0, send_msg_cb, &done);
+	spdk_delay_us(30);
+	poll_thread(0);
+
+	table = spdk_thread_get_msg_latency(thread0);
+	SPDK_CU_ASSERT_FATAL(table != NULL);
+	CU_ASSERT(table->dropped == 0);
+	for (i = 0; i < SPDK_MSG_LATENCY_TABLE_SIZE; i++) {
+		if (table->entries[i].fn != NULL) {
+			CU_ASSERT(entry == NULL);
+			entry = &table->entries[i];
+		}
+	}
+	SPDK_CU_ASSERT_FATAL(entry != NULL);
+	CU_ASSERT(entry->fn == (void *)send_msg_cb);
+	CU_ASSERT(entry->src_id == spdk_thread_get_id(thread1));
+	CU_ASSERT(entry->count == 2);
+	CU_ASSERT(entry->total_tsc == 40);
+	CU_ASSERT(entry->max_tsc == 30);
+	CU_ASSERT(spdk_thread_get_msg_latency(thread1) == NULL);
+
+	/* Re-enabling tracking discards the gathered statistics */
+	spdk_msg_latency_tracking_enable(false);
+	spdk_msg_latency_tracking_enable(true);
+	CU_ASSERT(spdk_thread_get_msg_latency(thread0) == NULL);
+
+	/* Pairs which do not fit in the table are counted as dropped */
+	for (fn = 1; fn <= SPDK_MSG_LATENCY_TABLE_SIZE + 2; fn++) {
+		spdk_msg_latency_record(&fake_table, 1, (void *)fn, fn);
+	}
+	table = spdk_msg_latency_get(fake_table);
+	SPDK_CU_ASSERT_FATAL(table != NULL);
+	CU_ASSERT(table->dropped == 2);
+	spdk_msg_latency_record(&fake_table, 1, (void *)1, 5);
+	CU_ASSERT(table->dropped == 2);
+	free(fake_table);
+
+	spdk_msg_latency_tracking_enable(false);
+	free_threads();
+}
+
+static int
+poller_delay(void *ctx)
+{
+	uint32_t *delay_us = ctx;
+
+	spdk_delay_us(*delay_us);
+
+	return SPDK_POLLER_IDLE;
+}
+
+static void
+msg_delay(void *ctx)
+{
+	poller_delay(ctx);
+}
+
+static void
+poller_cost_stats(void)
+{
+	struct spdk_poller *active, *timed;
+	struct spdk_poller_stats stats;
+	uint32_t active_delay = 0, timed_delay = 1000;
+
+	allocate_threads(1);
+	set_thread(0);
+
+	/* In the unit tests one tick is one microsecond */
+	active = spdk_poller_register(poller_delay, &active_delay, 0);
+	SPDK_CU_ASSERT_FATAL(active != NULL);
+	timed = spdk_poller_register(poller_delay, &timed_delay, 10);
+	SPDK_CU_ASSERT_FATAL(timed != NULL);
+
+	poll_threads();
+	spdk_delay_us(10);
+	poll_threads();
+
+	spdk_poller_get_stats(active, &stats);
+	CU_ASSERT(stats.run_count == stats.tsc_histogram[0]);
+	CU_ASSERT(stats.tsc == 0);
+
+	/* 1000 ticks fall into [512, 1024) */
+	spdk_poller_get_stats(timed, &stats);
+	CU_ASSERT(stats.run_count == 1);
+	CU_ASSERT(stats.tsc == 1000);
+	CU_ASSERT(stats.tsc_histogram[0] == 0);
+	CU_ASSERT(stats.tsc_histogram[1] == 0);
+	CU_ASSERT(stats.tsc_histogram[2] == 1);
+
+	/* Anything longer than the histogram range goes to the last bucket */
+	timed_delay = 10 * 1000 * 1000;
+	spdk_delay_us(10);
+	poll_threads();
+	spdk_poller_get_stats(timed, &stats);
+	CU_ASSERT(stats.run_count == 2);
+	CU_ASSERT(stats.tsc == 1000 + 10 * 1000 * 1000);
+	CU_ASSERT(stats.tsc_histogram[SPDK_POLLER_TSC_HISTOGRAM_BUCKETS - 1] == 1);
+
+	/* Time spent in messages is not charged to the pollers */
+	spdk_thread_send_msg(spdk_get_thread(), msg_delay, &timed_delay);
+	poll_threads();
+	spdk_poller_get_stats(active, &stats);
+	CU_ASSERT(stats.tsc == 0);
+
+	spdk_poller_unregister(&active);
+	spdk_poller_unregister(&timed);
+	poll_threads();
+
+	free_threads();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1816,6 +2304,7 @@ main(int argc, char **argv)
 
 	CU_ADD_TEST(suite, thread_alloc);
 	CU_ADD_TEST(suite, thread_send_msg);
+	CU_ADD_TEST(suite, thread_send_msg_batch);
 	CU_ADD_TEST(suite, thread_poller);
 	CU_ADD_TEST(suite, poller_pause);
 	CU_ADD_TEST(suite, thread_for_each);
@@ -1830,7 +2319,14 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, device_unregister_and_thread_exit_race);
 	CU_ADD_TEST(suite, cache_closest_timed_poller);
 	CU_ADD_TEST(suite, multi_timed_pollers_have_same_expiration);
+	CU_ADD_TEST(suite, timed_pollers_long_periods);
+	CU_ADD_TEST(suite, timed_pollers_mixed_levels);
 	CU_ADD_TEST(suite, io_device_lookup);
+	CU_ADD_TEST(suite, thread_numa_id);
+	CU_ADD_TEST(suite, thread_numa_id_plurality);
+	CU_ADD_TEST(suite, poller_cost_stats);
+	CU_ADD_TEST(suite, io_channel_cache);
+	CU_ADD_TEST(suite, msg_latency_tracking);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
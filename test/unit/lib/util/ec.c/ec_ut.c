@@ -0,0 +1,192 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk_cunit.h"
+
+#include "util/ec.c"
+
+#define TEST_EC_LEN 1000
+
+static void
+test_ec_gf(void)
+{
+	uint32_t a;
+
+	/* Known values in GF(2^8) with polynomial 0x11d */
+	CU_ASSERT(ec_gf_mul(2, 0x80) == 0x1d);
+	CU_ASSERT(ec_gf_mul(3, 7) == 9);
+	CU_ASSERT(ec_gf_inv(2) == 0x8e);
+	CU_ASSERT(ec_gf_mul(0, 5) == 0);
+
+	for (a = 1; a < 256; a++) {
+		CU_ASSERT(ec_gf_mul(a, ec_gf_inv(a)) == 1);
+	}
+}
+
+static void
+test_ec_encode(void)
+{
+	uint8_t d0[4] = { 1, 0, 1, 0xff }, d1[4] = { 1, 1, 0, 0xff }, p0[4], p1[4];
+	void *data[] = { d0, d1 }, *parity[] = { p0, p1 };
+	int rc;
+
+	rc = spdk_ec_encode(data, 2, parity, 2, sizeof(d0));
+	CU_ASSERT(rc == 0);
+
+	/* First parity row of the Cauchy matrix is { inv(2 ^ 0), inv(2 ^ 1) } */
+	CU_ASSERT(p0[0] == (ec_gf_inv(2) ^ ec_gf_inv(3)));
+	CU_ASSERT(p0[0] == 0x7a);
+	CU_ASSERT(p0[1] == ec_gf_inv(3));
+	CU_ASSERT(p0[2] == ec_gf_inv(2));
+	/* Second parity row is { inv(3 ^ 0), inv(3 ^ 1) } */
+	CU_ASSERT(p1[0] == (ec_gf_inv(3) ^ ec_gf_inv(2)));
+	CU_ASSERT(p1[1] == ec_gf_inv(2));
+	CU_ASSERT(p1[3] == (ec_gf_mul(0xff, ec_gf_inv(3)) ^ ec_gf_mul(0xff, ec_gf_inv(2))));
+}
+
+static void
+_test_ec_decode(uint32_t ndata, uint32_t nparity)
+{
+	uint8_t *bufs[SPDK_EC_MAX_DATA_BUFS + SPDK_EC_MAX_PARITY_BUFS];
+	uint8_t *orig[SPDK_EC_MAX_DATA_BUFS + SPDK_EC_MAX_PARITY_BUFS];
+	uint32_t erased[SPDK_EC_MAX_PARITY_BUFS];
+	uint32_t total = ndata + nparity, nerased, i, mask;
+	size_t off;
+	int rc;
+
+	for (i = 0; i < total; i++) {
+		bufs[i] = malloc(TEST_EC_LEN);
+		orig[i] = malloc(TEST_EC_LEN);
+		SPDK_CU_ASSERT_FATAL(bufs[i] != NULL && orig[i] != NULL);
+		for (off = 0; off < TEST_EC_LEN; off++) {
+			bufs[i][off] = rand();
+		}
+	}
+
+	rc = spdk_ec_encode((void **)bufs, ndata, (void **)&bufs[ndata], nparity, TEST_EC_LEN);
+	CU_ASSERT(rc == 0);
+	for (i = 0; i < total; i++) {
+		memcpy(orig[i], bufs[i], TEST_EC_LEN);
+	}
+
+	/* Every combination of up to nparity lost buffers */
+	for (mask = 1; mask < (1u << total); mask++) {
+		if ((uint32_t)__builtin_popcount(mask) > nparity) {
+			continue;
+		}
+
+		nerased = 0;
+		for (i = total; i > 0; i--) {
+			if (mask & (1u << (i - 1))) {
+				erased[nerased++] = i - 1;
+				memset(bufs[i - 1], 0, TEST_EC_LEN);
+			}
+		}
+
+		rc = spdk_ec_decode((void **)bufs, ndata, (void **)&bufs[ndata], nparity,
+				    erased, nerased, TEST_EC_LEN);
+		CU_ASSERT(rc == 0);
+		for (i = 0; i < total; i++) {
+			CU_ASSERT(memcmp(bufs[i], orig[i], TEST_EC_LEN) == 0);
+		}
+	}
+
+	for (i = 0; i < total; i++) {
+		free(bufs[i]);
+		free(orig[i]);
+	}
+}
+
+static void
+test_ec_decode(void)
+{
+	_test_ec_decode(1, 1);
+	_test_ec_decode(4, 2);
+	_test_ec_decode(6, 3);
+	_test_ec_decode(10, 4);
+}
+
+static void
+test_ec_invalid(void)
+{
+	uint8_t d0[8], d1[8], p0[8], p1[8];
+	void *data[] = { d0, d1 }, *parity[] = { p0, p1 };
+	uint32_t erased[3];
+
+	CU_ASSERT(spdk_ec_encode(data, 0, parity, 2, sizeof(d0)) == -EINVAL);
+	CU_ASSERT(spdk_ec_encode(data, 2, parity, 0, sizeof(d0)) == -EINVAL);
+	CU_ASSERT(spdk_ec_encode(data, SPDK_EC_MAX_DATA_BUFS + 1, parity, 2, sizeof(d0)) == -EINVAL);
+	CU_ASSERT(spdk_ec_encode(data, 2, parity, SPDK_EC_MAX_PARITY_BUFS + 1, sizeof(d0)) == -EINVAL);
+
+	/* More lost buffers than parity */
+	erased[0] = 0;
+	erased[1] = 1;
+	erased[2] = 2;
+	CU_ASSERT(spdk_ec_decode(data, 2, parity, 2, erased, 3, sizeof(d0)) == -EINVAL);
+	CU_ASSERT(spdk_ec_decode(data, 2, parity, 2, erased, 0, sizeof(d0)) == -EINVAL);
+
+	/* Out of range and duplicate indexes */
+	erased[0] = 4;
+	CU_ASSERT(spdk_ec_decode(data, 2, parity, 2, erased, 1, sizeof(d0)) == -EINVAL);
+	erased[0] = 1;
+	erased[1] = 1;
+	CU_ASSERT(spdk_ec_decode(data, 2, parity, 2, erased, 2, sizeof(d0)) == -EINVAL);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_set_error_action(CUEA_ABORT);
+	CU_initialize_registry();
+
+	suite = CU_add_suite("ec", NULL, NULL);
+
+	CU_ADD_TEST(suite, test_ec_gf);
+	CU_ADD_TEST(suite, test_ec_encode);
+	CU_ADD_TEST(suite, test_ec_decode);
+	CU_ADD_TEST(suite, test_ec_invalid);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+
+	CU_basic_run_tests();
+
+	num_failures = CU_get_number_of_failures();
+	CU_cleanup_registry();
+
+	return num_failures;
+}
@@ -0,0 +1,155 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk_cunit.h"
+
+#include "util/xor.c"
+
+#define TEST_XOR_MAX_SRC 8
+/* More sources than ISA-L is given in one call */
+#define TEST_XOR_MANY_SRC 300
+
+static void
+xor_gen_ref(uint8_t *dest, uint8_t **sources, uint32_t n, size_t len)
+{
+	size_t off;
+	uint32_t j;
+
+	for (off = 0; off < len; off++) {
+		dest[off] = 0;
+		for (j = 0; j < n; j++) {
+			dest[off] ^= sources[j][off];
+		}
+	}
+}
+
+static void
+_test_xor_gen(uint32_t n, size_t len, size_t misalign)
+{
+	uint8_t *bufs[TEST_XOR_MANY_SRC], *dest, *ref;
+	size_t alignment = spdk_xor_get_optimal_alignment();
+	uint32_t i;
+	size_t off;
+	int rc;
+
+	for (i = 0; i < n; i++) {
+		bufs[i] = NULL;
+		rc = posix_memalign((void **)&bufs[i], alignment, len + misalign);
+		SPDK_CU_ASSERT_FATAL(rc == 0);
+		for (off = 0; off < len + misalign; off++) {
+			bufs[i][off] = rand();
+		}
+		bufs[i] += misalign;
+	}
+	rc = posix_memalign((void **)&dest, alignment, len);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	ref = malloc(len);
+	SPDK_CU_ASSERT_FATAL(ref != NULL);
+
+	rc = spdk_xor_gen(dest, (void **)bufs, n, len);
+	CU_ASSERT(rc == 0);
+	xor_gen_ref(ref, bufs, n, len);
+	CU_ASSERT(memcmp(dest, ref, len) == 0);
+
+	for (i = 0; i < n; i++) {
+		free(bufs[i] - misalign);
+	}
+	free(dest);
+	free(ref);
+}
+
+static void
+test_xor_gen(void)
+{
+	uint32_t n;
+
+	for (n = 2; n <= TEST_XOR_MAX_SRC; n++) {
+		/* Aligned buffers and length */
+		_test_xor_gen(n, 4096, 0);
+		/* Length with a partial word at the end */
+		_test_xor_gen(n, 4096 + 7, 0);
+		/* Unaligned sources */
+		_test_xor_gen(n, 4096, 3);
+		/* Shorter than a word */
+		_test_xor_gen(n, 5, 1);
+	}
+
+	_test_xor_gen(TEST_XOR_MANY_SRC, 4096, 0);
+	_test_xor_gen(TEST_XOR_MANY_SRC, 4096, 3);
+}
+
+static void
+test_xor_gen_invalid(void)
+{
+	uint8_t src[16] = {}, dest[16];
+	void *sources[] = { src };
+
+	CU_ASSERT(spdk_xor_gen(dest, sources, 1, sizeof(dest)) == -EINVAL);
+	CU_ASSERT(spdk_xor_gen(dest, sources, 0, sizeof(dest)) == -EINVAL);
+}
+
+static void
+test_xor_get_optimal_alignment(void)
+{
+	size_t alignment = spdk_xor_get_optimal_alignment();
+
+	CU_ASSERT(alignment >= sizeof(uint64_t));
+	CU_ASSERT((alignment & (alignment - 1)) == 0);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_set_error_action(CUEA_ABORT);
+	CU_initialize_registry();
+
+	suite = CU_add_suite("xor", NULL, NULL);
+
+	CU_ADD_TEST(suite, test_xor_gen);
+	CU_ADD_TEST(suite, test_xor_gen_invalid);
+	CU_ADD_TEST(suite, test_xor_get_optimal_alignment);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+
+	CU_basic_run_tests();
+
+	num_failures = CU_get_number_of_failures();
+	CU_cleanup_registry();
+
+	return num_failures;
+}
@@ -113,6 +113,9 @@ function unittest_scsi() {
 function unittest_sock() {
 	$valgrind $testdir/lib/sock/sock.c/sock_ut
 	$valgrind $testdir/lib/sock/posix.c/posix_ut
+	if [ $(uname -s) = Linux ]; then
+		$valgrind $testdir/lib/sock/shm.c/shm_ut
+	fi
 	# Check whether uring is configured
 	if grep -q '#define SPDK_CONFIG_URING 1' $rootdir/include/spdk/config.h; then
 		$valgrind $testdir/lib/sock/uring.c/uring_ut
@@ -128,9 +131,11 @@ function unittest_util() {
 	$valgrind $testdir/lib/util/crc32c.c/crc32c_ut
 	$valgrind $testdir/lib/util/string.c/string_ut
 	$valgrind $testdir/lib/util/dif.c/dif_ut
+	$valgrind $testdir/lib/util/ec.c/ec_ut
 	$valgrind $testdir/lib/util/iov.c/iov_ut
 	$valgrind $testdir/lib/util/math.c/math_ut
 	$valgrind $testdir/lib/util/pipe.c/pipe_ut
+	$valgrind $testdir/lib/util/xor.c/xor_ut
 }
 
 function unittest_init() {